@@ -30,6 +30,22 @@ APT_BEGIN_EXTERN_C
 
 /** Opaque consumer task declaration */
 typedef struct apt_consumer_task_t apt_consumer_task_t;
+/** Consumer task statistics declaration */
+typedef struct apt_consumer_task_stat_t apt_consumer_task_stat_t;
+
+/** Consumer task statistics */
+struct apt_consumer_task_stat_t {
+	/** Number of processed messages */
+	apr_uint32_t msg_count;
+	/** Number of messages currently waiting in the queue */
+	apr_uint32_t queue_size;
+	/** Max number of messages waiting in the queue */
+	apr_uint32_t max_queue_size;
+	/** Total time processed messages have waited in the queue (usec) */
+	apr_uint64_t total_latency;
+	/** Max time a message has waited in the queue (usec) */
+	apr_uint32_t max_latency;
+};
 
 /**
  * Create consumer task.
@@ -60,6 +76,13 @@ APT_DECLARE(apt_task_vtable_t*) apt_consumer_task_vtable_get(apt_consumer_task_t
  */
 APT_DECLARE(void*) apt_consumer_task_object_get(const apt_consumer_task_t *task);
 
+/**
+ * Get consumer task statistics.
+ * @param task the consumer task to get statistics of
+ * @param stat the statistics to fill
+ */
+APT_DECLARE(void) apt_consumer_task_stat_get(const apt_consumer_task_t *task, apt_consumer_task_stat_t *stat);
+
 APT_END_EXTERN_C
 
 #endif /* APT_CONSUMER_TASK_H */
@@ -104,6 +104,15 @@ APT_DECLARE(apt_header_field_t*) apt_header_field_create_from_line(const apt_str
  */
 APT_DECLARE(apt_header_field_t*) apt_header_field_copy(const apt_header_field_t *src_header_field, apr_pool_t *pool);
 
+/**
+ * Create header field sharing name and value with specified header field.
+ * @param src_header_field the header field to share name and value of
+ * @param pool the pool to allocate memory from
+ * @remark only the header field itself is allocated, the name and value are referenced,
+ * therefore they should neither be modified in place nor outlived by the created header field
+ */
+APT_DECLARE(apt_header_field_t*) apt_header_field_share(const apt_header_field_t *src_header_field, apr_pool_t *pool);
+
 /**
  * Initialize header section (collection of header fields).
  * @param header the header section to initialize
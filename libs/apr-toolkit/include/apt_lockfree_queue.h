@@ -0,0 +1,100 @@
+/*
+ * Copyright 2008-2010 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef APT_LOCKFREE_QUEUE_H
+#define APT_LOCKFREE_QUEUE_H
+
+/**
+ * @file apt_lockfree_queue.h
+ * @brief Bounded Lock-free MPSC Queue of Opaque void* Objects
+ * @remark Any number of threads may push objects concurrently,
+ *         while only one thread at a time may pop them.
+ */
+
+#include "apt.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Default size (number of elements) of lock-free queue */
+#define LOCKFREE_QUEUE_DEFAULT_SIZE	1024
+
+/** Opaque lock-free queue declaration */
+typedef struct apt_lockfree_queue_t apt_lockfree_queue_t;
+
+/**
+ * Create lock-free queue.
+ * @param size the max number of elements (rounded up to a power of 2)
+ * @param pool the pool to allocate memory from
+ * @return the created queue
+ */
+APT_DECLARE(apt_lockfree_queue_t*) apt_lockfree_queue_create(apr_size_t size, apr_pool_t *pool);
+
+/**
+ * Create lock-free queue, optionally backed by an overflow list.
+ * @param size the max number of elements of the ring (rounded up to a power of 2)
+ * @param overflow_list whether to spill objects to a locked list once the ring is full
+ * @param pool the pool to allocate memory from
+ * @return the created queue
+ * @remark Push fails on full queue only if no overflow list is used.
+ */
+APT_DECLARE(apt_lockfree_queue_t*) apt_lockfree_queue_create_ex(apr_size_t size, apt_bool_t overflow_list, apr_pool_t *pool);
+
+/**
+ * Destroy lock-free queue.
+ * @param queue the queue to destroy
+ */
+APT_DECLARE(void) apt_lockfree_queue_destroy(apt_lockfree_queue_t *queue);
+
+/**
+ * Push object to the queue (never blocks).
+ * @param queue the queue to push object to
+ * @param obj the object to push
+ * @return FALSE if the queue is full, otherwise TRUE
+ */
+APT_DECLARE(apt_bool_t) apt_lockfree_queue_push(apt_lockfree_queue_t *queue, void *obj);
+
+/**
+ * Pop object from the queue (never blocks).
+ * @param queue the queue to pop object from
+ * @return the popped object or NULL if the queue is empty
+ */
+APT_DECLARE(void*) apt_lockfree_queue_pop(apt_lockfree_queue_t *queue);
+
+/**
+ * Query whether the queue is empty.
+ * @param queue the queue to query
+ * @return TRUE if empty, otherwise FALSE
+ */
+APT_DECLARE(apt_bool_t) apt_lockfree_queue_is_empty(const apt_lockfree_queue_t *queue);
+
+/**
+ * Get the max number of elements the queue can hold.
+ * @param queue the queue to get capacity of
+ */
+APT_DECLARE(apr_size_t) apt_lockfree_queue_capacity_get(const apt_lockfree_queue_t *queue);
+
+/**
+ * Get the number of objects rejected (or spilled to the overflow list) since the queue was full.
+ * @param queue the queue to get overflow count of
+ */
+APT_DECLARE(apr_uint32_t) apt_lockfree_queue_overflow_count_get(const apt_lockfree_queue_t *queue);
+
+
+APT_END_EXTERN_C
+
+#endif /* APT_LOCKFREE_QUEUE_H */
@@ -40,6 +40,30 @@ struct apt_str_table_item_t {
 	apr_size_t key;
 };
 
+/** Max number of key characters perfect hash is computed over */
+#define APT_STR_TABLE_HASH_MAX_KEYS 4
+
+/** String table hash declaration */
+typedef struct apt_str_table_hash_t apt_str_table_hash_t;
+
+/**
+ * Minimal perfect hash of a string table (generated by strtablegen).
+ * @remark The hash is computed over the length of the string and the (no case) key characters.
+ * The first pass selects a bucket, the seed of the bucket is used by the second pass to select a slot.
+ */
+struct apt_str_table_hash_t {
+	/** Positions of the key characters (negative positions are counted from the end) */
+	int                 keys[APT_STR_TABLE_HASH_MAX_KEYS];
+	/** Number of the key characters */
+	apr_size_t          key_count;
+	/** Seed of each bucket */
+	const apr_uint16_t *seeds;
+	/** Id of the item stored in each slot */
+	const apr_uint16_t *ids;
+	/** Number of buckets and slots (equals to the size of the table) */
+	apr_size_t          size;
+};
+
 
 /**
  * Get the string by a given id.
@@ -59,6 +83,24 @@ APT_DECLARE(const apt_str_t*) apt_string_table_str_get(const apt_str_table_item_
  */
 APT_DECLARE(apr_size_t) apt_string_table_id_find(const apt_str_table_item_t table[], apr_size_t size, const apt_str_t *value);
 
+/**
+ * Find the id associated with a given string using perfect hash of the table.
+ * @param table the table to search for the id
+ * @param size the size of the table
+ * @param hash the perfect hash of the table (linear search is done if NULL)
+ * @param value the string to search for
+ * @return the id associated with the string, or invalid id if string cannot be matched
+ */
+APT_DECLARE(apr_size_t) apt_string_table_hash_id_find(const apt_str_table_item_t table[], apr_size_t size, const apt_str_table_hash_t *hash, const apt_str_t *value);
+
+/**
+ * Compute the hash of a given string over the length and the key characters.
+ * @param hash the perfect hash to take key positions from
+ * @param value the string to compute the hash of
+ * @param seed the seed to mix in
+ */
+APT_DECLARE(apr_uint32_t) apt_string_table_hash_compute(const apt_str_table_hash_t *hash, const apt_str_t *value, apr_uint32_t seed);
+
 
 APT_END_EXTERN_C
 
@@ -42,7 +42,7 @@ typedef void (*apt_task_event_f)(apt_task_t *task);
 /**
  * Create task.
  * @param obj the external object to associate with the task
- * @param msg_pool the pool of task messages
+ * @param msg_pool the pool of task messages (destroyed along with the task)
  * @param pool the pool to allocate memory from
  */
 APT_DECLARE(apt_task_t*) apt_task_create(
@@ -55,10 +55,28 @@ struct apt_task_msg_t {
 	apt_task_msg_type_e  type;
 	/** Task msg sub type */
 	int                  sub_type;
+	/** Time the message has been queued at (set by consumer task for latency statistics) */
+	apr_time_t           queue_time;
 	/** Context specific data */
 	char                 data[1];
 };
 
+/** Default number of messages preallocated by static pool */
+#define TASK_MSG_POOL_DEFAULT_SIZE	256
+
+/** Task message pool statistics */
+typedef struct apt_task_msg_pool_stat_t apt_task_msg_pool_stat_t;
+struct apt_task_msg_pool_stat_t {
+	/** Number of preallocated messages (0 for dynamic pool) */
+	apr_size_t   capacity;
+	/** Number of messages currently acquired */
+	apr_uint32_t in_use_count;
+	/** Max number of messages acquired at a time */
+	apr_uint32_t high_water_mark;
+	/** Number of messages allocated dynamically since the pool was exhausted */
+	apr_uint32_t exhaustion_count;
+};
+
 
 /** Create pool of task messages with dynamic allocation of messages (no actual pool is created) */
 APT_DECLARE(apt_task_msg_pool_t*) apt_task_msg_pool_create_dynamic(apr_size_t msg_size, apr_pool_t *pool);
@@ -66,6 +84,9 @@ APT_DECLARE(apt_task_msg_pool_t*) apt_task_msg_pool_create_dynamic(apr_size_t ms
 /** Create pool of task messages with static allocation of messages */
 APT_DECLARE(apt_task_msg_pool_t*) apt_task_msg_pool_create_static(apr_size_t msg_size, apr_size_t msg_pool_size, apr_pool_t *pool);
 
+/** Get statistics of pool of task messages */
+APT_DECLARE(void) apt_task_msg_pool_stat_get(const apt_task_msg_pool_t *msg_pool, apt_task_msg_pool_stat_t *stat);
+
 /** Destroy pool of task messages */
 APT_DECLARE(void) apt_task_msg_pool_destroy(apt_task_msg_pool_t *msg_pool);
 
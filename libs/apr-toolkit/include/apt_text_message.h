@@ -59,9 +59,26 @@ APT_DECLARE(apt_message_status_e) apt_message_parser_run(apt_message_parser_t *p
 /** Get external object associated with parser */
 APT_DECLARE(void*) apt_message_parser_object_get(apt_message_parser_t *parser);
 
+/** Set pool to allocate the messages being parsed from (effective for the next message) */
+APT_DECLARE(void) apt_message_parser_pool_set(apt_message_parser_t *parser, apr_pool_t *pool);
+
 /** Set verbose mode for the parser */
 APT_DECLARE(void) apt_message_parser_verbose_set(apt_message_parser_t *parser, apt_bool_t verbose);
 
+/**
+ * Get the remaining part of the body the parser awaits, which can be received directly into.
+ * @param parser the parser
+ * @param buf the remaining part of the body buffer to receive into
+ * @return the remaining length of the body, or 0 if the parser awaits no body
+ */
+APT_DECLARE(apr_size_t) apt_message_parser_body_remaining_get(apt_message_parser_t *parser, char **buf);
+
+/** Advance the body by the length received directly into the remaining part of the body buffer */
+APT_DECLARE(void) apt_message_parser_body_advance(apt_message_parser_t *parser, apr_size_t length);
+
+/** Get the number of body bytes copied from the stream for the last (being) parsed message */
+APT_DECLARE(apr_size_t) apt_message_parser_copied_length_get(const apt_message_parser_t *parser);
+
 
 /** Create message generator */
 APT_DECLARE(apt_message_generator_t*) apt_message_generator_create(void *obj, const apt_message_generator_vtable_t *vtable, apr_pool_t *pool);
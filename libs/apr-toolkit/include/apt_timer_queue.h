@@ -21,7 +21,7 @@
 
 /**
  * @file apt_timer_queue.h
- * @brief Timer Queue
+ * @brief Timer Queue (Hierarchical Timing Wheel)
  */ 
 
 #include "apt.h"
@@ -37,9 +37,16 @@ typedef struct apt_timer_queue_t apt_timer_queue_t;
 typedef void (*apt_timer_proc_f)(apt_timer_t *timer, void *obj);
 
 
-/** Create timer queue */
+/** Create timer queue (1 time unit per tick) */
 APT_DECLARE(apt_timer_queue_t*) apt_timer_queue_create(apr_pool_t *pool);
 
+/**
+ * Create timer queue with the specified resolution.
+ * @param resolution the number of time units per tick (timeouts are rounded up to it)
+ * @param pool the pool to allocate memory from
+ */
+APT_DECLARE(apt_timer_queue_t*) apt_timer_queue_create_ex(apr_uint32_t resolution, apr_pool_t *pool);
+
 /** Destroy timer queue */
 APT_DECLARE(void) apt_timer_queue_destroy(apt_timer_queue_t *timer_queue);
 
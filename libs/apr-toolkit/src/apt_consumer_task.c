@@ -22,9 +22,10 @@
 #include "apt_log.h"
 
 struct apt_consumer_task_t {
-	void        *obj;
-	apt_task_t  *base;
-	apr_queue_t *msg_queue;
+	void                    *obj;
+	apt_task_t              *base;
+	apr_queue_t             *msg_queue;
+	apt_consumer_task_stat_t stat;
 };
 
 static apt_bool_t apt_consumer_task_msg_signal(apt_task_t *task, apt_task_msg_t *msg);
@@ -39,6 +40,7 @@ APT_DECLARE(apt_consumer_task_t*) apt_consumer_task_create(
 	apt_consumer_task_t *consumer_task = apr_palloc(pool,sizeof(apt_consumer_task_t));
 	consumer_task->obj = obj;
 	consumer_task->msg_queue = NULL;
+	memset(&consumer_task->stat,0,sizeof(apt_consumer_task_stat_t));
 	if(apr_queue_create(&consumer_task->msg_queue,1024,pool) != APR_SUCCESS) {
 		return NULL;
 	}
@@ -71,9 +73,16 @@ APT_DECLARE(void*) apt_consumer_task_object_get(const apt_consumer_task_t *task)
 	return task->obj;
 }
 
+APT_DECLARE(void) apt_consumer_task_stat_get(const apt_consumer_task_t *task, apt_consumer_task_stat_t *stat)
+{
+	*stat = task->stat;
+	stat->queue_size = apr_queue_size(task->msg_queue);
+}
+
 static apt_bool_t apt_consumer_task_msg_signal(apt_task_t *task, apt_task_msg_t *msg)
 {
 	apt_consumer_task_t *consumer_task = apt_task_object_get(task);
+	msg->queue_time = apr_time_now();
 	return (apr_queue_push(consumer_task->msg_queue,msg) == APR_SUCCESS) ? TRUE : FALSE;
 }
 
@@ -83,6 +92,9 @@ static apt_bool_t apt_consumer_task_run(apt_task_t *task)
 	void *msg;
 	apt_bool_t *running;
 	apt_consumer_task_t *consumer_task;
+	apt_consumer_task_stat_t *stat;
+	apr_uint32_t queue_size;
+	apr_interval_time_t latency;
 	consumer_task = apt_task_object_get(task);
 	if(!consumer_task) {
 		return FALSE;
@@ -93,12 +105,26 @@ static apt_bool_t apt_consumer_task_run(apt_task_t *task)
 		return FALSE;
 	}
 
+	stat = &consumer_task->stat;
 	while(*running) {
 		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Wait for Messages [%s]",apt_task_name_get(task));
 		rv = apr_queue_pop(consumer_task->msg_queue,&msg);
 		if(rv == APR_SUCCESS) {
 			if(msg) {
 				apt_task_msg_t *task_msg = msg;
+				/* the popped message is counted as well */
+				queue_size = apr_queue_size(consumer_task->msg_queue) + 1;
+				if(queue_size > stat->max_queue_size) {
+					stat->max_queue_size = queue_size;
+				}
+				latency = apr_time_now() - task_msg->queue_time;
+				if(latency > 0) {
+					stat->total_latency += latency;
+					if(latency > (apr_interval_time_t)stat->max_latency) {
+						stat->max_latency = (apr_uint32_t)latency;
+					}
+				}
+				stat->msg_count++;
 				apt_task_msg_process(consumer_task->base,task_msg);
 			}
 		}
@@ -102,6 +102,17 @@ APT_DECLARE(apt_header_field_t*) apt_header_field_copy(const apt_header_field_t
 	return header_field;
 }
 
+/** Create header field sharing name and value with specified header field */
+APT_DECLARE(apt_header_field_t*) apt_header_field_share(const apt_header_field_t *src_header_field, apr_pool_t *pool)
+{
+	apt_header_field_t *header_field = apr_palloc(pool,sizeof(apt_header_field_t));
+	header_field->name = src_header_field->name;
+	header_field->value = src_header_field->value;
+	header_field->id = src_header_field->id;
+	APR_RING_ELEM_INIT(header_field,link);
+	return header_field;
+}
+
 /** Initialize header section (collection of header fields) */
 APT_DECLARE(void) apt_header_section_init(apt_header_section_t *header)
 {
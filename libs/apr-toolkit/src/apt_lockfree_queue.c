@@ -0,0 +1,224 @@
+/*
+ * Copyright 2008-2010 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <apr_atomic.h>
+#include <apr_thread_mutex.h>
+#include "apt_lockfree_queue.h"
+#include "apt_cyclic_queue.h"
+
+/*
+ * Each cell carries a sequence number telling whose turn it is:
+ *   seq == pos       the cell is free for the producer claiming position pos
+ *   seq == pos + 1   the cell holds the object pushed at position pos
+ * Producers claim positions by CAS on the tail, the only consumer advances
+ * the head without any atomic read-modify-write on the shared counters.
+ *
+ * A queue created with an overflow list spills the objects to the list once
+ * the ring is full, and keeps spilling as long as the list is not drained,
+ * so the objects of each producer still come out in the order pushed.
+ */
+
+/** Queue cell */
+typedef struct apt_lockfree_cell_t apt_lockfree_cell_t;
+struct apt_lockfree_cell_t {
+	volatile apr_uint32_t seq;
+	void                 *obj;
+};
+
+struct apt_lockfree_queue_t {
+	apt_lockfree_cell_t  *cells;
+	apr_uint32_t          mask;
+	/** Next position to push to (shared by producers) */
+	volatile apr_uint32_t tail;
+	/** Next position to pop from (owned by the consumer) */
+	volatile apr_uint32_t head;
+	/** Number of objects rejected or spilled since the queue was full */
+	volatile apr_uint32_t overflow_count;
+
+	/** Overflow list (NULL if the queue is bounded) */
+	apt_cyclic_queue_t   *overflow_list;
+	apr_thread_mutex_t   *overflow_guard;
+	/** Number of objects in the overflow list */
+	volatile apr_uint32_t overflow_size;
+};
+
+/** Read with full memory barrier (plain atomic read implies none) */
+static APR_INLINE apr_uint32_t apt_lockfree_seq_get(volatile apr_uint32_t *seq)
+{
+	return apr_atomic_cas32(seq,0,0);
+}
+
+APT_DECLARE(apt_lockfree_queue_t*) apt_lockfree_queue_create(apr_size_t size, apr_pool_t *pool)
+{
+	return apt_lockfree_queue_create_ex(size,FALSE,pool);
+}
+
+APT_DECLARE(apt_lockfree_queue_t*) apt_lockfree_queue_create_ex(apr_size_t size, apt_bool_t overflow_list, apr_pool_t *pool)
+{
+	apr_uint32_t i;
+	apr_uint32_t capacity = 2;
+	apt_lockfree_queue_t *queue = apr_palloc(pool,sizeof(apt_lockfree_queue_t));
+	while(capacity < size && capacity < 0x40000000) {
+		capacity <<= 1;
+	}
+
+	queue->cells = apr_palloc(pool,sizeof(apt_lockfree_cell_t) * capacity);
+	for(i=0; i<capacity; i++) {
+		queue->cells[i].seq = i;
+		queue->cells[i].obj = NULL;
+	}
+	queue->mask = capacity - 1;
+	apr_atomic_set32(&queue->tail,0);
+	apr_atomic_set32(&queue->head,0);
+	apr_atomic_set32(&queue->overflow_count,0);
+
+	queue->overflow_list = NULL;
+	queue->overflow_guard = NULL;
+	apr_atomic_set32(&queue->overflow_size,0);
+	if(overflow_list == TRUE) {
+		if(apr_thread_mutex_create(&queue->overflow_guard,APR_THREAD_MUTEX_UNNESTED,pool) != APR_SUCCESS) {
+			return NULL;
+		}
+		queue->overflow_list = apt_cyclic_queue_create(CYCLIC_QUEUE_DEFAULT_SIZE);
+	}
+	return queue;
+}
+
+APT_DECLARE(void) apt_lockfree_queue_destroy(apt_lockfree_queue_t *queue)
+{
+	queue->cells = NULL;
+	if(queue->overflow_list) {
+		apt_cyclic_queue_destroy(queue->overflow_list);
+		queue->overflow_list = NULL;
+	}
+	if(queue->overflow_guard) {
+		apr_thread_mutex_destroy(queue->overflow_guard);
+		queue->overflow_guard = NULL;
+	}
+}
+
+/** Push object to the overflow list */
+static apt_bool_t apt_lockfree_queue_spill(apt_lockfree_queue_t *queue, void *obj)
+{
+	apt_bool_t status;
+	apr_thread_mutex_lock(queue->overflow_guard);
+	status = apt_cyclic_queue_push(queue->overflow_list,obj);
+	if(status == TRUE) {
+		apr_atomic_inc32(&queue->overflow_size);
+	}
+	apr_thread_mutex_unlock(queue->overflow_guard);
+	return status;
+}
+
+/** Pop object from the overflow list */
+static void* apt_lockfree_queue_unspill(apt_lockfree_queue_t *queue)
+{
+	void *obj;
+	apr_thread_mutex_lock(queue->overflow_guard);
+	obj = apt_cyclic_queue_pop(queue->overflow_list);
+	if(obj) {
+		apr_atomic_dec32(&queue->overflow_size);
+	}
+	apr_thread_mutex_unlock(queue->overflow_guard);
+	return obj;
+}
+
+APT_DECLARE(apt_bool_t) apt_lockfree_queue_push(apt_lockfree_queue_t *queue, void *obj)
+{
+	apt_lockfree_cell_t *cell;
+	apr_uint32_t pos = apr_atomic_read32(&queue->tail);
+	apr_int32_t diff;
+
+	if(queue->overflow_list && apr_atomic_read32(&queue->overflow_size)) {
+		/* keep spilling until the overflow list is drained */
+		apr_atomic_inc32(&queue->overflow_count);
+		return apt_lockfree_queue_spill(queue,obj);
+	}
+
+	for(;;) {
+		cell = &queue->cells[pos & queue->mask];
+		diff = (apr_int32_t)(apt_lockfree_seq_get(&cell->seq) - pos);
+		if(diff == 0) {
+			/* the cell is free, try to claim the position */
+			apr_uint32_t cur = apr_atomic_cas32(&queue->tail,pos+1,pos);
+			if(cur == pos) {
+				break;
+			}
+			pos = cur;
+		}
+		else if(diff < 0) {
+			/* the cell still holds an object pushed one lap before */
+			apr_atomic_inc32(&queue->overflow_count);
+			if(queue->overflow_list) {
+				return apt_lockfree_queue_spill(queue,obj);
+			}
+			return FALSE;
+		}
+		else {
+			/* another producer claimed the position */
+			pos = apr_atomic_read32(&queue->tail);
+		}
+	}
+
+	cell->obj = obj;
+	/* publish the object to the consumer */
+	apr_atomic_xchg32(&cell->seq,pos+1);
+	return TRUE;
+}
+
+APT_DECLARE(void*) apt_lockfree_queue_pop(apt_lockfree_queue_t *queue)
+{
+	void *obj;
+	apr_uint32_t pos = queue->head;
+	apt_lockfree_cell_t *cell = &queue->cells[pos & queue->mask];
+	if(apt_lockfree_seq_get(&cell->seq) != pos+1) {
+		/* empty or the object is not published yet */
+		if(queue->overflow_list && apr_atomic_read32(&queue->overflow_size) &&
+			apt_lockfree_seq_get(&queue->tail) == pos) {
+			/* the ring is drained, the spilled objects are next */
+			return apt_lockfree_queue_unspill(queue);
+		}
+		return NULL;
+	}
+
+	obj = cell->obj;
+	queue->head = pos + 1;
+	/* release the cell for the producers of the next lap */
+	apr_atomic_xchg32(&cell->seq,pos+queue->mask+1);
+	return obj;
+}
+
+APT_DECLARE(apt_bool_t) apt_lockfree_queue_is_empty(const apt_lockfree_queue_t *queue)
+{
+	apr_uint32_t pos = queue->head;
+	const apt_lockfree_cell_t *cell = &queue->cells[pos & queue->mask];
+	if(cell->seq == pos+1) {
+		return FALSE;
+	}
+	return (queue->overflow_size == 0) ? TRUE : FALSE;
+}
+
+APT_DECLARE(apr_size_t) apt_lockfree_queue_capacity_get(const apt_lockfree_queue_t *queue)
+{
+	return (apr_size_t)queue->mask + 1;
+}
+
+APT_DECLARE(apr_uint32_t) apt_lockfree_queue_overflow_count_get(const apt_lockfree_queue_t *queue)
+{
+	return queue->overflow_count;
+}
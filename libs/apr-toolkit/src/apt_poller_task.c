@@ -19,26 +19,25 @@
 #include "apt_poller_task.h"
 #include "apt_task.h"
 #include "apt_pool.h"
-#include "apt_cyclic_queue.h"
+#include "apt_lockfree_queue.h"
 #include "apt_log.h"
 
 
 /** Poller task */
 struct apt_poller_task_t {
-	apr_pool_t         *pool;
-	apt_task_t         *base;
+	apr_pool_t           *pool;
+	apt_task_t           *base;
 	
-	void               *obj;
-	apt_poll_signal_f   signal_handler;
+	void                 *obj;
+	apt_poll_signal_f     signal_handler;
 
-	apr_thread_mutex_t *guard;
-	apt_cyclic_queue_t *msg_queue;
-	apt_pollset_t      *pollset;
-	apt_timer_queue_t  *timer_queue;
+	apt_lockfree_queue_t *msg_queue;
+	apt_pollset_t        *pollset;
+	apt_timer_queue_t    *timer_queue;
 
-	apr_pollfd_t       *desc_arr;
-	apr_int32_t         desc_count;
-	apr_int32_t         desc_index;
+	apr_pollfd_t         *desc_arr;
+	apr_int32_t           desc_count;
+	apr_int32_t           desc_index;
 
 };
 
@@ -88,8 +87,7 @@ APT_DECLARE(apt_poller_task_t*) apt_poller_task_create(
 	}
 	apt_task_auto_ready_set(task->base,FALSE);
 
-	task->msg_queue = apt_cyclic_queue_create(CYCLIC_QUEUE_DEFAULT_SIZE);
-	apr_thread_mutex_create(&task->guard,APR_THREAD_MUTEX_UNNESTED,pool);
+	task->msg_queue = apt_lockfree_queue_create_ex(LOCKFREE_QUEUE_DEFAULT_SIZE,TRUE,pool);
 
 	task->timer_queue = apt_timer_queue_create(pool);
 	task->desc_arr = NULL;
@@ -111,12 +109,8 @@ APT_DECLARE(void) apt_poller_task_cleanup(apt_poller_task_t *task)
 		apt_pollset_destroy(task->pollset);
 		task->pollset = NULL;
 	}
-	if(task->guard) {
-		apr_thread_mutex_destroy(task->guard);
-		task->guard = NULL;
-	}
 	if(task->msg_queue) {
-		apt_cyclic_queue_destroy(task->msg_queue);
+		apt_lockfree_queue_destroy(task->msg_queue);
 		task->msg_queue = NULL;
 	}
 }
@@ -201,9 +195,7 @@ static apt_bool_t apt_poller_task_wakeup_process(apt_poller_task_t *task)
 	apt_task_msg_t *msg;
 
 	do {
-		apr_thread_mutex_lock(task->guard);
-		msg = apt_cyclic_queue_pop(task->msg_queue);
-		apr_thread_mutex_unlock(task->guard);
+		msg = apt_lockfree_queue_pop(task->msg_queue);
 		if(msg) {
 			apt_task_msg_process(task->base,msg);
 		}
@@ -285,9 +277,14 @@ static apt_bool_t apt_poller_task_msg_signal(apt_task_t *base, apt_task_msg_t *m
 {
 	apt_bool_t status;
 	apt_poller_task_t *task = apt_task_object_get(base);
-	apr_thread_mutex_lock(task->guard);
-	status = apt_cyclic_queue_push(task->msg_queue,msg);
-	apr_thread_mutex_unlock(task->guard);
+	status = apt_lockfree_queue_push(task->msg_queue,msg);
+	if(status == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_ERROR,"Failed to Queue Message [%s] overflows [%u]",
+			apt_task_name_get(base),
+			apt_lockfree_queue_overflow_count_get(task->msg_queue));
+		apt_task_msg_release(msg);
+		return FALSE;
+	}
 	if(apt_pollset_wakeup(task->pollset) != TRUE) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Signal Control Message");
 		status = FALSE;
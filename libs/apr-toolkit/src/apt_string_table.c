@@ -66,3 +66,46 @@ APT_DECLARE(apr_size_t) apt_string_table_id_find(const apt_str_table_item_t tabl
 	/* no match found, return invalid id */
 	return size;
 }
+
+/* Compute the hash of a given string over the length and the key characters */
+APT_DECLARE(apr_uint32_t) apt_string_table_hash_compute(const apt_str_table_hash_t *hash, const apt_str_t *value, apr_uint32_t seed)
+{
+	/* FNV-1a over the length and the key characters */
+	apr_uint32_t h = (2166136261U ^ seed) * 16777619U;
+	apr_size_t i;
+	int pos;
+	h = (h ^ (apr_uint32_t)value->length) * 16777619U;
+	for(i=0; i<hash->key_count; i++) {
+		pos = hash->keys[i];
+		if(pos < 0) {
+			pos += (int)value->length;
+		}
+		/* out of range key character is taken as 0 */
+		if(pos >= 0 && (apr_size_t)pos < value->length) {
+			h = (h ^ (apr_uint32_t)tolower((unsigned char)value->buf[pos])) * 16777619U;
+		}
+		else {
+			h = h * 16777619U;
+		}
+	}
+	h ^= h >> 16;
+	return h;
+}
+
+/* Find the id associated with a given string using perfect hash of the table */
+APT_DECLARE(apr_size_t) apt_string_table_hash_id_find(const apt_str_table_item_t table[], apr_size_t size, const apt_str_table_hash_t *hash, const apt_str_t *value)
+{
+	apr_size_t bucket;
+	apr_size_t id;
+	if(!hash || hash->size != size || !size) {
+		return apt_string_table_id_find(table,size,value);
+	}
+
+	bucket = apt_string_table_hash_compute(hash,value,0) % size;
+	id = hash->ids[apt_string_table_hash_compute(hash,value,hash->seeds[bucket]) % size];
+	/* the only candidate must be compared as a whole (unknown strings map to some slot too) */
+	if(id < size && apt_string_compare(&table[id].value,value) == TRUE) {
+		return id;
+	}
+	return size;
+}
@@ -109,6 +109,10 @@ APT_DECLARE(apt_bool_t) apt_task_destroy(apt_task_t *task)
 		task->vtable.destroy(task);
 	}
 	
+	if(task->msg_pool) {
+		apt_task_msg_pool_destroy(task->msg_pool);
+		task->msg_pool = NULL;
+	}
 	apr_thread_mutex_destroy(task->data_guard);
 	return TRUE;
 }
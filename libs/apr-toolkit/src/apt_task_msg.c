@@ -17,7 +17,11 @@
  */
 
 #include <stdlib.h>
+#include <apr_atomic.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
 #include "apt_task_msg.h"
+#include "apt_log.h"
 
 /** Abstract pool of task messages to allocate task messages from */
 struct apt_task_msg_pool_t {
@@ -28,6 +32,12 @@ struct apt_task_msg_pool_t {
 
 	void       *obj;
 	apr_pool_t *pool;
+
+	/** Usage counters (maintained by static pool only) */
+	volatile apr_uint32_t in_use_count;
+	volatile apr_uint32_t high_water_mark;
+	volatile apr_uint32_t exhaustion_count;
+	apr_size_t            capacity;
 };
 
 
@@ -71,16 +81,296 @@ APT_DECLARE(apt_task_msg_pool_t*) apt_task_msg_pool_create_dynamic(apr_size_t ms
 	task_msg_pool->acquire_msg = dynamic_pool_acquire_msg;
 	task_msg_pool->release_msg = dynamic_pool_release_msg;
 	task_msg_pool->destroy = dynamic_pool_destroy;
+	task_msg_pool->capacity = 0;
+	task_msg_pool->in_use_count = 0;
+	task_msg_pool->high_water_mark = 0;
+	task_msg_pool->exhaustion_count = 0;
 	return task_msg_pool;
 }
 
 
-/** Static allocation of messages from message pool (not implemented yet) */
-APT_DECLARE(apt_task_msg_pool_t*) apt_task_msg_pool_create_static(apr_size_t msg_size, apr_size_t pool_size, apr_pool_t *pool)
+/** Max number of messages cached per thread */
+#define MSG_CACHE_SIZE  32
+/** Number of messages moved between thread cache and global free list at once */
+#define MSG_CACHE_BATCH 16
+
+/** Static allocation of messages (fixed-size messages preallocated at once) */
+typedef struct apt_msg_pool_static_t apt_msg_pool_static_t;
+/** Per-thread cache of free messages */
+typedef struct apt_msg_cache_t apt_msg_cache_t;
+
+struct apt_msg_cache_t {
+	/** Pool the cache belongs to */
+	apt_msg_pool_static_t *owner;
+	/** List of all the caches of the pool */
+	apt_msg_cache_t       *prev;
+	apt_msg_cache_t       *next;
+
+	apr_size_t             count;
+	apt_task_msg_t        *msgs[MSG_CACHE_SIZE];
+};
+
+struct apt_msg_pool_static_t {
+	apt_task_msg_pool_t   *base;
+	/** Size of a single (aligned) message */
+	apr_size_t             size;
+	/** Preallocated block of messages */
+	char                  *block;
+	char                  *block_end;
+
+	/** Global free list guarded by the mutex */
+	apr_thread_mutex_t    *guard;
+	apt_task_msg_t       **free_msgs;
+	apr_size_t             free_count;
+
+	/** Per-thread caches */
+	apr_threadkey_t       *cache_key;
+	apt_msg_cache_t       *caches;
+};
+
+/** Return cached messages of the exited thread to the global free list */
+static void static_pool_cache_destroy(void *data)
 {
-	return NULL;
+	apt_msg_cache_t *cache = data;
+	apt_msg_pool_static_t *static_pool;
+	if(!cache) {
+		return;
+	}
+
+	static_pool = cache->owner;
+	apr_thread_mutex_lock(static_pool->guard);
+	memcpy(static_pool->free_msgs + static_pool->free_count,cache->msgs,sizeof(apt_task_msg_t*) * cache->count);
+	static_pool->free_count += cache->count;
+	if(cache->prev) {
+		cache->prev->next = cache->next;
+	}
+	else {
+		static_pool->caches = cache->next;
+	}
+	if(cache->next) {
+		cache->next->prev = cache->prev;
+	}
+	apr_thread_mutex_unlock(static_pool->guard);
+	free(cache);
 }
 
+static apt_msg_cache_t* static_pool_cache_get(apt_msg_pool_static_t *static_pool)
+{
+	apt_msg_cache_t *cache = NULL;
+	if(!static_pool->cache_key) {
+		return NULL;
+	}
+	if(apr_threadkey_private_get((void**)&cache,static_pool->cache_key) == APR_SUCCESS && cache) {
+		return cache;
+	}
+
+	cache = malloc(sizeof(apt_msg_cache_t));
+	if(!cache) {
+		return NULL;
+	}
+	cache->owner = static_pool;
+	cache->count = 0;
+	cache->prev = NULL;
+	if(apr_threadkey_private_set(cache,static_pool->cache_key) != APR_SUCCESS) {
+		free(cache);
+		return NULL;
+	}
+
+	apr_thread_mutex_lock(static_pool->guard);
+	cache->next = static_pool->caches;
+	if(cache->next) {
+		cache->next->prev = cache;
+	}
+	static_pool->caches = cache;
+	apr_thread_mutex_unlock(static_pool->guard);
+	return cache;
+}
+
+/** Move up to a batch of messages from the global free list to the thread cache */
+static void static_pool_cache_refill(apt_msg_pool_static_t *static_pool, apt_msg_cache_t *cache)
+{
+	apr_size_t count;
+	apr_thread_mutex_lock(static_pool->guard);
+	count = static_pool->free_count < MSG_CACHE_BATCH ? static_pool->free_count : MSG_CACHE_BATCH;
+	static_pool->free_count -= count;
+	memcpy(cache->msgs + cache->count,static_pool->free_msgs + static_pool->free_count,sizeof(apt_task_msg_t*) * count);
+	apr_thread_mutex_unlock(static_pool->guard);
+	cache->count += count;
+}
+
+/** Move a batch of messages from the thread cache back to the global free list */
+static void static_pool_cache_flush(apt_msg_pool_static_t *static_pool, apt_msg_cache_t *cache)
+{
+	cache->count -= MSG_CACHE_BATCH;
+	apr_thread_mutex_lock(static_pool->guard);
+	memcpy(static_pool->free_msgs + static_pool->free_count,cache->msgs + cache->count,sizeof(apt_task_msg_t*) * MSG_CACHE_BATCH);
+	static_pool->free_count += MSG_CACHE_BATCH;
+	apr_thread_mutex_unlock(static_pool->guard);
+}
+
+static apt_task_msg_t* static_pool_acquire_msg(apt_task_msg_pool_t *task_msg_pool)
+{
+	apt_msg_pool_static_t *static_pool = task_msg_pool->obj;
+	apt_msg_cache_t *cache = static_pool_cache_get(static_pool);
+	apt_task_msg_t *task_msg = NULL;
+	apr_uint32_t in_use_count;
+	apr_uint32_t high_water_mark;
+
+	if(cache) {
+		if(!cache->count) {
+			static_pool_cache_refill(static_pool,cache);
+		}
+		if(cache->count) {
+			task_msg = cache->msgs[--cache->count];
+		}
+	}
+	else {
+		apr_thread_mutex_lock(static_pool->guard);
+		if(static_pool->free_count) {
+			task_msg = static_pool->free_msgs[--static_pool->free_count];
+		}
+		apr_thread_mutex_unlock(static_pool->guard);
+	}
+
+	if(!task_msg) {
+		/* pool is exhausted, fall back to dynamic allocation */
+		apr_atomic_inc32(&task_msg_pool->exhaustion_count);
+		task_msg = malloc(static_pool->size);
+		if(!task_msg) {
+			return NULL;
+		}
+	}
+
+	in_use_count = apr_atomic_inc32(&task_msg_pool->in_use_count) + 1;
+	high_water_mark = apr_atomic_read32(&task_msg_pool->high_water_mark);
+	while(in_use_count > high_water_mark) {
+		apr_uint32_t cur = apr_atomic_cas32(&task_msg_pool->high_water_mark,in_use_count,high_water_mark);
+		if(cur == high_water_mark) {
+			break;
+		}
+		high_water_mark = cur;
+	}
+
+	task_msg->msg_pool = task_msg_pool;
+	task_msg->type = TASK_MSG_USER;
+	task_msg->sub_type = 0;
+	return task_msg;
+}
+
+static void static_pool_release_msg(apt_task_msg_t *task_msg)
+{
+	apt_task_msg_pool_t *task_msg_pool = task_msg->msg_pool;
+	apt_msg_pool_static_t *static_pool = task_msg_pool->obj;
+	apt_msg_cache_t *cache;
+
+	apr_atomic_dec32(&task_msg_pool->in_use_count);
+	if((char*)task_msg < static_pool->block || (char*)task_msg >= static_pool->block_end) {
+		/* allocated dynamically while the pool was exhausted */
+		free(task_msg);
+		return;
+	}
+
+	cache = static_pool_cache_get(static_pool);
+	if(cache) {
+		if(cache->count == MSG_CACHE_SIZE) {
+			static_pool_cache_flush(static_pool,cache);
+		}
+		cache->msgs[cache->count++] = task_msg;
+	}
+	else {
+		apr_thread_mutex_lock(static_pool->guard);
+		static_pool->free_msgs[static_pool->free_count++] = task_msg;
+		apr_thread_mutex_unlock(static_pool->guard);
+	}
+}
+
+/** Release the resources of static pool, invoked on destroy or, failing that, on destruction of the APR pool */
+static apr_status_t static_pool_cleanup(void *data)
+{
+	apt_task_msg_pool_t *task_msg_pool = data;
+	apt_msg_pool_static_t *static_pool = task_msg_pool->obj;
+	apt_msg_cache_t *cache;
+
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Destroy Task Msg Pool [%"APR_SIZE_T_FMT"] High Water Mark [%u] Exhausted [%u]",
+		task_msg_pool->capacity,
+		task_msg_pool->high_water_mark,
+		task_msg_pool->exhaustion_count);
+
+	if(static_pool->cache_key) {
+		/* no more destructors are invoked on thread exit after the key is deleted */
+		apr_threadkey_private_delete(static_pool->cache_key);
+		static_pool->cache_key = NULL;
+	}
+	while(static_pool->caches) {
+		cache = static_pool->caches;
+		static_pool->caches = cache->next;
+		free(cache);
+	}
+	if(static_pool->guard) {
+		apr_thread_mutex_destroy(static_pool->guard);
+		static_pool->guard = NULL;
+	}
+	return APR_SUCCESS;
+}
+
+static void static_pool_destroy(apt_task_msg_pool_t *task_msg_pool)
+{
+	/* run the cleanup now and unregister it, so it isn't invoked once again */
+	apr_pool_cleanup_run(task_msg_pool->pool,task_msg_pool,static_pool_cleanup);
+}
+
+APT_DECLARE(apt_task_msg_pool_t*) apt_task_msg_pool_create_static(apr_size_t msg_size, apr_size_t pool_size, apr_pool_t *pool)
+{
+	apr_size_t i;
+	apt_task_msg_pool_t *task_msg_pool;
+	apt_msg_pool_static_t *static_pool;
+
+	if(!pool_size) {
+		pool_size = TASK_MSG_POOL_DEFAULT_SIZE;
+	}
+
+	task_msg_pool = apr_palloc(pool,sizeof(apt_task_msg_pool_t));
+	static_pool = apr_palloc(pool,sizeof(apt_msg_pool_static_t));
+	static_pool->base = task_msg_pool;
+	static_pool->size = APR_ALIGN_DEFAULT(msg_size + sizeof(apt_task_msg_t) - 1);
+	static_pool->block = apr_palloc(pool,static_pool->size * pool_size);
+	static_pool->block_end = static_pool->block + static_pool->size * pool_size;
+	static_pool->guard = NULL;
+	static_pool->caches = NULL;
+	static_pool->cache_key = NULL;
+
+	if(apr_thread_mutex_create(&static_pool->guard,APR_THREAD_MUTEX_UNNESTED,pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Task Msg Pool Mutex");
+		return apt_task_msg_pool_create_dynamic(msg_size,pool);
+	}
+	if(apr_threadkey_private_create(&static_pool->cache_key,static_pool_cache_destroy,pool) != APR_SUCCESS) {
+		/* still operational, just all the threads share the global free list */
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Task Msg Pool Thread Key");
+		static_pool->cache_key = NULL;
+	}
+
+	/* the global free list must hold every message, including those cached by threads */
+	static_pool->free_msgs = apr_palloc(pool,sizeof(apt_task_msg_t*) * pool_size);
+	for(i=0; i<pool_size; i++) {
+		static_pool->free_msgs[i] = (apt_task_msg_t*)(static_pool->block + static_pool->size * (pool_size - i - 1));
+	}
+	static_pool->free_count = pool_size;
+
+	task_msg_pool->pool = pool;
+	task_msg_pool->obj = static_pool;
+	task_msg_pool->acquire_msg = static_pool_acquire_msg;
+	task_msg_pool->release_msg = static_pool_release_msg;
+	task_msg_pool->destroy = static_pool_destroy;
+	task_msg_pool->capacity = pool_size;
+	apr_atomic_set32(&task_msg_pool->in_use_count,0);
+	apr_atomic_set32(&task_msg_pool->high_water_mark,0);
+	apr_atomic_set32(&task_msg_pool->exhaustion_count,0);
+
+	/* the thread key must be deleted before the memory of the pool goes away,
+	otherwise the cache destructor is invoked on exit of a thread against freed memory */
+	apr_pool_cleanup_register(pool,task_msg_pool,static_pool_cleanup,apr_pool_cleanup_null);
+	return task_msg_pool;
+}
 
 
 APT_DECLARE(void) apt_task_msg_pool_destroy(apt_task_msg_pool_t *msg_pool)
@@ -90,6 +380,14 @@ APT_DECLARE(void) apt_task_msg_pool_destroy(apt_task_msg_pool_t *msg_pool)
 	}
 }
 
+APT_DECLARE(void) apt_task_msg_pool_stat_get(const apt_task_msg_pool_t *msg_pool, apt_task_msg_pool_stat_t *stat)
+{
+	stat->capacity = msg_pool->capacity;
+	stat->in_use_count = msg_pool->in_use_count;
+	stat->high_water_mark = msg_pool->high_water_mark;
+	stat->exhaustion_count = msg_pool->exhaustion_count;
+}
+
 APT_DECLARE(apt_task_msg_t*) apt_task_msg_acquire(apt_task_msg_pool_t *task_msg_pool)
 {
 	if(!task_msg_pool->acquire_msg)
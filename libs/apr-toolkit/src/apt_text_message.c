@@ -34,6 +34,7 @@ struct apt_message_parser_t {
 	apr_pool_t                        *pool;
 	apt_message_context_t              context;
 	apr_size_t                         content_length;
+	apr_size_t                         copied_length;
 	apt_message_stage_e                stage;
 	apt_bool_t                         skip_lf;
 	apt_bool_t                         verbose;
@@ -178,6 +179,7 @@ static apt_bool_t apt_message_body_read(apt_message_parser_t *parser, apt_text_s
 		memcpy(body->buf + body->length, stream->pos, required_length);
 		body->length += required_length;
 		stream->pos += required_length;
+		parser->copied_length += required_length;
 		if(parser->verbose == TRUE) {
 			apr_size_t length = required_length;
 			const char *masked_data = apt_log_data_mask(stream->pos,&length,parser->pool);
@@ -232,6 +234,7 @@ APT_DECLARE(apt_message_parser_t*) apt_message_parser_create(void *obj, const ap
 	parser->context.body = NULL;
 	parser->context.header = NULL;
 	parser->content_length = 0;
+	parser->copied_length = 0;
 	parser->stage = APT_MESSAGE_STAGE_START_LINE;
 	parser->skip_lf = FALSE;
 	parser->verbose = FALSE;
@@ -294,10 +297,13 @@ APT_DECLARE(apt_message_status_e) apt_message_parser_run(apt_message_parser_t *p
 			if(parser->vtable->on_header_complete) {
 				if(parser->vtable->on_header_complete(parser,&parser->context) == FALSE) {
 					status = APT_MESSAGE_STATUS_INVALID;
+					/* do not refer to the invalid message any longer */
+					parser->stage = APT_MESSAGE_STAGE_START_LINE;
 					break;
 				}
 			}
 			
+			parser->copied_length = 0;
 			if(parser->context.body && parser->context.body->length) {
 				apt_str_t *body = parser->context.body;
 				parser->content_length = body->length;
@@ -349,6 +355,46 @@ APT_DECLARE(void) apt_message_parser_verbose_set(apt_message_parser_t *parser, a
 	parser->verbose = verbose;
 }
 
+/** Set pool to allocate the messages being parsed from */
+APT_DECLARE(void) apt_message_parser_pool_set(apt_message_parser_t *parser, apr_pool_t *pool)
+{
+	parser->pool = pool;
+}
+
+/** Get the remaining part of the body the parser awaits */
+APT_DECLARE(apr_size_t) apt_message_parser_body_remaining_get(apt_message_parser_t *parser, char **buf)
+{
+	apt_str_t *body = parser->context.body;
+	if(parser->stage != APT_MESSAGE_STAGE_BODY || !body || !body->buf) {
+		return 0;
+	}
+	if(parser->skip_lf == TRUE) {
+		/* <LF> split from the header section must be skipped from the stream first */
+		return 0;
+	}
+	*buf = body->buf + body->length;
+	return parser->content_length - body->length;
+}
+
+/** Advance the body by the length received directly */
+APT_DECLARE(void) apt_message_parser_body_advance(apt_message_parser_t *parser, apr_size_t length)
+{
+	apt_str_t *body = parser->context.body;
+	if(parser->stage != APT_MESSAGE_STAGE_BODY || !body || !body->buf) {
+		return;
+	}
+	if(body->length + length > parser->content_length) {
+		length = parser->content_length - body->length;
+	}
+	body->length += length;
+}
+
+/** Get the number of body bytes copied from the stream */
+APT_DECLARE(apr_size_t) apt_message_parser_copied_length_get(const apt_message_parser_t *parser)
+{
+	return parser->copied_length;
+}
+
 
 /** Create message generator */
 APT_DECLARE(apt_message_generator_t*) apt_message_generator_create(void *obj, const apt_message_generator_vtable_t *vtable, apr_pool_t *pool)
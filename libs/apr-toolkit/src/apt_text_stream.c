@@ -26,46 +26,75 @@
 #define TOKEN_TRUE_LENGTH  (sizeof(TOKEN_TRUE)-1)
 #define TOKEN_FALSE_LENGTH (sizeof(TOKEN_FALSE)-1)
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define APT_TEXT_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#ifdef APT_TEXT_SSE2
+/** Get the index of the lowest set bit of a non-zero mask */
+static APR_INLINE int apt_text_mask_index(int mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index,(unsigned long)mask);
+	return (int)index;
+#else
+	return __builtin_ctz((unsigned int)mask);
+#endif
+}
+#endif
 
-/** Navigate through the lines of the text stream (message) */
-APT_DECLARE(apt_bool_t) apt_text_line_read(apt_text_stream_t *stream, apt_str_t *line)
+/** Find the first occurrence of either of two chars, return end if there is none */
+static APR_INLINE char* apt_text_chars_find(char *pos, const char *end, char ch1, char ch2)
 {
-	char *pos = stream->pos;
-	apt_bool_t status = FALSE;
-	line->length = 0;
-	line->buf = pos;
-	/* while not end of stream */
-	while(pos < stream->end) {
-		if(*pos == APT_TOKEN_CR) {
-			/* end of line detected */
-			line->length = pos - line->buf;
-			pos++;
-			if(pos < stream->end && *pos == APT_TOKEN_LF) {
-				pos++;
-			}
-			status = TRUE;
-			break;
+#ifdef APT_TEXT_SSE2
+	/* compare 16 chars at once (the tail is scanned char by char) */
+	const __m128i v1 = _mm_set1_epi8(ch1);
+	const __m128i v2 = _mm_set1_epi8(ch2);
+	__m128i chunk;
+	int mask;
+	while(end - pos >= 16) {
+		chunk = _mm_loadu_si128((const __m128i*)pos);
+		mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk,v1),_mm_cmpeq_epi8(chunk,v2)));
+		if(mask) {
+			return pos + apt_text_mask_index(mask);
 		}
-		else if(*pos == APT_TOKEN_LF) {
-			/* end of line detected */
-			line->length = pos - line->buf;
-			pos++;
-			status = TRUE;
-			break;
-		}
-		pos++;
+		pos += 16;
 	}
+#endif
+	while(pos < end && *pos != ch1 && *pos != ch2) pos++;
+	return pos;
+}
 
-	if(status == TRUE) {
-		/* advance stream pos */
-		stream->pos = pos;
+/** Skip end of line (CR, LF or CRLF) the given pos points to */
+static APR_INLINE char* apt_text_eol_skip(char *pos, const char *end)
+{
+	if(*pos++ == APT_TOKEN_CR && pos < end && *pos == APT_TOKEN_LF) {
+		pos++;
 	}
-	else {
+	return pos;
+}
+
+
+/** Navigate through the lines of the text stream (message) */
+APT_DECLARE(apt_bool_t) apt_text_line_read(apt_text_stream_t *stream, apt_str_t *line)
+{
+	char *pos = apt_text_chars_find(stream->pos,stream->end,APT_TOKEN_CR,APT_TOKEN_LF);
+	line->buf = stream->pos;
+	line->length = pos - line->buf;
+	if(pos == stream->end) {
 		/* end of stream is reached, do not advance stream pos, but set is_eos flag */
 		stream->is_eos = TRUE;
-		line->length = pos - line->buf;
+		return FALSE;
 	}
-	return status;
+
+	/* end of line detected, advance stream pos */
+	stream->pos = apt_text_eol_skip(pos,stream->end);
+	return TRUE;
 }
 
 /** To be used to navigate through the header fields (name:value pairs) of the text stream (message) 
@@ -83,68 +112,46 @@ APT_DECLARE(apt_bool_t) apt_text_line_read(apt_text_stream_t *stream, apt_str_t
 APT_DECLARE(apt_bool_t) apt_text_header_read(apt_text_stream_t *stream, apt_pair_t *pair)
 {
 	char *pos = stream->pos;
-	apt_bool_t status = FALSE;
+	char *eol;
+	char *separator;
 	apt_string_reset(&pair->name);
 	apt_string_reset(&pair->value);
-	/* while not end of stream */
-	while(pos < stream->end) {
-		if(*pos == APT_TOKEN_CR) {
-			/* end of line detected */
-			if(pair->value.buf) {
-				/* set length of the value */
-				pair->value.length = pos - pair->value.buf;
-			}
-			pos++;
-			if(pos < stream->end && *pos == APT_TOKEN_LF) {
-				pos++;
-			}
-			status = TRUE;
-			break;
-		}
-		else if(*pos == APT_TOKEN_LF) {
-			/* end of line detected */
-			if(pair->value.buf) {
-				/* set length of the value */
-				pair->value.length = pos - pair->value.buf;
-			}
-			pos++;
-			status = TRUE;
-			break;
-		}
-		else if(!pair->name.length) {
-			/* skip preceding white spaces (SHOULD NOT be any WSP, though) and read name */
-			if(!pair->name.buf && apt_text_is_wsp(*pos) == FALSE) {
-				pair->name.buf = pos;
-			}
-			if(*pos == ':') {
-				/* set length of the name */
-				pair->name.length = pos - pair->name.buf;
-			}
-		}
-		else if(!pair->value.length) {
+
+	eol = apt_text_chars_find(pos,stream->end,APT_TOKEN_CR,APT_TOKEN_LF);
+	if(eol == stream->end) {
+		/* end of stream is reached, do not advance stream pos, but set is_eos flag */
+		stream->is_eos = TRUE;
+		return FALSE;
+	}
+
+	/* skip preceding white spaces (SHOULD NOT be any WSP, though) and read name */
+	while(pos < eol && apt_text_is_wsp(*pos) == TRUE) pos++;
+	if(pos < eol) {
+		pair->name.buf = pos;
+		/* name is terminated by the first separator following its first char */
+		separator = apt_text_chars_find(pos+1,eol,':',':');
+		if(separator < eol) {
+			/* set length of the name */
+			pair->name.length = separator - pair->name.buf;
+
 			/* skip preceding white spaces and read value */
-			if(!pair->value.buf && apt_text_is_wsp(*pos) == FALSE) {
+			pos = separator + 1;
+			while(pos < eol && apt_text_is_wsp(*pos) == TRUE) pos++;
+			if(pos < eol) {
 				pair->value.buf = pos;
+				pair->value.length = eol - pos;
 			}
 		}
-		pos++;
 	}
 
-	if(status == TRUE) {
-		/* advance stream pos regardless it's a valid header or not */
-		stream->pos = pos;
-		
-		/* if length == 0 && buf => header is malformed */
-		if(!pair->name.length && pair->name.buf) {
-			status = FALSE;
-		}
-	}
-	else {
-		/* end of stream is reached, do not advance stream pos, but set is_eos flag */
-		stream->is_eos = TRUE;
-	}
+	/* advance stream pos regardless it's a valid header or not */
+	stream->pos = apt_text_eol_skip(eol,stream->end);
 
-	return status;
+	/* if length == 0 && buf => header is malformed */
+	if(!pair->name.length && pair->name.buf) {
+		return FALSE;
+	}
+	return TRUE;
 }
 
 
@@ -158,7 +165,7 @@ APT_DECLARE(apt_bool_t) apt_text_field_read(apt_text_stream_t *stream, char sepa
 
 	field->buf = pos;
 	field->length = 0;
-	while(pos < stream->end && *pos != separator) pos++;
+	pos = apt_text_chars_find(pos,stream->end,separator,separator);
 
 	field->length = pos - field->buf;
 	if(pos < stream->end) {
@@ -23,13 +23,42 @@
 #include "apt_timer_queue.h"
 #include "apt_log.h"
 
+/*
+ * Hierarchical timing wheel. The time is measured in ticks of the queue
+ * resolution. The first wheel has a slot per tick for the timers expiring
+ * within the next 256 ticks; each next wheel has 64 slots, every slot
+ * spanning a full revolution of the previous wheel. Once the previous wheel
+ * wraps, the timers of the current slot of the next one are cascaded down.
+ * Together the wheels cover the whole 32-bit tick range.
+ */
+#define TIMER_ROOT_BITS  8
+#define TIMER_NODE_BITS  6
+#define TIMER_ROOT_SIZE  (1 << TIMER_ROOT_BITS)
+#define TIMER_NODE_SIZE  (1 << TIMER_NODE_BITS)
+#define TIMER_ROOT_MASK  (TIMER_ROOT_SIZE - 1)
+#define TIMER_NODE_MASK  (TIMER_NODE_SIZE - 1)
+/** Number of node (upper) wheels */
+#define TIMER_NODE_COUNT 4
+
+/** Slot of the wheel (list of timers) */
+APR_RING_HEAD(apt_timer_head_t, apt_timer_t);
+typedef struct apt_timer_head_t apt_timer_head_t;
+
 /** Timer queue */
 struct apt_timer_queue_t {
-	/** Ring head */
-	APR_RING_HEAD(apt_timer_head_t, apt_timer_t) head;
+	/** Root wheel (a slot per tick) */
+	apt_timer_head_t root[TIMER_ROOT_SIZE];
+	/** Node wheels */
+	apt_timer_head_t node[TIMER_NODE_COUNT][TIMER_NODE_SIZE];
 
-	/** Elapsed time */
-	apr_uint32_t  elapsed_time;
+	/** Resolution of the queue (time units per tick) */
+	apr_uint32_t     resolution;
+	/** Current time in ticks */
+	apr_uint32_t     cur_tick;
+	/** Elapsed time not accounted in ticks yet */
+	apr_uint32_t     elapsed_time;
+	/** Number of set timers */
+	apr_size_t       count;
 };
 
 /** Timer */
@@ -39,8 +68,10 @@ struct apt_timer_t {
 
 	/** Back pointer to queue */
 	apt_timer_queue_t   *queue;
-	/** Time next report is scheduled at */
-	apr_uint32_t         scheduled_time;
+	/** Tick the timer is scheduled at */
+	apr_uint32_t         scheduled_tick;
+	/** Whether the timer is set */
+	apt_bool_t           is_set;
 
 	/** Timer proc */
 	apt_timer_proc_f     proc;
@@ -48,14 +79,29 @@ struct apt_timer_t {
 	void                *obj;
 };
 
-static void apt_timers_reschedule(apt_timer_queue_t *timer_queue);
-
 /** Create timer queue */
 APT_DECLARE(apt_timer_queue_t*) apt_timer_queue_create(apr_pool_t *pool)
 {
+	return apt_timer_queue_create_ex(1,pool);
+}
+
+/** Create timer queue with the specified resolution */
+APT_DECLARE(apt_timer_queue_t*) apt_timer_queue_create_ex(apr_uint32_t resolution, apr_pool_t *pool)
+{
+	int i, j;
 	apt_timer_queue_t *timer_queue = apr_palloc(pool,sizeof(apt_timer_queue_t));
-	APR_RING_INIT(&timer_queue->head, apt_timer_t, link);
+	for(i=0; i<TIMER_ROOT_SIZE; i++) {
+		APR_RING_INIT(&timer_queue->root[i], apt_timer_t, link);
+	}
+	for(i=0; i<TIMER_NODE_COUNT; i++) {
+		for(j=0; j<TIMER_NODE_SIZE; j++) {
+			APR_RING_INIT(&timer_queue->node[i][j], apt_timer_t, link);
+		}
+	}
+	timer_queue->resolution = resolution ? resolution : 1;
+	timer_queue->cur_tick = 0;
 	timer_queue->elapsed_time = 0;
+	timer_queue->count = 0;
 	return timer_queue;
 }
 
@@ -64,65 +110,181 @@ APT_DECLARE(void) apt_timer_queue_destroy(apt_timer_queue_t *timer_queue)
 {
 }
 
-/** Advance scheduled timers */
-APT_DECLARE(void) apt_timer_queue_advance(apt_timer_queue_t *timer_queue, apr_uint32_t elapsed_time)
+/** Get the slot the timer belongs to according to its scheduled tick */
+static apt_timer_head_t* apt_timer_slot_get(apt_timer_queue_t *timer_queue, apr_uint32_t scheduled_tick)
+{
+	apr_uint32_t delta = scheduled_tick - timer_queue->cur_tick;
+	int shift = TIMER_ROOT_BITS;
+	int level;
+
+	if(delta < TIMER_ROOT_SIZE) {
+		return &timer_queue->root[scheduled_tick & TIMER_ROOT_MASK];
+	}
+	for(level=0; level<TIMER_NODE_COUNT-1; level++) {
+		if(delta < (apr_uint32_t)1 << (shift + TIMER_NODE_BITS)) {
+			break;
+		}
+		shift += TIMER_NODE_BITS;
+	}
+	return &timer_queue->node[level][(scheduled_tick >> shift) & TIMER_NODE_MASK];
+}
+
+/** Move the timers of the slot of the node wheel down to the lower wheels */
+static int apt_timers_cascade(apt_timer_queue_t *timer_queue, int level)
 {
 	apt_timer_t *timer;
+	apt_timer_head_t *slot;
+	int index = (timer_queue->cur_tick >> (TIMER_ROOT_BITS + level * TIMER_NODE_BITS)) & TIMER_NODE_MASK;
 
-	if(APR_RING_EMPTY(&timer_queue->head, apt_timer_t, link)) {
-		/* just return, nothing to do */
-		return;
+	slot = &timer_queue->node[level][index];
+	while(!APR_RING_EMPTY(slot, apt_timer_t, link)) {
+		timer = APR_RING_FIRST(slot);
+		APR_RING_REMOVE(timer, link);
+		APR_RING_INSERT_TAIL(apt_timer_slot_get(timer_queue,timer->scheduled_tick),timer,apt_timer_t,link);
 	}
+	return index;
+}
 
-	/* increment elapsed time */
-	timer_queue->elapsed_time += elapsed_time;
-	if(timer_queue->elapsed_time >= 0xFFFF) {
-		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Reschedule Timers [%u]",timer_queue->elapsed_time);
-		apt_timers_reschedule(timer_queue);
+/** Advance the queue by a single tick and process the elapsed timers */
+static void apt_timer_queue_tick(apt_timer_queue_t *timer_queue)
+{
+	apt_timer_t *timer;
+	apt_timer_head_t elapsed;
+	int index = timer_queue->cur_tick & TIMER_ROOT_MASK;
+	if(!index) {
+		/* the root wheel wrapped, cascade the upper wheels as needed */
+		int level;
+		for(level=0; level<TIMER_NODE_COUNT; level++) {
+			if(apt_timers_cascade(timer_queue,level) != 0) {
+				break;
+			}
+		}
+	}
+	timer_queue->cur_tick++;
+
+	if(APR_RING_EMPTY(&timer_queue->root[index], apt_timer_t, link)) {
+		return;
 	}
 
-	/* process timers */
-	do {
-		/* get first node (timer) */
-		timer = APR_RING_FIRST(&timer_queue->head);
+	/* detach the elapsed timers first, since the timer procs may set timers again */
+	APR_RING_INIT(&elapsed, apt_timer_t, link);
+	while(!APR_RING_EMPTY(&timer_queue->root[index], apt_timer_t, link)) {
+		timer = APR_RING_FIRST(&timer_queue->root[index]);
+		APR_RING_REMOVE(timer, link);
+		APR_RING_INSERT_TAIL(&elapsed,timer,apt_timer_t,link);
+	}
 
-		if(timer->scheduled_time > timer_queue->elapsed_time) {
-			/* scheduled time is not elapsed yet */
-			break;
-		}
-		
-		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Timer Elapsed 0x%x [%u]",timer,timer->scheduled_time);
+	while(!APR_RING_EMPTY(&elapsed, apt_timer_t, link)) {
+		timer = APR_RING_FIRST(&elapsed);
+		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Timer Elapsed 0x%x [%u]",timer,timer->scheduled_tick);
 		/* remove the elapsed timer from the list */
 		APR_RING_REMOVE(timer, link);
-		timer->scheduled_time = 0;
+		timer->is_set = FALSE;
+		timer_queue->count--;
 		/* process the elapsed timer */
 		timer->proc(timer,timer->obj);
 	}
-	while(!APR_RING_EMPTY(&timer_queue->head, apt_timer_t, link));
+}
+
+/** Advance scheduled timers */
+APT_DECLARE(void) apt_timer_queue_advance(apt_timer_queue_t *timer_queue, apr_uint32_t elapsed_time)
+{
+	apr_uint32_t ticks;
+
+	timer_queue->elapsed_time += elapsed_time;
+	ticks = timer_queue->elapsed_time / timer_queue->resolution;
+	timer_queue->elapsed_time -= ticks * timer_queue->resolution;
+
+	while(ticks) {
+		if(!timer_queue->count) {
+			/* just move on, nothing to process */
+			timer_queue->cur_tick += ticks;
+			break;
+		}
+		apt_timer_queue_tick(timer_queue);
+		ticks--;
+	}
 }
 
 /** Is timer queue empty */
 APT_DECLARE(apt_bool_t) apt_timer_queue_is_empty(const apt_timer_queue_t *timer_queue)
 {
-	return APR_RING_EMPTY(&timer_queue->head, apt_timer_t, link) ? TRUE : FALSE;
+	return timer_queue->count ? FALSE : TRUE;
+}
+
+/** Get the earliest scheduled tick of the timers of the slot */
+static apt_bool_t apt_timer_slot_earliest_get(const apt_timer_queue_t *timer_queue, const apt_timer_head_t *slot, apr_uint32_t *delta)
+{
+	const apt_timer_t *timer;
+	apt_bool_t found = FALSE;
+	for(timer = APR_RING_FIRST(slot);
+			timer != APR_RING_SENTINEL(slot, apt_timer_t, link);
+				timer = APR_RING_NEXT(timer, link)) {
+
+		apr_uint32_t timer_delta = timer->scheduled_tick - timer_queue->cur_tick;
+		if(found == FALSE || timer_delta < *delta) {
+			*delta = timer_delta;
+			found = TRUE;
+		}
+	}
+	return found;
 }
 
 /** Get current timeout */
 APT_DECLARE(apt_bool_t) apt_timer_queue_timeout_get(const apt_timer_queue_t *timer_queue, apr_uint32_t *timeout)
 {
-	apt_timer_t *timer;
-	/* is queue empty */
-	if(APR_RING_EMPTY(&timer_queue->head, apt_timer_t, link)) {
+	apr_uint32_t delta = 0;
+	apr_uint32_t slot_delta;
+	apt_bool_t found = FALSE;
+	int index;
+	int i;
+	int level;
+
+	if(!timer_queue->count) {
 		return FALSE;
 	}
 
-	/* get first node (timer) */
-	timer = APR_RING_FIRST(&timer_queue->head);
-	if(!timer) {
+	/* all the timers of a root slot are scheduled at the same tick */
+	index = timer_queue->cur_tick & TIMER_ROOT_MASK;
+	for(i=0; i<TIMER_ROOT_SIZE; i++) {
+		const apt_timer_head_t *slot = &timer_queue->root[(index + i) & TIMER_ROOT_MASK];
+		if(!APR_RING_EMPTY(slot, apt_timer_t, link)) {
+			delta = APR_RING_FIRST(slot)->scheduled_tick - timer_queue->cur_tick;
+			found = TRUE;
+			break;
+		}
+	}
+
+	/* timers set earlier may still wait in the upper wheels, check the closest slots of each */
+	for(level=0; level<TIMER_NODE_COUNT; level++) {
+		index = (timer_queue->cur_tick >> (TIMER_ROOT_BITS + level * TIMER_NODE_BITS)) & TIMER_NODE_MASK;
+		/* the current slot holds either the timers a full revolution ahead or,
+		right at the revolution boundary, the ones about to be cascaded */
+		if(apt_timer_slot_earliest_get(timer_queue,&timer_queue->node[level][index],&slot_delta) == TRUE) {
+			if(found == FALSE || slot_delta < delta) {
+				delta = slot_delta;
+				found = TRUE;
+			}
+		}
+		for(i=1; i<TIMER_NODE_SIZE; i++) {
+			const apt_timer_head_t *slot = &timer_queue->node[level][(index + i) & TIMER_NODE_MASK];
+			if(apt_timer_slot_earliest_get(timer_queue,slot,&slot_delta) == TRUE) {
+				if(found == FALSE || slot_delta < delta) {
+					delta = slot_delta;
+					found = TRUE;
+				}
+				break;
+			}
+		}
+	}
+
+	if(found == FALSE) {
 		return FALSE;
 	}
-		
-	*timeout = timer->scheduled_time - timer_queue->elapsed_time;
+
+	/* the timer elapses once the tick it is scheduled at is over */
+	delta = (delta + 1) * timer_queue->resolution;
+	*timeout = delta > timer_queue->elapsed_time ? delta - timer_queue->elapsed_time : 0;
 	return TRUE;
 }
 
@@ -132,49 +294,43 @@ APT_DECLARE(apt_timer_t*) apt_timer_create(apt_timer_queue_t *timer_queue, apt_t
 {
 	apt_timer_t *timer = apr_palloc(pool,sizeof(apt_timer_t));
 	timer->queue = timer_queue;
-	timer->scheduled_time = 0;
+	timer->scheduled_tick = 0;
+	timer->is_set = FALSE;
 	timer->proc = proc;
 	timer->obj = obj;
 	return timer;
 }
 
-static APR_INLINE apt_bool_t apt_timer_insert(apt_timer_queue_t *timer_queue, apt_timer_t *timer)
-{
-	apt_timer_t *it;
-	for(it = APR_RING_LAST(&timer_queue->head);
-			it != APR_RING_SENTINEL(&timer_queue->head, apt_timer_t, link);
-				it = APR_RING_PREV(it, link)) {
-		
-		if(it->scheduled_time <= timer->scheduled_time) {
-			APR_RING_INSERT_AFTER(it,timer,link);
-			return TRUE;
-		}
-	}
-	APR_RING_INSERT_HEAD(&timer_queue->head,timer,apt_timer_t,link);
-	return TRUE;
-}
-
 /** Set one-shot timer */
 APT_DECLARE(apt_bool_t) apt_timer_set(apt_timer_t *timer, apr_uint32_t timeout)
-
 {
 	apt_timer_queue_t *queue = timer->queue;
+	apr_uint32_t ticks;
 
 	if(timeout <= 0 || !timer->proc) {
 		return FALSE;
 	}
-	
-	/* calculate time to elapse */
-	timer->scheduled_time = queue->elapsed_time + timeout;
-	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Set Timer 0x%x [%u]",timer,timer->scheduled_time);
 
-	if(APR_RING_EMPTY(&queue->head, apt_timer_t, link)) {
-		APR_RING_INSERT_TAIL(&queue->head,timer,apt_timer_t,link);
-		return TRUE;
+	if(timer->is_set == TRUE) {
+		/* reschedule the timer */
+		APR_RING_REMOVE(timer,link);
+		queue->count--;
 	}
 
-	/* insert new node (timer) to sorted by scheduled time list */
-	return apt_timer_insert(queue,timer);
+	/* round the timeout up to the resolution, counting the partially elapsed tick */
+	ticks = (timeout + queue->elapsed_time + queue->resolution - 1) / queue->resolution;
+	if(!ticks) {
+		ticks = 1;
+	}
+
+	/* the timer is processed when the tick it is scheduled at is over */
+	timer->scheduled_tick = queue->cur_tick + ticks - 1;
+	timer->is_set = TRUE;
+	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Set Timer 0x%x [%u]",timer,timer->scheduled_tick);
+
+	APR_RING_INSERT_TAIL(apt_timer_slot_get(queue,timer->scheduled_tick),timer,apt_timer_t,link);
+	queue->count++;
+	return TRUE;
 }
 
 /** Kill timer */
@@ -182,30 +338,14 @@ APT_DECLARE(apt_bool_t) apt_timer_kill(apt_timer_t *timer)
 {
 	apt_timer_queue_t *queue = timer->queue;
 
-	if(!timer->scheduled_time) {
+	if(timer->is_set == FALSE) {
 		return FALSE;
 	}
 
-	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Kill Timer 0x%x [%u]",timer,timer->scheduled_time);
+	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Kill Timer 0x%x [%u]",timer,timer->scheduled_tick);
 	/* remove node (timer) from the list */
 	APR_RING_REMOVE(timer,link);
-	timer->scheduled_time = 0;
-
-	if(APR_RING_EMPTY(&queue->head, apt_timer_t, link)) {
-		/* reset elapsed time if no timers set */
-		queue->elapsed_time = 0;
-	}
+	timer->is_set = FALSE;
+	queue->count--;
 	return TRUE;
 }
-
-static void apt_timers_reschedule(apt_timer_queue_t *queue)
-{
-	apt_timer_t *it;
-	for(it = APR_RING_LAST(&queue->head);
-			it != APR_RING_SENTINEL(&queue->head, apt_timer_t, link);
-				it = APR_RING_PREV(it, link)) {
-		
-		it->scheduled_time -= queue->elapsed_time;
-	}
-	queue->elapsed_time = 0;
-}
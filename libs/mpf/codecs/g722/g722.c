@@ -0,0 +1,408 @@
+/*
+ * Copyright 2008-2010 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <string.h>
+#include "g722.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define G722_SSE2
+#include <emmintrin.h>
+#endif
+
+/** Number of sample pairs filtered at once */
+#define G722_BLOCK_PAIRS 80
+/** Number of samples kept for the QMF filters between blocks */
+#define G722_QMF_HISTORY (G722_QMF_TAPS - 2)
+
+/** QMF filter coefficients (the other half is symmetric) */
+static const short qmf_coeffs[12] = {
+	3, -11, 12, 32, -210, 951, 3876, -805, 362, -156, 53, -11
+};
+
+/** 6-bit low-band quantizer decision levels */
+static const int q6[32] = {
+	   0,   35,   72,  110,  150,  190,  233,  276,
+	 323,  370,  422,  473,  530,  587,  650,  714,
+	 786,  858,  940, 1023, 1121, 1219, 1339, 1458,
+	1612, 1765, 1980, 2195, 2557, 2919,    0,    0
+};
+/** 6-bit low-band codes of negative differences */
+static const int iln[32] = {
+	 0, 63, 62, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19,
+	18, 17, 16, 15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  0
+};
+/** 6-bit low-band codes of positive differences */
+static const int ilp[32] = {
+	 0, 61, 60, 59, 58, 57, 56, 55, 54, 53, 52, 51, 50, 49, 48, 47,
+	46, 45, 44, 43, 42, 41, 40, 39, 38, 37, 36, 35, 34, 33, 32,  0
+};
+/** 6-bit low-band inverse quantizer output levels */
+static const int qm6[64] = {
+	  -136,   -136,   -136,   -136, -24808, -21904, -19008, -16704,
+	-14984, -13512, -12280, -11192, -10232,  -9360,  -8576,  -7856,
+	 -7192,  -6576,  -6000,  -5456,  -4944,  -4464,  -4008,  -3576,
+	 -3168,  -2776,  -2400,  -2032,  -1688,  -1360,  -1040,   -728,
+	 24808,  21904,  19008,  16704,  14984,  13512,  12280,  11192,
+	 10232,   9360,   8576,   7856,   7192,   6576,   6000,   5456,
+	  4944,   4464,   4008,   3576,   3168,   2776,   2400,   2032,
+	  1688,   1360,   1040,    728,    432,    136,   -432,   -136
+};
+/** 4-bit low-band inverse quantizer output levels (used for adaptation) */
+static const int qm4[16] = {
+	     0, -20456, -12896,  -8968,  -6288,  -4240,  -2584,  -1200,
+	 20456,  12896,   8968,   6288,   4240,   2584,   1200,      0
+};
+/** Low-band code to logarithmic scale factor multiplier index */
+static const int rl42[16] = {
+	0, 7, 6, 5, 4, 3, 2, 1, 7, 6, 5, 4, 3, 2, 1, 0
+};
+/** Low-band logarithmic scale factor multipliers */
+static const int wl[8] = {
+	-60, -30, 58, 172, 334, 538, 1198, 3042
+};
+/** Inverse logarithmic scale factor table */
+static const int ilb[32] = {
+	2048, 2093, 2139, 2186, 2233, 2282, 2332, 2383,
+	2435, 2489, 2543, 2599, 2656, 2714, 2774, 2834,
+	2896, 2960, 3025, 3091, 3158, 3228, 3298, 3371,
+	3444, 3520, 3597, 3676, 3756, 3838, 3922, 4008
+};
+/** 2-bit high-band codes of negative and positive differences */
+static const int ihn[3] = {0, 1, 0};
+static const int ihp[3] = {0, 3, 2};
+/** 2-bit high-band inverse quantizer output levels */
+static const int qm2[4] = {-7408, -1616, 7408, 1616};
+/** High-band code to logarithmic scale factor multiplier index */
+static const int rh2[4] = {2, 1, 2, 1};
+/** High-band logarithmic scale factor multipliers */
+static const int wh[3] = {0, -214, 798};
+
+static __inline int g722_saturate(int amp)
+{
+	if(amp > 32767) {
+		return 32767;
+	}
+	if(amp < -32768) {
+		return -32768;
+	}
+	return amp;
+}
+
+static __inline int g722_limit(int amp, int min, int max)
+{
+	if(amp > max) {
+		return max;
+	}
+	if(amp < min) {
+		return min;
+	}
+	return amp;
+}
+
+static void g722_band_init(g722_band_t *band, int det)
+{
+	memset(band,0,sizeof(g722_band_t));
+	band->det = det;
+}
+
+/** Update the scale factor from the logarithmic one (SCALEL, SCALEH) */
+static __inline void g722_band_scale(g722_band_t *band, int shift)
+{
+	int wd1 = (band->nb >> 6) & 31;
+	int wd2 = shift - (band->nb >> 11);
+	int wd3 = (wd2 < 0) ? (ilb[wd1] << -wd2) : (ilb[wd1] >> wd2);
+	band->det = wd3 << 2;
+}
+
+/** Adapt the predictor of the sub-band to the quantized difference (block 4) */
+static void g722_band_adapt(g722_band_t *band, int d)
+{
+	int wd1, wd2, wd3;
+	int ap1, ap2;
+	int sg0, sg1, sg2;
+	int b;
+	int sz;
+	int i;
+
+	/* RECONS, PARREC */
+	band->d[0] = d;
+	band->r[0] = g722_saturate(band->s + d);
+	band->p[0] = g722_saturate(band->sz + d);
+
+	/* UPPOL2 */
+	sg0 = band->p[0] >> 15;
+	sg1 = band->p[1] >> 15;
+	sg2 = band->p[2] >> 15;
+	wd1 = g722_saturate(band->a[1] << 2);
+	wd2 = (sg0 == sg1) ? -wd1 : wd1;
+	if(wd2 > 32767) {
+		wd2 = 32767;
+	}
+	wd3 = (sg0 == sg2) ? 128 : -128;
+	wd3 += wd2 >> 7;
+	wd3 += (band->a[2] * 32512) >> 15;
+	ap2 = g722_limit(wd3,-12288,12288);
+
+	/* UPPOL1 */
+	wd1 = (sg0 == sg1) ? 192 : -192;
+	wd2 = (band->a[1] * 32640) >> 15;
+	wd3 = g722_saturate(15360 - ap2);
+	ap1 = g722_limit(g722_saturate(wd1 + wd2),-wd3,wd3);
+
+	/* UPZERO, DELAYA and FILTEZ in a single pass from the oldest difference */
+	wd1 = (d == 0) ? 0 : 128;
+	sg0 = d >> 15;
+	sz = 0;
+	for(i=6; i>0; i--) {
+		wd2 = ((band->d[i] >> 15) == sg0) ? wd1 : -wd1;
+		b = g722_saturate(wd2 + ((band->b[i] * 32640) >> 15));
+		band->b[i] = b;
+		band->d[i] = band->d[i-1];
+		sz += (b * g722_saturate(band->d[i] + band->d[i])) >> 15;
+	}
+	band->sz = g722_saturate(sz);
+
+	/* DELAYA */
+	band->r[2] = band->r[1];
+	band->r[1] = band->r[0];
+	band->p[2] = band->p[1];
+	band->p[1] = band->p[0];
+	band->a[2] = ap2;
+	band->a[1] = ap1;
+
+	/* FILTEP */
+	wd1 = g722_saturate(band->r[1] + band->r[1]);
+	wd1 = (band->a[1] * wd1) >> 15;
+	wd2 = g722_saturate(band->r[2] + band->r[2]);
+	wd2 = (band->a[2] * wd2) >> 15;
+	band->sp = g722_saturate(wd1 + wd2);
+
+	/* PREDIC */
+	band->s = g722_saturate(band->sp + band->sz);
+}
+
+/** Adapt the low-band scale factor and predictor to the code (blocks 2L, 3L, 4L) */
+static __inline void g722_low_band_update(g722_band_t *band, int ilow)
+{
+	int ril = ilow >> 2;
+	int dlow = (band->det * qm4[ril]) >> 15;
+
+	band->nb = g722_limit(((band->nb * 127) >> 7) + wl[rl42[ril]],0,18432);
+	g722_band_scale(band,8);
+	g722_band_adapt(band,dlow);
+}
+
+/** Adapt the high-band scale factor and predictor to the code (blocks 2H, 3H, 4H) */
+static __inline void g722_high_band_update(g722_band_t *band, int ihigh, int dhigh)
+{
+	band->nb = g722_limit(((band->nb * 127) >> 7) + wh[rh2[ihigh]],0,22528);
+	g722_band_scale(band,10);
+	g722_band_adapt(band,dhigh);
+}
+
+/**
+ * Run the QMF filter over count windows of G722_QMF_TAPS samples, advancing by 2 samples.
+ * sum[j] = sum(x[2i] * h[i] + x[2i+1] * h[11-i])
+ * dif[j] = sum(x[2i+1] * h[11-i] - x[2i] * h[i])
+ */
+static void g722_qmf_run(const short *x, int count, int *sum, int *dif)
+{
+	int j = 0;
+	int i;
+	int even, odd;
+#ifdef G722_SSE2
+	const short *h = qmf_coeffs;
+	const __m128i s0 = _mm_setr_epi16(h[0],h[11],h[1],h[10],h[2],h[9],h[3],h[8]);
+	const __m128i s1 = _mm_setr_epi16(h[4],h[7],h[5],h[6],h[6],h[5],h[7],h[4]);
+	const __m128i s2 = _mm_setr_epi16(h[8],h[3],h[9],h[2],h[10],h[1],h[11],h[0]);
+	const __m128i d0 = _mm_setr_epi16(-h[0],h[11],-h[1],h[10],-h[2],h[9],-h[3],h[8]);
+	const __m128i d1 = _mm_setr_epi16(-h[4],h[7],-h[5],h[6],-h[6],h[5],-h[7],h[4]);
+	const __m128i d2 = _mm_setr_epi16(-h[8],h[3],-h[9],h[2],-h[10],h[1],-h[11],h[0]);
+	__m128i w0, w1, w2;
+	__m128i as[4], ad[4];
+	__m128i t0, t1;
+	int k;
+
+	for(; j+4<=count; j+=4) {
+		for(k=0; k<4; k++) {
+			w0 = _mm_loadu_si128((const __m128i*)(x + 2*(j+k)));
+			w1 = _mm_loadu_si128((const __m128i*)(x + 2*(j+k) + 8));
+			w2 = _mm_loadu_si128((const __m128i*)(x + 2*(j+k) + 16));
+			as[k] = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(w0,s0),_mm_madd_epi16(w1,s1)),_mm_madd_epi16(w2,s2));
+			ad[k] = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(w0,d0),_mm_madd_epi16(w1,d1)),_mm_madd_epi16(w2,d2));
+		}
+		/* horizontal sums of 4 accumulators at once */
+		t0 = _mm_add_epi32(_mm_unpacklo_epi32(as[0],as[1]),_mm_unpackhi_epi32(as[0],as[1]));
+		t1 = _mm_add_epi32(_mm_unpacklo_epi32(as[2],as[3]),_mm_unpackhi_epi32(as[2],as[3]));
+		_mm_storeu_si128((__m128i*)(sum + j),_mm_add_epi32(_mm_unpacklo_epi64(t0,t1),_mm_unpackhi_epi64(t0,t1)));
+		t0 = _mm_add_epi32(_mm_unpacklo_epi32(ad[0],ad[1]),_mm_unpackhi_epi32(ad[0],ad[1]));
+		t1 = _mm_add_epi32(_mm_unpacklo_epi32(ad[2],ad[3]),_mm_unpackhi_epi32(ad[2],ad[3]));
+		_mm_storeu_si128((__m128i*)(dif + j),_mm_add_epi32(_mm_unpacklo_epi64(t0,t1),_mm_unpackhi_epi64(t0,t1)));
+	}
+#endif
+	for(; j<count; j++) {
+		even = 0;
+		odd = 0;
+		for(i=0; i<12; i++) {
+			even += x[2*(j+i)] * qmf_coeffs[i];
+			odd += x[2*(j+i)+1] * qmf_coeffs[11-i];
+		}
+		sum[j] = odd + even;
+		dif[j] = odd - even;
+	}
+}
+
+void g722_encoder_init(g722_encoder_t *encoder)
+{
+	memset(encoder->x,0,sizeof(encoder->x));
+	g722_band_init(&encoder->band[0],32);
+	g722_band_init(&encoder->band[1],8);
+}
+
+/** Encode one pair of sub-band samples */
+static __inline int g722_encode_pair(g722_encoder_t *encoder, int xlow, int xhigh)
+{
+	g722_band_t *band;
+	int el, eh;
+	int wd;
+	int i, hi;
+	int ilow, ihigh;
+
+	/* low band: SUBTRA, QUANTL (binary search for the first decision level above the difference) */
+	band = &encoder->band[0];
+	el = g722_saturate(xlow - band->s);
+	wd = (el >= 0) ? el : -(el + 1);
+	i = 1;
+	hi = 30;
+	while(i < hi) {
+		int mid = (i + hi) >> 1;
+		if(wd < ((q6[mid] * band->det) >> 12)) {
+			hi = mid;
+		}
+		else {
+			i = mid + 1;
+		}
+	}
+	ilow = (el < 0) ? iln[i] : ilp[i];
+	g722_low_band_update(band,ilow);
+
+	/* high band: SUBTRA, QUANTH */
+	band = &encoder->band[1];
+	eh = g722_saturate(xhigh - band->s);
+	wd = (eh >= 0) ? eh : -(eh + 1);
+	i = (wd >= ((564 * band->det) >> 12)) ? 2 : 1;
+	ihigh = (eh < 0) ? ihn[i] : ihp[i];
+	g722_high_band_update(band,ihigh,(band->det * qm2[ihigh]) >> 15);
+
+	return (ihigh << 6) | ilow;
+}
+
+int g722_encode(g722_encoder_t *encoder, unsigned char *code, const short *amp, int count)
+{
+	short x[G722_QMF_HISTORY + 2*G722_BLOCK_PAIRS];
+	int sum[G722_BLOCK_PAIRS];
+	int dif[G722_BLOCK_PAIRS];
+	int pairs = count / 2;
+	int done = 0;
+	int n;
+	int j;
+
+	memcpy(x,encoder->x,sizeof(encoder->x));
+	while(done < pairs) {
+		n = pairs - done;
+		if(n > G722_BLOCK_PAIRS) {
+			n = G722_BLOCK_PAIRS;
+		}
+		memcpy(x + G722_QMF_HISTORY,amp + 2*done,2 * n * sizeof(short));
+
+		/* transmit QMF: xlow = sum >> 14, xhigh = dif >> 14 */
+		g722_qmf_run(x,n,sum,dif);
+		for(j=0; j<n; j++) {
+			code[done + j] = (unsigned char)g722_encode_pair(encoder,sum[j] >> 14,dif[j] >> 14);
+		}
+
+		memmove(x,x + 2*n,sizeof(encoder->x));
+		done += n;
+	}
+	memcpy(encoder->x,x,sizeof(encoder->x));
+	return pairs;
+}
+
+void g722_decoder_init(g722_decoder_t *decoder)
+{
+	memset(decoder->x,0,sizeof(decoder->x));
+	g722_band_init(&decoder->band[0],32);
+	g722_band_init(&decoder->band[1],8);
+}
+
+/** Decode one code to the pair of sub-band samples */
+static __inline void g722_decode_pair(g722_decoder_t *decoder, int code, short *x)
+{
+	g722_band_t *band;
+	int ilow = code & 0x3F;
+	int ihigh = (code >> 6) & 0x03;
+	int rlow, rhigh;
+	int dhigh;
+
+	/* low band: INVQBL, RECONS, LIMIT */
+	band = &decoder->band[0];
+	rlow = g722_limit(band->s + ((band->det * qm6[ilow]) >> 15),-16384,16383);
+	g722_low_band_update(band,ilow);
+
+	/* high band: INVQAH, RECONS, LIMIT */
+	band = &decoder->band[1];
+	dhigh = (band->det * qm2[ihigh]) >> 15;
+	rhigh = g722_limit(band->s + dhigh,-16384,16383);
+	g722_high_band_update(band,ihigh,dhigh);
+
+	x[0] = (short)(rlow + rhigh);
+	x[1] = (short)(rlow - rhigh);
+}
+
+int g722_decode(g722_decoder_t *decoder, short *amp, const unsigned char *code, int count)
+{
+	short x[G722_QMF_HISTORY + 2*G722_BLOCK_PAIRS];
+	int sum[G722_BLOCK_PAIRS];
+	int dif[G722_BLOCK_PAIRS];
+	int done = 0;
+	int n;
+	int j;
+
+	memcpy(x,decoder->x,sizeof(decoder->x));
+	while(done < count) {
+		n = count - done;
+		if(n > G722_BLOCK_PAIRS) {
+			n = G722_BLOCK_PAIRS;
+		}
+		for(j=0; j<n; j++) {
+			g722_decode_pair(decoder,code[done + j],x + G722_QMF_HISTORY + 2*j);
+		}
+
+		/* receive QMF: sum = xout1 + xout2, dif = xout1 - xout2 */
+		g722_qmf_run(x,n,sum,dif);
+		for(j=0; j<n; j++) {
+			amp[2*(done + j)] = (short)g722_saturate(((sum[j] + dif[j]) >> 1) >> 11);
+			amp[2*(done + j) + 1] = (short)g722_saturate(((sum[j] - dif[j]) >> 1) >> 11);
+		}
+
+		memmove(x,x + 2*n,sizeof(decoder->x));
+		done += n;
+	}
+	memcpy(decoder->x,x,sizeof(decoder->x));
+	return count * 2;
+}
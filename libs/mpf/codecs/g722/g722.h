@@ -0,0 +1,115 @@
+/*
+ * Copyright 2008-2010 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef G722_H
+#define G722_H
+
+/**
+ * @file g722.h
+ * @brief ITU-T G.722 7kHz Audio Codec (64 kbit/s mode)
+ *
+ * The QMF analysis and synthesis filters are computed for a whole block of
+ * samples at once (SSE2 when available), the sub-band ADPCM coders run
+ * sample by sample afterwards, since they are inherently recursive.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Number of QMF taps */
+#define G722_QMF_TAPS 24
+
+/** Sub-band ADPCM state */
+typedef struct g722_band_t g722_band_t;
+/** Encoder state */
+typedef struct g722_encoder_t g722_encoder_t;
+/** Decoder state */
+typedef struct g722_decoder_t g722_decoder_t;
+
+/** Sub-band ADPCM state */
+struct g722_band_t {
+	/** Predictor output */
+	int s;
+	/** Pole section output */
+	int sp;
+	/** Zero section output */
+	int sz;
+	/** Reconstructed signals */
+	int r[3];
+	/** Pole predictor coefficients */
+	int a[3];
+	/** Partially reconstructed signals */
+	int p[3];
+	/** Quantized differences */
+	int d[7];
+	/** Zero predictor coefficients */
+	int b[7];
+	/** Logarithmic quantizer scale factor */
+	int nb;
+	/** Quantizer scale factor */
+	int det;
+};
+
+/** Encoder state */
+struct g722_encoder_t {
+	/** Input samples kept for the QMF analysis filter (the oldest first) */
+	short       x[G722_QMF_TAPS - 2];
+	/** Lower and higher sub-band states */
+	g722_band_t band[2];
+};
+
+/** Decoder state */
+struct g722_decoder_t {
+	/** Sub-band signals kept for the QMF synthesis filter (the oldest first) */
+	short       x[G722_QMF_TAPS - 2];
+	/** Lower and higher sub-band states */
+	g722_band_t band[2];
+};
+
+/** Reset encoder state */
+void g722_encoder_init(g722_encoder_t *encoder);
+
+/**
+ * Encode block of 16kHz linear samples, each pair of samples produces one code.
+ * @param encoder the encoder state
+ * @param code the buffer to store count/2 codes in
+ * @param amp the linear samples to encode
+ * @param count the number of samples (the odd one is ignored)
+ * @return the number of codes
+ */
+int g722_encode(g722_encoder_t *encoder, unsigned char *code, const short *amp, int count);
+
+/** Reset decoder state */
+void g722_decoder_init(g722_decoder_t *decoder);
+
+/**
+ * Decode block of codes to 16kHz linear samples, each code produces a pair of samples.
+ * @param decoder the decoder state
+ * @param amp the buffer to store count*2 linear samples in
+ * @param code the codes to decode
+ * @param count the number of codes
+ * @return the number of samples
+ */
+int g722_decode(g722_decoder_t *decoder, short *amp, const unsigned char *code, int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* G722_H */
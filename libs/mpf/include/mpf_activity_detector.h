@@ -40,6 +40,12 @@ typedef enum {
 	MPF_DETECTOR_EVENT_NOINPUT     /**< noinput event occurred */
 } mpf_detector_event_e;
 
+/** Modes of activity detector */
+typedef enum {
+	MPF_DETECTOR_MODE_LEVEL,   /**< average level of frame is compared to a fixed threshold */
+	MPF_DETECTOR_MODE_ADAPTIVE /**< band energies of frame are compared to an adaptive noise floor */
+} mpf_detector_mode_e;
+
 
 /** Create activity detector */
 MPF_DECLARE(mpf_activity_detector_t*) mpf_activity_detector_create(apr_pool_t *pool);
@@ -47,6 +53,15 @@ MPF_DECLARE(mpf_activity_detector_t*) mpf_activity_detector_create(apr_pool_t *p
 /** Reset activity detector */
 MPF_DECLARE(void) mpf_activity_detector_reset(mpf_activity_detector_t *detector);
 
+/** Set detection mode */
+MPF_DECLARE(void) mpf_activity_detector_mode_set(mpf_activity_detector_t *detector, mpf_detector_mode_e mode);
+
+/** Set sensitivity of adaptive detection (0.0 - 1.0, see Sensitivity-Level) */
+MPF_DECLARE(void) mpf_activity_detector_sensitivity_set(mpf_activity_detector_t *detector, float sensitivity);
+
+/** Set period voice activity is held after the last active frame in adaptive mode */
+MPF_DECLARE(void) mpf_activity_detector_hangover_set(mpf_activity_detector_t *detector, apr_size_t hangover_timeout);
+
 /** Set threshold of voice activity (silence) level */
 MPF_DECLARE(void) mpf_activity_detector_level_set(mpf_activity_detector_t *detector, apr_size_t level_threshold);
 
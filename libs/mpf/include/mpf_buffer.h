@@ -21,13 +21,18 @@
 
 /**
  * @file mpf_buffer.h
- * @brief Buffer of Media Chunks
+ * @brief Bounded Buffer of Media Data
+ * @remark Lock-free buffer for one producer (e.g. TTS thread)
+ *         and one consumer (audio stream) thread.
  */ 
 
 #include "mpf_frame.h"
 
 APT_BEGIN_EXTERN_C
 
+/** Size of buffer in bytes (1 sec of 16 kHz linear audio) */
+#define MPF_BUFFER_DEFAULT_SIZE 32768
+
 /** Opaque media buffer declaration */
 typedef struct mpf_buffer_t mpf_buffer_t;
 
@@ -38,13 +43,13 @@ mpf_buffer_t* mpf_buffer_create(apr_pool_t *pool);
 /** Destroy buffer */
 void mpf_buffer_destroy(mpf_buffer_t *buffer);
 
-/** Restart buffer */
+/** Restart buffer (drop pending data, called by consumer) */
 apt_bool_t mpf_buffer_restart(mpf_buffer_t *buffer);
 
-/** Write audio chunk to buffer */
+/** Write audio chunk to buffer (FALSE if there is no room for the whole chunk) */
 apt_bool_t mpf_buffer_audio_write(mpf_buffer_t *buffer, void *data, apr_size_t size);
 
-/** Write event to buffer */
+/** Write event to buffer (only one event may be pending) */
 apt_bool_t mpf_buffer_event_write(mpf_buffer_t *buffer, mpf_frame_type_e event_type);
 
 /** Read media frame from buffer */
@@ -41,6 +41,10 @@ struct mpf_codec_t {
 	const mpf_codec_attribs_t    *attribs;
 	/** Optional static codec descriptor (pt < 96) */
 	const mpf_codec_descriptor_t *static_descriptor;
+	/** Codec specific (per instance) state, allocated on open by stateful codecs */
+	void                         *obj;
+	/** Pool to allocate codec specific state from */
+	apr_pool_t                   *pool;
 };
 
 /** Table of codec virtual methods */
@@ -79,6 +83,8 @@ static APR_INLINE mpf_codec_t* mpf_codec_create(
 	codec->vtable = vtable;
 	codec->attribs = attribs;
 	codec->static_descriptor = descriptor;
+	codec->obj = NULL;
+	codec->pool = pool;
 	return codec;
 }
 
@@ -93,6 +99,8 @@ static APR_INLINE mpf_codec_t* mpf_codec_clone(mpf_codec_t *src_codec, apr_pool_
 	codec->vtable = src_codec->vtable;
 	codec->attribs = src_codec->attribs;
 	codec->static_descriptor = src_codec->static_descriptor;
+	codec->obj = NULL;
+	codec->pool = pool;
 	return codec;
 }
 
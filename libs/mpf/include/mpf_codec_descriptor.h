@@ -140,10 +140,16 @@ static APR_INLINE apr_size_t mpf_codec_frame_size_calculate(const mpf_codec_desc
 			descriptor->sampling_rate / 1000 / 8; /* 1000 - msec per sec, 8 - bits per byte */
 }
 
-/** Calculate samples of the frame (ts) */
+/** Get RTP clock rate, which differs from the sampling rate for G.722 (RFC3551) */
+MPF_DECLARE(apr_uint16_t) mpf_codec_rtp_clock_rate_get(const mpf_codec_descriptor_t *descriptor);
+
+/** Set sampling rate by RTP clock rate (codec name and payload type must be set beforehand) */
+MPF_DECLARE(void) mpf_codec_rtp_clock_rate_set(mpf_codec_descriptor_t *descriptor, apr_uint16_t clock_rate);
+
+/** Calculate samples of the frame (ts), measured in units of RTP clock */
 static APR_INLINE apr_size_t mpf_codec_frame_samples_calculate(const mpf_codec_descriptor_t *descriptor)
 {
-	return descriptor->channel_count * CODEC_FRAME_TIME_BASE * descriptor->sampling_rate / 1000;
+	return descriptor->channel_count * CODEC_FRAME_TIME_BASE * mpf_codec_rtp_clock_rate_get(descriptor) / 1000;
 }
 
 /** Calculate linear frame size in bytes */
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2008-2010 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef MPF_CODEC_G711_H
+#define MPF_CODEC_G711_H
+
+/**
+ * @file mpf_codec_g711.h
+ * @brief MPF G.711 Bulk Conversion Routines
+ */
+
+#include "mpf.h"
+
+APT_BEGIN_EXTERN_C
+
+/**
+ * Encode block of linear samples to u-law.
+ * @param linear the linear samples to encode
+ * @param ulaw the buffer to store u-law samples in
+ * @param count the number of samples
+ */
+MPF_DECLARE(void) mpf_g711u_encode(const apr_int16_t *linear, apr_byte_t *ulaw, apr_size_t count);
+
+/**
+ * Decode block of u-law samples to linear.
+ * @param ulaw the u-law samples to decode
+ * @param linear the buffer to store linear samples in
+ * @param count the number of samples
+ */
+MPF_DECLARE(void) mpf_g711u_decode(const apr_byte_t *ulaw, apr_int16_t *linear, apr_size_t count);
+
+/**
+ * Encode block of linear samples to A-law.
+ * @param linear the linear samples to encode
+ * @param alaw the buffer to store A-law samples in
+ * @param count the number of samples
+ */
+MPF_DECLARE(void) mpf_g711a_encode(const apr_int16_t *linear, apr_byte_t *alaw, apr_size_t count);
+
+/**
+ * Decode block of A-law samples to linear.
+ * @param alaw the A-law samples to decode
+ * @param linear the buffer to store linear samples in
+ * @param count the number of samples
+ */
+MPF_DECLARE(void) mpf_g711a_decode(const apr_byte_t *alaw, apr_int16_t *linear, apr_size_t count);
+
+APT_END_EXTERN_C
+
+#endif /* MPF_CODEC_G711_H */
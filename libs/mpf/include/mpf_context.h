@@ -25,11 +25,33 @@
  */ 
 
 #include "mpf_types.h"
+#include "mpf_object.h"
 
 APT_BEGIN_EXTERN_C
 
+/** Max length of the context name kept in the profile */
+#define MPF_CONTEXT_PROFILE_NAME_SIZE 64
+
 /** Opaque factory of media contexts */
 typedef struct mpf_context_factory_t mpf_context_factory_t;
+/** Processing profile of media contexts */
+typedef struct mpf_context_profile_t mpf_context_profile_t;
+
+/** Processing profile of media contexts collected on sampled ticks */
+struct mpf_context_profile_t {
+	/** Profiles of media processing objects per object type */
+	mpf_object_profile_t objects[MPF_OBJECT_TYPE_COUNT];
+	/** Number of sampled ticks */
+	apr_uint32_t         sample_count;
+	/** Number of context costs sampled */
+	apr_uint32_t         context_count;
+	/** Total processing time of the sampled contexts (usec) */
+	apr_uint64_t         context_total_time;
+	/** Max processing time of a context within a tick (usec) */
+	apr_uint32_t         context_max_time;
+	/** Name of the context the max processing time has been sampled for */
+	char                 context_max_name[MPF_CONTEXT_PROFILE_NAME_SIZE];
+};
  
 /**
  * Create factory of media contexts.
@@ -46,9 +68,21 @@ MPF_DECLARE(void) mpf_context_factory_destroy(mpf_context_factory_t *factory);
  */
 MPF_DECLARE(apt_bool_t) mpf_context_factory_process(mpf_context_factory_t *factory);
 
+/**
+ * Process factory of media contexts measuring the processing time of each object and context.
+ * @param factory the factory to process
+ * @param profile the profile to accumulate measurements in
+ */
+MPF_DECLARE(apt_bool_t) mpf_context_factory_profile_process(mpf_context_factory_t *factory, mpf_context_profile_t *profile);
+
+/**
+ * Get the load of the factory (number of active contexts assigned to the factory).
+ */
+MPF_DECLARE(apr_size_t) mpf_context_factory_load_get(mpf_context_factory_t *factory);
+
 /**
  * Create MPF context.
- * @param factory the factory context belongs to
+ * @param factory the factory context belongs to (might be NULL and assigned later)
  * @param name the informative name of the context
  * @param obj the external object associated with context
  * @param max_termination_count the max number of terminations in context
@@ -73,6 +107,19 @@ MPF_DECLARE(apt_bool_t) mpf_context_destroy(mpf_context_t *context);
  */
 MPF_DECLARE(void*) mpf_context_object_get(const mpf_context_t *context);
 
+/**
+ * Get the factory MPF context is assigned to.
+ * @param context the context to get factory of
+ */
+MPF_DECLARE(mpf_context_factory_t*) mpf_context_factory_get(const mpf_context_t *context);
+
+/**
+ * Assign MPF context to the factory, if not assigned yet.
+ * @param context the context to assign
+ * @param factory the factory to assign context to
+ */
+MPF_DECLARE(apt_bool_t) mpf_context_factory_assign(mpf_context_t *context, mpf_context_factory_t *factory);
+
 /**
  * Add termination to context.
  * @param context the context to add termination to
@@ -85,6 +85,8 @@ static APR_INLINE struct mpf_dtmf_detector_t *mpf_dtmf_detector_create(
 
 /**
  * Get DTMF digit from buffer of digits detected so far and remove it.
+ * The buffer is a lock-free ring: digits may be taken from another thread
+ * than the one frames are passed in, as long as it is a single thread.
  * @param detector  The detector.
  * @return DTMF character [0-9*#A-D] or NUL if the buffer is empty.
  */
@@ -99,6 +101,7 @@ MPF_DECLARE(apr_size_t) mpf_dtmf_detector_digits_lost(const struct mpf_dtmf_dete
 
 /**
  * Empty the buffer and reset detection states.
+ * Detection states are reset on the next frame passed to the detector.
  * @param detector  The detector.
  */
 MPF_DECLARE(void) mpf_dtmf_detector_reset(struct mpf_dtmf_detector_t *detector);
@@ -112,6 +115,19 @@ MPF_DECLARE(void) mpf_dtmf_detector_get_frame(
 								struct mpf_dtmf_detector_t *detector,
 								const struct mpf_frame_t *frame);
 
+/**
+ * Detect DTMF digits in frames of several detectors at once.
+ * Audio of detectors is analyzed in pairs, which is faster than
+ * passing the frames one by one to mpf_dtmf_detector_get_frame().
+ * @param detectors Array of detectors.
+ * @param frames    Array of frames, one per detector.
+ * @param count     Number of detectors.
+ */
+MPF_DECLARE(void) mpf_dtmf_detector_get_frames(
+								struct mpf_dtmf_detector_t **detectors,
+								const struct mpf_frame_t **frames,
+								apr_size_t count);
+
 /**
  * Free all resources associated with the detector.
  * @param detector  The detector.
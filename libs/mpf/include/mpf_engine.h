@@ -26,12 +26,61 @@
 
 #include "apt_task.h"
 #include "mpf_message.h"
+#include "mpf_rtp_poller.h"
+#include "mpf_context.h"
 
 APT_BEGIN_EXTERN_C
 
 /** MPF task message definition */
 typedef apt_task_msg_t mpf_task_msg_t;
 
+/** Max number of workers (scheduler threads) of the engine */
+#define MPF_ENGINE_MAX_WORKER_COUNT 64
+
+/** MPF engine worker statistics */
+typedef struct mpf_engine_worker_stat_t mpf_engine_worker_stat_t;
+
+/** MPF engine worker statistics */
+struct mpf_engine_worker_stat_t {
+	/** Number of active contexts processed by the worker */
+	apr_size_t          context_count;
+	/** Number of processed ticks */
+	apr_uint32_t        tick_count;
+	/** Number of ticks processing of which took longer than the tick itself */
+	apr_uint32_t        overrun_count;
+	/** Max processing time of a tick (usec) */
+	apr_uint32_t        max_tick_duration;
+	/** RTP poller statistics */
+	mpf_rtp_poller_stat_t rtp_stat;
+};
+
+/** Number of buckets of the tick duration histogram */
+#define MPF_TICK_HISTOGRAM_SIZE 10
+
+/** MPF engine worker profile */
+typedef struct mpf_engine_profile_t mpf_engine_profile_t;
+
+/** MPF engine worker profile (collected only while profiling is enabled) */
+struct mpf_engine_profile_t {
+	/** Histogram of tick durations, the upper bounds of the buckets are
+	100, 250, 500, 1000, 2000, 5000, 10000, 20000, 50000 usec and infinity */
+	apr_uint32_t          tick_histogram[MPF_TICK_HISTOGRAM_SIZE];
+	/** Number of profiled ticks */
+	apr_uint32_t          tick_count;
+	/** Number of profiled ticks processing of which took longer than the tick itself */
+	apr_uint32_t          overrun_count;
+	/** Total processing time of the profiled ticks (usec) */
+	apr_uint64_t          total_tick_duration;
+	/** Max processing time of a tick (usec) */
+	apr_uint32_t          max_tick_duration;
+	/** Number of ticks fired late by the scheduler */
+	apr_uint32_t          late_tick_count;
+	/** Max drift of the scheduler clock behind the schedule (usec) */
+	apr_uint32_t          max_time_drift;
+	/** Processing profile of media contexts and objects (sampled ticks only) */
+	mpf_context_profile_t context_profile;
+};
+
 /**
  * Create MPF engine.
  * @param id the identifier of the engine
@@ -149,10 +198,66 @@ MPF_DECLARE(apt_bool_t) mpf_engine_message_send(mpf_engine_t *engine, mpf_task_m
 /**
  * Set scheduler rate.
  * @param engine the engine to set rate for
- * @param rate the rate (n times faster than real-time)
+ * @param rate the rate (n times faster than real-time, 1 to 10)
+ * @return FALSE if the rate is out of range, the real-time rate is used then
  */
 MPF_DECLARE(apt_bool_t) mpf_engine_scheduler_rate_set(mpf_engine_t *engine, unsigned long rate);
 
+/**
+ * Set the number of workers (scheduler threads) to distribute media contexts across.
+ * @param engine the engine to set the number of workers for
+ * @param worker_count the number of workers
+ * @remark should be called before the engine is started
+ */
+MPF_DECLARE(apt_bool_t) mpf_engine_worker_count_set(mpf_engine_t *engine, apr_size_t worker_count);
+
+/**
+ * Get the number of workers.
+ * @param engine the engine to get the number of workers of
+ */
+MPF_DECLARE(apr_size_t) mpf_engine_worker_count_get(const mpf_engine_t *engine);
+
+/**
+ * Get the statistics of the worker.
+ * @param engine the engine to get statistics of
+ * @param id the identifier (index) of the worker
+ * @param stat the statistics to fill
+ */
+MPF_DECLARE(apt_bool_t) mpf_engine_worker_stat_get(const mpf_engine_t *engine, apr_size_t id, mpf_engine_worker_stat_t *stat);
+
+/**
+ * Enable or disable profiling of the engine.
+ * @param engine the engine to set profiling for
+ * @param enable whether to collect the profile
+ * @param sample_rate the number of ticks to sample objects and contexts once per (0 - default)
+ * @param dump_interval the interval to periodically dump the profile to the log at (msec, 0 - never)
+ * @remark the tick durations are profiled every tick, the objects and contexts are
+ * timed every sample_rate tick only, so the overhead of profiling stays small
+ */
+MPF_DECLARE(apt_bool_t) mpf_engine_profiling_set(mpf_engine_t *engine, apt_bool_t enable, apr_size_t sample_rate, apr_size_t dump_interval);
+
+/**
+ * Get the bucket of the tick duration histogram the duration falls into.
+ * @param duration the tick duration (usec)
+ * @return the index of the bucket, the upper bound of which the duration is below
+ */
+MPF_DECLARE(apr_size_t) mpf_engine_tick_histogram_bucket_get(apr_uint32_t duration);
+
+/**
+ * Get the profile of the worker.
+ * @param engine the engine to get profile of
+ * @param id the identifier (index) of the worker
+ * @param profile the profile to fill
+ */
+MPF_DECLARE(apt_bool_t) mpf_engine_worker_profile_get(const mpf_engine_t *engine, apr_size_t id, mpf_engine_profile_t *profile);
+
+/**
+ * Get the profile of the engine aggregated across all the workers.
+ * @param engine the engine to get profile of
+ * @param profile the profile to fill
+ */
+MPF_DECLARE(apt_bool_t) mpf_engine_profile_get(const mpf_engine_t *engine, mpf_engine_profile_t *profile);
+
 /**
  * Get the identifier of the engine .
  * @param engine the engine to get name of
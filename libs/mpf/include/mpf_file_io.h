@@ -0,0 +1,120 @@
+/*
+ * Copyright 2008-2010 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef MPF_FILE_IO_H
+#define MPF_FILE_IO_H
+
+/**
+ * @file mpf_file_io.h
+ * @brief MPF Asynchronous File I/O
+ * @remark Files are read and written by a shared background thread.
+ *         Audio stream callbacks only copy data to/from per-file rings,
+ *         hence they never block on disk access.
+ */
+
+#include "mpf.h"
+
+APT_BEGIN_EXTERN_C
+
+/** Default size of the buffer (ring) of each file in bytes */
+#define MPF_FILE_IO_DEFAULT_BUFFER_SIZE	65536
+
+/** Opaque file I/O (background thread) declaration */
+typedef struct mpf_file_io_t mpf_file_io_t;
+/** Opaque asynchronous file declaration */
+typedef struct mpf_async_file_t mpf_async_file_t;
+
+/** Enumeration of asynchronous file modes */
+typedef enum {
+	MPF_ASYNC_FILE_READ,  /**< read from file */
+	MPF_ASYNC_FILE_WRITE  /**< write to file */
+} mpf_async_file_mode_e;
+
+/**
+ * Create file I/O.
+ * @param buffer_size the size of the buffer of each file (rounded up to a power of 2)
+ * @param pool the pool to allocate memory from
+ */
+MPF_DECLARE(mpf_file_io_t*) mpf_file_io_create(apr_size_t buffer_size, apr_pool_t *pool);
+
+/**
+ * Start file I/O (background thread).
+ * @param file_io the file I/O to start
+ */
+MPF_DECLARE(apt_bool_t) mpf_file_io_start(mpf_file_io_t *file_io);
+
+/**
+ * Stop file I/O, flush and detach the remaining files.
+ * @param file_io the file I/O to stop
+ * @remark The files still open remain valid until closed by their owners,
+ *         but nothing is written or fetched anymore.
+ */
+MPF_DECLARE(apt_bool_t) mpf_file_io_stop(mpf_file_io_t *file_io);
+
+/**
+ * Open file (may block, not to be called from audio stream callbacks).
+ * @param file_io the file I/O to open file by
+ * @param file_path the path of the file to open
+ * @param mode the mode to open file in
+ * @return NULL if the file can't be opened or the file I/O is not running
+ * @remark Read buffer is prefilled before return.
+ */
+MPF_DECLARE(mpf_async_file_t*) mpf_async_file_open(mpf_file_io_t *file_io, const char *file_path, mpf_async_file_mode_e mode);
+
+/**
+ * Close file (never blocks).
+ * @param file the file to close
+ * @remark The pending data is flushed in background, the file must not be used afterwards.
+ *         The file is freed once both the owner and the background thread are done with it.
+ */
+MPF_DECLARE(void) mpf_async_file_close(mpf_async_file_t *file);
+
+/**
+ * Write data to file (never blocks).
+ * @param file the file to write to
+ * @param data the data to write
+ * @param size the size of the data
+ * @return FALSE if the buffer is full and the data is dropped, otherwise TRUE
+ */
+MPF_DECLARE(apt_bool_t) mpf_async_file_write(mpf_async_file_t *file, const void *data, apr_size_t size);
+
+/**
+ * Read data from file (never blocks).
+ * @param file the file to read from
+ * @param data the buffer to read data to
+ * @param size the size of the data to read
+ * @return TRUE if the whole size is read, otherwise FALSE (nothing is read)
+ */
+MPF_DECLARE(apt_bool_t) mpf_async_file_read(mpf_async_file_t *file, void *data, apr_size_t size);
+
+/**
+ * Check whether the whole file is read.
+ * @param file the file to check
+ * @remark FALSE returned after failed read indicates the data is not fetched yet.
+ */
+MPF_DECLARE(apt_bool_t) mpf_async_file_eof(const mpf_async_file_t *file);
+
+/**
+ * Get the number of writes dropped since the buffer was full.
+ * @param file the file to get the count of
+ */
+MPF_DECLARE(apr_uint32_t) mpf_async_file_overflow_count_get(const mpf_async_file_t *file);
+
+APT_END_EXTERN_C
+
+#endif /* MPF_FILE_IO_H */
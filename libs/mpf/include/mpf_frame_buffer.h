@@ -30,23 +30,64 @@ APT_BEGIN_EXTERN_C
 
 /** Opaque frame buffer declaration */
 typedef struct mpf_frame_buffer_t mpf_frame_buffer_t;
+/** Frame buffer statistics declaration */
+typedef struct mpf_frame_buffer_stat_t mpf_frame_buffer_stat_t;
 
+/** Policy of frame buffer on underrun (no frame available to read) */
+typedef enum {
+	MPF_FRAME_BUFFER_UNDERRUN_NONE,    /**< read frame of no media (default) */
+	MPF_FRAME_BUFFER_UNDERRUN_SILENCE, /**< read audio frame of silence (zero samples of linear PCM) */
+	MPF_FRAME_BUFFER_UNDERRUN_HOLD     /**< read the last read audio frame once again */
+} mpf_frame_buffer_underrun_policy_e;
 
-/** Create frame buffer */
+/** Frame buffer statistics */
+struct mpf_frame_buffer_stat_t {
+	/** Number of frames written */
+	apr_uint32_t write_count;
+	/** Number of frames read */
+	apr_uint32_t read_count;
+	/** Number of frames dropped on write, since the buffer was full */
+	apr_uint32_t overflow_count;
+	/** Number of reads, which found the buffer empty */
+	apr_uint32_t underrun_count;
+};
+
+
+/**
+ * Create frame buffer.
+ * @param frame_size the size of frame
+ * @param frame_count the max number of frames to buffer
+ * @param pool the pool to allocate memory from
+ * @remark The buffer is wait-free for one writer and one reader, which may run in different threads.
+ */
 mpf_frame_buffer_t* mpf_frame_buffer_create(apr_size_t frame_size, apr_size_t frame_count, apr_pool_t *pool);
 
 /** Destroy frame buffer */
 void mpf_frame_buffer_destroy(mpf_frame_buffer_t *buffer);
 
-/** Restart frame buffer */
+/**
+ * Restart frame buffer.
+ * @remark Buffered frames and accumulated partial frame are discarded, to be called by the writer.
+ */
 apt_bool_t mpf_frame_buffer_restart(mpf_frame_buffer_t *buffer);
 
-/** Write frame to buffer */
+/**
+ * Write frame to buffer.
+ * @remark Data of any size can be written, the remainder, which doesn't make up
+ * a complete frame, is accumulated until the next write. FALSE is returned
+ * if data is dropped, since the buffer is full.
+ */
 apt_bool_t mpf_frame_buffer_write(mpf_frame_buffer_t *buffer, const mpf_frame_t *frame);
 
 /** Read frame from buffer */
 apt_bool_t mpf_frame_buffer_read(mpf_frame_buffer_t *buffer, mpf_frame_t *frame);
 
+/** Set underrun policy */
+void mpf_frame_buffer_underrun_policy_set(mpf_frame_buffer_t *buffer, mpf_frame_buffer_underrun_policy_e policy);
+
+/** Get frame buffer statistics */
+void mpf_frame_buffer_stat_get(const mpf_frame_buffer_t *buffer, mpf_frame_buffer_stat_t *stat);
+
 APT_END_EXTERN_C
 
 #endif /* MPF_FRAME_BUFFER_H */
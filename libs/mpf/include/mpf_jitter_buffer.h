@@ -27,6 +27,7 @@
 #include "mpf_frame.h"
 #include "mpf_codec.h"
 #include "mpf_rtp_descriptor.h"
+#include "mpf_rtp_stat.h"
 
 APT_BEGIN_EXTERN_C
 
@@ -63,6 +64,9 @@ apt_bool_t mpf_jitter_buffer_read(mpf_jitter_buffer_t *jb, mpf_frame_t *media_fr
 /** Get current playout delay */
 apr_uint32_t mpf_jitter_buffer_playout_delay_get(const mpf_jitter_buffer_t *jb);
 
+/** Get jitter buffer statistics */
+void mpf_jitter_buffer_stat_get(const mpf_jitter_buffer_t *jb, rtp_jb_stat_t *stat);
+
 APT_END_EXTERN_C
 
 #endif /* MPF_JITTER_BUFFER_H */
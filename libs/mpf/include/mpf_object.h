@@ -30,11 +30,25 @@ APT_BEGIN_EXTERN_C
 
 /** MPF object declaration */
 typedef struct mpf_object_t mpf_object_t;
+/** MPF object profile declaration */
+typedef struct mpf_object_profile_t mpf_object_profile_t;
+
+/** Enumeration of media processing object types */
+typedef enum {
+	MPF_OBJECT_TYPE_BRIDGE,      /**< bridge with linear (decoded) media path */
+	MPF_OBJECT_TYPE_NULL_BRIDGE, /**< bridge passing encoded frames through */
+	MPF_OBJECT_TYPE_MIXER,       /**< mixer (N sources -> 1 sink) */
+	MPF_OBJECT_TYPE_MULTIPLIER,  /**< multiplier (1 source -> N sinks) */
+
+	MPF_OBJECT_TYPE_COUNT        /**< number of object types */
+} mpf_object_type_e;
 
 /** Media processing objects base */
 struct mpf_object_t {
 	/** Informative name used for debugging */
-	const char *name;
+	const char       *name;
+	/** Object type used for profiling */
+	mpf_object_type_e type;
 	/** Virtual destroy */
 	apt_bool_t (*destroy)(mpf_object_t *object);
 	/** Virtual process */
@@ -43,10 +57,21 @@ struct mpf_object_t {
 	void (*trace)(mpf_object_t *object);
 };
 
+/** Processing profile of media processing objects of the same type */
+struct mpf_object_profile_t {
+	/** Number of profiled (sampled) process calls */
+	apr_uint32_t process_count;
+	/** Total processing time of the profiled calls (usec) */
+	apr_uint64_t total_time;
+	/** Max processing time of a single call (usec) */
+	apr_uint32_t max_time;
+};
+
 /** Initialize object */
-static APR_INLINE void mpf_object_init(mpf_object_t *object, const char *name)
+static APR_INLINE void mpf_object_init(mpf_object_t *object, const char *name, mpf_object_type_e type)
 {
 	object->name = name;
+	object->type = type;
 	object->destroy = NULL;
 	object->process = NULL;
 	object->trace = NULL;
@@ -66,6 +91,18 @@ static APR_INLINE void mpf_object_process(mpf_object_t *object)
 		object->process(object);
 }
 
+/** Get the name of the object type */
+static APR_INLINE const char* mpf_object_type_str_get(mpf_object_type_e type)
+{
+	static const char *names[MPF_OBJECT_TYPE_COUNT] = {
+		"bridge",
+		"null-bridge",
+		"mixer",
+		"multiplier"
+	};
+	return (type < MPF_OBJECT_TYPE_COUNT) ? names[type] : "unknown";
+}
+
 /** Trace media path */
 static APR_INLINE void mpf_object_trace(mpf_object_t *object)
 {
@@ -103,6 +103,10 @@ struct mpf_jb_config_t {
 	apr_byte_t adaptive;
 	/** Enable/disable time skew detection */
 	apr_byte_t time_skew_detection;
+	/** Percentile of transit delays of received packets the adaptive playout delay is targeted at */
+	apr_byte_t playout_percentile;
+	/** Enable/disable packet loss concealment (G.711 and L16) */
+	apr_byte_t plc;
 };
 
 /** RTCP BYE transmission policy */
@@ -124,6 +128,8 @@ struct mpf_rtp_config_t {
 	apr_port_t        rtp_port_max;
 	/** Current RTP port */
 	apr_port_t        rtp_port_cur;
+	/** Receive RTP via socket poller of the media engine rather than per stream */
+	apt_bool_t        rtp_poller;
 };
 
 /** RTP settings */
@@ -184,6 +190,8 @@ static APR_INLINE void mpf_jb_config_init(mpf_jb_config_t *jb_config)
 	jb_config->min_playout_delay = 0;
 	jb_config->max_playout_delay = 0;
 	jb_config->time_skew_detection = 1;
+	jb_config->playout_percentile = 95;
+	jb_config->plc = 1;
 }
 
 /** Allocate RTP config */
@@ -195,6 +203,7 @@ static APR_INLINE mpf_rtp_config_t* mpf_rtp_config_alloc(apr_pool_t *pool)
 	rtp_config->rtp_port_cur = 0;
 	rtp_config->rtp_port_min = 0;
 	rtp_config->rtp_port_max = 0;
+	rtp_config->rtp_poller = FALSE;
 	return rtp_config;
 }
 
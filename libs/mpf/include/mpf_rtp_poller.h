@@ -0,0 +1,102 @@
+/*
+ * Copyright 2008-2010 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#ifndef MPF_RTP_POLLER_H
+#define MPF_RTP_POLLER_H
+
+/**
+ * @file mpf_rtp_poller.h
+ * @brief MPF RTP Socket Poller (Batched Receive of Ready Sockets)
+ */
+
+#include <apr_poll.h>
+#include "mpf_types.h"
+
+APT_BEGIN_EXTERN_C
+
+/** RTP poller statistics */
+typedef struct mpf_rtp_poller_stat_t mpf_rtp_poller_stat_t;
+
+/** Prototype of received packet handler */
+typedef apt_bool_t (*mpf_rtp_poller_handler_f)(void *obj, void *buffer, apr_size_t size);
+
+/** RTP poller statistics */
+struct mpf_rtp_poller_stat_t {
+	/** Number of registered sockets */
+	apr_size_t   socket_count;
+	/** Number of poll system calls */
+	apr_uint32_t poll_count;
+	/** Number of receive system calls */
+	apr_uint32_t recv_count;
+	/** Number of received packets */
+	apr_uint32_t packet_count;
+};
+
+/**
+ * Create RTP poller.
+ * @param max_ready_count the max number of ready sockets to fetch per poll
+ * @param pool the pool to allocate memory from
+ */
+MPF_DECLARE(mpf_rtp_poller_t*) mpf_rtp_poller_create(apr_size_t max_ready_count, apr_pool_t *pool);
+
+/**
+ * Destroy RTP poller.
+ * @param poller the poller to destroy
+ */
+MPF_DECLARE(void) mpf_rtp_poller_destroy(mpf_rtp_poller_t *poller);
+
+/**
+ * Add socket to RTP poller.
+ * @param poller the poller to add socket to
+ * @param socket the socket to add
+ * @param handler the handler to call per received packet
+ * @param obj the external object to pass to the handler
+ * @param pool the pool to allocate the poll descriptor from
+ * @remark the returned descriptor must be passed to mpf_rtp_poller_remove()
+ */
+MPF_DECLARE(apr_pollfd_t*) mpf_rtp_poller_add(
+								mpf_rtp_poller_t *poller,
+								apr_socket_t *socket,
+								mpf_rtp_poller_handler_f handler,
+								void *obj,
+								apr_pool_t *pool);
+
+/**
+ * Remove socket from RTP poller.
+ * @param poller the poller to remove socket from
+ * @param descriptor the descriptor returned by mpf_rtp_poller_add()
+ */
+MPF_DECLARE(apt_bool_t) mpf_rtp_poller_remove(mpf_rtp_poller_t *poller, apr_pollfd_t *descriptor);
+
+/**
+ * Receive and dispatch packets from all the ready sockets without blocking.
+ * @param poller the poller to process
+ */
+MPF_DECLARE(apt_bool_t) mpf_rtp_poller_process(mpf_rtp_poller_t *poller);
+
+/**
+ * Get RTP poller statistics.
+ * @param poller the poller to get statistics of
+ * @param stat the statistics to fill
+ */
+MPF_DECLARE(void) mpf_rtp_poller_stat_get(const mpf_rtp_poller_t *poller, mpf_rtp_poller_stat_t *stat);
+
+
+APT_END_EXTERN_C
+
+#endif /* MPF_RTP_POLLER_H */
@@ -31,6 +31,9 @@ APT_BEGIN_EXTERN_C
 /** RTP receiver statistics */
 typedef struct rtp_rx_stat_t rtp_rx_stat_t;
 
+/** Jitter buffer statistics of RTP receiver */
+typedef struct rtp_jb_stat_t rtp_jb_stat_t;
+
 /** RTCP statistics used in Sender Report (SR) */
 typedef struct rtcp_sr_stat_t rtcp_sr_stat_t;
 /** RTCP statistics used in Receiver Report (RR) */
@@ -56,6 +59,30 @@ struct rtp_rx_stat_t {
 	apr_byte_t   restarts;
 };
 
+/** Jitter buffer statistics of RTP receiver */
+struct rtp_jb_stat_t {
+	/** current depth of the buffer in msec */
+	apr_uint32_t depth;
+	/** current playout delay in msec */
+	apr_uint32_t playout_delay;
+	/** playout delay estimated by the percentile of transit delays in msec */
+	apr_uint32_t target_playout_delay;
+
+	/** number of packets arrived too late to be played out */
+	apr_uint32_t late_packets;
+	/** number of packets arrived too early (buffer is full) */
+	apr_uint32_t early_packets;
+
+	/** number of frames missing in the buffer at playout time */
+	apr_uint32_t lost_frames;
+	/** number of frames synthesized by packet loss concealment */
+	apr_uint32_t concealed_frames;
+	/** number of times two frames were merged into one to reduce the delay */
+	apr_uint32_t accelerated_frames;
+	/** number of frames synthesized to increase the delay */
+	apr_uint32_t expanded_frames;
+};
+
 /** RTCP statistics used in Sender Report (SR)  */
 struct rtcp_sr_stat_t {
 	/** sender source identifier */
@@ -110,6 +137,12 @@ static APR_INLINE void mpf_rtp_rx_stat_reset(rtp_rx_stat_t *rx_stat)
 	memset(rx_stat,0,sizeof(rtp_rx_stat_t));
 }
 
+/** Reset jitter buffer statistics */
+static APR_INLINE void mpf_rtp_jb_stat_reset(rtp_jb_stat_t *jb_stat)
+{
+	memset(jb_stat,0,sizeof(rtp_jb_stat_t));
+}
+
 APT_END_EXTERN_C
 
 #endif /* MPF_RTP_STAT_H */
@@ -26,6 +26,7 @@
 
 #include "mpf_stream.h"
 #include "mpf_rtp_descriptor.h"
+#include "mpf_rtp_stat.h"
 
 APT_BEGIN_EXTERN_C
 
@@ -57,6 +58,15 @@ MPF_DECLARE(apt_bool_t) mpf_rtp_stream_remove(mpf_audio_stream_t *stream);
  */
 MPF_DECLARE(apt_bool_t) mpf_rtp_stream_modify(mpf_audio_stream_t *stream, mpf_rtp_stream_descriptor_t *descriptor);
 
+/**
+ * Get receiver and jitter buffer statistics of RTP stream.
+ * @param stream RTP stream to get statistics of
+ * @param rx_stat the receiver statistics to fill (optional)
+ * @param jb_stat the jitter buffer statistics to fill (optional)
+ * @remark should be called from the context of the media engine, the stream is processed in
+ */
+MPF_DECLARE(apt_bool_t) mpf_rtp_stream_rx_stat_get(mpf_audio_stream_t *stream, rtp_rx_stat_t *rx_stat, rtp_jb_stat_t *jb_stat);
+
 APT_END_EXTERN_C
 
 #endif /* MPF_RTP_STREAM_H */
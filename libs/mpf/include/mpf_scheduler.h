@@ -31,6 +31,19 @@ APT_BEGIN_EXTERN_C
 /** Prototype of scheduler callback */
 typedef void (*mpf_scheduler_proc_f)(mpf_scheduler_t *scheduler, void *obj);
 
+/** Scheduler statistics */
+typedef struct mpf_scheduler_stat_t mpf_scheduler_stat_t;
+
+/** Scheduler statistics (collected only if the scheduler runs its own clock thread) */
+struct mpf_scheduler_stat_t {
+	/** Number of ticks fired with no sleep, since the clock was behind the schedule by a whole tick */
+	apr_uint32_t late_count;
+	/** Current drift of the clock behind the schedule (usec) */
+	apr_uint32_t time_drift;
+	/** Max drift of the clock behind the schedule (usec) */
+	apr_uint32_t max_time_drift;
+};
+
 /** Create scheduler */
 MPF_DECLARE(mpf_scheduler_t*) mpf_scheduler_create(apr_pool_t *pool);
 
@@ -62,6 +75,9 @@ MPF_DECLARE(apt_bool_t) mpf_scheduler_start(mpf_scheduler_t *scheduler);
 /** Stop scheduler */
 MPF_DECLARE(apt_bool_t) mpf_scheduler_stop(mpf_scheduler_t *scheduler);
 
+/** Get scheduler statistics */
+MPF_DECLARE(void) mpf_scheduler_stat_get(const mpf_scheduler_t *scheduler, mpf_scheduler_stat_t *stat);
+
 
 APT_END_EXTERN_C
 
@@ -65,6 +65,8 @@ struct mpf_termination_t {
 	const mpf_codec_manager_t      *codec_manager;
 	/** Timer queue */
 	apt_timer_queue_t              *timer_queue;
+	/** RTP poller of the engine worker processing the termination */
+	mpf_rtp_poller_t               *rtp_poller;
 	/** Termination factory entire termination created by */
 	mpf_termination_factory_t      *termination_factory;
 	/** Table of virtual methods */
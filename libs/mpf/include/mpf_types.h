@@ -52,6 +52,9 @@ typedef struct mpf_audio_stream_t mpf_audio_stream_t;
 /** Opaque MPF video stream declaration */
 typedef struct mpf_video_stream_t mpf_video_stream_t;
 
+/** Opaque MPF RTP poller declaration */
+typedef struct mpf_rtp_poller_t mpf_rtp_poller_t;
+
 
 APT_END_EXTERN_C
 
@@ -16,9 +16,27 @@
  * $Id$
  */
 
+#include <math.h>
 #include "mpf_activity_detector.h"
 #include "apt_log.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MPF_DETECTOR_SSE2
+#include <emmintrin.h>
+#endif
+
+/** Number of bands analyzed in adaptive mode (low, mid, high) */
+#define DETECTOR_BAND_COUNT             3
+/** Frames quieter than this level [dB] are never active */
+#define DETECTOR_LEVEL_MIN              30.0f
+/** SNR threshold [dB] at the lowest and the highest sensitivity */
+#define DETECTOR_SNR_THRESHOLD_MAX      12.0f
+#define DETECTOR_SNR_THRESHOLD_MIN      3.0f
+/** Noise floor adaptation rates: decrease, increase in inactivity, increase in activity */
+#define DETECTOR_FLOOR_FALL_RATE        0.3f
+#define DETECTOR_FLOOR_RISE_RATE        0.05f
+#define DETECTOR_FLOOR_CREEP_RATE       0.002f
+
 /** Detector states */
 typedef enum {
 	DETECTOR_STATE_INACTIVITY,           /**< inactivity detected */
@@ -43,6 +61,21 @@ struct mpf_activity_detector_t {
 	mpf_detector_state_e state;
 	/* duration spent in current state  */
 	apr_size_t           duration;
+
+	/* detection mode */
+	mpf_detector_mode_e  mode;
+	/* SNR threshold [dB] derived from sensitivity */
+	float                snr_threshold;
+	/* period activity is held after the last active frame */
+	apr_size_t           hangover_timeout;
+	/* remaining period activity is held */
+	apr_size_t           hangover;
+	/* noise floor [dB] per band */
+	float                noise_floor[DETECTOR_BAND_COUNT];
+	/* whether the noise floor is estimated yet */
+	apt_bool_t           noise_floor_set;
+	/* last two samples of the previous frame the band filters are run on */
+	float                history[2];
 };
 
 /** Create activity detector */
@@ -55,14 +88,47 @@ MPF_DECLARE(mpf_activity_detector_t*) mpf_activity_detector_create(apr_pool_t *p
 	detector->noinput_timeout = 5000; /* 5 s */
 	detector->duration = 0;
 	detector->state = DETECTOR_STATE_INACTIVITY;
+	detector->mode = MPF_DETECTOR_MODE_LEVEL;
+	detector->hangover_timeout = 100; /* 0.1 s */
+	detector->hangover = 0;
+	detector->noise_floor_set = FALSE;
+	detector->history[0] = detector->history[1] = 0;
+	mpf_activity_detector_sensitivity_set(detector,0.5f);
 	return detector;
 }
 
 /** Reset activity detector */
 MPF_DECLARE(void) mpf_activity_detector_reset(mpf_activity_detector_t *detector)
 {
+	/* the noise floor is a property of the line, it outlives the reset */
 	detector->duration = 0;
 	detector->state = DETECTOR_STATE_INACTIVITY;
+	detector->hangover = 0;
+}
+
+/** Set detection mode */
+MPF_DECLARE(void) mpf_activity_detector_mode_set(mpf_activity_detector_t *detector, mpf_detector_mode_e mode)
+{
+	detector->mode = mode;
+}
+
+/** Set sensitivity of adaptive detection */
+MPF_DECLARE(void) mpf_activity_detector_sensitivity_set(mpf_activity_detector_t *detector, float sensitivity)
+{
+	if(sensitivity < 0) {
+		sensitivity = 0;
+	}
+	else if(sensitivity > 1) {
+		sensitivity = 1;
+	}
+	detector->snr_threshold = DETECTOR_SNR_THRESHOLD_MAX -
+		(DETECTOR_SNR_THRESHOLD_MAX - DETECTOR_SNR_THRESHOLD_MIN) * sensitivity;
+}
+
+/** Set period voice activity is held after the last active frame */
+MPF_DECLARE(void) mpf_activity_detector_hangover_set(mpf_activity_detector_t *detector, apr_size_t hangover_timeout)
+{
+	detector->hangover_timeout = hangover_timeout;
 }
 
 /** Set threshold of voice activity (silence) level */
@@ -115,21 +181,185 @@ static apr_size_t mpf_activity_detector_level_calculate(const mpf_frame_t *frame
 	return sum / count;
 }
 
+#ifdef MPF_DETECTOR_SSE2
+/** Convert 4 linear samples to float */
+static APR_INLINE __m128 mpf_activity_detector_samples_load(const apr_int16_t *samples)
+{
+	__m128i x = _mm_loadl_epi64((const __m128i*)samples);
+	return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x,x),16));
+}
+
+/** Horizontal sum of 4 floats */
+static APR_INLINE float mpf_activity_detector_hsum(__m128 v)
+{
+	v = _mm_add_ps(v,_mm_movehl_ps(v,v));
+	v = _mm_add_ss(v,_mm_shuffle_ps(v,v,_MM_SHUFFLE(1,1,1,1)));
+	return _mm_cvtss_f32(v);
+}
+#endif
+
+/**
+ * Calculate energies [dB] of the frame in 3 bands by two-tap filters:
+ * low x(t)+x(t-1), mid x(t)-x(t-2) (peaks at fs/4), high x(t)-x(t-1).
+ */
+static void mpf_activity_detector_bands_calculate(mpf_activity_detector_t *detector, const mpf_frame_t *frame, float *energies)
+{
+	apr_size_t count = frame->codec_frame.size/2;
+	const apr_int16_t *samples = frame->codec_frame.buffer;
+	float x1 = detector->history[1];
+	float x2 = detector->history[0];
+	float low = 0, mid = 0, high = 0;
+	float x0, v;
+	apr_size_t i = 0;
+	apr_size_t b;
+
+	if(!count) {
+		energies[0] = energies[1] = energies[2] = 0;
+		return;
+	}
+
+	/* the first two samples depend on the previous frame */
+	for(; i<2 && i<count; i++) {
+		x0 = samples[i];
+		v = x0 + x1; low += v * v;
+		v = x0 - x2; mid += v * v;
+		v = x0 - x1; high += v * v;
+		x2 = x1;
+		x1 = x0;
+	}
+
+#ifdef MPF_DETECTOR_SSE2
+	{
+		__m128 low4 = _mm_setzero_ps();
+		__m128 mid4 = _mm_setzero_ps();
+		__m128 high4 = _mm_setzero_ps();
+		__m128 v0, v1, v2, t;
+		for(; i+4<=count; i+=4) {
+			v0 = mpf_activity_detector_samples_load(samples + i);
+			v1 = mpf_activity_detector_samples_load(samples + i - 1);
+			v2 = mpf_activity_detector_samples_load(samples + i - 2);
+			t = _mm_add_ps(v0,v1);
+			low4 = _mm_add_ps(low4,_mm_mul_ps(t,t));
+			t = _mm_sub_ps(v0,v2);
+			mid4 = _mm_add_ps(mid4,_mm_mul_ps(t,t));
+			t = _mm_sub_ps(v0,v1);
+			high4 = _mm_add_ps(high4,_mm_mul_ps(t,t));
+		}
+		low += mpf_activity_detector_hsum(low4);
+		mid += mpf_activity_detector_hsum(mid4);
+		high += mpf_activity_detector_hsum(high4);
+	}
+#endif
+
+	for(; i<count; i++) {
+		x0 = samples[i];
+		x1 = samples[i-1];
+		x2 = samples[i-2];
+		v = x0 + x1; low += v * v;
+		v = x0 - x2; mid += v * v;
+		v = x0 - x1; high += v * v;
+	}
+
+	detector->history[0] = count >= 2 ? samples[count-2] : detector->history[1];
+	detector->history[1] = samples[count-1];
+
+	/* mean power per sample, the filters have gain of 2 */
+	energies[0] = low;
+	energies[1] = mid;
+	energies[2] = high;
+	for(b=0; b<DETECTOR_BAND_COUNT; b++) {
+		energies[b] = 10 * log10f(energies[b] / (4 * count) + 1);
+	}
+}
+
+/** Classify the frame by band energies compared to the noise floor and adapt the floor */
+static apt_bool_t mpf_activity_detector_adaptive_classify(mpf_activity_detector_t *detector, const mpf_frame_t *frame)
+{
+	float energies[DETECTOR_BAND_COUNT];
+	float level = 0;
+	float snr = 0;
+	float rate;
+	apt_bool_t active = FALSE;
+	apr_size_t b;
+
+	if((frame->type & MEDIA_FRAME_TYPE_AUDIO) == MEDIA_FRAME_TYPE_AUDIO) {
+		mpf_activity_detector_bands_calculate(detector,frame,energies);
+		if(detector->noise_floor_set == FALSE) {
+			/* start from the first frame, the floor quickly falls if it is voice */
+			for(b=0; b<DETECTOR_BAND_COUNT; b++) {
+				detector->noise_floor[b] = energies[b];
+			}
+			detector->noise_floor_set = TRUE;
+		}
+
+		/* voice stands out of the noise in at least one band, which depends on sampling rate */
+		for(b=0; b<DETECTOR_BAND_COUNT; b++) {
+			level += energies[b];
+			if(energies[b] - detector->noise_floor[b] > snr) {
+				snr = energies[b] - detector->noise_floor[b];
+			}
+		}
+		level /= DETECTOR_BAND_COUNT;
+		if(level >= DETECTOR_LEVEL_MIN && snr >= detector->snr_threshold) {
+			active = TRUE;
+		}
+#if 0
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Activity Detector level [%.1f] snr [%.1f] floor [%.1f %.1f %.1f]",
+			level,snr,detector->noise_floor[0],detector->noise_floor[1],detector->noise_floor[2]);
+#endif
+
+		/* the floor follows the noise, only creeping up while voice is present */
+		for(b=0; b<DETECTOR_BAND_COUNT; b++) {
+			if(energies[b] < detector->noise_floor[b]) {
+				rate = DETECTOR_FLOOR_FALL_RATE;
+			}
+			else if(active == FALSE && !detector->hangover) {
+				rate = DETECTOR_FLOOR_RISE_RATE;
+			}
+			else {
+				rate = DETECTOR_FLOOR_CREEP_RATE;
+			}
+			detector->noise_floor[b] += rate * (energies[b] - detector->noise_floor[b]);
+		}
+	}
+
+	/* hold activity over short pauses */
+	if(active == TRUE) {
+		detector->hangover = detector->hangover_timeout;
+	}
+	else if(detector->hangover) {
+		detector->hangover = detector->hangover > CODEC_FRAME_TIME_BASE ? detector->hangover - CODEC_FRAME_TIME_BASE : 0;
+		active = TRUE;
+	}
+	return active;
+}
+
 /** Process current frame */
 MPF_DECLARE(mpf_detector_event_e) mpf_activity_detector_process(mpf_activity_detector_t *detector, const mpf_frame_t *frame)
 {
 	mpf_detector_event_e det_event = MPF_DETECTOR_EVENT_NONE;
-	apr_size_t level = 0;
-	if((frame->type & MEDIA_FRAME_TYPE_AUDIO) == MEDIA_FRAME_TYPE_AUDIO) {
-		/* first, calculate current activity level of processed frame */
-		level = mpf_activity_detector_level_calculate(frame);
+	apt_bool_t active;
+	/* period of inactivity already elapsed once activity is no longer held */
+	apr_size_t held = 0;
+
+	if(detector->mode == MPF_DETECTOR_MODE_ADAPTIVE) {
+		active = mpf_activity_detector_adaptive_classify(detector,frame);
+		held = detector->hangover_timeout;
+	}
+	else {
+		apr_size_t level = 0;
+		if((frame->type & MEDIA_FRAME_TYPE_AUDIO) == MEDIA_FRAME_TYPE_AUDIO) {
+			/* first, calculate current activity level of processed frame */
+			level = mpf_activity_detector_level_calculate(frame);
 #if 0
-		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Activity Detector [%"APR_SIZE_T_FMT"]",level);
+			apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Activity Detector [%"APR_SIZE_T_FMT"]",level);
 #endif
+		}
+		active = level >= detector->level_threshold ? TRUE : FALSE;
 	}
 
 	if(detector->state == DETECTOR_STATE_INACTIVITY) {
-		if(level >= detector->level_threshold) {
+		if(active == TRUE) {
 			/* start to detect activity */
 			mpf_activity_detector_state_change(detector,DETECTOR_STATE_ACTIVITY_TRANSITION);
 		}
@@ -142,7 +372,7 @@ MPF_DECLARE(mpf_detector_event_e) mpf_activity_detector_process(mpf_activity_det
 		}
 	}
 	else if(detector->state == DETECTOR_STATE_ACTIVITY_TRANSITION) {
-		if(level >= detector->level_threshold) {
+		if(active == TRUE) {
 			detector->duration += CODEC_FRAME_TIME_BASE;
 			if(detector->duration >= detector->speech_timeout) {
 				/* finally detected activity */
@@ -156,16 +386,17 @@ MPF_DECLARE(mpf_detector_event_e) mpf_activity_detector_process(mpf_activity_det
 		}
 	}
 	else if(detector->state == DETECTOR_STATE_ACTIVITY) {
-		if(level >= detector->level_threshold) {
+		if(active == TRUE) {
 			detector->duration += CODEC_FRAME_TIME_BASE;
 		}
 		else {
 			/* start to detect inactivity */
 			mpf_activity_detector_state_change(detector,DETECTOR_STATE_INACTIVITY_TRANSITION);
+			detector->duration = held;
 		}
 	}
 	else if(detector->state == DETECTOR_STATE_INACTIVITY_TRANSITION) {
-		if(level >= detector->level_threshold) {
+		if(active == TRUE) {
 			/* fallback to activity */
 			mpf_activity_detector_state_change(detector,DETECTOR_STATE_ACTIVITY);
 		}
@@ -114,7 +114,7 @@ static mpf_bridge_t* mpf_bridge_base_create(mpf_audio_stream_t *source, mpf_audi
 	bridge->source = source;
 	bridge->sink = sink;
 	bridge->codec = NULL;
-	mpf_object_init(&bridge->base,name);
+	mpf_object_init(&bridge->base,name,MPF_OBJECT_TYPE_BRIDGE);
 	bridge->base.destroy = mpf_bridge_destroy;
 	bridge->base.process = mpf_bridge_process;
 	bridge->base.trace = mpf_bridge_trace;
@@ -157,6 +157,7 @@ static mpf_object_t* mpf_null_bridge_create(mpf_audio_stream_t *source, mpf_audi
 	if(!bridge) {
 		return NULL;
 	}
+	bridge->base.type = MPF_OBJECT_TYPE_NULL_BRIDGE;
 	bridge->base.process = mpf_null_bridge_process;
 
 	codec = mpf_codec_manager_codec_get(codec_manager,source->rx_descriptor,pool);
@@ -16,158 +16,147 @@
  * $Id$
  */
 
-#ifdef WIN32
-#pragma warning(disable: 4127)
-#endif
-#include <apr_ring.h>
+#include <apr_atomic.h>
 #include "mpf_buffer.h"
 
-typedef struct mpf_chunk_t mpf_chunk_t;
-
-struct mpf_chunk_t {
-	APR_RING_ENTRY(mpf_chunk_t) link;
-	mpf_frame_t                 frame;
-};
-
+/*
+ * Bounded single-producer single-consumer ring of audio data.
+ * The producer only advances the tail, the consumer only advances the head,
+ * so neither of them ever locks or allocates memory.
+ */
 struct mpf_buffer_t {
-	APR_RING_HEAD(mpf_chunk_head_t, mpf_chunk_t) head;
-	mpf_chunk_t                                 *cur_chunk;
-	apr_size_t                                   remaining_chunk_size;
-	apr_thread_mutex_t                          *guard;
-	apr_pool_t                                  *pool;
-	apr_size_t                                   size; /* total size */
+	/** Ring storage */
+	apr_byte_t           *data;
+	apr_uint32_t          mask;
+	/** Consumer position */
+	volatile apr_uint32_t head;
+	/** Producer position */
+	volatile apr_uint32_t tail;
+
+	/** Type of pending event */
+	mpf_frame_type_e      event_type;
+	/** Position the pending event is written at */
+	apr_uint32_t          event_pos;
+	/** Whether the event is pending (set by producer, cleared by consumer) */
+	volatile apr_uint32_t event_set;
 };
 
+/** Read with full memory barrier */
+static APR_INLINE apr_uint32_t mpf_buffer_seq_get(volatile apr_uint32_t *seq)
+{
+	return apr_atomic_cas32(seq,0,0);
+}
+
 mpf_buffer_t* mpf_buffer_create(apr_pool_t *pool)
 {
+	apr_uint32_t capacity = 1024;
 	mpf_buffer_t *buffer = apr_palloc(pool,sizeof(mpf_buffer_t));
-	buffer->pool = pool;
-	buffer->cur_chunk = NULL;
-	buffer->remaining_chunk_size = 0;
-	buffer->size = 0;
-	APR_RING_INIT(&buffer->head, mpf_chunk_t, link);
-	apr_thread_mutex_create(&buffer->guard,APR_THREAD_MUTEX_UNNESTED,pool);
+	while(capacity < MPF_BUFFER_DEFAULT_SIZE) {
+		capacity <<= 1;
+	}
+	buffer->data = apr_palloc(pool,capacity);
+	buffer->mask = capacity - 1;
+	buffer->head = 0;
+	buffer->tail = 0;
+	buffer->event_type = MEDIA_FRAME_TYPE_NONE;
+	buffer->event_pos = 0;
+	buffer->event_set = 0;
 	return buffer;
 }
 
 void mpf_buffer_destroy(mpf_buffer_t *buffer)
 {
-	if(buffer->guard) {
-		apr_thread_mutex_destroy(buffer->guard);
-		buffer->guard = NULL;
-	}
+	buffer->data = NULL;
 }
 
 apt_bool_t mpf_buffer_restart(mpf_buffer_t *buffer)
 {
-	apr_thread_mutex_lock(buffer->guard);
-	APR_RING_INIT(&buffer->head, mpf_chunk_t, link);
-	apr_thread_mutex_unlock(buffer->guard);
+	/* drop everything written so far, including the pending event */
+	apr_atomic_xchg32(&buffer->event_set,0);
+	apr_atomic_xchg32(&buffer->head,mpf_buffer_seq_get(&buffer->tail));
 	return TRUE;
 }
 
-static APR_INLINE apt_bool_t mpf_buffer_chunk_write(mpf_buffer_t *buffer, mpf_chunk_t *chunk)
-{
-	APR_RING_INSERT_TAIL(&buffer->head,chunk,mpf_chunk_t,link);
-	return TRUE;
-}
-
-static APR_INLINE mpf_chunk_t* mpf_buffer_chunk_read(mpf_buffer_t *buffer)
-{
-	mpf_chunk_t *chunk = NULL;
-	if(!APR_RING_EMPTY(&buffer->head,mpf_chunk_t,link)) {
-		chunk = APR_RING_FIRST(&buffer->head);
-		APR_RING_REMOVE(chunk,link);
-	}
-	return chunk;
-}
-
 apt_bool_t mpf_buffer_audio_write(mpf_buffer_t *buffer, void *data, apr_size_t size)
 {
-	mpf_chunk_t *chunk;
-	apt_bool_t status = TRUE;
-	apr_thread_mutex_lock(buffer->guard);
+	apr_uint32_t tail = buffer->tail;
+	apr_uint32_t offset = tail & buffer->mask;
+	apr_uint32_t first;
+	if(buffer->mask + 1 - (tail - mpf_buffer_seq_get(&buffer->head)) < size) {
+		/* not enough room, the producer should retry later */
+		return FALSE;
+	}
 
-	chunk = apr_palloc(buffer->pool,sizeof(mpf_chunk_t));
-	chunk->frame.codec_frame.buffer = apr_palloc(buffer->pool,size);
-	memcpy(chunk->frame.codec_frame.buffer,data,size);
-	chunk->frame.codec_frame.size = size;
-	chunk->frame.type = MEDIA_FRAME_TYPE_AUDIO;
-	status = mpf_buffer_chunk_write(buffer,chunk);
-	
-	buffer->size += size;
-	apr_thread_mutex_unlock(buffer->guard);
-	return status;
+	first = buffer->mask + 1 - offset;
+	if(first >= size) {
+		memcpy(buffer->data + offset,data,size);
+	}
+	else {
+		memcpy(buffer->data + offset,data,first);
+		memcpy(buffer->data,(const apr_byte_t*)data + first,size - first);
+	}
+	/* publish the data to the consumer */
+	apr_atomic_xchg32(&buffer->tail,tail + (apr_uint32_t)size);
+	return TRUE;
 }
 
 apt_bool_t mpf_buffer_event_write(mpf_buffer_t *buffer, mpf_frame_type_e event_type)
 {
-	mpf_chunk_t *chunk;
-	apt_bool_t status = TRUE;
-	apr_thread_mutex_lock(buffer->guard);
-
-	chunk = apr_palloc(buffer->pool,sizeof(mpf_chunk_t));
-	chunk->frame.codec_frame.buffer = NULL;
-	chunk->frame.codec_frame.size = 0;
-	chunk->frame.type = event_type;
-	status = mpf_buffer_chunk_write(buffer,chunk);
-	
-	apr_thread_mutex_unlock(buffer->guard);
-	return status;
+	if(mpf_buffer_seq_get(&buffer->event_set)) {
+		/* previous event is not read yet */
+		return FALSE;
+	}
+	buffer->event_type = event_type;
+	buffer->event_pos = buffer->tail;
+	apr_atomic_xchg32(&buffer->event_set,1);
+	return TRUE;
 }
 
 apt_bool_t mpf_buffer_frame_read(mpf_buffer_t *buffer, mpf_frame_t *media_frame)
 {
-	mpf_codec_frame_t *dest;
-	mpf_codec_frame_t *src;
-	apr_size_t remaining_frame_size = media_frame->codec_frame.size;
-	apr_thread_mutex_lock(buffer->guard);
-	do {
-		if(!buffer->cur_chunk) {
-			buffer->cur_chunk = mpf_buffer_chunk_read(buffer);
-			if(!buffer->cur_chunk) {
-				/* buffer is empty */
-				break;
-			}
-			buffer->remaining_chunk_size = buffer->cur_chunk->frame.codec_frame.size;
-		}
+	mpf_codec_frame_t *dest = &media_frame->codec_frame;
+	apr_uint32_t head = buffer->head;
+	apr_uint32_t offset = head & buffer->mask;
+	apr_uint32_t size = (apr_uint32_t)dest->size;
+	apr_uint32_t first;
+	/* check the event first, the data written before it is seen then */
+	apr_uint32_t event_set = mpf_buffer_seq_get(&buffer->event_set);
+	apr_uint32_t available = mpf_buffer_seq_get(&buffer->tail) - head;
+
+	if(event_set) {
+		/* don't read past the event */
+		available = buffer->event_pos - head;
+	}
+	if(size > available) {
+		size = available;
+	}
 
-		dest = &media_frame->codec_frame;
-		src = &buffer->cur_chunk->frame.codec_frame;
-		media_frame->type |= buffer->cur_chunk->frame.type;
-		if(remaining_frame_size < buffer->remaining_chunk_size) {
-			/* copy remaining_frame_size */
-			memcpy(
-				(char*)dest->buffer + dest->size - remaining_frame_size,
-				(char*)src->buffer + src->size - buffer->remaining_chunk_size,
-				remaining_frame_size);
-			buffer->remaining_chunk_size -= remaining_frame_size;
-			buffer->size -= remaining_frame_size;
-			remaining_frame_size = 0;
+	if(size) {
+		first = buffer->mask + 1 - offset;
+		if(first >= size) {
+			memcpy(dest->buffer,buffer->data + offset,size);
 		}
 		else {
-			/* copy remaining_chunk_size and proceed to the next chunk */
-			memcpy(
-				(char*)dest->buffer + dest->size - remaining_frame_size,
-				(char*)src->buffer + src->size - buffer->remaining_chunk_size,
-				buffer->remaining_chunk_size);
-			remaining_frame_size -= buffer->remaining_chunk_size;
-			buffer->size -= buffer->remaining_chunk_size;
-			buffer->remaining_chunk_size = 0;
-			buffer->cur_chunk = NULL;
+			memcpy(dest->buffer,buffer->data + offset,first);
+			memcpy((char*)dest->buffer + first,buffer->data,size - first);
 		}
+		media_frame->type |= MEDIA_FRAME_TYPE_AUDIO;
+		/* release the space to the producer */
+		apr_atomic_xchg32(&buffer->head,head + size);
 	}
-	while(remaining_frame_size);
 
-	if(remaining_frame_size) {
-		apr_size_t offset = media_frame->codec_frame.size - remaining_frame_size;
-		memset((char*)media_frame->codec_frame.buffer + offset, 0, remaining_frame_size);
+	if(size < dest->size) {
+		memset((char*)dest->buffer + size, 0, dest->size - size);
+		if(event_set) {
+			/* all the data before the event is read */
+			media_frame->type |= buffer->event_type;
+			apr_atomic_xchg32(&buffer->event_set,0);
+		}
 	}
-	apr_thread_mutex_unlock(buffer->guard);
 	return TRUE;
 }
 
 apr_size_t mpf_buffer_get_size(const mpf_buffer_t *buffer)
 {
-	return buffer->size;
+	return buffer->tail - buffer->head;
 }
@@ -24,6 +24,13 @@
 #define LPCM_CODEC_NAME        "LPCM"
 #define LPCM_CODEC_NAME_LENGTH (sizeof(LPCM_CODEC_NAME)-1)
 
+/* G.722 is sampled at 16kHz, but clocked at 8kHz in RTP */
+#define G722_CODEC_NAME        "G722"
+#define G722_CODEC_NAME_LENGTH (sizeof(G722_CODEC_NAME)-1)
+#define G722_SAMPLING_RATE     16000
+
+static const apt_str_t g722_name = {G722_CODEC_NAME, G722_CODEC_NAME_LENGTH};
+
 /* linear PCM atrributes */
 static const mpf_codec_attribs_t lpcm_attribs = {
 	{LPCM_CODEC_NAME, LPCM_CODEC_NAME_LENGTH},    /* codec name */
@@ -67,6 +74,34 @@ MPF_DECLARE(mpf_codec_descriptor_t*) mpf_codec_lpcm_descriptor_create(apr_uint16
 	return descriptor;
 }
 
+static APR_INLINE apt_bool_t mpf_codec_g722_check(const mpf_codec_descriptor_t *descriptor)
+{
+	if(descriptor->payload_type < RTP_PT_DYNAMIC) {
+		return descriptor->payload_type == RTP_PT_G722 ? TRUE : FALSE;
+	}
+	return apt_string_compare(&descriptor->name,&g722_name);
+}
+
+/** Get RTP clock rate, which differs from the sampling rate for G.722 (RFC3551) */
+MPF_DECLARE(apr_uint16_t) mpf_codec_rtp_clock_rate_get(const mpf_codec_descriptor_t *descriptor)
+{
+	if(mpf_codec_g722_check(descriptor) == TRUE) {
+		return descriptor->sampling_rate / 2;
+	}
+	return descriptor->sampling_rate;
+}
+
+/** Set sampling rate by RTP clock rate */
+MPF_DECLARE(void) mpf_codec_rtp_clock_rate_set(mpf_codec_descriptor_t *descriptor, apr_uint16_t clock_rate)
+{
+	if(mpf_codec_g722_check(descriptor) == TRUE) {
+		/* G.722 is always sampled at 16kHz, whatever clock rate (8000 or erroneous 16000) is advertised */
+		descriptor->sampling_rate = G722_SAMPLING_RATE;
+		return;
+	}
+	descriptor->sampling_rate = clock_rate;
+}
+
 /** Create codec descriptor by capabilities */
 MPF_DECLARE(mpf_codec_descriptor_t*) mpf_codec_descriptor_create_by_capabilities(const mpf_codec_capabilities_t *capabilities, const mpf_codec_descriptor_t *peer, apr_pool_t *pool)
 {
@@ -17,15 +17,208 @@
  */
 
 #include "mpf_codec.h"
+#include "mpf_codec_g711.h"
 #include "mpf_rtp_pt.h"
 #include "g711/g711.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MPF_G711_SSE2
+#include <emmintrin.h>
+#endif
+
 #define G711u_CODEC_NAME        "PCMU"
 #define G711u_CODEC_NAME_LENGTH (sizeof(G711u_CODEC_NAME)-1)
 
 #define G711a_CODEC_NAME        "PCMA"
 #define G711a_CODEC_NAME_LENGTH (sizeof(G711a_CODEC_NAME)-1)
 
+/** u-law to linear conversion table */
+static const apr_int16_t ulaw_to_linear_table[256] = {
+	-32124, -31100, -30076, -29052, -28028, -27004, -25980, -24956,
+	-23932, -22908, -21884, -20860, -19836, -18812, -17788, -16764,
+	-15996, -15484, -14972, -14460, -13948, -13436, -12924, -12412,
+	-11900, -11388, -10876, -10364,  -9852,  -9340,  -8828,  -8316,
+	 -7932,  -7676,  -7420,  -7164,  -6908,  -6652,  -6396,  -6140,
+	 -5884,  -5628,  -5372,  -5116,  -4860,  -4604,  -4348,  -4092,
+	 -3900,  -3772,  -3644,  -3516,  -3388,  -3260,  -3132,  -3004,
+	 -2876,  -2748,  -2620,  -2492,  -2364,  -2236,  -2108,  -1980,
+	 -1884,  -1820,  -1756,  -1692,  -1628,  -1564,  -1500,  -1436,
+	 -1372,  -1308,  -1244,  -1180,  -1116,  -1052,   -988,   -924,
+	  -876,   -844,   -812,   -780,   -748,   -716,   -684,   -652,
+	  -620,   -588,   -556,   -524,   -492,   -460,   -428,   -396,
+	  -372,   -356,   -340,   -324,   -308,   -292,   -276,   -260,
+	  -244,   -228,   -212,   -196,   -180,   -164,   -148,   -132,
+	  -120,   -112,   -104,    -96,    -88,    -80,    -72,    -64,
+	   -56,    -48,    -40,    -32,    -24,    -16,     -8,      0,
+	 32124,  31100,  30076,  29052,  28028,  27004,  25980,  24956,
+	 23932,  22908,  21884,  20860,  19836,  18812,  17788,  16764,
+	 15996,  15484,  14972,  14460,  13948,  13436,  12924,  12412,
+	 11900,  11388,  10876,  10364,   9852,   9340,   8828,   8316,
+	  7932,   7676,   7420,   7164,   6908,   6652,   6396,   6140,
+	  5884,   5628,   5372,   5116,   4860,   4604,   4348,   4092,
+	  3900,   3772,   3644,   3516,   3388,   3260,   3132,   3004,
+	  2876,   2748,   2620,   2492,   2364,   2236,   2108,   1980,
+	  1884,   1820,   1756,   1692,   1628,   1564,   1500,   1436,
+	  1372,   1308,   1244,   1180,   1116,   1052,    988,    924,
+	   876,    844,    812,    780,    748,    716,    684,    652,
+	   620,    588,    556,    524,    492,    460,    428,    396,
+	   372,    356,    340,    324,    308,    292,    276,    260,
+	   244,    228,    212,    196,    180,    164,    148,    132,
+	   120,    112,    104,     96,     88,     80,     72,     64,
+	    56,     48,     40,     32,     24,     16,      8,      0
+};
+
+/** A-law to linear conversion table */
+static const apr_int16_t alaw_to_linear_table[256] = {
+	 -5504,  -5248,  -6016,  -5760,  -4480,  -4224,  -4992,  -4736,
+	 -7552,  -7296,  -8064,  -7808,  -6528,  -6272,  -7040,  -6784,
+	 -2752,  -2624,  -3008,  -2880,  -2240,  -2112,  -2496,  -2368,
+	 -3776,  -3648,  -4032,  -3904,  -3264,  -3136,  -3520,  -3392,
+	-22016, -20992, -24064, -23040, -17920, -16896, -19968, -18944,
+	-30208, -29184, -32256, -31232, -26112, -25088, -28160, -27136,
+	-11008, -10496, -12032, -11520,  -8960,  -8448,  -9984,  -9472,
+	-15104, -14592, -16128, -15616, -13056, -12544, -14080, -13568,
+	  -344,   -328,   -376,   -360,   -280,   -264,   -312,   -296,
+	  -472,   -456,   -504,   -488,   -408,   -392,   -440,   -424,
+	   -88,    -72,   -120,   -104,    -24,     -8,    -56,    -40,
+	  -216,   -200,   -248,   -232,   -152,   -136,   -184,   -168,
+	 -1376,  -1312,  -1504,  -1440,  -1120,  -1056,  -1248,  -1184,
+	 -1888,  -1824,  -2016,  -1952,  -1632,  -1568,  -1760,  -1696,
+	  -688,   -656,   -752,   -720,   -560,   -528,   -624,   -592,
+	  -944,   -912,  -1008,   -976,   -816,   -784,   -880,   -848,
+	  5504,   5248,   6016,   5760,   4480,   4224,   4992,   4736,
+	  7552,   7296,   8064,   7808,   6528,   6272,   7040,   6784,
+	  2752,   2624,   3008,   2880,   2240,   2112,   2496,   2368,
+	  3776,   3648,   4032,   3904,   3264,   3136,   3520,   3392,
+	 22016,  20992,  24064,  23040,  17920,  16896,  19968,  18944,
+	 30208,  29184,  32256,  31232,  26112,  25088,  28160,  27136,
+	 11008,  10496,  12032,  11520,   8960,   8448,   9984,   9472,
+	 15104,  14592,  16128,  15616,  13056,  12544,  14080,  13568,
+	   344,    328,    376,    360,    280,    264,    312,    296,
+	   472,    456,    504,    488,    408,    392,    440,    424,
+	    88,     72,    120,    104,     24,      8,     56,     40,
+	   216,    200,    248,    232,    152,    136,    184,    168,
+	  1376,   1312,   1504,   1440,   1120,   1056,   1248,   1184,
+	  1888,   1824,   2016,   1952,   1632,   1568,   1760,   1696,
+	   688,    656,    752,    720,    560,    528,    624,    592,
+	   944,    912,   1008,    976,    816,    784,    880,    848
+};
+
+#ifdef MPF_G711_SSE2
+/** Encode 8 linear samples to u-law (bit exact with linear_to_ulaw) */
+static APR_INLINE __m128i g711u_encode_sse2(__m128i x)
+{
+	const __m128i bias = _mm_set1_epi16(0x84);
+	const __m128i flip = _mm_set1_epi16((short)0x8000);
+	__m128i sign = _mm_srai_epi16(x,15);
+	__m128i mag;
+	__m128i ge;
+	__m128i seg = _mm_setzero_si128();
+	__m128i mul = _mm_set1_epi16(0x2000);
+	__m128i code;
+	int k;
+
+	/* biased magnitude as unsigned 16-bit value, saturated to 0xFFFF */
+	mag = _mm_sub_epi16(_mm_xor_si128(x,sign),sign);
+	mag = _mm_adds_epu16(mag,bias);
+
+	/* segment is the number of thresholds (0x100 << k) the magnitude reaches,
+	multiplier (0x2000 >> segment) emulates per-lane right shift by segment+3 */
+	for(k=0; k<8; k++) {
+		ge = _mm_cmpgt_epi16(_mm_xor_si128(mag,flip),_mm_set1_epi16((short)(((0x100 << k) - 1) ^ 0x8000)));
+		seg = _mm_sub_epi16(seg,ge);
+		mul = _mm_xor_si128(mul,_mm_and_si128(_mm_xor_si128(mul,_mm_srli_epi16(mul,1)),ge));
+	}
+
+	code = _mm_and_si128(_mm_mulhi_epu16(mag,mul),_mm_set1_epi16(0x0F));
+	code = _mm_or_si128(code,_mm_slli_epi16(seg,4));
+	/* segment 8 is out of range -> clip (ge holds the last threshold) */
+	code = _mm_or_si128(_mm_andnot_si128(ge,code),_mm_and_si128(ge,_mm_set1_epi16(0x7F)));
+	/* mask is 0xFF for positive and 0x7F for negative samples */
+	return _mm_xor_si128(code,_mm_or_si128(_mm_set1_epi16(0x7F),_mm_andnot_si128(sign,_mm_set1_epi16(0x80))));
+}
+
+/** Encode 8 linear samples to A-law (bit exact with linear_to_alaw) */
+static APR_INLINE __m128i g711a_encode_sse2(__m128i x)
+{
+	__m128i sign = _mm_srai_epi16(x,15);
+	__m128i mag;
+	__m128i ge;
+	__m128i seg;
+	__m128i mul = _mm_set1_epi16(0x1000);
+	__m128i code;
+	int k;
+
+	/* magnitude is x for positive and (-x - 8) saturated to 0 for negative samples */
+	mag = _mm_or_si128(
+			_mm_andnot_si128(sign,x),
+			_mm_and_si128(sign,_mm_subs_epu16(_mm_xor_si128(x,sign),_mm_set1_epi16(7))));
+
+	/* segments 0 and 1 share the same shift (4), magnitude never reaches segment 8 */
+	seg = _mm_sub_epi16(_mm_setzero_si128(),_mm_cmpgt_epi16(mag,_mm_set1_epi16(0xFF)));
+	for(k=1; k<7; k++) {
+		ge = _mm_cmpgt_epi16(mag,_mm_set1_epi16((short)((0x100 << k) - 1)));
+		seg = _mm_sub_epi16(seg,ge);
+		mul = _mm_xor_si128(mul,_mm_and_si128(_mm_xor_si128(mul,_mm_srli_epi16(mul,1)),ge));
+	}
+
+	code = _mm_and_si128(_mm_mulhi_epu16(mag,mul),_mm_set1_epi16(0x0F));
+	code = _mm_or_si128(code,_mm_slli_epi16(seg,4));
+	/* mask is 0xD5 for positive and 0x55 for negative samples */
+	return _mm_xor_si128(code,_mm_or_si128(_mm_set1_epi16(ALAW_AMI_MASK),_mm_andnot_si128(sign,_mm_set1_epi16(0x80))));
+}
+#endif
+
+MPF_DECLARE(void) mpf_g711u_encode(const apr_int16_t *linear, apr_byte_t *ulaw, apr_size_t count)
+{
+	apr_size_t i = 0;
+#ifdef MPF_G711_SSE2
+	__m128i lo;
+	__m128i hi;
+	for(; i+16<=count; i+=16) {
+		lo = g711u_encode_sse2(_mm_loadu_si128((const __m128i*)(linear+i)));
+		hi = g711u_encode_sse2(_mm_loadu_si128((const __m128i*)(linear+i+8)));
+		_mm_storeu_si128((__m128i*)(ulaw+i),_mm_packus_epi16(lo,hi));
+	}
+#endif
+	for(; i<count; i++) {
+		ulaw[i] = linear_to_ulaw(linear[i]);
+	}
+}
+
+MPF_DECLARE(void) mpf_g711u_decode(const apr_byte_t *ulaw, apr_int16_t *linear, apr_size_t count)
+{
+	apr_size_t i;
+	for(i=0; i<count; i++) {
+		linear[i] = ulaw_to_linear_table[ulaw[i]];
+	}
+}
+
+MPF_DECLARE(void) mpf_g711a_encode(const apr_int16_t *linear, apr_byte_t *alaw, apr_size_t count)
+{
+	apr_size_t i = 0;
+#ifdef MPF_G711_SSE2
+	__m128i lo;
+	__m128i hi;
+	for(; i+16<=count; i+=16) {
+		lo = g711a_encode_sse2(_mm_loadu_si128((const __m128i*)(linear+i)));
+		hi = g711a_encode_sse2(_mm_loadu_si128((const __m128i*)(linear+i+8)));
+		_mm_storeu_si128((__m128i*)(alaw+i),_mm_packus_epi16(lo,hi));
+	}
+#endif
+	for(; i<count; i++) {
+		alaw[i] = linear_to_alaw(linear[i]);
+	}
+}
+
+MPF_DECLARE(void) mpf_g711a_decode(const apr_byte_t *alaw, apr_int16_t *linear, apr_size_t count)
+{
+	apr_size_t i;
+	for(i=0; i<count; i++) {
+		linear[i] = alaw_to_linear_table[alaw[i]];
+	}
+}
+
 static apt_bool_t g711_open(mpf_codec_t *codec)
 {
 	return TRUE;
@@ -39,17 +232,14 @@ static apt_bool_t g711_close(mpf_codec_t *codec)
 static apt_bool_t g711u_encode(mpf_codec_t *codec, const mpf_codec_frame_t *frame_in, mpf_codec_frame_t *frame_out)
 {
 	const apr_int16_t *decode_buf;
-	unsigned char *encode_buf;
-	apr_size_t i;
+	apr_byte_t *encode_buf;
 
 	decode_buf = frame_in->buffer;
 	encode_buf = frame_out->buffer;
 
 	frame_out->size = frame_in->size / sizeof(apr_int16_t);
 
-	for(i=0; i<frame_out->size; i++) {
-		encode_buf[i] = linear_to_ulaw(decode_buf[i]);
-	}
+	mpf_g711u_encode(decode_buf,encode_buf,frame_out->size);
 
 	return TRUE;
 }
@@ -57,17 +247,14 @@ static apt_bool_t g711u_encode(mpf_codec_t *codec, const mpf_codec_frame_t *fram
 static apt_bool_t g711u_decode(mpf_codec_t *codec, const mpf_codec_frame_t *frame_in, mpf_codec_frame_t *frame_out)
 {
 	apr_int16_t *decode_buf;
-	const unsigned char *encode_buf;
-	apr_size_t i;
+	const apr_byte_t *encode_buf;
 
 	decode_buf = frame_out->buffer;
 	encode_buf = frame_in->buffer;
 
 	frame_out->size = frame_in->size * sizeof(apr_int16_t);
 
-	for(i=0; i<frame_in->size; i++) {
-		decode_buf[i] = ulaw_to_linear(encode_buf[i]);
-	}
+	mpf_g711u_decode(encode_buf,decode_buf,frame_in->size);
 
 	return TRUE;
 }
@@ -86,17 +273,14 @@ static apt_bool_t g711u_init(mpf_codec_t *codec, mpf_codec_frame_t *frame_out)
 static apt_bool_t g711a_encode(mpf_codec_t *codec, const mpf_codec_frame_t *frame_in, mpf_codec_frame_t *frame_out)
 {
 	const apr_int16_t *decode_buf;
-	unsigned char *encode_buf;
-	apr_size_t i;
+	apr_byte_t *encode_buf;
 
 	decode_buf = frame_in->buffer;
 	encode_buf = frame_out->buffer;
 
 	frame_out->size = frame_in->size / sizeof(apr_int16_t);
 
-	for(i=0; i<frame_out->size; i++) {
-		encode_buf[i] = linear_to_alaw(decode_buf[i]);
-	}
+	mpf_g711a_encode(decode_buf,encode_buf,frame_out->size);
 
 	return TRUE;
 }
@@ -104,17 +288,14 @@ static apt_bool_t g711a_encode(mpf_codec_t *codec, const mpf_codec_frame_t *fram
 static apt_bool_t g711a_decode(mpf_codec_t *codec, const mpf_codec_frame_t *frame_in, mpf_codec_frame_t *frame_out)
 {
 	apr_int16_t *decode_buf;
-	const unsigned char *encode_buf;
-	apr_size_t i;
+	const apr_byte_t *encode_buf;
 
 	decode_buf = frame_out->buffer;
 	encode_buf = frame_in->buffer;
 
 	frame_out->size = frame_in->size * sizeof(apr_int16_t);
 
-	for(i=0; i<frame_in->size; i++) {
-		decode_buf[i] = alaw_to_linear(encode_buf[i]);
-	}
+	mpf_g711a_decode(encode_buf,decode_buf,frame_in->size);
 
 	return TRUE;
 }
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2008-2010 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include "mpf_codec.h"
+#include "mpf_rtp_pt.h"
+#include "g722/g722.h"
+
+#define G722_CODEC_NAME        "G722"
+#define G722_CODEC_NAME_LENGTH (sizeof(G722_CODEC_NAME)-1)
+
+/** Code, which decodes to zero in both sub-bands once the scale factors have decayed to minimum */
+#define G722_SILENCE_CODE      0xFC
+
+/** G.722 codec state (each codec instance is used either for encoding or decoding) */
+typedef struct mpf_g722_state_t mpf_g722_state_t;
+struct mpf_g722_state_t {
+	g722_encoder_t encoder;
+	g722_decoder_t decoder;
+};
+
+static apt_bool_t g722_codec_open(mpf_codec_t *codec)
+{
+	mpf_g722_state_t *state = codec->obj;
+	if(!state) {
+		state = apr_palloc(codec->pool,sizeof(mpf_g722_state_t));
+		codec->obj = state;
+	}
+	g722_encoder_init(&state->encoder);
+	g722_decoder_init(&state->decoder);
+	return TRUE;
+}
+
+static apt_bool_t g722_codec_close(mpf_codec_t *codec)
+{
+	/* state is allocated from the pool of the codec */
+	return TRUE;
+}
+
+static apt_bool_t g722_codec_encode(mpf_codec_t *codec, const mpf_codec_frame_t *frame_in, mpf_codec_frame_t *frame_out)
+{
+	mpf_g722_state_t *state = codec->obj;
+	if(!state) {
+		return FALSE;
+	}
+
+	frame_out->size = g722_encode(
+						&state->encoder,
+						frame_out->buffer,
+						frame_in->buffer,
+						(int)(frame_in->size / sizeof(apr_int16_t)));
+	return TRUE;
+}
+
+static apt_bool_t g722_codec_decode(mpf_codec_t *codec, const mpf_codec_frame_t *frame_in, mpf_codec_frame_t *frame_out)
+{
+	mpf_g722_state_t *state = codec->obj;
+	if(!state) {
+		return FALSE;
+	}
+
+	frame_out->size = sizeof(apr_int16_t) * g722_decode(
+						&state->decoder,
+						frame_out->buffer,
+						frame_in->buffer,
+						(int)frame_in->size);
+	return TRUE;
+}
+
+static apt_bool_t g722_codec_init(mpf_codec_t *codec, mpf_codec_frame_t *frame_out)
+{
+	memset(frame_out->buffer,G722_SILENCE_CODE,frame_out->size);
+	return TRUE;
+}
+
+static const mpf_codec_vtable_t g722_vtable = {
+	g722_codec_open,
+	g722_codec_close,
+	g722_codec_encode,
+	g722_codec_decode,
+	NULL,
+	g722_codec_init
+};
+
+/* RTP clock rate of G.722 is 8000 (RFC3551), see mpf_codec_rtp_clock_rate_get() */
+static const mpf_codec_descriptor_t g722_descriptor = {
+	RTP_PT_G722,
+	{G722_CODEC_NAME, G722_CODEC_NAME_LENGTH},
+	16000,
+	1,
+	{NULL, 0},
+	TRUE
+};
+
+static const mpf_codec_attribs_t g722_attribs = {
+	{G722_CODEC_NAME, G722_CODEC_NAME_LENGTH},    /* codec name */
+	4,                                            /* bits per sample (64 kbit/s) */
+	MPF_SAMPLE_RATE_16000                         /* supported sampling rates */
+};
+
+mpf_codec_t* mpf_codec_g722_create(apr_pool_t *pool)
+{
+	return mpf_codec_create(&g722_vtable,&g722_attribs,&g722_descriptor,pool);
+}
@@ -156,7 +156,7 @@ static apt_bool_t mpf_codec_manager_codec_parse(const mpf_codec_manager_t *codec
 			/* parse optional sampling rate */
 			str = apr_strtok(codec_desc_str, separator, &state);
 			if(str) {
-				descriptor->sampling_rate = (apr_uint16_t)atol(str);
+				mpf_codec_rtp_clock_rate_set(descriptor,(apr_uint16_t)atol(str));
 
 				/* parse optional channel count */
 				str = apr_strtok(codec_desc_str, separator, &state);
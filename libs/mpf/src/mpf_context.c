@@ -20,6 +20,8 @@
 #pragma warning(disable: 4127)
 #endif
 #include <apr_ring.h> 
+#include <apr_atomic.h>
+#include <apr_strings.h>
 #include "mpf_context.h"
 #include "mpf_termination.h"
 #include "mpf_stream.h"
@@ -46,6 +48,8 @@ struct mpf_context_t {
 	APR_RING_ENTRY(mpf_context_t) link;
 	/** Back pointer to the context factory */
 	mpf_context_factory_t        *factory;
+	/** Whether the context is counted in the load of the factory */
+	apt_bool_t                    active;
 	/** Pool to allocate memory from */
 	apr_pool_t                   *pool;
 	/** Informative name of the context used for debugging */
@@ -71,6 +75,8 @@ struct mpf_context_t {
 struct mpf_context_factory_t {
 	/** Ring head */
 	APR_RING_HEAD(mpf_context_head_t, mpf_context_t) head;
+	/** Number of active contexts assigned to the factory */
+	volatile apr_uint32_t load;
 };
 
 
@@ -84,6 +90,7 @@ MPF_DECLARE(mpf_context_factory_t*) mpf_context_factory_create(apr_pool_t *pool)
 {
 	mpf_context_factory_t *factory = apr_palloc(pool, sizeof(mpf_context_factory_t));
 	APR_RING_INIT(&factory->head, mpf_context_t, link);
+	apr_atomic_set32(&factory->load,0);
 	return factory;
 }
 
@@ -110,6 +117,68 @@ MPF_DECLARE(apt_bool_t) mpf_context_factory_process(mpf_context_factory_t *facto
 	return TRUE;
 }
 
+MPF_DECLARE(apt_bool_t) mpf_context_factory_profile_process(mpf_context_factory_t *factory, mpf_context_profile_t *profile)
+{
+	mpf_context_t *context;
+	mpf_object_t *object;
+	mpf_object_profile_t *object_profile;
+	apr_time_t time_start;
+	apr_time_t time_last;
+	apr_time_t time_now;
+	apr_uint32_t duration;
+	int i;
+
+	profile->sample_count++;
+	time_now = apr_time_now();
+	for(context = APR_RING_FIRST(&factory->head);
+			context != APR_RING_SENTINEL(&factory->head, mpf_context_t, link);
+				context = APR_RING_NEXT(context, link)) {
+
+		if(!context->mpf_objects->nelts) {
+			continue;
+		}
+
+		/* the end of one measurement is the start of the next one */
+		time_start = time_now;
+		for(i=0; i<context->mpf_objects->nelts; i++) {
+			object = APR_ARRAY_IDX(context->mpf_objects,i,mpf_object_t*);
+			if(!object || !object->process) {
+				continue;
+			}
+
+			time_last = time_now;
+			object->process(object);
+			time_now = apr_time_now();
+
+			duration = (apr_uint32_t)(time_now - time_last);
+			if(object->type < MPF_OBJECT_TYPE_COUNT) {
+				object_profile = &profile->objects[object->type];
+				object_profile->process_count++;
+				object_profile->total_time += duration;
+				if(duration > object_profile->max_time) {
+					object_profile->max_time = duration;
+				}
+			}
+		}
+
+		duration = (apr_uint32_t)(time_now - time_start);
+		profile->context_count++;
+		profile->context_total_time += duration;
+		if(duration > profile->context_max_time) {
+			profile->context_max_time = duration;
+			/* the context may be gone by the time the profile is queried, keep a copy of the name */
+			apr_cpystrn(profile->context_max_name,context->name,sizeof(profile->context_max_name));
+		}
+	}
+
+	return TRUE;
+}
+
+MPF_DECLARE(apr_size_t) mpf_context_factory_load_get(mpf_context_factory_t *factory)
+{
+	return apr_atomic_read32(&factory->load);
+}
+
  
 MPF_DECLARE(mpf_context_t*) mpf_context_create(
 								mpf_context_factory_t *factory,
@@ -123,6 +192,7 @@ MPF_DECLARE(mpf_context_t*) mpf_context_create(
 	header_item_t *header_item;
 	mpf_context_t *context = apr_palloc(pool,sizeof(mpf_context_t));
 	context->factory = factory;
+	context->active = FALSE;
 	context->obj = obj;
 	context->pool = pool;
 	context->name = name;
@@ -168,6 +238,25 @@ MPF_DECLARE(void*) mpf_context_object_get(const mpf_context_t *context)
 	return context->obj;
 }
 
+MPF_DECLARE(mpf_context_factory_t*) mpf_context_factory_get(const mpf_context_t *context)
+{
+	return context->factory;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_context_factory_assign(mpf_context_t *context, mpf_context_factory_t *factory)
+{
+	if(context->factory) {
+		/* context is already assigned to the factory */
+		return FALSE;
+	}
+
+	context->factory = factory;
+	/* account the context right away, it's going to be activated on the first termination */
+	context->active = TRUE;
+	apr_atomic_inc32(&factory->load);
+	return TRUE;
+}
+
 MPF_DECLARE(apt_bool_t) mpf_context_termination_add(mpf_context_t *context, mpf_termination_t *termination)
 {
 	apr_size_t i;
@@ -178,8 +267,16 @@ MPF_DECLARE(apt_bool_t) mpf_context_termination_add(mpf_context_t *context, mpf_
 			continue;
 		}
 		if(!context->count) {
+			if(!context->factory) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No Factory Assigned to Media Context %s",context->name);
+				return FALSE;
+			}
 			apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Add Media Context %s",context->name);
 			APR_RING_INSERT_TAIL(&context->factory->head,context,mpf_context_t,link);
+			if(!context->active) {
+				context->active = TRUE;
+				apr_atomic_inc32(&context->factory->load);
+			}
 		}
 
 		header_item->termination = termination;
@@ -236,6 +333,10 @@ MPF_DECLARE(apt_bool_t) mpf_context_termination_subtract(mpf_context_t *context,
 	if(!context->count) {
 		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Remove Media Context %s",context->name);
 		APR_RING_REMOVE(context,link);
+		if(context->active) {
+			context->active = FALSE;
+			apr_atomic_dec32(&context->factory->load);
+		}
 	}
 	return TRUE;
 }
@@ -17,16 +17,21 @@
  */
 
 #include "mpf_dtmf_detector.h"
-#include "apr_thread_mutex.h"
+#include "apr_atomic.h"
 #include "apt_log.h"
 #include "mpf_named_event.h"
 #include <math.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MPF_DTMF_SSE2
+#include <emmintrin.h>
+#endif
+
 #ifndef M_PI
 #	define M_PI 3.141592653589793238462643
 #endif
 
-/** Max detected DTMF digits buffer length */
+/** Max detected DTMF digits buffer length (power of two) */
 #define MPF_DTMFDET_BUFFER_LEN  32
 
 /** Number of DTMF frequencies */
@@ -39,22 +44,27 @@
 #define DTMF_EVENT_ID_MAX       15  /* 0123456789*#ABCD */
 
 /**
- * Goertzel frequency detector (second-order IIR filter) state:
+ * Bank of Goertzel frequency detectors (second-order IIR filters), one per DTMF frequency:
  *
  * s(t) = x(t) + coef * s(t-1) - s(t-2), where s(0)=0; s(1) = 0;
  * x(t) is the input signal
  *
  * Then energy of frequency f in the signal is:
  * X(f)X'(f) = s(t-2)^2 + s(t-1)^2 - coef*s(t-2)*s(t-1)
+ *
+ * The states are kept in single precision so that all 8 filters are
+ * advanced by a single vector operation per sample.
  */
-typedef struct goertzel_state_t {
-	/** coef = cos(2*pi*f_tone/f_sampling) */
-	double coef;
-	/** s(t-2) or resulting energy @see goertzel_state_t */
-	double s1;
-	/** s(t-1) @see goertzel_state_t */
-	double s2;
-} goertzel_state_t;
+typedef struct goertzel_bank_t {
+	/** coef = 2*cos(2*pi*f_tone/f_sampling) */
+	float coef[DTMF_FREQUENCIES];
+	/** s(t-2) @see goertzel_bank_t */
+	float s1[DTMF_FREQUENCIES];
+	/** s(t-1) @see goertzel_bank_t */
+	float s2[DTMF_FREQUENCIES];
+	/** Total energy of signal */
+	float totenergy;
+} goertzel_bank_t;
 
 /** DTMF frequencies */
 static const double dtmf_freqs[DTMF_FREQUENCIES] = {
@@ -70,20 +80,23 @@ static const char freq2digits[DTMF_FREQUENCIES/2][DTMF_FREQUENCIES/2] =
 
 /** Media Processing Framework's Dual Tone Multiple Frequncy detector */
 struct mpf_dtmf_detector_t {
-	/** Mutex to guard the buffer */
-	struct apr_thread_mutex_t     *mutex;
 	/** Recognizer band */
 	enum mpf_dtmf_detector_band_e  band;
-	/** Detected digits buffer */
-	char                           buf[MPF_DTMFDET_BUFFER_LEN+1];
-	/** Number of digits in the buffer */
-	apr_size_t                     digits;
+	/**
+	 * Detected digits ring. The media thread (single producer) only advances
+	 * the tail, the application (single consumer) only advances the head.
+	 */
+	char                           buf[MPF_DTMFDET_BUFFER_LEN];
+	/** Consumer position in the ring */
+	volatile apr_uint32_t          head;
+	/** Producer position in the ring */
+	volatile apr_uint32_t          tail;
 	/** Number of lost digits due to full buffer */
-	apr_size_t                     lost_digits;
+	volatile apr_uint32_t          lost_digits;
+	/** Reset of detection states requested by consumer */
+	volatile apr_uint32_t          reset_pending;
 	/** Frequency analyzators */
-	struct goertzel_state_t        energies[DTMF_FREQUENCIES];
-	/** Total energy of signal */
-	double                         totenergy;
+	struct goertzel_bank_t         bank;
 	/** Number of samples in a window */
 	apr_size_t                     wsamples;
 	/** Number of samples processed */
@@ -92,13 +105,29 @@ struct mpf_dtmf_detector_t {
 	char                           last1, last2, curr;
 };
 
+/** Read with full memory barrier */
+static APR_INLINE apr_uint32_t mpf_dtmf_seq_get(volatile apr_uint32_t *seq)
+{
+	return apr_atomic_cas32(seq, 0, 0);
+}
+
+static void mpf_dtmf_detector_states_reset(struct mpf_dtmf_detector_t *detector)
+{
+	apr_size_t i;
+	for (i = 0; i < DTMF_FREQUENCIES; i++) {
+		detector->bank.s1[i] = 0;
+		detector->bank.s2[i] = 0;
+	}
+	detector->bank.totenergy = 0;
+	detector->nsamples = 0;
+	detector->last1 = detector->last2 = detector->curr = 0;
+}
 
 MPF_DECLARE(struct mpf_dtmf_detector_t *) mpf_dtmf_detector_create_ex(
 								const struct mpf_audio_stream_t *stream,
 								enum mpf_dtmf_detector_band_e band,
 								struct apr_pool_t *pool)
 {
-	apr_status_t status;
 	struct mpf_dtmf_detector_t *det;
 	int flg_band = band;
 
@@ -111,26 +140,21 @@ MPF_DECLARE(struct mpf_dtmf_detector_t *) mpf_dtmf_detector_create_ex(
 
 	det = apr_palloc(pool, sizeof(mpf_dtmf_detector_t));
 	if (!det) return NULL;
-	status = apr_thread_mutex_create(&det->mutex, APR_THREAD_MUTEX_DEFAULT, pool);
-	if (status != APR_SUCCESS) return NULL;
 
 	det->band = (enum mpf_dtmf_detector_band_e) flg_band;
-	det->buf[0] = 0;
-	det->digits = 0;
+	det->head = 0;
+	det->tail = 0;
 	det->lost_digits = 0;
+	det->reset_pending = 0;
 
 	if (det->band & MPF_DTMF_DETECTOR_INBAND) {
 		apr_size_t i;
 		for (i = 0; i < DTMF_FREQUENCIES; i++) {
-			det->energies[i].coef = 2 * cos(2 * M_PI * dtmf_freqs[i] /
-				stream->tx_descriptor->sampling_rate);
-			det->energies[i].s1 = 0;
-			det->energies[i].s2 = 0;
+			det->bank.coef[i] = (float) (2 * cos(2 * M_PI * dtmf_freqs[i] /
+				stream->tx_descriptor->sampling_rate));
 		}
-		det->nsamples = 0;
 		det->wsamples = GOERTZEL_SAMPLES_8K * (stream->tx_descriptor->sampling_rate / 8000);
-		det->last1 = det->last2 = det->curr = 0;
-		det->totenergy = 0;
+		mpf_dtmf_detector_states_reset(det);
 	}
 
 	return det;
@@ -139,60 +163,191 @@ MPF_DECLARE(struct mpf_dtmf_detector_t *) mpf_dtmf_detector_create_ex(
 MPF_DECLARE(char) mpf_dtmf_detector_digit_get(struct mpf_dtmf_detector_t *detector)
 {
 	char digit;
-	apr_thread_mutex_lock(detector->mutex);
-	digit = detector->buf[0];
-	if (digit) {
-		strcpy(detector->buf, detector->buf + 1);
-		detector->digits--;
-	}
-	apr_thread_mutex_unlock(detector->mutex);
+	apr_uint32_t head = detector->head;
+	if (head == mpf_dtmf_seq_get(&detector->tail))
+		return 0;
+
+	digit = detector->buf[head & (MPF_DTMFDET_BUFFER_LEN - 1)];
+	apr_atomic_xchg32(&detector->head, head + 1);
 	return digit;
 }
 
 MPF_DECLARE(apr_size_t) mpf_dtmf_detector_digits_lost(const struct mpf_dtmf_detector_t *detector)
 {
-	return detector->lost_digits;
+	return apr_atomic_read32((volatile apr_uint32_t *) &detector->lost_digits);
 }
 
 MPF_DECLARE(void) mpf_dtmf_detector_reset(struct mpf_dtmf_detector_t *detector)
 {
-	apr_thread_mutex_lock(detector->mutex);
-	detector->buf[0] = 0;
-	detector->lost_digits = 0;
-	detector->digits = 0;
-	detector->curr = detector->last1 = detector->last2 = 0;
-	detector->nsamples = 0;
-	detector->totenergy = 0;
-	apr_thread_mutex_unlock(detector->mutex);
+	/* drop the digits as a consumer, the producer resets its states on the next frame */
+	apr_atomic_xchg32(&detector->head, mpf_dtmf_seq_get(&detector->tail));
+	apr_atomic_set32(&detector->lost_digits, 0);
+	apr_atomic_set32(&detector->reset_pending, 1);
 }
 
 static APR_INLINE void mpf_dtmf_detector_add_digit(
 								struct mpf_dtmf_detector_t *detector,
 								char digit)
 {
+	apr_uint32_t tail = detector->tail;
 	if (!digit) return;
-	apr_thread_mutex_lock(detector->mutex);
-	if (detector->digits < MPF_DTMFDET_BUFFER_LEN) {
-		detector->buf[detector->digits++] = digit;
-		detector->buf[detector->digits] = 0;
-	} else
-		detector->lost_digits++;
-	apr_thread_mutex_unlock(detector->mutex);
+	if (tail - mpf_dtmf_seq_get(&detector->head) >= MPF_DTMFDET_BUFFER_LEN) {
+		apr_atomic_inc32(&detector->lost_digits);
+		return;
+	}
+	detector->buf[tail & (MPF_DTMFDET_BUFFER_LEN - 1)] = digit;
+	apr_atomic_xchg32(&detector->tail, tail + 1);
 }
 
-static APR_INLINE void goertzel_sample(
-								struct mpf_dtmf_detector_t *detector,
-								apr_int16_t sample)
+#ifdef MPF_DTMF_SSE2
+/** Advance the filters s1 (s(t-2)) and s2 (s(t-1)) by the sample x broadcasted to all lanes */
+#define GOERTZEL_STEP(x, coef, s1, s2) \
+	do { \
+		__m128 s_ = _mm_sub_ps(_mm_add_ps(x, _mm_mul_ps(coef, s2)), s1); \
+		s1 = s2; \
+		s2 = s_; \
+	} while (0)
+
+/** Run the bank over 4 samples already converted to float */
+#define GOERTZEL_STEP4(xf, coef_lo, coef_hi, s1_lo, s1_hi, s2_lo, s2_hi) \
+	do { \
+		__m128 x_ = _mm_shuffle_ps(xf, xf, _MM_SHUFFLE(0,0,0,0)); \
+		GOERTZEL_STEP(x_, coef_lo, s1_lo, s2_lo); \
+		GOERTZEL_STEP(x_, coef_hi, s1_hi, s2_hi); \
+		x_ = _mm_shuffle_ps(xf, xf, _MM_SHUFFLE(1,1,1,1)); \
+		GOERTZEL_STEP(x_, coef_lo, s1_lo, s2_lo); \
+		GOERTZEL_STEP(x_, coef_hi, s1_hi, s2_hi); \
+		x_ = _mm_shuffle_ps(xf, xf, _MM_SHUFFLE(2,2,2,2)); \
+		GOERTZEL_STEP(x_, coef_lo, s1_lo, s2_lo); \
+		GOERTZEL_STEP(x_, coef_hi, s1_hi, s2_hi); \
+		x_ = _mm_shuffle_ps(xf, xf, _MM_SHUFFLE(3,3,3,3)); \
+		GOERTZEL_STEP(x_, coef_lo, s1_lo, s2_lo); \
+		GOERTZEL_STEP(x_, coef_hi, s1_hi, s2_hi); \
+	} while (0)
+
+/** Convert 4 linear samples to float */
+static APR_INLINE __m128 goertzel_samples_load(const apr_int16_t *samples)
 {
-	apr_size_t i;
-	double s;
-	for (i = 0; i < DTMF_FREQUENCIES; i++) {
-		s = detector->energies[i].s1;
-		detector->energies[i].s1 = detector->energies[i].s2;
-		detector->energies[i].s2 = sample +
-			detector->energies[i].coef * detector->energies[i].s1 - s;
+	__m128i x = _mm_loadl_epi64((const __m128i *) samples);
+	return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+}
+
+/** Horizontal sum of 4 floats */
+static APR_INLINE float goertzel_hsum(__m128 v)
+{
+	v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+	v = _mm_add_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1,1,1,1)));
+	return _mm_cvtss_f32(v);
+}
+#endif
+
+/** Run the bank over the samples */
+static void goertzel_bank_run(
+								struct goertzel_bank_t *bank,
+								const apr_int16_t *samples,
+								apr_size_t count)
+{
+	apr_size_t i = 0;
+#ifdef MPF_DTMF_SSE2
+	__m128 coef_lo = _mm_loadu_ps(bank->coef);
+	__m128 coef_hi = _mm_loadu_ps(bank->coef + 4);
+	__m128 s1_lo = _mm_loadu_ps(bank->s1);
+	__m128 s1_hi = _mm_loadu_ps(bank->s1 + 4);
+	__m128 s2_lo = _mm_loadu_ps(bank->s2);
+	__m128 s2_hi = _mm_loadu_ps(bank->s2 + 4);
+	__m128 energy = _mm_setzero_ps();
+	__m128 xf;
+
+	for (; i + 4 <= count; i += 4) {
+		xf = goertzel_samples_load(samples + i);
+		energy = _mm_add_ps(energy, _mm_mul_ps(xf, xf));
+		GOERTZEL_STEP4(xf, coef_lo, coef_hi, s1_lo, s1_hi, s2_lo, s2_hi);
+	}
+	for (; i < count; i++) {
+		xf = _mm_set1_ps(samples[i]);
+		energy = _mm_add_ss(energy, _mm_mul_ss(xf, xf));
+		GOERTZEL_STEP(xf, coef_lo, s1_lo, s2_lo);
+		GOERTZEL_STEP(xf, coef_hi, s1_hi, s2_hi);
+	}
+
+	_mm_storeu_ps(bank->s1, s1_lo);
+	_mm_storeu_ps(bank->s1 + 4, s1_hi);
+	_mm_storeu_ps(bank->s2, s2_lo);
+	_mm_storeu_ps(bank->s2 + 4, s2_hi);
+	bank->totenergy += goertzel_hsum(energy);
+#else
+	apr_size_t j;
+	float x, s;
+	for (; i < count; i++) {
+		x = samples[i];
+		for (j = 0; j < DTMF_FREQUENCIES; j++) {
+			s = x + bank->coef[j] * bank->s2[j] - bank->s1[j];
+			bank->s1[j] = bank->s2[j];
+			bank->s2[j] = s;
+		}
+		bank->totenergy += x * x;
 	}
-	detector->totenergy += sample * sample;
+#endif
+}
+
+/**
+ * Run two banks over their own samples at once. The filters are latency
+ * rather than throughput bound, so interleaving independent channels
+ * keeps the vector unit busy.
+ */
+static void goertzel_bank_pair_run(
+								struct goertzel_bank_t *bank_a,
+								const apr_int16_t *samples_a,
+								struct goertzel_bank_t *bank_b,
+								const apr_int16_t *samples_b,
+								apr_size_t count)
+{
+#ifdef MPF_DTMF_SSE2
+	apr_size_t i = 0;
+	__m128 coef_a_lo = _mm_loadu_ps(bank_a->coef);
+	__m128 coef_a_hi = _mm_loadu_ps(bank_a->coef + 4);
+	__m128 s1_a_lo = _mm_loadu_ps(bank_a->s1);
+	__m128 s1_a_hi = _mm_loadu_ps(bank_a->s1 + 4);
+	__m128 s2_a_lo = _mm_loadu_ps(bank_a->s2);
+	__m128 s2_a_hi = _mm_loadu_ps(bank_a->s2 + 4);
+	__m128 coef_b_lo = _mm_loadu_ps(bank_b->coef);
+	__m128 coef_b_hi = _mm_loadu_ps(bank_b->coef + 4);
+	__m128 s1_b_lo = _mm_loadu_ps(bank_b->s1);
+	__m128 s1_b_hi = _mm_loadu_ps(bank_b->s1 + 4);
+	__m128 s2_b_lo = _mm_loadu_ps(bank_b->s2);
+	__m128 s2_b_hi = _mm_loadu_ps(bank_b->s2 + 4);
+	__m128 energy_a = _mm_setzero_ps();
+	__m128 energy_b = _mm_setzero_ps();
+	__m128 xf_a, xf_b;
+
+	for (; i + 4 <= count; i += 4) {
+		xf_a = goertzel_samples_load(samples_a + i);
+		xf_b = goertzel_samples_load(samples_b + i);
+		energy_a = _mm_add_ps(energy_a, _mm_mul_ps(xf_a, xf_a));
+		energy_b = _mm_add_ps(energy_b, _mm_mul_ps(xf_b, xf_b));
+		GOERTZEL_STEP4(xf_a, coef_a_lo, coef_a_hi, s1_a_lo, s1_a_hi, s2_a_lo, s2_a_hi);
+		GOERTZEL_STEP4(xf_b, coef_b_lo, coef_b_hi, s1_b_lo, s1_b_hi, s2_b_lo, s2_b_hi);
+	}
+
+	_mm_storeu_ps(bank_a->s1, s1_a_lo);
+	_mm_storeu_ps(bank_a->s1 + 4, s1_a_hi);
+	_mm_storeu_ps(bank_a->s2, s2_a_lo);
+	_mm_storeu_ps(bank_a->s2 + 4, s2_a_hi);
+	bank_a->totenergy += goertzel_hsum(energy_a);
+	_mm_storeu_ps(bank_b->s1, s1_b_lo);
+	_mm_storeu_ps(bank_b->s1 + 4, s1_b_hi);
+	_mm_storeu_ps(bank_b->s2, s2_b_lo);
+	_mm_storeu_ps(bank_b->s2 + 4, s2_b_hi);
+	bank_b->totenergy += goertzel_hsum(energy_b);
+
+	if (i < count) {
+		goertzel_bank_run(bank_a, samples_a + i, count - i);
+		goertzel_bank_run(bank_b, samples_b + i, count - i);
+	}
+#else
+	goertzel_bank_run(bank_a, samples_a, count);
+	goertzel_bank_run(bank_b, samples_b, count);
+#endif
 }
 
 static void goertzel_energies_digit(struct mpf_dtmf_detector_t *detector)
@@ -200,12 +355,13 @@ static void goertzel_energies_digit(struct mpf_dtmf_detector_t *detector)
 	apr_size_t i, rmax = 0, cmax = 0;
 	double reng = 0, ceng = 0;
 	char digit = 0;
+	struct goertzel_bank_t *bank = &detector->bank;
 
 	/* Calculate energies and maxims */
 	for (i = 0; i < DTMF_FREQUENCIES; i++) {
-		double eng = detector->energies[i].s1 * detector->energies[i].s1 +
-			detector->energies[i].s2 * detector->energies[i].s2 -
-			detector->energies[i].coef * detector->energies[i].s1 * detector->energies[i].s2;
+		double s1 = bank->s1[i];
+		double s2 = bank->s2[i];
+		double eng = s1 * s1 + s2 * s2 - bank->coef[i] * s1 * s2;
 		if (i < DTMF_FREQUENCIES/2) {
 			if (eng > reng) {
 				rmax = i;
@@ -235,7 +391,7 @@ static void goertzel_energies_digit(struct mpf_dtmf_detector_t *detector)
 		 */
 	} else if ((ceng < reng) && (ceng < reng * 0.158)) {  /* twist > 8db, error */
 		/* Reverse twist check failed */
-	} else if (0.25 * detector->totenergy > (reng + ceng)) {  /* 16db */
+	} else if (0.25 * bank->totenergy > (reng + ceng)) {  /* 16db */
 		/* Signal energy to total energy ratio test failed */
 	} else {
 		digit = freq2digits[rmax][cmax - DTMF_FREQUENCIES/2];
@@ -255,16 +411,51 @@ static void goertzel_energies_digit(struct mpf_dtmf_detector_t *detector)
 
 	/* Reset Goertzel's detectors */
 	for (i = 0; i < DTMF_FREQUENCIES; i++) {
-		detector->energies[i].s1 = 0;
-		detector->energies[i].s2 = 0;
+		bank->s1[i] = 0;
+		bank->s2[i] = 0;
 	}
-	detector->totenergy = 0;
+	bank->totenergy = 0;
 }
 
-MPF_DECLARE(void) mpf_dtmf_detector_get_frame(
+/** Count samples of the current window and evaluate it once complete */
+static APR_INLINE void goertzel_window_advance(struct mpf_dtmf_detector_t *detector, apr_size_t count)
+{
+	detector->nsamples += count;
+	if (detector->nsamples >= detector->wsamples) {
+		goertzel_energies_digit(detector);
+		detector->nsamples = 0;
+	}
+}
+
+static void mpf_dtmf_detector_samples_process(
+								struct mpf_dtmf_detector_t *detector,
+								const apr_int16_t *samples,
+								apr_size_t count)
+{
+	apr_size_t n;
+	while (count) {
+		n = detector->wsamples - detector->nsamples;
+		if (n > count) n = count;
+		goertzel_bank_run(&detector->bank, samples, n);
+		goertzel_window_advance(detector, n);
+		samples += n;
+		count -= n;
+	}
+}
+
+/**
+ * Process an event frame or check whether audio of the frame is to be analyzed.
+ * @return TRUE if the samples of the frame are to be analyzed in-band
+ */
+static apt_bool_t mpf_dtmf_detector_frame_check(
 								struct mpf_dtmf_detector_t *detector,
 								const struct mpf_frame_t *frame)
 {
+	if (apr_atomic_read32(&detector->reset_pending) && apr_atomic_cas32(&detector->reset_pending, 0, 1)) {
+		if (detector->band & MPF_DTMF_DETECTOR_INBAND)
+			mpf_dtmf_detector_states_reset(detector);
+	}
+
 	if ((detector->band & MPF_DTMF_DETECTOR_OUTBAND) &&
 		(frame->type & MEDIA_FRAME_TYPE_EVENT) &&
 		(frame->event_frame.event_id <= DTMF_EVENT_ID_MAX) &&
@@ -277,25 +468,76 @@ MPF_DECLARE(void) mpf_dtmf_detector_get_frame(
 		}
 		mpf_dtmf_detector_add_digit(detector, mpf_event_id_to_dtmf_char(
 			frame->event_frame.event_id));
-		return;
+		return FALSE;
 	}
 
-	if ((detector->band & MPF_DTMF_DETECTOR_INBAND) && (frame->type & MEDIA_FRAME_TYPE_AUDIO)) {
-		apr_int16_t *samples = frame->codec_frame.buffer;
-		apr_size_t i;
+	return ((detector->band & MPF_DTMF_DETECTOR_INBAND) && (frame->type & MEDIA_FRAME_TYPE_AUDIO)) ?
+		TRUE : FALSE;
+}
 
-		for (i = 0; i < frame->codec_frame.size / 2; i++) {
-			goertzel_sample(detector, samples[i]);
-			if (++detector->nsamples >= detector->wsamples) {
-				goertzel_energies_digit(detector);
-				detector->nsamples = 0;
-			}
+MPF_DECLARE(void) mpf_dtmf_detector_get_frame(
+								struct mpf_dtmf_detector_t *detector,
+								const struct mpf_frame_t *frame)
+{
+	if (mpf_dtmf_detector_frame_check(detector, frame) == TRUE) {
+		mpf_dtmf_detector_samples_process(detector, frame->codec_frame.buffer,
+			frame->codec_frame.size / 2);
+	}
+}
+
+MPF_DECLARE(void) mpf_dtmf_detector_get_frames(
+								struct mpf_dtmf_detector_t **detectors,
+								const struct mpf_frame_t **frames,
+								apr_size_t count)
+{
+	struct mpf_dtmf_detector_t *det_a = NULL;
+	const apr_int16_t *samples_a = NULL;
+	apr_size_t count_a = 0;
+	const apr_int16_t *samples_b;
+	apr_size_t count_b;
+	apr_size_t i, n;
+
+	for (i = 0; i < count; i++) {
+		if (mpf_dtmf_detector_frame_check(detectors[i], frames[i]) == FALSE)
+			continue;
+
+		if (!det_a) {
+			/* wait for a pair */
+			det_a = detectors[i];
+			samples_a = frames[i]->codec_frame.buffer;
+			count_a = frames[i]->codec_frame.size / 2;
+			continue;
 		}
+
+		samples_b = frames[i]->codec_frame.buffer;
+		count_b = frames[i]->codec_frame.size / 2;
+		/* advance both detectors in lock step up to the nearest window boundary */
+		while (count_a && count_b) {
+			n = count_a < count_b ? count_a : count_b;
+			if (n > det_a->wsamples - det_a->nsamples)
+				n = det_a->wsamples - det_a->nsamples;
+			if (n > detectors[i]->wsamples - detectors[i]->nsamples)
+				n = detectors[i]->wsamples - detectors[i]->nsamples;
+
+			goertzel_bank_pair_run(&det_a->bank, samples_a, &detectors[i]->bank, samples_b, n);
+			goertzel_window_advance(det_a, n);
+			goertzel_window_advance(detectors[i], n);
+			samples_a += n;
+			count_a -= n;
+			samples_b += n;
+			count_b -= n;
+		}
+		mpf_dtmf_detector_samples_process(det_a, samples_a, count_a);
+		mpf_dtmf_detector_samples_process(detectors[i], samples_b, count_b);
+		det_a = NULL;
+	}
+
+	if (det_a) {
+		mpf_dtmf_detector_samples_process(det_a, samples_a, count_a);
 	}
 }
 
 MPF_DECLARE(void) mpf_dtmf_detector_destroy(struct mpf_dtmf_detector_t *detector)
 {
-	apr_thread_mutex_destroy(detector->mutex);
-	detector->mutex = NULL;
+	/* The detector is allocated from the pool and holds no other resources */
 }
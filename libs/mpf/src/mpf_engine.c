@@ -24,21 +24,47 @@
 #include "mpf_codec_descriptor.h"
 #include "mpf_codec_manager.h"
 #include "apt_obj_list.h"
-#include "apt_cyclic_queue.h"
+#include "apt_lockfree_queue.h"
 #include "apt_log.h"
 
 #define MPF_TIMER_RESOLUTION 100 /* 100 ms */
+#define MPF_RTP_POLLER_READY_COUNT 256
+#define MPF_PROFILE_SAMPLE_RATE 10 /* sample objects and contexts every 10th tick */
+
+/** Media engine worker (scheduler thread processing its own subset of contexts) */
+typedef struct mpf_engine_worker_t mpf_engine_worker_t;
+
+struct mpf_engine_worker_t {
+	mpf_engine_t              *engine;
+	apr_size_t                 id;
+	apt_lockfree_queue_t      *request_queue;
+	mpf_context_factory_t     *context_factory;
+	mpf_scheduler_t           *scheduler;
+	apt_timer_queue_t         *timer_queue;
+	mpf_rtp_poller_t          *rtp_poller;
+	mpf_engine_worker_stat_t   stat;
+	mpf_engine_profile_t       profile;
+	apr_size_t                 profile_tick;
+	apr_size_t                 profile_elapsed_time;
+};
 
 struct mpf_engine_t {
 	apr_pool_t                *pool;
 	apt_task_t                *task;
 	apt_task_msg_type_e        task_msg_type;
-	apr_thread_mutex_t        *request_queue_guard;
-	apt_cyclic_queue_t        *request_queue;
-	mpf_context_factory_t     *context_factory;
-	mpf_scheduler_t           *scheduler;
-	apt_timer_queue_t         *timer_queue;
+	apr_thread_mutex_t        *placement_guard;
+	mpf_engine_worker_t      **workers;
+	apr_size_t                 worker_count;
+	unsigned long              rate;
 	const mpf_codec_manager_t *codec_manager;
+	apt_bool_t                 profiling;
+	apr_size_t                 profile_sample_rate;
+	apr_size_t                 profile_dump_interval;
+};
+
+/** Upper bounds of the buckets of the tick duration histogram (usec), the last bucket is unbounded */
+static const apr_uint32_t tick_histogram_bounds[MPF_TICK_HISTOGRAM_SIZE-1] = {
+	100, 250, 500, 1000, 2000, 5000, 10000, 20000, 50000
 };
 
 static void mpf_engine_main(mpf_scheduler_t *scheduler, void *obj);
@@ -53,6 +79,45 @@ static apt_bool_t mpf_engine_msg_process(apt_task_t *task, apt_task_msg_t *msg);
 mpf_codec_t* mpf_codec_l16_create(apr_pool_t *pool);
 mpf_codec_t* mpf_codec_g711u_create(apr_pool_t *pool);
 mpf_codec_t* mpf_codec_g711a_create(apr_pool_t *pool);
+mpf_codec_t* mpf_codec_g722_create(apr_pool_t *pool);
+
+static mpf_engine_worker_t* mpf_engine_worker_create(mpf_engine_t *engine, apr_size_t id)
+{
+	mpf_engine_worker_t *worker = apr_palloc(engine->pool,sizeof(mpf_engine_worker_t));
+	worker->engine = engine;
+	worker->id = id;
+	memset(&worker->stat,0,sizeof(mpf_engine_worker_stat_t));
+	memset(&worker->profile,0,sizeof(mpf_engine_profile_t));
+	worker->profile_tick = 0;
+	worker->profile_elapsed_time = 0;
+
+	worker->context_factory = mpf_context_factory_create(engine->pool);
+	worker->request_queue = apt_lockfree_queue_create_ex(LOCKFREE_QUEUE_DEFAULT_SIZE,TRUE,engine->pool);
+
+	worker->scheduler = mpf_scheduler_create(engine->pool);
+	mpf_scheduler_media_clock_set(worker->scheduler,CODEC_FRAME_TIME_BASE,mpf_engine_main,worker);
+
+	worker->timer_queue = apt_timer_queue_create_ex(MPF_TIMER_RESOLUTION,engine->pool);
+	/* streams fall back to receiving on their own if there is no poller */
+	worker->rtp_poller = mpf_rtp_poller_create(MPF_RTP_POLLER_READY_COUNT,engine->pool);
+	mpf_scheduler_timer_clock_set(worker->scheduler,MPF_TIMER_RESOLUTION,mpf_engine_timer_proc,worker);
+
+	if(engine->rate > 1) {
+		mpf_scheduler_rate_set(worker->scheduler,engine->rate);
+	}
+	return worker;
+}
+
+static void mpf_engine_worker_destroy(mpf_engine_worker_t *worker)
+{
+	if(worker->rtp_poller) {
+		mpf_rtp_poller_destroy(worker->rtp_poller);
+	}
+	apt_timer_queue_destroy(worker->timer_queue);
+	mpf_scheduler_destroy(worker->scheduler);
+	mpf_context_factory_destroy(worker->context_factory);
+	apt_lockfree_queue_destroy(worker->request_queue);
+}
 
 MPF_DECLARE(mpf_engine_t*) mpf_engine_create(const char *id, apr_pool_t *pool)
 {
@@ -60,11 +125,15 @@ MPF_DECLARE(mpf_engine_t*) mpf_engine_create(const char *id, apr_pool_t *pool)
 	apt_task_msg_pool_t *msg_pool;
 	mpf_engine_t *engine = apr_palloc(pool,sizeof(mpf_engine_t));
 	engine->pool = pool;
-	engine->request_queue = NULL;
-	engine->context_factory = NULL;
+	engine->workers = NULL;
+	engine->worker_count = 0;
+	engine->rate = 1;
 	engine->codec_manager = NULL;
+	engine->profiling = FALSE;
+	engine->profile_sample_rate = MPF_PROFILE_SAMPLE_RATE;
+	engine->profile_dump_interval = 0;
 
-	msg_pool = apt_task_msg_pool_create_dynamic(sizeof(mpf_message_container_t),pool);
+	msg_pool = apt_task_msg_pool_create_static(sizeof(mpf_message_container_t),TASK_MSG_POOL_DEFAULT_SIZE,pool);
 
 	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Create Media Engine [%s]",id);
 	engine->task = apt_task_create(engine,msg_pool,pool);
@@ -85,16 +154,212 @@ MPF_DECLARE(mpf_engine_t*) mpf_engine_create(const char *id, apr_pool_t *pool)
 
 	engine->task_msg_type = TASK_MSG_USER;
 
-	engine->context_factory = mpf_context_factory_create(engine->pool);
-	engine->request_queue = apt_cyclic_queue_create(CYCLIC_QUEUE_DEFAULT_SIZE);
-	apr_thread_mutex_create(&engine->request_queue_guard,APR_THREAD_MUTEX_UNNESTED,engine->pool);
+	apr_thread_mutex_create(&engine->placement_guard,APR_THREAD_MUTEX_UNNESTED,engine->pool);
+	mpf_engine_worker_count_set(engine,1);
+	return engine;
+}
 
-	engine->scheduler = mpf_scheduler_create(engine->pool);
-	mpf_scheduler_media_clock_set(engine->scheduler,CODEC_FRAME_TIME_BASE,mpf_engine_main,engine);
+MPF_DECLARE(apt_bool_t) mpf_engine_worker_count_set(mpf_engine_t *engine, apr_size_t worker_count)
+{
+	apr_size_t i;
+	mpf_engine_worker_t **workers;
+	if(worker_count == 0 || worker_count > MPF_ENGINE_MAX_WORKER_COUNT) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Worker Count [%"APR_SIZE_T_FMT"] [%s]",
+			worker_count,mpf_engine_id_get(engine));
+		return FALSE;
+	}
+	if(worker_count <= engine->worker_count) {
+		/* workers can be added, but never removed */
+		return FALSE;
+	}
 
-	engine->timer_queue = apt_timer_queue_create(engine->pool);
-	mpf_scheduler_timer_clock_set(engine->scheduler,MPF_TIMER_RESOLUTION,mpf_engine_timer_proc,engine);
-	return engine;
+	workers = apr_palloc(engine->pool,worker_count * sizeof(mpf_engine_worker_t*));
+	for(i=0; i<engine->worker_count; i++) {
+		workers[i] = engine->workers[i];
+	}
+	for(; i<worker_count; i++) {
+		workers[i] = mpf_engine_worker_create(engine,i);
+	}
+	engine->workers = workers;
+	engine->worker_count = worker_count;
+	return TRUE;
+}
+
+MPF_DECLARE(apr_size_t) mpf_engine_worker_count_get(const mpf_engine_t *engine)
+{
+	return engine->worker_count;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_engine_worker_stat_get(const mpf_engine_t *engine, apr_size_t id, mpf_engine_worker_stat_t *stat)
+{
+	mpf_engine_worker_t *worker;
+	if(id >= engine->worker_count || !stat) {
+		return FALSE;
+	}
+
+	worker = engine->workers[id];
+	*stat = worker->stat;
+	stat->context_count = mpf_context_factory_load_get(worker->context_factory);
+	if(worker->rtp_poller) {
+		mpf_rtp_poller_stat_get(worker->rtp_poller,&stat->rtp_stat);
+	}
+	return TRUE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_engine_profiling_set(mpf_engine_t *engine, apt_bool_t enable, apr_size_t sample_rate, apr_size_t dump_interval)
+{
+	engine->profile_sample_rate = sample_rate ? sample_rate : MPF_PROFILE_SAMPLE_RATE;
+	engine->profile_dump_interval = dump_interval;
+	engine->profiling = enable;
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Media Engine Profiling [%s] sample rate [%"APR_SIZE_T_FMT"] dump interval [%"APR_SIZE_T_FMT" ms] [%s]",
+		enable == TRUE ? "on" : "off",
+		engine->profile_sample_rate,
+		engine->profile_dump_interval,
+		mpf_engine_id_get(engine));
+	return TRUE;
+}
+
+MPF_DECLARE(apr_size_t) mpf_engine_tick_histogram_bucket_get(apr_uint32_t duration)
+{
+	apr_size_t i;
+	for(i=0; i<MPF_TICK_HISTOGRAM_SIZE-1; i++) {
+		if(duration < tick_histogram_bounds[i]) {
+			break;
+		}
+	}
+	return i;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_engine_worker_profile_get(const mpf_engine_t *engine, apr_size_t id, mpf_engine_profile_t *profile)
+{
+	mpf_engine_worker_t *worker;
+	mpf_scheduler_stat_t scheduler_stat;
+	if(id >= engine->worker_count || !profile) {
+		return FALSE;
+	}
+
+	worker = engine->workers[id];
+	*profile = worker->profile;
+	mpf_scheduler_stat_get(worker->scheduler,&scheduler_stat);
+	profile->late_tick_count = scheduler_stat.late_count;
+	profile->max_time_drift = scheduler_stat.max_time_drift;
+	return TRUE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_engine_profile_get(const mpf_engine_t *engine, mpf_engine_profile_t *profile)
+{
+	mpf_engine_profile_t worker_profile;
+	mpf_context_profile_t *context_profile;
+	mpf_context_profile_t *worker_context_profile;
+	mpf_object_profile_t *object_profile;
+	mpf_object_profile_t *worker_object_profile;
+	apr_size_t i,j;
+	if(!profile) {
+		return FALSE;
+	}
+
+	memset(profile,0,sizeof(mpf_engine_profile_t));
+	context_profile = &profile->context_profile;
+	for(i=0; i<engine->worker_count; i++) {
+		mpf_engine_worker_profile_get(engine,i,&worker_profile);
+
+		for(j=0; j<MPF_TICK_HISTOGRAM_SIZE; j++) {
+			profile->tick_histogram[j] += worker_profile.tick_histogram[j];
+		}
+		profile->tick_count += worker_profile.tick_count;
+		profile->overrun_count += worker_profile.overrun_count;
+		profile->total_tick_duration += worker_profile.total_tick_duration;
+		if(worker_profile.max_tick_duration > profile->max_tick_duration) {
+			profile->max_tick_duration = worker_profile.max_tick_duration;
+		}
+		profile->late_tick_count += worker_profile.late_tick_count;
+		if(worker_profile.max_time_drift > profile->max_time_drift) {
+			profile->max_time_drift = worker_profile.max_time_drift;
+		}
+
+		worker_context_profile = &worker_profile.context_profile;
+		for(j=0; j<MPF_OBJECT_TYPE_COUNT; j++) {
+			object_profile = &context_profile->objects[j];
+			worker_object_profile = &worker_context_profile->objects[j];
+			object_profile->process_count += worker_object_profile->process_count;
+			object_profile->total_time += worker_object_profile->total_time;
+			if(worker_object_profile->max_time > object_profile->max_time) {
+				object_profile->max_time = worker_object_profile->max_time;
+			}
+		}
+		context_profile->sample_count += worker_context_profile->sample_count;
+		context_profile->context_count += worker_context_profile->context_count;
+		context_profile->context_total_time += worker_context_profile->context_total_time;
+		if(worker_context_profile->context_max_time > context_profile->context_max_time) {
+			context_profile->context_max_time = worker_context_profile->context_max_time;
+			memcpy(context_profile->context_max_name,worker_context_profile->context_max_name,sizeof(context_profile->context_max_name));
+		}
+	}
+	return TRUE;
+}
+
+static void mpf_engine_worker_profile_dump(mpf_engine_worker_t *worker)
+{
+	mpf_engine_profile_t profile;
+	mpf_context_profile_t *context_profile = &profile.context_profile;
+	mpf_object_profile_t *object_profile;
+	const char *name = apt_task_name_get(worker->engine->task);
+	char buf[512];
+	apr_size_t offset = 0;
+	apr_size_t i;
+
+	mpf_engine_worker_profile_get(worker->engine,worker->id,&profile);
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Media Engine Worker [%"APR_SIZE_T_FMT"] Profile: ticks [%u] overruns [%u] avg tick [%u usec] max tick [%u usec] late ticks [%u] max drift [%u usec] [%s]",
+		worker->id,
+		profile.tick_count,
+		profile.overrun_count,
+		profile.tick_count ? (apr_uint32_t)(profile.total_tick_duration / profile.tick_count) : 0,
+		profile.max_tick_duration,
+		profile.late_tick_count,
+		profile.max_time_drift,
+		name);
+
+	for(i=0; i<MPF_TICK_HISTOGRAM_SIZE && offset < sizeof(buf); i++) {
+		if(i < MPF_TICK_HISTOGRAM_SIZE-1) {
+			offset += apr_snprintf(buf+offset,sizeof(buf)-offset," <%u [%u]",
+				tick_histogram_bounds[i],profile.tick_histogram[i]);
+		}
+		else {
+			offset += apr_snprintf(buf+offset,sizeof(buf)-offset," >=%u [%u]",
+				tick_histogram_bounds[i-1],profile.tick_histogram[i]);
+		}
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Media Engine Worker [%"APR_SIZE_T_FMT"] Tick Histogram (usec):%s [%s]",
+		worker->id,buf,name);
+
+	if(!context_profile->sample_count) {
+		return;
+	}
+
+	offset = 0;
+	buf[0] = '\0';
+	for(i=0; i<MPF_OBJECT_TYPE_COUNT && offset < sizeof(buf); i++) {
+		object_profile = &context_profile->objects[i];
+		if(!object_profile->process_count) {
+			continue;
+		}
+		offset += apr_snprintf(buf+offset,sizeof(buf)-offset," %s [count:%u avg:%u max:%u]",
+			mpf_object_type_str_get(i),
+			object_profile->process_count,
+			(apr_uint32_t)(object_profile->total_time / object_profile->process_count),
+			object_profile->max_time);
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Media Engine Worker [%"APR_SIZE_T_FMT"] Object Profile (usec):%s [%s]",
+		worker->id,buf,name);
+
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Media Engine Worker [%"APR_SIZE_T_FMT"] Context Profile: samples [%u] contexts [%u] avg [%u usec] max [%u usec] <%s> [%s]",
+		worker->id,
+		context_profile->sample_count,
+		context_profile->context_count,
+		context_profile->context_count ? (apr_uint32_t)(context_profile->context_total_time / context_profile->context_count) : 0,
+		context_profile->context_max_time,
+		context_profile->context_max_name,
+		name);
 }
 
 MPF_DECLARE(mpf_context_t*) mpf_engine_context_create(
@@ -104,7 +369,8 @@ MPF_DECLARE(mpf_context_t*) mpf_engine_context_create(
 								apr_size_t max_termination_count,
 								apr_pool_t *pool)
 {
-	return mpf_context_create(engine->context_factory,name,obj,max_termination_count,pool);
+	/* context is assigned to the least loaded worker upon the first request */
+	return mpf_context_create(NULL,name,obj,max_termination_count,pool);
 }
 
 MPF_DECLARE(apt_bool_t) mpf_engine_context_destroy(mpf_context_t *context)
@@ -142,6 +408,10 @@ static mpf_message_t* mpf_engine_message_get(mpf_engine_t *engine, mpf_task_msg_
 	}
 	else {
 		*task_msg = apt_task_msg_get(engine->task);
+		if(!*task_msg) {
+			apt_log(APT_LOG_MARK,APT_PRIO_ERROR,"Failed to Get MPF Task Message [%s]",apt_task_name_get(engine->task));
+			return NULL;
+		}
 		container = (mpf_message_container_t*) (*task_msg)->data;
 		container->count = 0;
 	}
@@ -225,30 +495,58 @@ MPF_DECLARE(apt_bool_t) mpf_engine_message_send(mpf_engine_t *engine, mpf_task_m
 
 static apt_bool_t mpf_engine_destroy(apt_task_t *task)
 {
+	apr_size_t i;
 	mpf_engine_t *engine = apt_task_object_get(task);
 
-	apt_timer_queue_destroy(engine->timer_queue);
-	mpf_scheduler_destroy(engine->scheduler);
-	mpf_context_factory_destroy(engine->context_factory);
-	apt_cyclic_queue_destroy(engine->request_queue);
-	apr_thread_mutex_destroy(engine->request_queue_guard);
+	for(i=0; i<engine->worker_count; i++) {
+		mpf_engine_worker_destroy(engine->workers[i]);
+	}
+	apr_thread_mutex_destroy(engine->placement_guard);
 	return TRUE;
 }
 
 static apt_bool_t mpf_engine_start(apt_task_t *task)
 {
+	apr_size_t i;
 	mpf_engine_t *engine = apt_task_object_get(task);
 
-	mpf_scheduler_start(engine->scheduler);
+	for(i=0; i<engine->worker_count; i++) {
+		mpf_scheduler_start(engine->workers[i]->scheduler);
+	}
 	apt_task_child_start(task);
 	return TRUE;
 }
 
 static apt_bool_t mpf_engine_terminate(apt_task_t *task)
 {
+	apr_size_t i;
 	mpf_engine_t *engine = apt_task_object_get(task);
 
-	mpf_scheduler_stop(engine->scheduler);
+	mpf_engine_worker_t *worker;
+
+	for(i=0; i<engine->worker_count; i++) {
+		worker = engine->workers[i];
+		mpf_scheduler_stop(worker->scheduler);
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Media Engine Worker [%"APR_SIZE_T_FMT"] Stats: ticks [%u] overruns [%u] max tick [%u usec] [%s]",
+			worker->id,
+			worker->stat.tick_count,
+			worker->stat.overrun_count,
+			worker->stat.max_tick_duration,
+			apt_task_name_get(task));
+		if(worker->rtp_poller) {
+			mpf_rtp_poller_stat_t rtp_stat;
+			mpf_rtp_poller_stat_get(worker->rtp_poller,&rtp_stat);
+			apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Media Engine Worker [%"APR_SIZE_T_FMT"] RTP Stats: packets [%u] polls [%u] receives [%u] [%s]",
+				worker->id,
+				rtp_stat.packet_count,
+				rtp_stat.poll_count,
+				rtp_stat.recv_count,
+				apt_task_name_get(task));
+		}
+		if(engine->profiling == TRUE) {
+			mpf_engine_worker_profile_dump(worker);
+		}
+	}
 	apt_task_child_terminate(task);
 	return TRUE;
 }
@@ -265,6 +563,10 @@ static apt_bool_t mpf_engine_event_raise(mpf_termination_t *termination, int eve
 	}
 
 	task_msg = apt_task_msg_get(engine->task);
+	if(!task_msg) {
+		apt_log(APT_LOG_MARK,APT_PRIO_ERROR,"Failed to Raise MPF Event [%d]: no task message",event_id);
+		return FALSE;
+	}
 	task_msg->type = engine->task_msg_type;
 	event_msg = (mpf_message_container_t*) task_msg->data;
 	mpf_message = event_msg->messages;
@@ -280,15 +582,69 @@ static apt_bool_t mpf_engine_event_raise(mpf_termination_t *termination, int eve
 	return apt_task_msg_parent_signal(engine->task,task_msg);
 }
 
+/** Get the worker the context is assigned to or assign the context to the least loaded worker */
+static mpf_engine_worker_t* mpf_engine_worker_place(mpf_engine_t *engine, mpf_context_t *context)
+{
+	apr_size_t i;
+	apr_size_t load;
+	apr_size_t min_load;
+	mpf_context_factory_t *factory;
+	mpf_engine_worker_t *worker = engine->workers[0];
+	if(!context) {
+		return worker;
+	}
+
+	apr_thread_mutex_lock(engine->placement_guard);
+	factory = mpf_context_factory_get(context);
+	if(factory) {
+		for(i=0; i<engine->worker_count; i++) {
+			if(engine->workers[i]->context_factory == factory) {
+				worker = engine->workers[i];
+				break;
+			}
+		}
+	}
+	else {
+		min_load = mpf_context_factory_load_get(worker->context_factory);
+		for(i=1; i<engine->worker_count; i++) {
+			load = mpf_context_factory_load_get(engine->workers[i]->context_factory);
+			if(load < min_load) {
+				min_load = load;
+				worker = engine->workers[i];
+			}
+		}
+		mpf_context_factory_assign(context,worker->context_factory);
+		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Assign Media Context to Worker [%"APR_SIZE_T_FMT"] [%s]",
+			worker->id,apt_task_name_get(engine->task));
+	}
+	apr_thread_mutex_unlock(engine->placement_guard);
+	return worker;
+}
+
 static apt_bool_t mpf_engine_msg_signal(apt_task_t *task, apt_task_msg_t *msg)
 {
+	apr_size_t i;
+	mpf_context_t *context = NULL;
+	mpf_engine_worker_t *worker;
 	mpf_engine_t *engine = apt_task_object_get(task);
-	
-	apr_thread_mutex_lock(engine->request_queue_guard);
-	if(apt_cyclic_queue_push(engine->request_queue,msg) == FALSE) {
-		apt_log(APT_LOG_MARK,APT_PRIO_ERROR,"MPF Request Queue is Full [%s]",apt_task_name_get(task));
+	const mpf_message_container_t *request = (const mpf_message_container_t*) msg->data;
+
+	/* messages in the container are all related to the same context */
+	for(i=0; i<request->count; i++) {
+		if(request->messages[i].context) {
+			context = request->messages[i].context;
+			break;
+		}
+	}
+	worker = mpf_engine_worker_place(engine,context);
+
+	if(apt_lockfree_queue_push(worker->request_queue,msg) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_ERROR,"Failed to Queue MPF Request [%s] overflows [%u]",
+			apt_task_name_get(task),
+			apt_lockfree_queue_overflow_count_get(worker->request_queue));
+		apt_task_msg_release(msg);
+		return FALSE;
 	}
-	apr_thread_mutex_unlock(engine->request_queue_guard);
 	return TRUE;
 }
 
@@ -301,10 +657,15 @@ static apt_bool_t mpf_engine_msg_process(apt_task_t *task, apt_task_msg_t *msg)
 	mpf_message_t *mpf_response;
 	mpf_context_t *context;
 	mpf_termination_t *termination;
+	mpf_engine_worker_t *worker;
 	const mpf_message_t *mpf_request;
 	const mpf_message_container_t *request = (const mpf_message_container_t*) msg->data;
 
 	response_msg = apt_task_msg_get(engine->task);
+	if(!response_msg) {
+		apt_log(APT_LOG_MARK,APT_PRIO_ERROR,"Failed to Respond to MPF Request: no task message");
+		return FALSE;
+	}
 	response_msg->type = engine->task_msg_type;
 	response = (mpf_message_container_t*) response_msg->data;
 	*response = *request;
@@ -327,7 +688,9 @@ static apt_bool_t mpf_engine_msg_process(apt_task_t *task, apt_task_msg_t *msg)
 				termination->event_handler_obj = engine;
 				termination->event_handler = mpf_engine_event_raise;
 				termination->codec_manager = engine->codec_manager;
-				termination->timer_queue = engine->timer_queue;
+				worker = mpf_engine_worker_place(engine,context);
+				termination->timer_queue = worker->timer_queue;
+				termination->rtp_poller = worker->rtp_poller;
 
 				mpf_termination_add(termination,mpf_request->descriptor);
 				if(mpf_context_termination_add(context,termination) == FALSE) {
@@ -388,28 +751,70 @@ static apt_bool_t mpf_engine_msg_process(apt_task_t *task, apt_task_msg_t *msg)
 
 static void mpf_engine_main(mpf_scheduler_t *scheduler, void *obj)
 {
-	mpf_engine_t *engine = obj;
+	mpf_engine_worker_t *worker = obj;
+	mpf_engine_t *engine = worker->engine;
 	apt_task_msg_t *msg;
+	apr_time_t time_start = apr_time_now();
+	apr_interval_time_t duration;
+	apt_bool_t overrun;
 
 	/* process request queue */
-	apr_thread_mutex_lock(engine->request_queue_guard);
-	msg = apt_cyclic_queue_pop(engine->request_queue);
-	while(msg) {
-		apr_thread_mutex_unlock(engine->request_queue_guard);
+	while((msg = apt_lockfree_queue_pop(worker->request_queue)) != NULL) {
 		apt_task_msg_process(engine->task,msg);
-		apr_thread_mutex_lock(engine->request_queue_guard);
-		msg = apt_cyclic_queue_pop(engine->request_queue);
 	}
-	apr_thread_mutex_unlock(engine->request_queue_guard);
 
-	/* process factory of media contexts */
-	mpf_context_factory_process(engine->context_factory);
+	/* receive RTP packets from ready sockets */
+	if(worker->rtp_poller) {
+		mpf_rtp_poller_process(worker->rtp_poller);
+	}
+
+	/* process factory of media contexts, timing objects and contexts on sampled ticks */
+	if(engine->profiling == TRUE && ++worker->profile_tick >= engine->profile_sample_rate) {
+		worker->profile_tick = 0;
+		mpf_context_factory_profile_process(worker->context_factory,&worker->profile.context_profile);
+	}
+	else {
+		mpf_context_factory_process(worker->context_factory);
+	}
+
+	/* update tick stats */
+	duration = apr_time_now() - time_start;
+	overrun = (duration * engine->rate > CODEC_FRAME_TIME_BASE * 1000) ? TRUE : FALSE;
+	worker->stat.tick_count++;
+	if(duration > (apr_interval_time_t)worker->stat.max_tick_duration) {
+		worker->stat.max_tick_duration = (apr_uint32_t)duration;
+	}
+	if(overrun == TRUE) {
+		worker->stat.overrun_count++;
+	}
+
+	if(engine->profiling == TRUE) {
+		mpf_engine_profile_t *profile = &worker->profile;
+		profile->tick_histogram[mpf_engine_tick_histogram_bucket_get((apr_uint32_t)duration)]++;
+		profile->tick_count++;
+		profile->total_tick_duration += duration;
+		if(duration > (apr_interval_time_t)profile->max_tick_duration) {
+			profile->max_tick_duration = (apr_uint32_t)duration;
+		}
+		if(overrun == TRUE) {
+			profile->overrun_count++;
+		}
+	}
 }
 
 static void mpf_engine_timer_proc(mpf_scheduler_t *scheduler, void *obj)
 {
-	mpf_engine_t *engine = obj;
-	apt_timer_queue_advance(engine->timer_queue,MPF_TIMER_RESOLUTION);
+	mpf_engine_worker_t *worker = obj;
+	mpf_engine_t *engine = worker->engine;
+	apt_timer_queue_advance(worker->timer_queue,MPF_TIMER_RESOLUTION);
+
+	if(engine->profiling == TRUE && engine->profile_dump_interval) {
+		worker->profile_elapsed_time += MPF_TIMER_RESOLUTION;
+		if(worker->profile_elapsed_time >= engine->profile_dump_interval) {
+			worker->profile_elapsed_time = 0;
+			mpf_engine_worker_profile_dump(worker);
+		}
+	}
 }
 
 MPF_DECLARE(mpf_codec_manager_t*) mpf_engine_codec_manager_create(apr_pool_t *pool)
@@ -424,6 +829,9 @@ MPF_DECLARE(mpf_codec_manager_t*) mpf_engine_codec_manager_create(apr_pool_t *po
 		codec = mpf_codec_g711a_create(pool);
 		mpf_codec_manager_codec_register(codec_manager,codec);
 
+		codec = mpf_codec_g722_create(pool);
+		mpf_codec_manager_codec_register(codec_manager,codec);
+
 		codec = mpf_codec_l16_create(pool);
 		mpf_codec_manager_codec_register(codec_manager,codec);
 	}
@@ -438,7 +846,18 @@ MPF_DECLARE(apt_bool_t) mpf_engine_codec_manager_register(mpf_engine_t *engine,
 
 MPF_DECLARE(apt_bool_t) mpf_engine_scheduler_rate_set(mpf_engine_t *engine, unsigned long rate)
 {
-	return mpf_scheduler_rate_set(engine->scheduler,rate);
+	apr_size_t i;
+	apt_bool_t status = TRUE;
+	if(rate == 0 || rate > 10) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Scheduler Rate [%lu]: use real-time rate [1]",rate);
+		rate = 1;
+		status = FALSE;
+	}
+	engine->rate = rate;
+	for(i=0; i<engine->worker_count; i++) {
+		mpf_scheduler_rate_set(engine->workers[i]->scheduler,rate);
+	}
+	return status;
 }
 
 MPF_DECLARE(const char*) mpf_engine_id_get(const mpf_engine_t *engine)
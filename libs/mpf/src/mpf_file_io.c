@@ -0,0 +1,425 @@
+/*
+ * Copyright 2008-2010 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <apr_atomic.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+#include "mpf_file_io.h"
+#include "apt_lockfree_queue.h"
+#include "apt_log.h"
+
+/** Interval the background thread services the files at (usec) */
+#define MPF_FILE_IO_INTERVAL 20000
+
+/*
+ * Each file has a single-producer single-consumer ring. For the files being
+ * written the audio stream is the producer and the background thread is
+ * the consumer, for the files being read it is the other way round.
+ * The background thread transfers whole batches (a quarter of the ring) at
+ * batch aligned offsets, so disk access is done in large aligned blocks;
+ * only the tail of a file is written partially on close.
+ *
+ * A file is referenced by its owner and by the background thread. The owner
+ * drops its reference on close, the background thread once the file is closed
+ * or the file I/O is stopped, whichever drops the last one frees the file.
+ */
+
+/** Asynchronous file */
+struct mpf_async_file_t {
+	/** Back pointer to file I/O */
+	mpf_file_io_t        *file_io;
+	/** File handle (accessed by the background thread only once opened) */
+	FILE                 *handle;
+	/** File mode */
+	mpf_async_file_mode_e mode;
+
+	/** Ring buffer */
+	apr_byte_t           *data;
+	apr_uint32_t          mask;
+	/** Consumer position */
+	volatile apr_uint32_t head;
+	/** Producer position */
+	volatile apr_uint32_t tail;
+
+	/** Number of references (owner and background thread) */
+	volatile apr_uint32_t refs;
+	/** Set by the owner once the file is closed */
+	volatile apr_uint32_t closing;
+	/** Set by the background thread once the whole file is fetched */
+	volatile apr_uint32_t eof;
+	/** Number of writes dropped since the ring was full */
+	apr_uint32_t          overflow_count;
+
+	/** Next file in the list of the background thread */
+	mpf_async_file_t     *next;
+};
+
+/** File I/O */
+struct mpf_file_io_t {
+	apr_pool_t           *pool;
+	/** Size of the ring of each file */
+	apr_uint32_t          buffer_size;
+	/** Size of the block transferred at once */
+	apr_uint32_t          batch_size;
+
+	/** Newly opened files to be taken over by the background thread */
+	apt_lockfree_queue_t *open_queue;
+	/** Files serviced by the background thread */
+	mpf_async_file_t     *files;
+
+	apr_thread_t         *thread;
+	apr_thread_mutex_t   *guard;
+	apr_thread_cond_t    *wakeup;
+	volatile apr_uint32_t running;
+};
+
+/** Read with full memory barrier */
+static APR_INLINE apr_uint32_t mpf_file_io_seq_get(volatile apr_uint32_t *seq)
+{
+	return apr_atomic_cas32(seq,0,0);
+}
+
+MPF_DECLARE(mpf_file_io_t*) mpf_file_io_create(apr_size_t buffer_size, apr_pool_t *pool)
+{
+	apr_uint32_t size = 4096;
+	mpf_file_io_t *file_io = apr_palloc(pool,sizeof(mpf_file_io_t));
+	if(!buffer_size) {
+		buffer_size = MPF_FILE_IO_DEFAULT_BUFFER_SIZE;
+	}
+	while(size < buffer_size && size < 0x1000000) {
+		size <<= 1;
+	}
+
+	file_io->pool = pool;
+	file_io->buffer_size = size;
+	file_io->batch_size = size / 4;
+	file_io->open_queue = apt_lockfree_queue_create(LOCKFREE_QUEUE_DEFAULT_SIZE,pool);
+	file_io->files = NULL;
+	file_io->thread = NULL;
+	file_io->guard = NULL;
+	file_io->wakeup = NULL;
+	apr_atomic_set32(&file_io->running,0);
+
+	if(apr_thread_mutex_create(&file_io->guard,APR_THREAD_MUTEX_UNNESTED,pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create File I/O Mutex");
+		return NULL;
+	}
+	if(apr_thread_cond_create(&file_io->wakeup,pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create File I/O Condition");
+		apr_thread_mutex_destroy(file_io->guard);
+		return NULL;
+	}
+	return file_io;
+}
+
+/** Write whole batches (or everything pending on close) to disk */
+static void mpf_async_file_flush(mpf_async_file_t *file, apr_uint32_t batch_size, apt_bool_t all)
+{
+	apr_uint32_t head = apr_atomic_read32(&file->head);
+	apr_uint32_t used = mpf_file_io_seq_get(&file->tail) - head;
+	apr_uint32_t offset;
+	apr_uint32_t size;
+	if(all == FALSE) {
+		used -= used % batch_size;
+	}
+
+	while(used) {
+		offset = head & file->mask;
+		size = file->mask + 1 - offset;
+		if(size > used) {
+			size = used;
+		}
+		if(fwrite(file->data + offset,1,size,file->handle) != size) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Write File [%u bytes]",size);
+		}
+		head += size;
+		used -= size;
+		/* release the space to the producer */
+		apr_atomic_xchg32(&file->head,head);
+	}
+}
+
+/** Read whole batches from disk as long as there is room */
+static void mpf_async_file_fetch(mpf_async_file_t *file, apr_uint32_t batch_size)
+{
+	apr_uint32_t tail = apr_atomic_read32(&file->tail);
+	apr_size_t size;
+	if(apr_atomic_read32(&file->eof)) {
+		return;
+	}
+
+	while(file->mask + 1 - (tail - mpf_file_io_seq_get(&file->head)) >= batch_size) {
+		size = fread(file->data + (tail & file->mask),1,batch_size,file->handle);
+		tail += (apr_uint32_t)size;
+		/* publish the data to the consumer */
+		apr_atomic_xchg32(&file->tail,tail);
+		if(size < batch_size) {
+			apr_atomic_xchg32(&file->eof,1);
+			break;
+		}
+	}
+}
+
+static void mpf_async_file_destroy(mpf_async_file_t *file)
+{
+	if(file->overflow_count) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"File I/O Overflows [%u]",file->overflow_count);
+	}
+	if(file->handle) {
+		fclose(file->handle);
+		file->handle = NULL;
+	}
+	free(file->data);
+	free(file);
+}
+
+/** Drop a reference to the file, destroy it if the last one is dropped */
+static void mpf_async_file_release(mpf_async_file_t *file)
+{
+	if(apr_atomic_dec32(&file->refs) == 0) {
+		mpf_async_file_destroy(file);
+	}
+}
+
+/** Detach the file from the background thread */
+static void mpf_async_file_detach(mpf_async_file_t *file)
+{
+	if(file->handle) {
+		fclose(file->handle);
+		file->handle = NULL;
+	}
+	/* nothing is to be fetched anymore, let the stream run out */
+	apr_atomic_xchg32(&file->eof,1);
+	mpf_async_file_release(file);
+}
+
+/** Service the files, detach them all if the file I/O is being stopped */
+static void mpf_file_io_process(mpf_file_io_t *file_io, apt_bool_t stop)
+{
+	mpf_async_file_t *file;
+	mpf_async_file_t **it;
+	apt_bool_t closing;
+
+	/* take over the newly opened files */
+	while((file = apt_lockfree_queue_pop(file_io->open_queue)) != NULL) {
+		file->next = file_io->files;
+		file_io->files = file;
+	}
+
+	it = &file_io->files;
+	while(*it) {
+		file = *it;
+		/* check the flag first, so the data written before close is seen */
+		closing = (stop == TRUE || mpf_file_io_seq_get(&file->closing)) ? TRUE : FALSE;
+		if(file->mode == MPF_ASYNC_FILE_WRITE) {
+			mpf_async_file_flush(file,file_io->batch_size,closing);
+		}
+		else if(closing == FALSE) {
+			mpf_async_file_fetch(file,file_io->batch_size);
+		}
+
+		if(closing == TRUE) {
+			*it = file->next;
+			mpf_async_file_detach(file);
+			continue;
+		}
+		it = &file->next;
+	}
+}
+
+static void* APR_THREAD_FUNC mpf_file_io_run(apr_thread_t *thread, void *data)
+{
+	mpf_file_io_t *file_io = data;
+
+	apr_thread_mutex_lock(file_io->guard);
+	while(apr_atomic_read32(&file_io->running)) {
+		apr_thread_mutex_unlock(file_io->guard);
+		mpf_file_io_process(file_io,FALSE);
+		apr_thread_mutex_lock(file_io->guard);
+		if(apr_atomic_read32(&file_io->running)) {
+			apr_thread_cond_timedwait(file_io->wakeup,file_io->guard,MPF_FILE_IO_INTERVAL);
+		}
+	}
+	apr_thread_mutex_unlock(file_io->guard);
+
+	mpf_file_io_process(file_io,TRUE);
+	return NULL;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_file_io_start(mpf_file_io_t *file_io)
+{
+	if(file_io->thread) {
+		return FALSE;
+	}
+
+	apr_atomic_set32(&file_io->running,1);
+	if(apr_thread_create(&file_io->thread,NULL,mpf_file_io_run,file_io,file_io->pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Start File I/O Thread");
+		apr_atomic_set32(&file_io->running,0);
+		file_io->thread = NULL;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_file_io_stop(mpf_file_io_t *file_io)
+{
+	apr_status_t rv;
+	if(!file_io->thread) {
+		return FALSE;
+	}
+
+	apr_thread_mutex_lock(file_io->guard);
+	apr_atomic_set32(&file_io->running,0);
+	apr_thread_cond_signal(file_io->wakeup);
+	apr_thread_mutex_unlock(file_io->guard);
+
+	apr_thread_join(&rv,file_io->thread);
+	file_io->thread = NULL;
+	return TRUE;
+}
+
+MPF_DECLARE(mpf_async_file_t*) mpf_async_file_open(mpf_file_io_t *file_io, const char *file_path, mpf_async_file_mode_e mode)
+{
+	mpf_async_file_t *file;
+	FILE *handle = fopen(file_path,mode == MPF_ASYNC_FILE_WRITE ? "wb" : "rb");
+	if(!handle) {
+		return NULL;
+	}
+
+	file = malloc(sizeof(mpf_async_file_t));
+	if(file) {
+		file->data = malloc(file_io->buffer_size);
+	}
+	if(!file || !file->data) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Allocate File I/O Buffer [%s]",file_path);
+		free(file);
+		fclose(handle);
+		return NULL;
+	}
+
+	file->file_io = file_io;
+	file->handle = handle;
+	file->mode = mode;
+	file->mask = file_io->buffer_size - 1;
+	file->head = 0;
+	file->tail = 0;
+	file->refs = 2;
+	file->closing = 0;
+	file->eof = 0;
+	file->overflow_count = 0;
+	file->next = NULL;
+
+	if(mode == MPF_ASYNC_FILE_READ) {
+		/* prefill the buffer, so the stream doesn't have to wait for the background thread */
+		mpf_async_file_fetch(file,file_io->batch_size);
+	}
+
+	/* the file is handed over to the background thread from now on,
+	the guard makes sure the thread doesn't exit before it takes the file over */
+	apr_thread_mutex_lock(file_io->guard);
+	if(!apr_atomic_read32(&file_io->running)) {
+		apr_thread_mutex_unlock(file_io->guard);
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Hand Over File [%s]: file I/O not running",file_path);
+		mpf_async_file_destroy(file);
+		return NULL;
+	}
+	if(apt_lockfree_queue_push(file_io->open_queue,file) == FALSE) {
+		apr_thread_mutex_unlock(file_io->guard);
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Hand Over File [%s]",file_path);
+		mpf_async_file_destroy(file);
+		return NULL;
+	}
+	apr_thread_mutex_unlock(file_io->guard);
+	return file;
+}
+
+MPF_DECLARE(void) mpf_async_file_close(mpf_async_file_t *file)
+{
+	apr_atomic_xchg32(&file->closing,1);
+	mpf_async_file_release(file);
+}
+
+MPF_DECLARE(apt_bool_t) mpf_async_file_write(mpf_async_file_t *file, const void *data, apr_size_t size)
+{
+	apr_uint32_t tail = apr_atomic_read32(&file->tail);
+	apr_uint32_t offset = tail & file->mask;
+	apr_uint32_t first;
+	if(file->mask + 1 - (tail - mpf_file_io_seq_get(&file->head)) < size) {
+		file->overflow_count++;
+		return FALSE;
+	}
+
+	first = file->mask + 1 - offset;
+	if(first >= size) {
+		memcpy(file->data + offset,data,size);
+	}
+	else {
+		memcpy(file->data + offset,data,first);
+		memcpy(file->data,(const apr_byte_t*)data + first,size - first);
+	}
+	/* publish the data to the background thread */
+	apr_atomic_xchg32(&file->tail,tail + (apr_uint32_t)size);
+	return TRUE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_async_file_read(mpf_async_file_t *file, void *data, apr_size_t size)
+{
+	apr_uint32_t head = apr_atomic_read32(&file->head);
+	apr_uint32_t offset = head & file->mask;
+	apr_uint32_t first;
+	/* check the flag first, the data fetched before it is set is seen then */
+	apr_uint32_t eof = mpf_file_io_seq_get(&file->eof);
+	apr_uint32_t tail = mpf_file_io_seq_get(&file->tail);
+	if(tail - head < size) {
+		if(eof) {
+			/* drop the incomplete remainder, nothing is to follow */
+			apr_atomic_xchg32(&file->head,tail);
+		}
+		return FALSE;
+	}
+
+	first = file->mask + 1 - offset;
+	if(first >= size) {
+		memcpy(data,file->data + offset,size);
+	}
+	else {
+		memcpy(data,file->data + offset,first);
+		memcpy((apr_byte_t*)data + first,file->data,size - first);
+	}
+	/* release the space to the background thread */
+	apr_atomic_xchg32(&file->head,head + (apr_uint32_t)size);
+	return TRUE;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_async_file_eof(const mpf_async_file_t *file)
+{
+	mpf_async_file_t *f = (mpf_async_file_t*)file;
+	if(!apr_atomic_read32(&f->eof)) {
+		return FALSE;
+	}
+	return (apr_atomic_read32(&f->head) == apr_atomic_read32(&f->tail)) ? TRUE : FALSE;
+}
+
+MPF_DECLARE(apr_uint32_t) mpf_async_file_overflow_count_get(const mpf_async_file_t *file)
+{
+	return file->overflow_count;
+}
@@ -16,96 +16,209 @@
  * $Id$
  */
 
+#include <apr_atomic.h>
 #include "mpf_frame_buffer.h"
 
+/*
+ * Single-producer/single-consumer ring of frames.
+ * The positions are free running counters, the writer is the only one to advance
+ * write_pos and restart_pos, the reader is the only one to advance read_pos.
+ * Data of a frame is completed before write_pos is published and
+ * consumed before read_pos is published, so no lock is needed.
+ */
 struct mpf_frame_buffer_t {
-	apr_byte_t         *raw_data;
-	mpf_frame_t        *frames;
-	apr_size_t          frame_count;
-	apr_size_t          frame_size;
+	apr_byte_t           *raw_data;
+	mpf_frame_t          *frames;
+	/** Max number of buffered frames */
+	apr_uint32_t          frame_count;
+	/** Mask to get index of a frame by position (number of allocated frames - 1) */
+	apr_uint32_t          index_mask;
+	apr_size_t            frame_size;
+
+	/** Position to write the next frame at (writer) */
+	volatile apr_uint32_t write_pos;
+	/** Position to restart reading from (writer) */
+	volatile apr_uint32_t restart_pos;
+	/** Position to read the next frame from (reader) */
+	volatile apr_uint32_t read_pos;
+
+	/** Size of partial frame accumulated at write_pos (writer) */
+	apr_size_t            partial_size;
+
+	/** Underrun policy */
+	mpf_frame_buffer_underrun_policy_e underrun_policy;
+	/** Last read audio frame to hold on underrun (reader) */
+	apr_byte_t           *hold_data;
+	/** Whether hold_data contains a frame (reader) */
+	apt_bool_t            hold_available;
 
-	apr_size_t          write_pos;
-	apr_size_t          read_pos;
+	/** Statistics (each counter is updated by either writer or reader) */
+	volatile apr_uint32_t write_count;
+	volatile apr_uint32_t read_count;
+	volatile apr_uint32_t overflow_count;
+	volatile apr_uint32_t underrun_count;
 
-	apr_thread_mutex_t *guard;
-	apr_pool_t         *pool;
+	apr_pool_t           *pool;
 };
 
+/** Load position published by the other side (full barrier) */
+static APR_INLINE apr_uint32_t mpf_frame_buffer_pos_load(volatile apr_uint32_t *pos)
+{
+	return apr_atomic_add32(pos,0);
+}
+
+/** Publish position to the other side (full barrier) */
+static APR_INLINE void mpf_frame_buffer_pos_store(volatile apr_uint32_t *pos, apr_uint32_t value)
+{
+	apr_atomic_xchg32(pos,value);
+}
 
 mpf_frame_buffer_t* mpf_frame_buffer_create(apr_size_t frame_size, apr_size_t frame_count, apr_pool_t *pool)
 {
 	apr_size_t i;
+	apr_uint32_t allocated_count = 1;
 	mpf_frame_t *frame;
 	mpf_frame_buffer_t *buffer = apr_palloc(pool,sizeof(mpf_frame_buffer_t));
 
+	if(!frame_count) {
+		frame_count = 1;
+	}
+	/* number of allocated frames is a power of 2 to keep indexes consistent on wrap around of positions */
+	while(allocated_count < frame_count) {
+		allocated_count <<= 1;
+	}
+
 	buffer->frame_size = frame_size;
-	buffer->frame_count = frame_count;
-	buffer->raw_data = apr_palloc(pool,buffer->frame_size*buffer->frame_count);
-	buffer->frames = apr_palloc(pool,sizeof(mpf_frame_t)*buffer->frame_count);
-	for(i=0; i<buffer->frame_count; i++) {
+	buffer->frame_count = (apr_uint32_t)frame_count;
+	buffer->index_mask = allocated_count - 1;
+	buffer->raw_data = apr_palloc(pool,buffer->frame_size*allocated_count);
+	buffer->frames = apr_palloc(pool,sizeof(mpf_frame_t)*allocated_count);
+	for(i=0; i<allocated_count; i++) {
 		frame = &buffer->frames[i];
 		frame->type = MEDIA_FRAME_TYPE_NONE;
 		frame->marker = MPF_MARKER_NONE;
 		frame->codec_frame.buffer = buffer->raw_data + i*buffer->frame_size;
+		frame->codec_frame.size = 0;
 	}
 
-	buffer->write_pos = buffer->read_pos = 0;
-	apr_thread_mutex_create(&buffer->guard,APR_THREAD_MUTEX_UNNESTED,pool);
+	buffer->partial_size = 0;
+	buffer->underrun_policy = MPF_FRAME_BUFFER_UNDERRUN_NONE;
+	buffer->hold_data = apr_pcalloc(pool,buffer->frame_size);
+	buffer->hold_available = FALSE;
+	apr_atomic_set32(&buffer->write_pos,0);
+	apr_atomic_set32(&buffer->restart_pos,0);
+	apr_atomic_set32(&buffer->read_pos,0);
+	apr_atomic_set32(&buffer->write_count,0);
+	apr_atomic_set32(&buffer->read_count,0);
+	apr_atomic_set32(&buffer->overflow_count,0);
+	apr_atomic_set32(&buffer->underrun_count,0);
+	buffer->pool = pool;
 	return buffer;
 }
 
 void mpf_frame_buffer_destroy(mpf_frame_buffer_t *buffer)
 {
-	if(buffer->guard) {
-		apr_thread_mutex_destroy(buffer->guard);
-		buffer->guard = NULL;
-	}
+	/* memory is allocated from the pool, there is nothing to release */
 }
 
 apt_bool_t mpf_frame_buffer_restart(mpf_frame_buffer_t *buffer)
 {
-	buffer->write_pos = buffer->read_pos;
+	/* the reader skips frames up to the restart position on its next read */
+	buffer->partial_size = 0;
+	mpf_frame_buffer_pos_store(&buffer->restart_pos,buffer->write_pos);
 	return TRUE;
 }
 
-static APR_INLINE mpf_frame_t* mpf_frame_buffer_frame_get(mpf_frame_buffer_t *buffer, apr_size_t pos)
+static APR_INLINE mpf_frame_t* mpf_frame_buffer_frame_get(mpf_frame_buffer_t *buffer, apr_uint32_t pos)
 {
-	apr_size_t index = pos % buffer->frame_count;
-	return &buffer->frames[index];
+	return &buffer->frames[pos & buffer->index_mask];
 }
 
 apt_bool_t mpf_frame_buffer_write(mpf_frame_buffer_t *buffer, const mpf_frame_t *frame)
 {
 	mpf_frame_t *write_frame;
-	void *data = frame->codec_frame.buffer;
+	apr_size_t chunk_size;
+	const apr_byte_t *data = frame->codec_frame.buffer;
 	apr_size_t size = frame->codec_frame.size;
+	apr_uint32_t write_pos = buffer->write_pos;
+	apr_uint32_t read_pos = mpf_frame_buffer_pos_load(&buffer->read_pos);
+
+	while(size) {
+		if(write_pos - read_pos >= buffer->frame_count) {
+			/* the reader might have advanced since loaded */
+			read_pos = mpf_frame_buffer_pos_load(&buffer->read_pos);
+			if(write_pos - read_pos >= buffer->frame_count) {
+				break;
+			}
+		}
 
-	apr_thread_mutex_lock(buffer->guard);
-	while(buffer->write_pos - buffer->read_pos < buffer->frame_count && size >= buffer->frame_size) {
-		write_frame = mpf_frame_buffer_frame_get(buffer,buffer->write_pos);
-		write_frame->type = frame->type;
-		write_frame->codec_frame.size = buffer->frame_size;
+		write_frame = mpf_frame_buffer_frame_get(buffer,write_pos);
+		chunk_size = buffer->frame_size - buffer->partial_size;
+		if(chunk_size > size) {
+			chunk_size = size;
+		}
 		memcpy(
-			write_frame->codec_frame.buffer,
+			(apr_byte_t*)write_frame->codec_frame.buffer + buffer->partial_size,
 			data,
-			write_frame->codec_frame.size);
+			chunk_size);
+		data += chunk_size;
+		size -= chunk_size;
+		buffer->partial_size += chunk_size;
+
+		if(buffer->partial_size == buffer->frame_size) {
+			/* complete frame, publish it */
+			write_frame->type = frame->type;
+			write_frame->marker = MPF_MARKER_NONE;
+			write_frame->codec_frame.size = buffer->frame_size;
+			buffer->partial_size = 0;
+			write_pos++;
+			mpf_frame_buffer_pos_store(&buffer->write_pos,write_pos);
+			apr_atomic_inc32(&buffer->write_count);
+		}
+	}
 
-		data = (char*)data + buffer->frame_size;
-		size -= buffer->frame_size;
-		buffer->write_pos ++;
+	if(size) {
+		/* buffer is full, drop the rest */
+		apr_atomic_add32(&buffer->overflow_count,(apr_uint32_t)((size + buffer->frame_size - 1) / buffer->frame_size));
+		return FALSE;
 	}
+	return TRUE;
+}
 
-	apr_thread_mutex_unlock(buffer->guard);
-	/* if size != 0 => non frame alligned or buffer is full */
-	return size == 0 ? TRUE : FALSE;
+/** Read frame on underrun */
+static void mpf_frame_buffer_underrun_read(mpf_frame_buffer_t *buffer, mpf_frame_t *media_frame)
+{
+	media_frame->marker = MPF_MARKER_NONE;
+	if(buffer->underrun_policy == MPF_FRAME_BUFFER_UNDERRUN_SILENCE) {
+		media_frame->type = MEDIA_FRAME_TYPE_AUDIO;
+		media_frame->codec_frame.size = buffer->frame_size;
+		memset(media_frame->codec_frame.buffer,0,media_frame->codec_frame.size);
+	}
+	else if(buffer->underrun_policy == MPF_FRAME_BUFFER_UNDERRUN_HOLD && buffer->hold_available == TRUE) {
+		media_frame->type = MEDIA_FRAME_TYPE_AUDIO;
+		media_frame->codec_frame.size = buffer->frame_size;
+		memcpy(media_frame->codec_frame.buffer,buffer->hold_data,media_frame->codec_frame.size);
+	}
+	else {
+		media_frame->type = MEDIA_FRAME_TYPE_NONE;
+	}
 }
 
 apt_bool_t mpf_frame_buffer_read(mpf_frame_buffer_t *buffer, mpf_frame_t *media_frame)
 {
-	apr_thread_mutex_lock(buffer->guard);
-	if(buffer->write_pos > buffer->read_pos) {
+	apr_uint32_t read_pos = buffer->read_pos;
+	apr_uint32_t write_pos = mpf_frame_buffer_pos_load(&buffer->write_pos);
+	apr_uint32_t restart_pos = mpf_frame_buffer_pos_load(&buffer->restart_pos);
+
+	if((apr_int32_t)(restart_pos - read_pos) > 0) {
+		/* skip frames written before restart */
+		read_pos = restart_pos;
+		buffer->hold_available = FALSE;
+	}
+
+	if(write_pos != read_pos) {
 		/* normal read */
-		mpf_frame_t *src_media_frame = mpf_frame_buffer_frame_get(buffer,buffer->read_pos);
+		mpf_frame_t *src_media_frame = mpf_frame_buffer_frame_get(buffer,read_pos);
 		media_frame->type = src_media_frame->type;
 		media_frame->marker = src_media_frame->marker;
 		if(media_frame->type & MEDIA_FRAME_TYPE_AUDIO) {
@@ -114,19 +227,35 @@ apt_bool_t mpf_frame_buffer_read(mpf_frame_buffer_t *buffer, mpf_frame_t *media_
 				media_frame->codec_frame.buffer,
 				src_media_frame->codec_frame.buffer,
 				media_frame->codec_frame.size);
+			if(buffer->underrun_policy == MPF_FRAME_BUFFER_UNDERRUN_HOLD) {
+				memcpy(buffer->hold_data,src_media_frame->codec_frame.buffer,buffer->frame_size);
+				buffer->hold_available = TRUE;
+			}
 		}
-		if(media_frame->type & MEDIA_FRAME_TYPE_EVENT) {
-			media_frame->event_frame = src_media_frame->event_frame;
-		}
-		src_media_frame->type = MEDIA_FRAME_TYPE_NONE;
-		src_media_frame->marker = MPF_MARKER_NONE;
-		buffer->read_pos ++;
+		read_pos++;
+		mpf_frame_buffer_pos_store(&buffer->read_pos,read_pos);
+		apr_atomic_inc32(&buffer->read_count);
 	}
 	else {
 		/* underflow */
-		media_frame->type = MEDIA_FRAME_TYPE_NONE;
-		media_frame->marker = MPF_MARKER_NONE;
+		if(read_pos != buffer->read_pos) {
+			mpf_frame_buffer_pos_store(&buffer->read_pos,read_pos);
+		}
+		mpf_frame_buffer_underrun_read(buffer,media_frame);
+		apr_atomic_inc32(&buffer->underrun_count);
 	}
-	apr_thread_mutex_unlock(buffer->guard);
 	return TRUE;
 }
+
+void mpf_frame_buffer_underrun_policy_set(mpf_frame_buffer_t *buffer, mpf_frame_buffer_underrun_policy_e policy)
+{
+	buffer->underrun_policy = policy;
+}
+
+void mpf_frame_buffer_stat_get(const mpf_frame_buffer_t *buffer, mpf_frame_buffer_stat_t *stat)
+{
+	stat->write_count = buffer->write_count;
+	stat->read_count = buffer->read_count;
+	stat->overflow_count = buffer->overflow_count;
+	stat->underrun_count = buffer->underrun_count;
+}
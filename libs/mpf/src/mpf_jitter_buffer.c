@@ -16,7 +16,11 @@
  * $Id$
  */
 
+#include <math.h>
+#define APR_WANT_BYTEFUNC
+#include <apr_want.h>
 #include "mpf_jitter_buffer.h"
+#include "mpf_codec_g711.h"
 #include "mpf_trace.h"
 
 #if ENABLE_JB_TRACE == 1
@@ -27,6 +31,33 @@
 #define JB_TRACE mpf_null_trace
 #endif
 
+/* forget factor of the histogram of transit delays in Q15 (~0.9993) */
+#define JB_HISTOGRAM_FORGET_FACTOR 32745
+/* number of frames kept in history of played out samples */
+#define JB_HISTORY_FRAMES          4
+/* number of packets in a window the min transit delay is searched in */
+#define JB_TRANSIT_WINDOW          250
+/* min transit delay before any packet is received */
+#define JB_TRANSIT_UNKNOWN         0x7FFFFFFF
+/* max number of consecutive frames to conceal (60 msec), the rest is played out as silence */
+#define JB_PLC_MAX_FRAMES          6
+/* attenuation of concealed signal per frame in Q15 (20%) */
+#define JB_PLC_ATTENUATION         6554
+/* min normalized correlation to merge two frames of non-silent audio */
+#define JB_MERGE_MIN_CORRELATION   0.5
+/* mean absolute amplitude, below which two frames are merged regardless of correlation */
+#define JB_MERGE_SILENCE_LEVEL     64
+/* max number of reads to look for similar frames to merge, then the best ones found are merged anyway */
+#define JB_MERGE_MAX_ATTEMPTS      20
+
+/** Format of frames, which can be converted to linear samples for concealment and time-stretching */
+typedef enum {
+	JB_LINEAR_NONE,
+	JB_LINEAR_L16,
+	JB_LINEAR_PCMU,
+	JB_LINEAR_PCMA
+} jb_linear_format_e;
+
 struct mpf_jitter_buffer_t {
 	/* jitter buffer config */
 	mpf_jb_config_t *config;
@@ -72,8 +103,477 @@ struct mpf_jitter_buffer_t {
 	mpf_named_event_frame_t        event_write_base;
 	/* the last received update for the event */
 	const mpf_named_event_frame_t *event_write_update;
+
+	/* histogram of transit delays (Q30 probabilities per frame) */
+	apr_uint32_t    *histogram;
+	/* number of packets the histogram has been built of */
+	apr_uint32_t     histogram_count;
+	/* min transit delays over the current and the previous windows of packets */
+	apr_int32_t      transit_min[2];
+	/* number of packets in the current window */
+	apr_uint32_t     transit_count;
+	/* playout delay estimated by the histogram in timestamp units */
+	apr_uint32_t     target_delay_ts;
+	/* min playout delay in timestamp units */
+	apr_uint32_t     min_playout_delay_ts;
+
+	/* format to convert frames to linear samples in */
+	jb_linear_format_e linear_format;
+	/* number of linear samples in a frame */
+	apr_size_t       frame_samples;
+	/* history of played out linear samples (the most recent last) */
+	apr_int16_t     *history;
+	/* number of samples in history */
+	apr_size_t       history_samples;
+	/* audio has been played out since the buffer synchronized (missing frames are lost ones) */
+	apr_byte_t       playing;
+	/* history is continuous up to the current read pos (concealment is possible) */
+	apr_byte_t       history_valid;
+	/* linear samples of two frames to process */
+	apr_int16_t     *work;
+	/* min and max pitch periods in samples */
+	apr_size_t       pitch_min;
+	apr_size_t       pitch_max;
+	/* pitch period repeated by concealment */
+	apr_int16_t     *plc_buffer;
+	/* length of the pitch period in samples */
+	apr_size_t       plc_pitch;
+	/* current offset in the pitch period */
+	apr_size_t       plc_offset;
+	/* number of consecutive frames concealed */
+	apr_uint32_t     plc_frames;
+	/* number of reads frames are not similar enough to merge */
+	apr_uint32_t     merge_attempts;
+
+	/* statistics */
+	rtp_jb_stat_t    stat;
 };
 
+static APR_INLINE mpf_frame_t* mpf_jitter_buffer_frame_get(mpf_jitter_buffer_t *jb, apr_size_t ts)
+{
+	apr_size_t index = (ts / jb->frame_ts) % jb->frame_count;
+	return &jb->frames[index];
+}
+
+static const apt_str_t l16_name = {"L16", 3};
+static const apt_str_t pcmu_name = {"PCMU", 4};
+static const apt_str_t pcma_name = {"PCMA", 4};
+
+static jb_linear_format_e mpf_jitter_buffer_linear_format_get(const mpf_codec_descriptor_t *descriptor)
+{
+	if(descriptor->channel_count != 1) {
+		return JB_LINEAR_NONE;
+	}
+	if(apt_string_compare(&descriptor->name,&l16_name) == TRUE) {
+		return JB_LINEAR_L16;
+	}
+	if(apt_string_compare(&descriptor->name,&pcmu_name) == TRUE) {
+		return JB_LINEAR_PCMU;
+	}
+	if(apt_string_compare(&descriptor->name,&pcma_name) == TRUE) {
+		return JB_LINEAR_PCMA;
+	}
+	return JB_LINEAR_NONE;
+}
+
+static void mpf_jitter_buffer_linear_create(mpf_jitter_buffer_t *jb, const mpf_codec_descriptor_t *descriptor, apr_pool_t *pool)
+{
+	jb->linear_format = JB_LINEAR_NONE;
+	jb->frame_samples = 0;
+	jb->history = NULL;
+	jb->history_samples = 0;
+	jb->playing = FALSE;
+	jb->history_valid = FALSE;
+	jb->work = NULL;
+	jb->pitch_min = jb->pitch_max = 0;
+	jb->plc_buffer = NULL;
+	jb->plc_pitch = jb->plc_offset = 0;
+	jb->plc_frames = 0;
+	jb->merge_attempts = 0;
+
+	if(!jb->config->plc && !jb->config->adaptive) {
+		/* neither concealment nor time-stretching is required */
+		return;
+	}
+
+	jb->linear_format = mpf_jitter_buffer_linear_format_get(descriptor);
+	if(jb->linear_format == JB_LINEAR_NONE) {
+		return;
+	}
+
+	jb->frame_samples = (jb->linear_format == JB_LINEAR_L16) ? jb->frame_size / sizeof(apr_int16_t) : jb->frame_size;
+	jb->history_samples = JB_HISTORY_FRAMES * jb->frame_samples;
+	jb->history = apr_pcalloc(pool,sizeof(apr_int16_t) * jb->history_samples);
+	jb->work = apr_palloc(pool,sizeof(apr_int16_t) * 2 * jb->frame_samples);
+	/* pitch of speech ranges from 66 Hz up to 400 Hz */
+	jb->pitch_min = descriptor->sampling_rate / 400;
+	jb->pitch_max = descriptor->sampling_rate / 66;
+	jb->plc_buffer = apr_palloc(pool,sizeof(apr_int16_t) * jb->pitch_max);
+}
+
+static void mpf_jitter_buffer_linear_decode(const mpf_jitter_buffer_t *jb, const mpf_codec_frame_t *frame, apr_int16_t *linear)
+{
+	apr_size_t i;
+	const apr_int16_t *l16;
+	switch(jb->linear_format) {
+		case JB_LINEAR_L16:
+			l16 = frame->buffer;
+			for(i=0; i<jb->frame_samples; i++) {
+				linear[i] = (apr_int16_t)ntohs(l16[i]);
+			}
+			break;
+		case JB_LINEAR_PCMU:
+			mpf_g711u_decode(frame->buffer,linear,jb->frame_samples);
+			break;
+		case JB_LINEAR_PCMA:
+			mpf_g711a_decode(frame->buffer,linear,jb->frame_samples);
+			break;
+		default:
+			break;
+	}
+}
+
+static void mpf_jitter_buffer_linear_encode(const mpf_jitter_buffer_t *jb, const apr_int16_t *linear, mpf_frame_t *media_frame)
+{
+	apr_size_t i;
+	apr_int16_t *l16;
+	switch(jb->linear_format) {
+		case JB_LINEAR_L16:
+			l16 = media_frame->codec_frame.buffer;
+			for(i=0; i<jb->frame_samples; i++) {
+				l16[i] = (apr_int16_t)htons(linear[i]);
+			}
+			break;
+		case JB_LINEAR_PCMU:
+			mpf_g711u_encode(linear,media_frame->codec_frame.buffer,jb->frame_samples);
+			break;
+		case JB_LINEAR_PCMA:
+			mpf_g711a_encode(linear,media_frame->codec_frame.buffer,jb->frame_samples);
+			break;
+		default:
+			break;
+	}
+	media_frame->codec_frame.size = jb->frame_size;
+	media_frame->type = MEDIA_FRAME_TYPE_AUDIO;
+	media_frame->marker = MPF_MARKER_NONE;
+}
+
+static APR_INLINE void mpf_jitter_buffer_history_push(mpf_jitter_buffer_t *jb, const apr_int16_t *linear)
+{
+	apr_size_t keep = jb->history_samples - jb->frame_samples;
+	memmove(jb->history,jb->history + jb->frame_samples,sizeof(apr_int16_t) * keep);
+	memcpy(jb->history + keep,linear,sizeof(apr_int16_t) * jb->frame_samples);
+	jb->history_valid = TRUE;
+}
+
+/* Find the pitch period maximizing the correlation of the most recent samples with the lagged ones */
+static apr_size_t mpf_jitter_buffer_pitch_detect(const mpf_jitter_buffer_t *jb)
+{
+	const apr_int16_t *x = jb->history + jb->history_samples - jb->frame_samples / 2;
+	apr_size_t window = jb->frame_samples / 2;
+	apr_size_t pitch = jb->pitch_max;
+	apr_size_t lag;
+	apr_size_t i;
+	double corr, energy, score;
+	double max_score = 0;
+
+	for(lag = jb->pitch_min; lag <= jb->pitch_max; lag++) {
+		corr = energy = 0;
+		for(i=0; i<window; i++) {
+			corr += (double)x[i] * x[(apr_ssize_t)i - (apr_ssize_t)lag];
+			energy += (double)x[(apr_ssize_t)i - (apr_ssize_t)lag] * x[(apr_ssize_t)i - (apr_ssize_t)lag];
+		}
+		if(corr <= 0 || energy <= 0) {
+			continue;
+		}
+		score = corr * corr / energy;
+		if(score > max_score) {
+			max_score = score;
+			pitch = lag;
+		}
+	}
+	return pitch;
+}
+
+/* Gain of the n-th sample of the current concealed frame in Q15 */
+static APR_INLINE apr_int32_t mpf_jitter_buffer_plc_gain(const mpf_jitter_buffer_t *jb, apr_uint32_t frames, apr_size_t n)
+{
+	/* the first frame is repeated as is, then the signal fades out by 20% per frame */
+	apr_int32_t gain;
+	if(!frames) {
+		return 32768;
+	}
+	gain = 32768 - JB_PLC_ATTENUATION * (apr_int32_t)(frames - 1) - (apr_int32_t)(JB_PLC_ATTENUATION * n / jb->frame_samples);
+	return gain > 0 ? gain : 0;
+}
+
+/* Synthesize the next frame by repeating the last pitch period of history */
+static void mpf_jitter_buffer_plc_generate(mpf_jitter_buffer_t *jb, apr_int16_t *linear)
+{
+	apr_size_t i;
+	if(!jb->plc_frames) {
+		/* the first concealed frame: extract the pitch period and smooth its edges */
+		const apr_int16_t *x = jb->history + jb->history_samples;
+		apr_size_t pitch = mpf_jitter_buffer_pitch_detect(jb);
+		apr_size_t overlap = pitch / 4;
+		apr_int32_t w;
+		for(i=0; i<pitch; i++) {
+			jb->plc_buffer[i] = x[(apr_ssize_t)i - (apr_ssize_t)pitch];
+		}
+		/* the end of the period is blended with the samples preceding its beginning */
+		for(i=0; i<overlap; i++) {
+			w = (apr_int32_t)(32768 * (i + 1) / (overlap + 1));
+			jb->plc_buffer[pitch - overlap + i] = (apr_int16_t)(
+				(x[(apr_ssize_t)i - (apr_ssize_t)overlap] * (32768 - w) +
+				 x[(apr_ssize_t)i - (apr_ssize_t)overlap - (apr_ssize_t)pitch] * w) >> 15);
+		}
+		jb->plc_pitch = pitch;
+		jb->plc_offset = 0;
+	}
+
+	for(i=0; i<jb->frame_samples; i++) {
+		linear[i] = (apr_int16_t)((jb->plc_buffer[jb->plc_offset] * mpf_jitter_buffer_plc_gain(jb,jb->plc_frames,i)) >> 15);
+		if(++jb->plc_offset == jb->plc_pitch) {
+			jb->plc_offset = 0;
+		}
+	}
+	jb->plc_frames++;
+	mpf_jitter_buffer_history_push(jb,linear);
+}
+
+/* Conceal missing frame, if possible */
+static apt_bool_t mpf_jitter_buffer_conceal(mpf_jitter_buffer_t *jb, mpf_frame_t *media_frame)
+{
+	if(!jb->config->plc || jb->linear_format == JB_LINEAR_NONE || !jb->playing ||
+		jb->history_valid == FALSE || jb->plc_frames >= JB_PLC_MAX_FRAMES) {
+		return FALSE;
+	}
+
+	mpf_jitter_buffer_plc_generate(jb,jb->work);
+	mpf_jitter_buffer_linear_encode(jb,jb->work,media_frame);
+	jb->stat.concealed_frames++;
+	JB_TRACE("JB conceal ts=%u pitch=%"APR_SIZE_T_FMT" frames=%u\n",jb->read_ts,jb->plc_pitch,jb->plc_frames);
+	return TRUE;
+}
+
+/* Update history by the frame read, cross-fading from concealed signal if any */
+static void mpf_jitter_buffer_history_update(mpf_jitter_buffer_t *jb, mpf_frame_t *media_frame)
+{
+	apr_int16_t *linear = jb->work;
+	mpf_jitter_buffer_linear_decode(jb,&media_frame->codec_frame,linear);
+	if(jb->plc_frames) {
+		/* continue concealed signal and fade it out into the received one */
+		apr_size_t overlap = jb->frame_samples / 4;
+		apr_size_t offset = jb->plc_offset;
+		apr_int32_t gain = mpf_jitter_buffer_plc_gain(jb,jb->plc_frames,0);
+		apr_int32_t w;
+		apr_size_t i;
+		for(i=0; i<overlap; i++) {
+			w = (apr_int32_t)(32768 * (i + 1) / (overlap + 1));
+			linear[i] = (apr_int16_t)(((((jb->plc_buffer[offset] * gain) >> 15) * (32768 - w)) + linear[i] * w) >> 15);
+			if(++offset == jb->plc_pitch) {
+				offset = 0;
+			}
+		}
+		jb->plc_frames = 0;
+		mpf_jitter_buffer_linear_encode(jb,linear,media_frame);
+	}
+	mpf_jitter_buffer_history_push(jb,linear);
+}
+
+/* Merge two frames (2N samples) into one (N samples) cross-fading the most similar segments one frame apart */
+static apt_bool_t mpf_jitter_buffer_merge(mpf_jitter_buffer_t *jb, apr_int16_t *x)
+{
+	apr_size_t n = jb->frame_samples;
+	apr_size_t overlap = n / 2;
+	apr_size_t pos = 0;
+	apr_size_t p,i;
+	apr_int32_t w;
+	double corr, energy1, energy2, score;
+	double max_score = -1;
+	apr_uint32_t level = 0;
+
+	for(i=0; i<2*n; i++) {
+		level += x[i] >= 0 ? x[i] : -x[i];
+	}
+	level /= (apr_uint32_t)(2*n);
+
+	for(p=0; p<=n-overlap; p++) {
+		corr = energy1 = energy2 = 0;
+		for(i=0; i<overlap; i++) {
+			corr += (double)x[p+i] * x[p+n+i];
+			energy1 += (double)x[p+i] * x[p+i];
+			energy2 += (double)x[p+n+i] * x[p+n+i];
+		}
+		score = (energy1 > 0 && energy2 > 0) ? corr / sqrt(energy1 * energy2) : 0;
+		if(score > max_score) {
+			max_score = score;
+			pos = p;
+		}
+	}
+
+	if(max_score < JB_MERGE_MIN_CORRELATION && level >= JB_MERGE_SILENCE_LEVEL &&
+		++jb->merge_attempts < JB_MERGE_MAX_ATTEMPTS) {
+		/* merge would be audible, try the next frames */
+		return FALSE;
+	}
+	jb->merge_attempts = 0;
+
+	for(i=0; i<overlap; i++) {
+		w = (apr_int32_t)(32768 * (i + 1) / (overlap + 1));
+		x[pos+i] = (apr_int16_t)((x[pos+i] * (32768 - w) + x[pos+n+i] * w) >> 15);
+	}
+	memmove(x + pos + overlap,x + pos + n + overlap,sizeof(apr_int16_t) * (n - pos - overlap));
+	return TRUE;
+}
+
+/* Shift the playout delay keeping the positions of frames already in the buffer */
+static APR_INLINE void mpf_jitter_buffer_playout_delay_shift(mpf_jitter_buffer_t *jb, apr_int32_t delta_ts)
+{
+	jb->playout_delay_ts += delta_ts;
+	jb->write_ts_offset += delta_ts;
+	if(jb->config->time_skew_detection) {
+		jb->min_length_ts += delta_ts;
+		jb->max_length_ts += delta_ts;
+	}
+}
+
+/* Converge the playout delay to the target one by time-stretching the audio */
+static apt_bool_t mpf_jitter_buffer_time_stretch(mpf_jitter_buffer_t *jb, mpf_frame_t *src_media_frame, mpf_frame_t *media_frame)
+{
+	mpf_frame_t *next_media_frame;
+
+	if(!jb->config->adaptive || jb->linear_format == JB_LINEAR_NONE || jb->plc_frames ||
+		src_media_frame->type != MEDIA_FRAME_TYPE_AUDIO || src_media_frame->marker != MPF_MARKER_NONE) {
+		return FALSE;
+	}
+
+	if(jb->playout_delay_ts > jb->target_delay_ts + jb->frame_ts) {
+		/* accelerate: play out two buffered frames at once */
+		if(jb->write_ts - jb->read_ts < 2 * jb->frame_ts) {
+			return FALSE;
+		}
+		next_media_frame = mpf_jitter_buffer_frame_get(jb,jb->read_ts + jb->frame_ts);
+		if(next_media_frame->type != MEDIA_FRAME_TYPE_AUDIO || next_media_frame->marker != MPF_MARKER_NONE) {
+			return FALSE;
+		}
+
+		mpf_jitter_buffer_linear_decode(jb,&src_media_frame->codec_frame,jb->work);
+		mpf_jitter_buffer_linear_decode(jb,&next_media_frame->codec_frame,jb->work + jb->frame_samples);
+		if(mpf_jitter_buffer_merge(jb,jb->work) == FALSE) {
+			return FALSE;
+		}
+
+		mpf_jitter_buffer_linear_encode(jb,jb->work,media_frame);
+		mpf_jitter_buffer_history_push(jb,jb->work);
+		src_media_frame->type = next_media_frame->type = MEDIA_FRAME_TYPE_NONE;
+		jb->read_ts += 2 * jb->frame_ts;
+		mpf_jitter_buffer_playout_delay_shift(jb,-(apr_int32_t)jb->frame_ts);
+		jb->stat.accelerated_frames++;
+		JB_TRACE("JB accelerate playout delay=%u target=%u\n",jb->playout_delay_ts,jb->target_delay_ts);
+		return TRUE;
+	}
+
+	if(jb->target_delay_ts > jb->playout_delay_ts + jb->frame_ts && jb->history_valid == TRUE &&
+		jb->playout_delay_ts + jb->frame_ts <= jb->max_playout_delay_ts) {
+		/* expand: synthesize a frame and keep the read pos */
+		mpf_jitter_buffer_plc_generate(jb,jb->work);
+		mpf_jitter_buffer_linear_encode(jb,jb->work,media_frame);
+		mpf_jitter_buffer_playout_delay_shift(jb,(apr_int32_t)jb->frame_ts);
+		jb->stat.expanded_frames++;
+		JB_TRACE("JB expand playout delay=%u target=%u\n",jb->playout_delay_ts,jb->target_delay_ts);
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/* Update the histogram of transit delays by the packet to be written and estimate the target playout delay */
+static void mpf_jitter_buffer_delay_estimate(mpf_jitter_buffer_t *jb, apr_uint32_t write_ts)
+{
+	/* transit delay of the packet relatively to the packet the buffer synchronized with
+	(the packet is in time as long as the playout delay is not less than that) */
+	apr_int32_t transit_ts = (apr_int32_t)(jb->read_ts - (write_ts - jb->playout_delay_ts));
+	apr_int32_t transit_min;
+	apr_int32_t target_ts;
+	apr_size_t bin = 0;
+	apr_uint32_t forget;
+	apr_uint32_t threshold;
+	apr_uint32_t sum = 0;
+	apr_size_t i;
+
+	if(transit_ts < 0) {
+		/* the packet is faster than the one the buffer synchronized with, so that the playout delay
+		is underestimated => rebase the delay keeping the positions of the frames */
+		apr_uint32_t shift_ts = (apr_uint32_t)(-transit_ts);
+		if(shift_ts % jb->frame_ts != 0) {
+			shift_ts += jb->frame_ts - shift_ts % jb->frame_ts;
+		}
+		jb->playout_delay_ts += shift_ts;
+		jb->write_ts_offset += shift_ts;
+		transit_ts += shift_ts;
+		if(jb->transit_min[0] != JB_TRANSIT_UNKNOWN) {
+			jb->transit_min[0] += shift_ts;
+		}
+		if(jb->transit_min[1] != JB_TRANSIT_UNKNOWN) {
+			jb->transit_min[1] += shift_ts;
+		}
+		JB_TRACE("JB rebase playout delay=%u\n",jb->playout_delay_ts);
+	}
+
+	/* the fastest packet is the reference, the min is kept over two consecutive windows of packets */
+	if(jb->transit_count == JB_TRANSIT_WINDOW) {
+		jb->transit_min[1] = jb->transit_min[0];
+		jb->transit_min[0] = transit_ts;
+		jb->transit_count = 0;
+	}
+	else if(transit_ts < jb->transit_min[0]) {
+		jb->transit_min[0] = transit_ts;
+	}
+	jb->transit_count++;
+	transit_min = jb->transit_min[0] < jb->transit_min[1] ? jb->transit_min[0] : jb->transit_min[1];
+
+	if(transit_ts > transit_min) {
+		bin = (transit_ts - transit_min + jb->frame_ts - 1) / jb->frame_ts;
+		if(bin >= jb->frame_count) {
+			bin = jb->frame_count - 1;
+		}
+	}
+
+	/* forget factor grows with the number of packets, so that the histogram converges fast initially */
+	forget = 32768 - 32768 / (jb->histogram_count + 1);
+	if(forget > JB_HISTOGRAM_FORGET_FACTOR) {
+		forget = JB_HISTOGRAM_FORGET_FACTOR;
+	}
+	else {
+		jb->histogram_count++;
+	}
+	for(i=0; i<jb->frame_count; i++) {
+		jb->histogram[i] = (apr_uint32_t)(((apr_uint64_t)jb->histogram[i] * forget) >> 15);
+	}
+	jb->histogram[bin] += (32768 - forget) << 15;
+
+	/* find the delay not exceeded by the given percentile of packets */
+	threshold = (apr_uint32_t)(((apr_uint64_t)1 << 30) * jb->config->playout_percentile / 100);
+	for(i=0; i<jb->frame_count-1; i++) {
+		sum += jb->histogram[i];
+		if(sum >= threshold) {
+			break;
+		}
+	}
+
+	/* one more frame is reserved, since packets arrive asynchronously with reads */
+	target_ts = transit_min + (apr_int32_t)((i + 1) * jb->frame_ts);
+	if(target_ts > 0 && target_ts % jb->frame_ts != 0) {
+		target_ts += jb->frame_ts - target_ts % jb->frame_ts;
+	}
+	if(target_ts < (apr_int32_t)jb->min_playout_delay_ts) {
+		target_ts = jb->min_playout_delay_ts;
+	}
+	if(target_ts > (apr_int32_t)jb->max_playout_delay_ts) {
+		target_ts = jb->max_playout_delay_ts;
+	}
+	jb->target_delay_ts = target_ts;
+}
 
 mpf_jitter_buffer_t* mpf_jitter_buffer_create(mpf_jb_config_t *jb_config, mpf_codec_descriptor_t *descriptor, mpf_codec_t *codec, apr_pool_t *pool)
 {
@@ -95,6 +595,9 @@ mpf_jitter_buffer_t* mpf_jitter_buffer_create(mpf_jb_config_t *jb_config, mpf_co
 	if(jb_config->max_playout_delay == 0) {
 		jb_config->max_playout_delay = 600; /* ms */
 	}
+	if(jb_config->playout_percentile == 0 || jb_config->playout_percentile > 100) {
+		jb_config->playout_percentile = 95;
+	}
 	
 	jb->config = jb_config;
 	jb->codec = codec;
@@ -119,6 +622,10 @@ mpf_jitter_buffer_t* mpf_jitter_buffer_create(mpf_jb_config_t *jb_config, mpf_co
 	/* calculate playout delay in timestamp units */
 	jb->playout_delay_ts = jb->frame_ts * jb->config->initial_playout_delay / CODEC_FRAME_TIME_BASE;
 	jb->max_playout_delay_ts = jb->frame_ts * jb->config->max_playout_delay / CODEC_FRAME_TIME_BASE;
+	jb->min_playout_delay_ts = jb->frame_ts * jb->config->min_playout_delay / CODEC_FRAME_TIME_BASE;
+	if(jb->min_playout_delay_ts < jb->frame_ts) {
+		jb->min_playout_delay_ts = jb->frame_ts;
+	}
 
 	jb->write_sync = 1;
 	jb->write_ts_offset = 0;
@@ -131,6 +638,15 @@ mpf_jitter_buffer_t* mpf_jitter_buffer_create(mpf_jb_config_t *jb_config, mpf_co
 	memset(&jb->event_write_base,0,sizeof(mpf_named_event_frame_t));
 	jb->event_write_update = NULL;
 
+	/* the target playout delay is the initial one, until packets arrive */
+	jb->histogram = apr_pcalloc(pool,sizeof(apr_uint32_t)*jb->frame_count);
+	jb->histogram_count = 0;
+	jb->transit_min[0] = jb->transit_min[1] = JB_TRANSIT_UNKNOWN;
+	jb->transit_count = 0;
+	jb->target_delay_ts = jb->playout_delay_ts;
+
+	mpf_jitter_buffer_linear_create(jb,descriptor,pool);
+	mpf_rtp_jb_stat_reset(&jb->stat);
 	return jb;
 }
 
@@ -152,16 +668,15 @@ apt_bool_t mpf_jitter_buffer_restart(mpf_jitter_buffer_t *jb)
 		jb->playout_delay_ts = jb->frame_ts * jb->config->initial_playout_delay / CODEC_FRAME_TIME_BASE;
 	}
 
+	/* history is no more continuous */
+	jb->playing = FALSE;
+	jb->history_valid = FALSE;
+	jb->plc_frames = 0;
+
 	JB_TRACE("JB restart\n");
 	return TRUE;
 }
 
-static APR_INLINE mpf_frame_t* mpf_jitter_buffer_frame_get(mpf_jitter_buffer_t *jb, apr_size_t ts)
-{
-	apr_size_t index = (ts / jb->frame_ts) % jb->frame_count;
-	return &jb->frames[index];
-}
-
 static APR_INLINE void mpf_jitter_buffer_stat_update(mpf_jitter_buffer_t *jb)
 {
 	apr_int32_t length_ts;
@@ -202,6 +717,11 @@ static APR_INLINE jb_result_t mpf_jitter_buffer_write_prepare(mpf_jitter_buffer_
 		/* calculate the offset */
 		jb->write_ts_offset = ts - jb->read_ts;
 		jb->write_sync = 0;
+		/* frames preceding the first one written after sync are not lost */
+		jb->playing = FALSE;
+		/* transit delays are relative to the offset */
+		jb->transit_min[0] = jb->transit_min[1] = JB_TRANSIT_UNKNOWN;
+		jb->transit_count = 0;
 	
 		if(jb->config->time_skew_detection) {
 			/* reset the statistics */
@@ -243,6 +763,11 @@ jb_result_t mpf_jitter_buffer_write(mpf_jitter_buffer_t *jb, void *buffer, apr_s
 		return result;
 	}
 
+	if(jb->config->adaptive) {
+		/* update the statistics of transit delays */
+		mpf_jitter_buffer_delay_estimate(jb,write_ts);
+	}
+
 	if(write_ts >= jb->read_ts) {
 		if(write_ts >= jb->write_ts) {
 			/* normal order */
@@ -257,6 +782,7 @@ jb_result_t mpf_jitter_buffer_write(mpf_jitter_buffer_t *jb, void *buffer, apr_s
 		if(write_ts < jb->write_ts) {
 			/* out of order => discard */
 			JB_TRACE("JB write ts=%u out of order, too late => discard\n",write_ts);
+			jb->stat.late_packets++;
 			return JB_DISCARD_TOO_LATE;
 		}
 
@@ -283,6 +809,12 @@ jb_result_t mpf_jitter_buffer_write(mpf_jitter_buffer_t *jb, void *buffer, apr_s
 				/* adjust the offset and write pos */
 				jb->write_ts_offset -= skew_ts;
 				write_ts = ts - jb->write_ts_offset + jb->playout_delay_ts;
+				if(jb->transit_min[0] != JB_TRANSIT_UNKNOWN) {
+					jb->transit_min[0] -= skew_ts;
+				}
+				if(jb->transit_min[1] != JB_TRANSIT_UNKNOWN) {
+					jb->transit_min[1] -= skew_ts;
+				}
 
 				/* adjust the statistics */
 				jb->min_length_ts += skew_ts;
@@ -301,12 +833,21 @@ jb_result_t mpf_jitter_buffer_write(mpf_jitter_buffer_t *jb, void *buffer, apr_s
 			if(jb->config->adaptive == 0) {
 				/* jitter buffer is not adaptive => discard the packet */
 				JB_TRACE("JB write ts=%u too late => discard\n",write_ts);
+				jb->stat.late_packets++;
 				return JB_DISCARD_TOO_LATE;
 			}
 
 			if(jb->playout_delay_ts + delta_ts > jb->max_playout_delay_ts) {
 				/* max playout delay will be reached => discard the packet */
 				JB_TRACE("JB write ts=%u max playout delay reached => discard\n",write_ts);
+				jb->stat.late_packets++;
+				return JB_DISCARD_TOO_LATE;
+			}
+
+			if(jb->playout_delay_ts + delta_ts > jb->target_delay_ts) {
+				/* the packet is beyond the percentile of transit delays => discard (conceal) it */
+				JB_TRACE("JB write ts=%u target playout delay=%u exceeded => discard\n",write_ts,jb->target_delay_ts);
+				jb->stat.late_packets++;
 				return JB_DISCARD_TOO_LATE;
 			}
 
@@ -324,12 +865,13 @@ jb_result_t mpf_jitter_buffer_write(mpf_jitter_buffer_t *jb, void *buffer, apr_s
 	}
 
 	/* get number of frames available to write */
-	available_frame_count = jb->frame_count - (write_ts - jb->read_ts)/jb->frame_ts;
-	if(available_frame_count <= 0) {
+	if((write_ts - jb->read_ts)/jb->frame_ts >= jb->frame_count) {
 		/* too early */
 		JB_TRACE("JB write ts=%u too early => discard\n",write_ts);
+		jb->stat.early_packets++;
 		return JB_DISCARD_TOO_EARLY;
 	}
+	available_frame_count = jb->frame_count - (write_ts - jb->read_ts)/jb->frame_ts;
 
 	JB_TRACE("JB write ts=%u size=%"APR_SIZE_T_FMT"\n",write_ts,size);
 	while(available_frame_count && size) {
@@ -417,6 +959,7 @@ jb_result_t mpf_jitter_buffer_event_write(mpf_jitter_buffer_t *jb, const mpf_nam
 			/* jitter buffer is not adaptive => discard the packet */
 			JB_TRACE("JB write ts=%u event=%d duration=%d too late => discard\n",
 				write_ts,named_event->event_id,named_event->duration);
+			jb->stat.late_packets++;
 			return JB_DISCARD_TOO_LATE;
 		}
 
@@ -427,6 +970,7 @@ jb_result_t mpf_jitter_buffer_event_write(mpf_jitter_buffer_t *jb, const mpf_nam
 			/* max playout delay will be reached => discard the packet */
 			JB_TRACE("JB write ts=%u event=%d duration=%d max playout delay reached => discard\n",
 				write_ts,named_event->event_id,named_event->duration);
+			jb->stat.late_packets++;
 			return JB_DISCARD_TOO_LATE;
 		}
 
@@ -442,6 +986,7 @@ jb_result_t mpf_jitter_buffer_event_write(mpf_jitter_buffer_t *jb, const mpf_nam
 		/* too early */
 		JB_TRACE("JB write ts=%u event=%d duration=%d too early => discard\n",
 			write_ts,named_event->event_id,named_event->duration);
+		jb->stat.early_packets++;
 		return JB_DISCARD_TOO_EARLY;
 	}
 
@@ -470,23 +1015,54 @@ apt_bool_t mpf_jitter_buffer_read(mpf_jitter_buffer_t *jb, mpf_frame_t *media_fr
 {
 	mpf_frame_t *src_media_frame = mpf_jitter_buffer_frame_get(jb,jb->read_ts);
 	if(jb->write_ts > jb->read_ts) {
-		/* normal read */
-		JB_TRACE("JB read ts=%u\n",	jb->read_ts);
-		media_frame->type = src_media_frame->type;
-		media_frame->marker = src_media_frame->marker;
-		if(media_frame->type & MEDIA_FRAME_TYPE_AUDIO) {
-			media_frame->codec_frame.size = src_media_frame->codec_frame.size;
-			memcpy(media_frame->codec_frame.buffer,src_media_frame->codec_frame.buffer,media_frame->codec_frame.size);
+		if(mpf_jitter_buffer_time_stretch(jb,src_media_frame,media_frame) == TRUE) {
+			/* read pos is advanced (if at all) by time-stretching */
+			if(jb->config->time_skew_detection) {
+				mpf_jitter_buffer_stat_update(jb);
+			}
+			return TRUE;
 		}
-		if(media_frame->type & MEDIA_FRAME_TYPE_EVENT) {
-			media_frame->event_frame = src_media_frame->event_frame;
+
+		if(src_media_frame->type == MEDIA_FRAME_TYPE_NONE) {
+			/* missing frame (lost in network or arrived too late) */
+			JB_TRACE("JB read ts=%u missing\n", jb->read_ts);
+			if(jb->playing) {
+				jb->stat.lost_frames++;
+			}
+			if(mpf_jitter_buffer_conceal(jb,media_frame) == FALSE) {
+				media_frame->type = MEDIA_FRAME_TYPE_NONE;
+				media_frame->marker = MPF_MARKER_NONE;
+			}
+		}
+		else {
+			/* normal read */
+			JB_TRACE("JB read ts=%u\n",	jb->read_ts);
+			media_frame->type = src_media_frame->type;
+			media_frame->marker = src_media_frame->marker;
+			if(media_frame->type & MEDIA_FRAME_TYPE_AUDIO) {
+				jb->playing = TRUE;
+				media_frame->codec_frame.size = src_media_frame->codec_frame.size;
+				memcpy(media_frame->codec_frame.buffer,src_media_frame->codec_frame.buffer,media_frame->codec_frame.size);
+				if(jb->linear_format != JB_LINEAR_NONE) {
+					mpf_jitter_buffer_history_update(jb,media_frame);
+				}
+			}
+			else {
+				/* no audio to continue from */
+				jb->history_valid = FALSE;
+			}
+			if(media_frame->type & MEDIA_FRAME_TYPE_EVENT) {
+				media_frame->event_frame = src_media_frame->event_frame;
+			}
 		}
 	}
 	else {
 		/* underflow */
 		JB_TRACE("JB read ts=%u underflow\n", jb->read_ts);
-		media_frame->type = MEDIA_FRAME_TYPE_NONE;
-		media_frame->marker = MPF_MARKER_NONE;
+		if(mpf_jitter_buffer_conceal(jb,media_frame) == FALSE) {
+			media_frame->type = MEDIA_FRAME_TYPE_NONE;
+			media_frame->marker = MPF_MARKER_NONE;
+		}
 	}
 	src_media_frame->type = MEDIA_FRAME_TYPE_NONE;
 	src_media_frame->marker = MPF_MARKER_NONE;
@@ -508,3 +1084,17 @@ apr_uint32_t mpf_jitter_buffer_playout_delay_get(const mpf_jitter_buffer_t *jb)
 
 	return jb->playout_delay_ts * CODEC_FRAME_TIME_BASE / jb->frame_ts;
 }
+
+void mpf_jitter_buffer_stat_get(const mpf_jitter_buffer_t *jb, rtp_jb_stat_t *stat)
+{
+	*stat = jb->stat;
+	stat->depth = 0;
+	if(jb->write_ts > jb->read_ts) {
+		stat->depth = (jb->write_ts - jb->read_ts) * CODEC_FRAME_TIME_BASE / jb->frame_ts;
+	}
+	stat->playout_delay = mpf_jitter_buffer_playout_delay_get(jb);
+	stat->target_playout_delay = stat->playout_delay;
+	if(jb->config->adaptive) {
+		stat->target_playout_delay = jb->target_delay_ts * CODEC_FRAME_TIME_BASE / jb->frame_ts;
+	}
+}
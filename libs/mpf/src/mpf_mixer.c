@@ -156,7 +156,7 @@ MPF_DECLARE(mpf_object_t*) mpf_mixer_create(
 	mixer->source_arr = NULL;
 	mixer->source_count = 0;
 	mixer->sink = NULL;
-	mpf_object_init(&mixer->base,name);
+	mpf_object_init(&mixer->base,name,MPF_OBJECT_TYPE_MIXER);
 	mixer->base.process = mpf_mixer_process;
 	mixer->base.destroy = mpf_mixer_destroy;
 	mixer->base.trace = mpf_mixer_trace;
@@ -194,6 +194,17 @@ MPF_DECLARE(mpf_object_t*) mpf_mixer_create(
 				source = decoder;
 			}
 		}
+		if(source->rx_descriptor && sink->tx_descriptor &&
+			source->rx_descriptor->sampling_rate != sink->tx_descriptor->sampling_rate) {
+			/* set resampler before mixer */
+			mpf_audio_stream_t *resampler = mpf_resampler_create(source,sink,pool);
+			if(!resampler) {
+				/* unsupported rate conversion, leave the source out of the mix */
+				source_arr[i] = NULL;
+				continue;
+			}
+			source = resampler;
+		}
 		source_arr[i] = source;
 		mpf_audio_stream_rx_open(source,NULL);
 	}
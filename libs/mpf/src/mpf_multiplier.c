@@ -135,7 +135,7 @@ MPF_DECLARE(mpf_object_t*) mpf_multiplier_create(
 	multiplier->source = NULL;
 	multiplier->sink_arr = NULL;
 	multiplier->sink_count = 0;
-	mpf_object_init(&multiplier->base,name);
+	mpf_object_init(&multiplier->base,name,MPF_OBJECT_TYPE_MULTIPLIER);
 	multiplier->base.process = mpf_multiplier_process;
 	multiplier->base.destroy = mpf_multiplier_destroy;
 	multiplier->base.trace = mpf_multiplier_trace;
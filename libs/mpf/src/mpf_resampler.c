@@ -17,12 +17,371 @@
  */
 
 #include "mpf_resampler.h"
+#include "mpf_codec_descriptor.h"
 #include "apt_log.h"
 
-MPF_DECLARE(mpf_audio_stream_t*) mpf_resampler_create(mpf_audio_stream_t *source, mpf_audio_stream_t *sink, apr_pool_t *pool)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MPF_RESAMPLER_SSE2
+#include <emmintrin.h>
+#endif
+
+/* 
+ * Coefficients of the polyphase filters are precomputed (Kaiser windowed sinc, beta 7,
+ * cutoff at 0.46 of the lower Nyquist frequency, 16 * max(up,down) taps in total) and
+ * stored in Q15 format. The coefficients of each phase are reversed and normalized to
+ * the unity gain, so that every output sample is a plain dot product of the phase and
+ * the input history. The tables are read-only and shared across all the resamplers.
+ */
+
+/** Polyphase filter coefficients (up 2, down 1, 16 taps per phase) */
+static const apr_int16_t resampler_coefs_2_1[32] = {
+	24,-89,187,-239,56,765,-3480,27495,11157,-4744,2480,-1229,
+	525,-176,39,-3,-3,39,-176,525,-1229,2480,-4744,11157,
+	27495,-3480,765,56,-239,187,-89,24
+};
+
+/** Polyphase filter coefficients (up 3, down 1, 16 taps per phase) */
+static const apr_int16_t resampler_coefs_3_1[48] = {
+	35,-128,288,-467,511,-78,-1899,28947,8072,-3959,2245,-1189,
+	543,-197,49,-5,6,-6,-57,308,-963,2407,-5735,20424,
+	20424,-5735,2407,-963,308,-57,-6,6,-5,49,-197,543,
+	-1189,2245,-3959,8072,28947,-1899,-78,511,-467,288,-128,35
+};
+
+/** Polyphase filter coefficients (up 4, down 1, 16 taps per phase) */
+static const apr_int16_t resampler_coefs_4_1[64] = {
+	41,-147,340,-585,752,-544,-952,29464,6584,-3511,2086,-1145,
+	540,-203,53,-5,17,-50,60,63,-537,1784,-5079,24401,
+	15898,-5583,2648,-1212,476,-143,26,-1,-1,26,-143,476,
+	-1212,2648,-5583,15898,24401,-5079,1784,-537,63,60,-50,17,
+	-5,53,-203,540,-1145,2086,-3511,6584,29464,-952,-544,752,
+	-585,340,-147,41
+};
+
+/** Polyphase filter coefficients (up 6, down 1, 16 taps per phase) */
+static const apr_int16_t resampler_coefs_6_1[96] = {
+	47,-167,391,-703,997,-1031,95,29839,5147,-3038,1904,-1086,
+	529,-205,55,-6,31,-102,202,-251,57,774,-3492,27500,
+	11171,-4778,2525,-1274,559,-196,47,-5,14,-36,18,156,
+	-706,2046,-5406,23161,17451,-5726,2624,-1162,438,-122,17,1,
+	1,17,-122,438,-1162,2624,-5726,17451,23161,-5406,2046,-706,
+	156,18,-36,14,-5,47,-196,559,-1274,2525,-4778,11171,
+	27500,-3492,774,57,-251,202,-102,31,-6,55,-205,529,
+	-1086,1904,-3038,5147,29839,95,-1031,997,-703,391,-167,47
+};
+
+/** Polyphase filter coefficients (up 1, down 2, 32 taps per phase) */
+static const apr_int16_t resampler_coefs_1_2[32] = {
+	-2,12,20,-45,-88,93,262,-119,-615,28,1240,383,
+	-2372,-1740,5579,13748,13748,5579,-1740,-2372,383,1240,28,-615,
+	-119,262,93,-88,-45,20,12,-2
+};
+
+/** Polyphase filter coefficients (up 1, down 3, 48 taps per phase) */
+static const apr_int16_t resampler_coefs_1_3[48] = {
+	-2,2,12,16,-2,-43,-66,-19,96,181,103,-156,
+	-397,-321,170,748,802,-26,-1320,-1912,-633,2691,6808,9650,
+	9654,6808,2691,-633,-1912,-1320,-26,802,748,170,-321,-397,
+	-156,103,181,96,-19,-66,-43,-2,16,12,2,-2
+};
+
+/** Polyphase filter coefficients (up 1, down 4, 64 taps per phase) */
+static const apr_int16_t resampler_coefs_1_4[64] = {
+	-1,0,4,10,13,6,-12,-37,-51,-36,15,85,
+	135,119,16,-146,-286,-303,-134,188,521,662,446,-136,
+	-878,-1396,-1270,-238,1646,3974,6100,7367,7369,6100,3974,1646,
+	-238,-1270,-1396,-878,-136,446,662,521,188,-134,-303,-286,
+	-146,16,119,135,85,15,-36,-51,-37,-12,6,13,
+	10,4,0,-1
+};
+
+/** Polyphase filter coefficients (up 1, down 6, 96 taps per phase) */
+static const apr_int16_t resampler_coefs_1_6[96] = {
+	-1,-1,0,2,5,8,9,8,3,-6,-17,-28,
+	-34,-33,-20,3,34,65,88,93,73,26,-42,-117,
+	-181,-212,-194,-118,10,166,317,421,437,341,129,-172,
+	-506,-796,-954,-901,-582,16,858,1862,2908,3860,4583,4974,
+	4974,4583,3860,2908,1862,858,16,-582,-901,-954,-796,-506,
+	-172,129,341,437,421,317,166,10,-118,-194,-212,-181,
+	-117,-42,26,73,93,88,65,34,3,-20,-33,-34,
+	-28,-17,-6,3,8,9,8,5,2,0,-1,-1
+};
+
+/** Polyphase filter coefficients (up 3, down 2, 16 taps per phase) */
+static const apr_int16_t resampler_coefs_3_2[48] = {
+	35,-128,288,-467,511,-78,-1899,28947,8072,-3959,2245,-1189,
+	543,-197,49,-5,6,-6,-57,308,-963,2407,-5735,20424,
+	20424,-5735,2407,-963,308,-57,-6,6,-5,49,-197,543,
+	-1189,2245,-3959,8072,28947,-1899,-78,511,-467,288,-128,35
+};
+
+/** Polyphase filter coefficients (up 2, down 3, 24 taps per phase) */
+static const apr_int16_t resampler_coefs_2_3[48] = {
+	4,33,-85,-38,362,-311,-642,1497,-52,-3823,5381,19298,
+	13615,-1266,-2639,1605,340,-793,205,192,-131,-4,23,-3,
+	-3,23,-4,-131,192,205,-793,340,1605,-2639,-1266,13615,
+	19298,5381,-3823,-52,1497,-642,-311,362,-38,-85,33,4
+};
+
+/** Polyphase filter */
+typedef struct mpf_resampler_filter_t mpf_resampler_filter_t;
+
+/** Polyphase filter */
+struct mpf_resampler_filter_t {
+	/** Interpolation factor */
+	apr_size_t         up;
+	/** Decimation factor */
+	apr_size_t         down;
+	/** Number of taps per phase (multiple of 8) */
+	apr_size_t         taps;
+	/** Coefficients [up][taps] */
+	const apr_int16_t *coefs;
+};
+
+/** Table of supported conversions (8000/16000/32000/48000) */
+static const mpf_resampler_filter_t resampler_filters[] = {
+	{2,1,16,resampler_coefs_2_1},
+	{3,1,16,resampler_coefs_3_1},
+	{4,1,16,resampler_coefs_4_1},
+	{6,1,16,resampler_coefs_6_1},
+	{1,2,32,resampler_coefs_1_2},
+	{1,3,48,resampler_coefs_1_3},
+	{1,4,64,resampler_coefs_1_4},
+	{1,6,96,resampler_coefs_1_6},
+	{3,2,16,resampler_coefs_3_2},
+	{2,3,24,resampler_coefs_2_3}
+};
+
+typedef struct mpf_resampler_t mpf_resampler_t;
+
+/** Resampler of linear PCM audio stream */
+struct mpf_resampler_t {
+	/** Audio stream base */
+	mpf_audio_stream_t           *base;
+	/** Source audio stream to resample */
+	mpf_audio_stream_t           *source;
+	/** Polyphase filter in use */
+	const mpf_resampler_filter_t *filter;
+	/** History of (taps - 1) samples followed by the current input frame */
+	apr_int16_t                  *history;
+	/** Number of input samples per frame */
+	apr_size_t                    in_samples;
+	/** Number of output samples per frame */
+	apr_size_t                    out_samples;
+	/** Input frame (buffer of the frame points to the tail of history) */
+	mpf_frame_t                   frame_in;
+};
+
+/** Calculate the dot product of the phase coefficients and input samples */
+static APR_INLINE apr_int32_t mpf_resampler_dot_product(const apr_int16_t *coefs, const apr_int16_t *samples, apr_size_t taps)
+{
+	apr_size_t i;
+#ifdef MPF_RESAMPLER_SSE2
+	__m128i acc = _mm_setzero_si128();
+	for(i=0; i<taps; i+=8) {
+		acc = _mm_add_epi32(acc,_mm_madd_epi16(
+				_mm_loadu_si128((const __m128i*)(coefs + i)),
+				_mm_loadu_si128((const __m128i*)(samples + i))));
+	}
+	acc = _mm_add_epi32(acc,_mm_shuffle_epi32(acc,_MM_SHUFFLE(1,0,3,2)));
+	acc = _mm_add_epi32(acc,_mm_shuffle_epi32(acc,_MM_SHUFFLE(2,3,0,1)));
+	return _mm_cvtsi128_si32(acc);
+#else
+	apr_int32_t acc = 0;
+	for(i=0; i<taps; i++) {
+		acc += (apr_int32_t)coefs[i] * samples[i];
+	}
+	return acc;
+#endif
+}
+
+/** Run polyphase filter over the history */
+static void mpf_resampler_filter_run(mpf_resampler_t *resampler, apr_int16_t *out)
+{
+	const mpf_resampler_filter_t *filter = resampler->filter;
+	apr_size_t n;
+	apr_size_t index = 0;
+	apr_size_t phase = 0;
+	apr_int32_t acc;
+	for(n=0; n<resampler->out_samples; n++) {
+		acc = mpf_resampler_dot_product(
+				filter->coefs + phase * filter->taps,
+				resampler->history + index,
+				filter->taps);
+		acc = (acc + 0x4000) >> 15;
+		if(acc > 32767) {
+			acc = 32767;
+		}
+		else if(acc < -32768) {
+			acc = -32768;
+		}
+		out[n] = (apr_int16_t)acc;
+
+		phase += filter->down;
+		while(phase >= filter->up) {
+			phase -= filter->up;
+			index++;
+		}
+	}
+
+	/* keep the last (taps - 1) samples for the next frame */
+	memmove(resampler->history,
+		resampler->history + resampler->in_samples,
+		(filter->taps - 1) * sizeof(apr_int16_t));
+}
+
+static apt_bool_t mpf_resampler_destroy(mpf_audio_stream_t *stream)
+{
+	mpf_resampler_t *resampler = stream->obj;
+	return mpf_audio_stream_destroy(resampler->source);
+}
+
+static apt_bool_t mpf_resampler_open(mpf_audio_stream_t *stream, mpf_codec_t *codec)
 {
-	apt_log(APT_LOG_MARK,APT_PRIO_WARNING,
-		"Currently resampling is not supported. "
-		"Try to configure and use the same sampling rate on both ends");
+	mpf_resampler_t *resampler = stream->obj;
+	memset(resampler->history,0,(resampler->filter->taps - 1) * sizeof(apr_int16_t));
+	return mpf_audio_stream_rx_open(resampler->source,NULL);
+}
+
+static apt_bool_t mpf_resampler_close(mpf_audio_stream_t *stream)
+{
+	mpf_resampler_t *resampler = stream->obj;
+	return mpf_audio_stream_rx_close(resampler->source);
+}
+
+static apt_bool_t mpf_resampler_process(mpf_audio_stream_t *stream, mpf_frame_t *frame)
+{
+	mpf_resampler_t *resampler = stream->obj;
+	resampler->frame_in.type = MEDIA_FRAME_TYPE_NONE;
+	resampler->frame_in.marker = MPF_MARKER_NONE;
+	if(mpf_audio_stream_frame_read(resampler->source,&resampler->frame_in) != TRUE) {
+		return FALSE;
+	}
+
+	frame->type = resampler->frame_in.type;
+	frame->marker = resampler->frame_in.marker;
+	if((frame->type & MEDIA_FRAME_TYPE_EVENT) == MEDIA_FRAME_TYPE_EVENT) {
+		frame->event_frame = resampler->frame_in.event_frame;
+	}
+	if((frame->type & MEDIA_FRAME_TYPE_AUDIO) == 0) {
+		/* keep the filter running over silence to avoid clicks on the next audio frame */
+		memset(resampler->frame_in.codec_frame.buffer,0,resampler->frame_in.codec_frame.size);
+	}
+	mpf_resampler_filter_run(resampler,frame->codec_frame.buffer);
+	return TRUE;
+}
+
+static void mpf_resampler_trace(mpf_audio_stream_t *stream, mpf_stream_direction_e direction, apt_text_stream_t *output)
+{
+	apr_size_t offset;
+	mpf_codec_descriptor_t *descriptor;
+	mpf_resampler_t *resampler = stream->obj;
+
+	mpf_audio_stream_trace(resampler->source,direction,output);
+
+	descriptor = resampler->base->rx_descriptor;
+	if(descriptor) {
+		offset = output->pos - output->text.buf;
+		output->pos += apr_snprintf(output->pos, output->text.length - offset,
+			"->Resampler->[%s/%d/%d]",
+			descriptor->name.buf,
+			descriptor->sampling_rate,
+			descriptor->channel_count);
+	}
+}
+
+static const mpf_audio_stream_vtable_t vtable = {
+	mpf_resampler_destroy,
+	mpf_resampler_open,
+	mpf_resampler_close,
+	mpf_resampler_process,
+	NULL,
+	NULL,
+	NULL,
+	mpf_resampler_trace
+};
+
+static apr_size_t mpf_gcd(apr_size_t a, apr_size_t b)
+{
+	apr_size_t t;
+	while(b) {
+		t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+static const mpf_resampler_filter_t* mpf_resampler_filter_find(apr_uint16_t in_rate, apr_uint16_t out_rate)
+{
+	apr_size_t i;
+	apr_size_t gcd = mpf_gcd(in_rate,out_rate);
+	apr_size_t up = out_rate / gcd;
+	apr_size_t down = in_rate / gcd;
+	for(i=0; i<sizeof(resampler_filters)/sizeof(resampler_filters[0]); i++) {
+		if(resampler_filters[i].up == up && resampler_filters[i].down == down) {
+			return &resampler_filters[i];
+		}
+	}
 	return NULL;
 }
+
+MPF_DECLARE(mpf_audio_stream_t*) mpf_resampler_create(mpf_audio_stream_t *source, mpf_audio_stream_t *sink, apr_pool_t *pool)
+{
+	mpf_resampler_t *resampler;
+	mpf_stream_capabilities_t *capabilities;
+	const mpf_resampler_filter_t *filter;
+	mpf_codec_descriptor_t *rx_descriptor;
+	mpf_codec_descriptor_t *tx_descriptor;
+	if(!source || !sink) {
+		return NULL;
+	}
+
+	rx_descriptor = source->rx_descriptor;
+	tx_descriptor = sink->tx_descriptor;
+	if(!rx_descriptor || !tx_descriptor) {
+		return NULL;
+	}
+
+	if(rx_descriptor->channel_count != 1 || tx_descriptor->channel_count != 1) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,
+			"Resampling is supported for mono streams only [%d->%d channels]",
+			rx_descriptor->channel_count,
+			tx_descriptor->channel_count);
+		return NULL;
+	}
+
+	filter = mpf_resampler_filter_find(rx_descriptor->sampling_rate,tx_descriptor->sampling_rate);
+	if(!filter) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,
+			"Unsupported Resampling [%d->%d]",
+			rx_descriptor->sampling_rate,
+			tx_descriptor->sampling_rate);
+		return NULL;
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Create Resampler [%d->%d]",
+		rx_descriptor->sampling_rate,
+		tx_descriptor->sampling_rate);
+	resampler = apr_palloc(pool,sizeof(mpf_resampler_t));
+	capabilities = mpf_stream_capabilities_create(STREAM_DIRECTION_RECEIVE,pool);
+	resampler->base = mpf_audio_stream_create(resampler,&vtable,capabilities,pool);
+	if(!resampler->base) {
+		return NULL;
+	}
+	resampler->base->rx_descriptor = mpf_codec_lpcm_descriptor_create(
+		tx_descriptor->sampling_rate,
+		tx_descriptor->channel_count,
+		pool);
+	resampler->base->rx_event_descriptor = source->rx_event_descriptor;
+
+	resampler->source = source;
+	resampler->filter = filter;
+	resampler->in_samples = rx_descriptor->sampling_rate * CODEC_FRAME_TIME_BASE / 1000;
+	resampler->out_samples = tx_descriptor->sampling_rate * CODEC_FRAME_TIME_BASE / 1000;
+
+	resampler->history = apr_pcalloc(pool,(filter->taps - 1 + resampler->in_samples) * sizeof(apr_int16_t));
+	resampler->frame_in.codec_frame.size = resampler->in_samples * BYTES_PER_SAMPLE;
+	resampler->frame_in.codec_frame.buffer = resampler->history + filter->taps - 1;
+	return resampler->base;
+}
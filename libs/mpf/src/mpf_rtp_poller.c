@@ -0,0 +1,213 @@
+/*
+ * Copyright 2008-2010 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+/* recvmmsg() is a GNU extension */
+#define _GNU_SOURCE
+#endif
+
+#include <apr_portable.h>
+#include "mpf_rtp_poller.h"
+#include "apt_log.h"
+
+#if defined(__linux__)
+#include <sys/socket.h>
+#ifdef MSG_WAITFORONE
+#define MPF_RTP_POLLER_RECVMMSG
+#endif
+#endif
+
+/** Max size of RTP packet */
+#define MAX_RTP_PACKET_SIZE  1500
+/** Max number of packets received from a socket per poll */
+#define MPF_RTP_POLLER_BATCH_SIZE 8
+
+/** Registered socket */
+typedef struct mpf_rtp_poller_entry_t mpf_rtp_poller_entry_t;
+struct mpf_rtp_poller_entry_t {
+	mpf_rtp_poller_handler_f handler;
+	void                    *obj;
+};
+
+struct mpf_rtp_poller_t {
+	/** APR pollset (epoll, kqueue, ... whichever is the best available) */
+	apr_pollset_t        *pollset;
+	/** Max number of ready sockets to fetch per poll */
+	apr_size_t            max_ready_count;
+	/** Statistics */
+	mpf_rtp_poller_stat_t stat;
+
+	/** Batch of receive buffers */
+	char                  buffers[MPF_RTP_POLLER_BATCH_SIZE][MAX_RTP_PACKET_SIZE];
+#ifdef MPF_RTP_POLLER_RECVMMSG
+	struct mmsghdr        msgs[MPF_RTP_POLLER_BATCH_SIZE];
+	struct iovec          iovecs[MPF_RTP_POLLER_BATCH_SIZE];
+#endif
+};
+
+
+MPF_DECLARE(mpf_rtp_poller_t*) mpf_rtp_poller_create(apr_size_t max_ready_count, apr_pool_t *pool)
+{
+	mpf_rtp_poller_t *poller;
+#ifdef MPF_RTP_POLLER_RECVMMSG
+	apr_size_t i;
+#endif
+	if(!max_ready_count) {
+		return NULL;
+	}
+
+	poller = apr_palloc(pool,sizeof(mpf_rtp_poller_t));
+	poller->max_ready_count = max_ready_count;
+	memset(&poller->stat,0,sizeof(mpf_rtp_poller_stat_t));
+	if(apr_pollset_create(&poller->pollset,(apr_uint32_t)max_ready_count,pool,0) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create RTP Pollset");
+		return NULL;
+	}
+
+#ifdef MPF_RTP_POLLER_RECVMMSG
+	memset(poller->msgs,0,sizeof(poller->msgs));
+	for(i=0; i<MPF_RTP_POLLER_BATCH_SIZE; i++) {
+		poller->iovecs[i].iov_base = poller->buffers[i];
+		poller->iovecs[i].iov_len = MAX_RTP_PACKET_SIZE;
+		poller->msgs[i].msg_hdr.msg_iov = &poller->iovecs[i];
+		poller->msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+#endif
+	return poller;
+}
+
+MPF_DECLARE(void) mpf_rtp_poller_destroy(mpf_rtp_poller_t *poller)
+{
+	apr_pollset_destroy(poller->pollset);
+}
+
+MPF_DECLARE(apr_pollfd_t*) mpf_rtp_poller_add(
+								mpf_rtp_poller_t *poller,
+								apr_socket_t *socket,
+								mpf_rtp_poller_handler_f handler,
+								void *obj,
+								apr_pool_t *pool)
+{
+	mpf_rtp_poller_entry_t *entry;
+	apr_pollfd_t *descriptor;
+	if(!socket || !handler) {
+		return NULL;
+	}
+
+	entry = apr_palloc(pool,sizeof(mpf_rtp_poller_entry_t));
+	entry->handler = handler;
+	entry->obj = obj;
+
+	descriptor = apr_palloc(pool,sizeof(apr_pollfd_t));
+	memset(descriptor,0,sizeof(apr_pollfd_t));
+	descriptor->desc_type = APR_POLL_SOCKET;
+	descriptor->reqevents = APR_POLLIN;
+	descriptor->desc.s = socket;
+	descriptor->client_data = entry;
+	if(apr_pollset_add(poller->pollset,descriptor) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Add Socket to RTP Pollset");
+		return NULL;
+	}
+	poller->stat.socket_count++;
+	return descriptor;
+}
+
+MPF_DECLARE(apt_bool_t) mpf_rtp_poller_remove(mpf_rtp_poller_t *poller, apr_pollfd_t *descriptor)
+{
+	if(!descriptor) {
+		return FALSE;
+	}
+	if(apr_pollset_remove(poller->pollset,descriptor) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Remove Socket from RTP Pollset");
+		return FALSE;
+	}
+	poller->stat.socket_count--;
+	return TRUE;
+}
+
+/** Drain the ready socket and dispatch received packets */
+static void mpf_rtp_poller_socket_drain(mpf_rtp_poller_t *poller, const apr_pollfd_t *descriptor)
+{
+	mpf_rtp_poller_entry_t *entry = descriptor->client_data;
+#ifdef MPF_RTP_POLLER_RECVMMSG
+	int i;
+	int count;
+	apr_os_sock_t fd;
+	if(apr_os_sock_get(&fd,descriptor->desc.s) != APR_SUCCESS) {
+		return;
+	}
+
+	do {
+		poller->stat.recv_count++;
+		count = recvmmsg(fd,poller->msgs,MPF_RTP_POLLER_BATCH_SIZE,MSG_DONTWAIT,NULL);
+		if(count <= 0) {
+			break;
+		}
+		poller->stat.packet_count += count;
+		for(i=0; i<count; i++) {
+			entry->handler(entry->obj,poller->buffers[i],poller->msgs[i].msg_len);
+		}
+	}
+	/* a full batch means more packets may be waiting */
+	while(count == MPF_RTP_POLLER_BATCH_SIZE);
+#else
+	apr_size_t size = MAX_RTP_PACKET_SIZE;
+	apr_size_t max_count = MPF_RTP_POLLER_BATCH_SIZE;
+	while(max_count) {
+		poller->stat.recv_count++;
+		if(apr_socket_recv(descriptor->desc.s,poller->buffers[0],&size) != APR_SUCCESS) {
+			break;
+		}
+		poller->stat.packet_count++;
+		entry->handler(entry->obj,poller->buffers[0],size);
+
+		size = MAX_RTP_PACKET_SIZE;
+		max_count--;
+	}
+#endif
+}
+
+MPF_DECLARE(apt_bool_t) mpf_rtp_poller_process(mpf_rtp_poller_t *poller)
+{
+	apr_int32_t i;
+	apr_int32_t count;
+	const apr_pollfd_t *descriptors;
+
+	if(!poller->stat.socket_count) {
+		return TRUE;
+	}
+
+	do {
+		count = 0;
+		poller->stat.poll_count++;
+		if(apr_pollset_poll(poller->pollset,0,&count,&descriptors) != APR_SUCCESS) {
+			break;
+		}
+		for(i=0; i<count; i++) {
+			mpf_rtp_poller_socket_drain(poller,&descriptors[i]);
+		}
+	}
+	/* the result set has been filled up, more sockets may be ready */
+	while((apr_size_t)count == poller->max_ready_count);
+	return TRUE;
+}
+
+MPF_DECLARE(void) mpf_rtp_poller_stat_get(const mpf_rtp_poller_t *poller, mpf_rtp_poller_stat_t *stat)
+{
+	*stat = poller->stat;
+}
@@ -20,6 +20,7 @@
 #include "apt_net.h"
 #include "apt_timer_queue.h"
 #include "mpf_rtp_stream.h"
+#include "mpf_rtp_poller.h"
 #include "mpf_termination.h"
 #include "mpf_codec_manager.h"
 #include "mpf_rtp_header.h"
@@ -67,6 +68,7 @@ struct mpf_rtp_stream_t {
 	apr_sockaddr_t             *rtp_r_sockaddr;
 	apr_sockaddr_t             *rtcp_l_sockaddr;
 	apr_sockaddr_t             *rtcp_r_sockaddr;
+	apr_pollfd_t               *rtp_pfd;
 
 	apt_timer_t                *rtcp_tx_timer;
 	apt_timer_t                *rtcp_rx_timer;
@@ -99,6 +101,7 @@ static apt_bool_t mpf_rtcp_report_send(mpf_rtp_stream_t *stream);
 static apt_bool_t mpf_rtcp_bye_send(mpf_rtp_stream_t *stream, apt_str_t *reason);
 static void mpf_rtcp_tx_timer_proc(apt_timer_t *timer, void *obj);
 static void mpf_rtcp_rx_timer_proc(apt_timer_t *timer, void *obj);
+static apt_bool_t mpf_rtp_poller_packet_handler(void *obj, void *buffer, apr_size_t size);
 
 
 MPF_DECLARE(mpf_audio_stream_t*) mpf_rtp_stream_create(mpf_termination_t *termination, mpf_rtp_config_t *config, mpf_rtp_settings_t *settings, apr_pool_t *pool)
@@ -125,6 +128,7 @@ MPF_DECLARE(mpf_audio_stream_t*) mpf_rtp_stream_create(mpf_termination_t *termin
 	rtp_stream->rtp_r_sockaddr = NULL;
 	rtp_stream->rtcp_l_sockaddr = NULL;
 	rtp_stream->rtcp_r_sockaddr = NULL;
+	rtp_stream->rtp_pfd = NULL;
 	rtp_stream->rtcp_tx_timer = NULL;
 	rtp_stream->rtcp_rx_timer = NULL;
 	rtp_stream->state = MPF_MEDIA_DISABLED;
@@ -492,8 +496,18 @@ static apt_bool_t mpf_rtp_rx_stream_open(mpf_audio_stream_t *stream, mpf_codec_t
 						codec,
 						rtp_stream->pool);
 
+	if(rtp_stream->config->rtp_poller == TRUE && stream->termination && stream->termination->rtp_poller) {
+		/* packets are dispatched by the poller of the engine as soon as the socket gets ready */
+		rtp_stream->rtp_pfd = mpf_rtp_poller_add(
+								stream->termination->rtp_poller,
+								rtp_stream->rtp_socket,
+								mpf_rtp_poller_packet_handler,
+								rtp_stream,
+								rtp_stream->pool);
+	}
+
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,
-			"Open RTP Receiver %s:%hu <- %s:%hu playout [%u ms] bounds [%u - %u ms] adaptive [%d] skew detection [%d]",
+			"Open RTP Receiver %s:%hu <- %s:%hu playout [%u ms] bounds [%u - %u ms] adaptive [%d] percentile [%d] skew detection [%d] plc [%d]",
 			rtp_stream->rtp_l_sockaddr->hostname,
 			rtp_stream->rtp_l_sockaddr->port,
 			rtp_stream->rtp_r_sockaddr->hostname,
@@ -502,29 +516,44 @@ static apt_bool_t mpf_rtp_rx_stream_open(mpf_audio_stream_t *stream, mpf_codec_t
 			jb_config->min_playout_delay,
 			jb_config->max_playout_delay,
 			jb_config->adaptive,
-			jb_config->time_skew_detection);
+			jb_config->playout_percentile,
+			jb_config->time_skew_detection,
+			jb_config->plc);
 	return TRUE;
 }
 
+static APR_INLINE void rtp_rx_lost_packets_update(rtp_receiver_t *receiver)
+{
+	receiver->stat.lost_packets = 0;
+	if(receiver->stat.received_packets) {
+		apr_uint32_t expected_packets = receiver->history.seq_cycles + 
+			receiver->history.seq_num_max - receiver->history.seq_num_base + 1;
+		if(expected_packets > receiver->stat.received_packets) {
+			receiver->stat.lost_packets = expected_packets - receiver->stat.received_packets;
+		}
+	}
+}
+
 static apt_bool_t mpf_rtp_rx_stream_close(mpf_audio_stream_t *stream)
 {
 	mpf_rtp_stream_t *rtp_stream = stream->obj;
 	rtp_receiver_t *receiver = &rtp_stream->receiver;
+	rtp_jb_stat_t jb_stat;
 
 	if(!rtp_stream->rtp_l_sockaddr || !rtp_stream->rtp_r_sockaddr) {
 		return FALSE;
 	}
 
-	receiver->stat.lost_packets = 0;
-	if(receiver->stat.received_packets) {
-		apr_uint32_t expected_packets = receiver->history.seq_cycles + 
-			receiver->history.seq_num_max - receiver->history.seq_num_base + 1;
-		if(expected_packets > receiver->stat.received_packets) {
-			receiver->stat.lost_packets = expected_packets - receiver->stat.received_packets;
-		}
+	if(rtp_stream->rtp_pfd) {
+		mpf_rtp_poller_remove(stream->termination->rtp_poller,rtp_stream->rtp_pfd);
+		rtp_stream->rtp_pfd = NULL;
 	}
 
-	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Close RTP Receiver %s:%hu <- %s:%hu [r:%u l:%u j:%u p:%u d:%u i:%u]",
+	rtp_rx_lost_packets_update(receiver);
+	mpf_jitter_buffer_stat_get(receiver->jb,&jb_stat);
+
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Close RTP Receiver %s:%hu <- %s:%hu [r:%u l:%u j:%u p:%u d:%u i:%u] "
+			"JB [late:%u lost:%u concealed:%u accelerated:%u expanded:%u]",
 			rtp_stream->rtp_l_sockaddr->hostname,
 			rtp_stream->rtp_l_sockaddr->port,
 			rtp_stream->rtp_r_sockaddr->hostname,
@@ -532,13 +561,36 @@ static apt_bool_t mpf_rtp_rx_stream_close(mpf_audio_stream_t *stream)
 			receiver->stat.received_packets,
 			receiver->stat.lost_packets,
 			receiver->rr_stat.jitter,
-			mpf_jitter_buffer_playout_delay_get(receiver->jb),
+			jb_stat.playout_delay,
 			receiver->stat.discarded_packets,
-			receiver->stat.ignored_packets);
+			receiver->stat.ignored_packets,
+			jb_stat.late_packets,
+			jb_stat.lost_frames,
+			jb_stat.concealed_frames,
+			jb_stat.accelerated_frames,
+			jb_stat.expanded_frames);
 	mpf_jitter_buffer_destroy(receiver->jb);
 	return TRUE;
 }
 
+MPF_DECLARE(apt_bool_t) mpf_rtp_stream_rx_stat_get(mpf_audio_stream_t *stream, rtp_rx_stat_t *rx_stat, rtp_jb_stat_t *jb_stat)
+{
+	mpf_rtp_stream_t *rtp_stream = stream->obj;
+	rtp_receiver_t *receiver = &rtp_stream->receiver;
+	if(!receiver->jb) {
+		return FALSE;
+	}
+
+	if(rx_stat) {
+		rtp_rx_lost_packets_update(receiver);
+		*rx_stat = receiver->stat;
+	}
+	if(jb_stat) {
+		mpf_jitter_buffer_stat_get(receiver->jb,jb_stat);
+	}
+	return TRUE;
+}
+
 
 static APR_INLINE void rtp_rx_overall_stat_reset(rtp_receiver_t *receiver)
 {
@@ -735,7 +787,7 @@ static APR_INLINE rtp_ts_result_e rtp_rx_ts_update(rtp_receiver_t *receiver, mpf
 	}
 
 	/* arrival time diff in samples */
-	deviation = time_diff * descriptor->channel_count * descriptor->sampling_rate / 1000;
+	deviation = time_diff * descriptor->channel_count * mpf_codec_rtp_clock_rate_get(descriptor) / 1000;
 	/* arrival timestamp diff */
 	deviation -= ts - receiver->history.ts_last;
 
@@ -862,10 +914,18 @@ static apt_bool_t rtp_rx_process(mpf_rtp_stream_t *rtp_stream)
 	return TRUE;
 }
 
+static apt_bool_t mpf_rtp_poller_packet_handler(void *obj, void *buffer, apr_size_t size)
+{
+	mpf_rtp_stream_t *rtp_stream = obj;
+	return rtp_rx_packet_receive(rtp_stream,buffer,size);
+}
+
 static apt_bool_t mpf_rtp_stream_receive(mpf_audio_stream_t *stream, mpf_frame_t *frame)
 {
 	mpf_rtp_stream_t *rtp_stream = stream->obj;
-	rtp_rx_process(rtp_stream);
+	if(!rtp_stream->rtp_pfd) {
+		rtp_rx_process(rtp_stream);
+	}
 
 	return mpf_jitter_buffer_read(rtp_stream->receiver.jb,frame);
 }
@@ -1131,6 +1191,11 @@ static apt_bool_t mpf_rtp_socket_pair_create(mpf_rtp_stream_t *stream, mpf_rtp_m
 
 static void mpf_rtp_socket_pair_close(mpf_rtp_stream_t *stream)
 {
+	if(stream->rtp_pfd) {
+		/* socket must not be closed while it is still polled */
+		mpf_rtp_poller_remove(stream->base->termination->rtp_poller,stream->rtp_pfd);
+		stream->rtp_pfd = NULL;
+	}
 	if(stream->rtp_socket) {
 		apr_socket_close(stream->rtp_socket);
 		stream->rtp_socket = NULL;
@@ -50,6 +50,8 @@ struct mpf_scheduler_t {
 	mpf_scheduler_proc_f timer_proc;
 	void                *timer_obj;
 
+	mpf_scheduler_stat_t stat;
+
 #ifdef ENABLE_MULTIMEDIA_TIMERS
 	unsigned int         timer_id;
 #else
@@ -76,6 +78,7 @@ MPF_DECLARE(mpf_scheduler_t*) mpf_scheduler_create(apr_pool_t *pool)
 	scheduler->timer_elapsed_time = 0;
 	scheduler->timer_obj = NULL;
 	scheduler->timer_proc = NULL;
+	memset(&scheduler->stat,0,sizeof(mpf_scheduler_stat_t));
 	return scheduler;
 }
 
@@ -129,6 +132,12 @@ MPF_DECLARE(apt_bool_t) mpf_scheduler_rate_set(
 	return TRUE;
 }
 
+/** Get scheduler statistics */
+MPF_DECLARE(void) mpf_scheduler_stat_get(const mpf_scheduler_t *scheduler, mpf_scheduler_stat_t *stat)
+{
+	*stat = scheduler->stat;
+}
+
 static APR_INLINE void mpf_scheduler_resolution_set(mpf_scheduler_t *scheduler)
 {
 	if(scheduler->media_resolution) {
@@ -220,12 +229,22 @@ static void* APR_THREAD_FUNC timer_thread_proc(apr_thread_t *thread, void *data)
 		if(timeout > time_drift) {
 			apr_sleep(timeout - time_drift);
 		}
+		else {
+			/* clock is behind the schedule by a whole tick, catch up with no sleep */
+			scheduler->stat.late_count++;
+		}
 
 		time_now = apr_time_now();
 		time_drift += time_now - time_last - timeout;
-#if 0
-		printf("time_drift=%d\n",time_drift);
-#endif
+		if(time_drift > 0) {
+			scheduler->stat.time_drift = (apr_uint32_t)time_drift;
+			if(scheduler->stat.time_drift > scheduler->stat.max_time_drift) {
+				scheduler->stat.max_time_drift = scheduler->stat.time_drift;
+			}
+		}
+		else {
+			scheduler->stat.time_drift = 0;
+		}
 	}
 	
 	apr_thread_exit(thread,APR_SUCCESS);
@@ -183,7 +183,7 @@ MRCP_DECLARE(mrcp_client_t*) mrcp_client_create(apt_dir_layout_t *dir_layout)
 	client->session_table = NULL;
 	client->cnt_msg_pool = NULL;
 
-	msg_pool = apt_task_msg_pool_create_dynamic(0,pool);
+	msg_pool = apt_task_msg_pool_create_static(0,TASK_MSG_POOL_DEFAULT_SIZE,pool);
 	client->task = apt_consumer_task_create(client,msg_pool,pool);
 	if(!client->task) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Client Task");
@@ -290,6 +290,35 @@ MRCP_DECLARE(apt_bool_t) mrcp_client_shutdown(mrcp_client_t *client)
 	return TRUE;
 }
 
+/** Destroy the message pools not owned by tasks, once all the tasks are done */
+static void mrcp_client_msg_pools_destroy(mrcp_client_t *client)
+{
+	apr_hash_index_t *it;
+	void *val;
+	mrcp_sig_agent_t *signaling_agent;
+	mrcp_application_t *application;
+	for(it = apr_hash_first(client->pool,client->sig_agent_table); it; it = apr_hash_next(it)) {
+		apr_hash_this(it,NULL,NULL,&val);
+		signaling_agent = val;
+		if(signaling_agent && signaling_agent->msg_pool) {
+			apt_task_msg_pool_destroy(signaling_agent->msg_pool);
+			signaling_agent->msg_pool = NULL;
+		}
+	}
+	for(it = apr_hash_first(client->pool,client->app_table); it; it = apr_hash_next(it)) {
+		apr_hash_this(it,NULL,NULL,&val);
+		application = val;
+		if(application && application->msg_pool) {
+			apt_task_msg_pool_destroy(application->msg_pool);
+			application->msg_pool = NULL;
+		}
+	}
+	if(client->cnt_msg_pool) {
+		apt_task_msg_pool_destroy(client->cnt_msg_pool);
+		client->cnt_msg_pool = NULL;
+	}
+}
+
 /** Destroy MRCP client */
 MRCP_DECLARE(apt_bool_t) mrcp_client_destroy(mrcp_client_t *client)
 {
@@ -301,6 +330,7 @@ MRCP_DECLARE(apt_bool_t) mrcp_client_destroy(mrcp_client_t *client)
 	task = apt_consumer_task_base_get(client->task);
 	apt_task_destroy(task);
 
+	mrcp_client_msg_pools_destroy(client);
 	apr_pool_destroy(client->pool);
 	return TRUE;
 }
@@ -403,7 +433,7 @@ MRCP_DECLARE(apt_bool_t) mrcp_client_signaling_agent_register(mrcp_client_t *cli
 		return FALSE;
 	}
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Register Signaling Agent [%s]",signaling_agent->id);
-	signaling_agent->msg_pool = apt_task_msg_pool_create_dynamic(sizeof(sig_agent_task_msg_data_t),client->pool);
+	signaling_agent->msg_pool = apt_task_msg_pool_create_static(sizeof(sig_agent_task_msg_data_t),TASK_MSG_POOL_DEFAULT_SIZE,client->pool);
 	signaling_agent->parent = client;
 	signaling_agent->resource_factory = client->resource_factory;
 	apr_hash_set(client->sig_agent_table,signaling_agent->id,APR_HASH_KEY_STRING,signaling_agent);
@@ -452,7 +482,9 @@ MRCP_DECLARE(apt_bool_t) mrcp_client_connection_agent_register(mrcp_client_t *cl
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Register Connection Agent [%s]",id);
 	mrcp_client_connection_resource_factory_set(connection_agent,client->resource_factory);
 	mrcp_client_connection_agent_handler_set(connection_agent,client,&connection_method_vtable);
-	client->cnt_msg_pool = apt_task_msg_pool_create_dynamic(sizeof(connection_agent_task_msg_data_t),client->pool);
+	if(!client->cnt_msg_pool) {
+		client->cnt_msg_pool = apt_task_msg_pool_create_static(sizeof(connection_agent_task_msg_data_t),TASK_MSG_POOL_DEFAULT_SIZE,client->pool);
+	}
 	apr_hash_set(client->cnt_agent_table,id,APR_HASH_KEY_STRING,connection_agent);
 	if(client->task) {
 		apt_task_t *task = apt_consumer_task_base_get(client->task);
@@ -534,7 +566,7 @@ MRCP_DECLARE(apt_bool_t) mrcp_client_application_register(mrcp_client_t *client,
 	}
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Register Application [%s]",name);
 	application->client = client;
-	application->msg_pool = apt_task_msg_pool_create_dynamic(sizeof(mrcp_app_message_t*),client->pool);
+	application->msg_pool = apt_task_msg_pool_create_static(sizeof(mrcp_app_message_t*),TASK_MSG_POOL_DEFAULT_SIZE,client->pool);
 	apr_hash_set(client->app_table,name,APR_HASH_KEY_STRING,application);
 	return TRUE;
 }
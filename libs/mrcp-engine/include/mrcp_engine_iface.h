@@ -22,6 +22,13 @@
 /**
  * @file mrcp_engine_iface.h
  * @brief MRCP Engine User Interface (typically user is an MRCP server)
+ *
+ * The user may invoke the methods below from several threads at once
+ * (e.g. the server shards), while the engine is entered by one thread at a
+ * time: the calls of the engine and its channels are serialized per engine.
+ * Thus, the plugins don't need to synchronize their methods against each
+ * other. The responses and events are still allowed to be sent from any
+ * thread, and the user should not block in their handlers.
  */ 
 
 #include "mrcp_engine_types.h"
@@ -51,30 +58,13 @@ mrcp_engine_channel_t* mrcp_engine_channel_virtual_create(mrcp_engine_t *engine,
 apt_bool_t mrcp_engine_channel_virtual_destroy(mrcp_engine_channel_t *channel);
 
 /** Open engine channel */
-static APR_INLINE apt_bool_t mrcp_engine_channel_virtual_open(mrcp_engine_channel_t *channel)
-{
-	if(channel->is_open == FALSE) {
-		channel->is_open = channel->method_vtable->open(channel);
-		return channel->is_open;
-	}
-	return FALSE;
-}
+apt_bool_t mrcp_engine_channel_virtual_open(mrcp_engine_channel_t *channel);
 
 /** Close engine channel */
-static APR_INLINE apt_bool_t mrcp_engine_channel_virtual_close(mrcp_engine_channel_t *channel)
-{
-	if(channel->is_open == TRUE) {
-		channel->is_open = FALSE;
-		return channel->method_vtable->close(channel);
-	}
-	return FALSE;
-}
+apt_bool_t mrcp_engine_channel_virtual_close(mrcp_engine_channel_t *channel);
 
 /** Process request */
-static APR_INLINE apt_bool_t mrcp_engine_channel_request_process(mrcp_engine_channel_t *channel, mrcp_message_t *message)
-{
-	return channel->method_vtable->process_request(channel,message);
-}
+apt_bool_t mrcp_engine_channel_request_process(mrcp_engine_channel_t *channel, mrcp_message_t *message);
 
 /** Allocate engine config */
 mrcp_engine_config_t* mrcp_engine_config_alloc(apr_pool_t *pool);
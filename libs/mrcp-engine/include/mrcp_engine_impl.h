@@ -105,7 +105,11 @@ static APR_INLINE apt_bool_t mrcp_engine_channel_close_respond(mrcp_engine_chann
 	return channel->event_vtable->on_close(channel);
 }
 
-/** Send response/event message */
+/**
+ * Send response/event message.
+ * @remark Once the final (COMPLETE) response or event is sent, the request and the memory
+ * allocated from its pool may be reused, so the engine must not refer to them anymore.
+ */
 static APR_INLINE apt_bool_t mrcp_engine_channel_message_send(mrcp_engine_channel_t *channel, mrcp_message_t *message)
 {
 	return channel->event_vtable->on_message(channel,message);
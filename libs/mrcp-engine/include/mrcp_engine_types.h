@@ -25,6 +25,7 @@
  */ 
 
 #include <apr_tables.h>
+#include <apr_thread_mutex.h>
 #include "mrcp_state_machine.h"
 #include "mpf_types.h"
 #include "apt_string.h"
@@ -132,10 +133,12 @@ struct mrcp_engine_t {
 	const apt_dir_layout_t            *dir_layout;
 	/** Config of engine */
 	mrcp_engine_config_t              *config;
-	/** Number of simultaneous channels currently in use */
-	apr_size_t                         cur_channel_count;
+	/** Number of simultaneous channels currently in use (updated atomically) */
+	volatile apr_uint32_t              cur_channel_count;
 	/** Is engine successfully opened */
 	apt_bool_t                         is_open;
+	/** Mutex serializing the calls into the engine made from several server shards */
+	apr_thread_mutex_t                *mutex;
 	/** Pool to allocate memory from */
 	apr_pool_t                        *pool;
 
@@ -16,23 +16,47 @@
  * $Id$
  */
 
+#include <apr_atomic.h>
 #include "mrcp_engine_iface.h"
 #include "apt_log.h"
 
+/** Enter the engine (the calls are serialized, since the server may call the engine from several shards) */
+static APR_INLINE void mrcp_engine_enter(mrcp_engine_t *engine)
+{
+	if(engine->mutex) {
+		apr_thread_mutex_lock(engine->mutex);
+	}
+}
+
+/** Leave the engine */
+static APR_INLINE void mrcp_engine_leave(mrcp_engine_t *engine)
+{
+	if(engine->mutex) {
+		apr_thread_mutex_unlock(engine->mutex);
+	}
+}
+
 /** Destroy engine */
 apt_bool_t mrcp_engine_virtual_destroy(mrcp_engine_t *engine)
 {
-	return engine->method_vtable->destroy(engine);
+	apt_bool_t status;
+	mrcp_engine_enter(engine);
+	status = engine->method_vtable->destroy(engine);
+	mrcp_engine_leave(engine);
+	return status;
 }
 
 /** Open engine */
 apt_bool_t mrcp_engine_virtual_open(mrcp_engine_t *engine)
 {
+	apt_bool_t status = FALSE;
+	mrcp_engine_enter(engine);
 	if(engine->is_open == FALSE) {
 		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Open Engine [%s]",engine->id);
-		return engine->method_vtable->open(engine);
+		status = engine->method_vtable->open(engine);
 	}
-	return FALSE;
+	mrcp_engine_leave(engine);
+	return status;
 }
 
 /** Response to open engine request */
@@ -47,12 +71,15 @@ void mrcp_engine_on_open(mrcp_engine_t *engine, apt_bool_t status)
 /** Close engine */
 apt_bool_t mrcp_engine_virtual_close(mrcp_engine_t *engine)
 {
+	apt_bool_t status = FALSE;
+	mrcp_engine_enter(engine);
 	if(engine->is_open == TRUE) {
 		engine->is_open = FALSE;
 		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Close Engine [%s]",engine->id);
-		return engine->method_vtable->close(engine);
+		status = engine->method_vtable->close(engine);
 	}
-	return FALSE;
+	mrcp_engine_leave(engine);
+	return status;
 }
 
 /** Response to close engine request */
@@ -62,32 +89,100 @@ void mrcp_engine_on_close(mrcp_engine_t *engine)
 	engine->is_open = FALSE;
 }
 
+/** Reserve a channel slot (channels may be created from several server shards at once) */
+static apt_bool_t mrcp_engine_channel_count_acquire(mrcp_engine_t *engine)
+{
+	apr_uint32_t count;
+	do {
+		count = apr_atomic_read32(&engine->cur_channel_count);
+		if(engine->config->max_channel_count && count >= engine->config->max_channel_count) {
+			return FALSE;
+		}
+	}
+	while(apr_atomic_cas32(&engine->cur_channel_count,count+1,count) != count);
+	return TRUE;
+}
+
+/** Release the channel slot */
+static void mrcp_engine_channel_count_release(mrcp_engine_t *engine)
+{
+	apr_uint32_t count;
+	do {
+		count = apr_atomic_read32(&engine->cur_channel_count);
+		if(!count) {
+			return;
+		}
+	}
+	while(apr_atomic_cas32(&engine->cur_channel_count,count-1,count) != count);
+}
+
 /** Create engine channel */
 mrcp_engine_channel_t* mrcp_engine_channel_virtual_create(mrcp_engine_t *engine, mrcp_version_e mrcp_version, apr_pool_t *pool)
 {
 	mrcp_engine_channel_t *channel;
-	if(engine->is_open != TRUE) {
+	if(mrcp_engine_channel_count_acquire(engine) == FALSE) {
 		return NULL;
 	}
-	if(engine->config->max_channel_count && engine->cur_channel_count >= engine->config->max_channel_count) {
-		return NULL;
+	mrcp_engine_enter(engine);
+	channel = NULL;
+	if(engine->is_open == TRUE) {
+		channel = engine->method_vtable->create_channel(engine,pool);
 	}
-	channel = engine->method_vtable->create_channel(engine,pool);
-	if(channel) {
-		channel->mrcp_version = mrcp_version;
-		engine->cur_channel_count++;
+	mrcp_engine_leave(engine);
+	if(!channel) {
+		mrcp_engine_channel_count_release(engine);
+		return NULL;
 	}
+	channel->mrcp_version = mrcp_version;
 	return channel;
 }
 
 /** Destroy engine channel */
 apt_bool_t mrcp_engine_channel_virtual_destroy(mrcp_engine_channel_t *channel)
 {
+	apt_bool_t status;
 	mrcp_engine_t *engine = channel->engine;
-	if(engine->cur_channel_count) {
-		engine->cur_channel_count--;
+	mrcp_engine_channel_count_release(engine);
+	mrcp_engine_enter(engine);
+	status = channel->method_vtable->destroy(channel);
+	mrcp_engine_leave(engine);
+	return status;
+}
+
+/** Open engine channel */
+apt_bool_t mrcp_engine_channel_virtual_open(mrcp_engine_channel_t *channel)
+{
+	apt_bool_t status = FALSE;
+	mrcp_engine_enter(channel->engine);
+	if(channel->is_open == FALSE) {
+		channel->is_open = channel->method_vtable->open(channel);
+		status = channel->is_open;
 	}
-	return channel->method_vtable->destroy(channel);
+	mrcp_engine_leave(channel->engine);
+	return status;
+}
+
+/** Close engine channel */
+apt_bool_t mrcp_engine_channel_virtual_close(mrcp_engine_channel_t *channel)
+{
+	apt_bool_t status = FALSE;
+	mrcp_engine_enter(channel->engine);
+	if(channel->is_open == TRUE) {
+		channel->is_open = FALSE;
+		status = channel->method_vtable->close(channel);
+	}
+	mrcp_engine_leave(channel->engine);
+	return status;
+}
+
+/** Process request */
+apt_bool_t mrcp_engine_channel_request_process(mrcp_engine_channel_t *channel, mrcp_message_t *message)
+{
+	apt_bool_t status;
+	mrcp_engine_enter(channel->engine);
+	status = channel->method_vtable->process_request(channel,message);
+	mrcp_engine_leave(channel->engine);
+	return status;
 }
 
 /** Allocate engine config */
@@ -16,6 +16,7 @@
  * $Id$
  */
 
+#include <apr_atomic.h>
 #include "mrcp_engine_impl.h"
 #include "mpf_termination_factory.h"
 
@@ -36,10 +37,14 @@ mrcp_engine_t* mrcp_engine_create(
 	engine->config = NULL;
 	engine->codec_manager = NULL;
 	engine->dir_layout = NULL;
-	engine->cur_channel_count = 0;
+	apr_atomic_set32(&engine->cur_channel_count,0);
 	engine->is_open = FALSE;
+	engine->mutex = NULL;
 	engine->pool = pool;
 	engine->create_state_machine = NULL;
+	if(apr_thread_mutex_create(&engine->mutex,APR_THREAD_MUTEX_DEFAULT,pool) != APR_SUCCESS) {
+		return NULL;
+	}
 	return engine;
 }
 
@@ -28,9 +28,24 @@
 #include "mrcp_engine_iface.h"
 #include "mpf_rtp_descriptor.h"
 #include "apt_task.h"
+#include "apt_consumer_task.h"
 
 APT_BEGIN_EXTERN_C
 
+/** Max number of shards of the server core */
+#define MRCP_SERVER_MAX_SHARD_COUNT 64
+
+/** MRCP server shard statistics */
+typedef struct mrcp_server_shard_stat_t mrcp_server_shard_stat_t;
+
+/** MRCP server shard statistics */
+struct mrcp_server_shard_stat_t {
+	/** Number of sessions currently owned by the shard */
+	apr_size_t               session_count;
+	/** Statistics of the message queue of the shard */
+	apt_consumer_task_stat_t task_stat;
+};
+
 /**
  * Create MRCP server instance.
  * @return the created server instance
@@ -56,6 +71,30 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_shutdown(mrcp_server_t *server);
  */
 MRCP_DECLARE(apt_bool_t) mrcp_server_destroy(mrcp_server_t *server);
 
+/**
+ * Set the number of shards (consumer tasks) to distribute sessions across.
+ * @param server the MRCP server to set the number of shards for
+ * @param shard_count the number of shards
+ * @remark should be called before the server is started; sessions are routed
+ * to the shards by the hash of the session identifier, a session is processed
+ * by the task of its shard only
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_shard_count_set(mrcp_server_t *server, apr_size_t shard_count);
+
+/**
+ * Get the number of shards.
+ * @param server the MRCP server to get the number of shards of
+ */
+MRCP_DECLARE(apr_size_t) mrcp_server_shard_count_get(const mrcp_server_t *server);
+
+/**
+ * Get the statistics of the shard.
+ * @param server the MRCP server to get statistics of
+ * @param id the identifier (index) of the shard
+ * @param stat the statistics to fill
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_shard_stat_get(const mrcp_server_t *server, apr_size_t id, mrcp_server_shard_stat_t *stat);
+
 
 /**
  * Register MRCP resource factory.
@@ -159,6 +198,32 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_profile_register(
 									mrcp_profile_t *profile,
 									apr_table_t *plugin_map);
 
+/**
+ * Get memory pool to allocate RTP settings and profiles from.
+ * @param server the MRCP server to get memory pool from
+ * @remark The pool belongs to the generation of RTP settings and profiles
+ * being loaded, and is destroyed along with the generation.
+ */
+MRCP_DECLARE(apr_pool_t*) mrcp_server_profile_pool_get(const mrcp_server_t *server);
+
+/**
+ * Begin reload of RTP settings and profiles of running server.
+ * @param server the MRCP server to reload RTP settings and profiles of
+ * @remark RTP settings and profiles registered until the reload is ended
+ * make up a new generation, which replaces the current one as a whole.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_profiles_reload_begin(mrcp_server_t *server);
+
+/**
+ * End reload of RTP settings and profiles of running server.
+ * @param server the MRCP server to end reload of RTP settings and profiles of
+ * @param commit whether to swap in (TRUE) or discard (FALSE) the reloaded generation
+ * @remark Established sessions keep using the profiles they have been created with,
+ * only new sessions use the reloaded ones. The previous generation is destroyed
+ * once the last session referencing it is destroyed.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_profiles_reload_end(mrcp_server_t *server, apt_bool_t commit);
+
 /**
  * Load MRCP engine as a plugin.
  * @param server the MRCP server to use
@@ -33,12 +33,17 @@
 
 APT_BEGIN_EXTERN_C
 
+/** Length of the session identifier generated by the server */
+#define MRCP_SESSION_ID_HEX_STRING_LENGTH 16
+
 /** Opaque MRCP channel declaration */
 typedef struct mrcp_channel_t mrcp_channel_t;
 /** MRCP server session declaration */
 typedef struct mrcp_server_session_t mrcp_server_session_t;
 /** MRCP signaling message declaration */
 typedef struct mrcp_signaling_message_t mrcp_signaling_message_t;
+/** Opaque MRCP server shard declaration */
+typedef struct mrcp_server_shard_t mrcp_server_shard_t;
 
 /** Enumeration of signaling task messages */
 typedef enum {
@@ -79,6 +84,8 @@ struct mrcp_server_session_t {
 	mrcp_session_t              base;
 	/** MRCP server */
 	mrcp_server_t              *server;
+	/** Shard of the server the session is processed by */
+	mrcp_server_shard_t        *shard;
 	/** MRCP profile */
 	mrcp_profile_t             *profile;
 
@@ -16,6 +16,8 @@
  * $Id$
  */
 
+#include <apr_atomic.h>
+#include <apr_thread_mutex.h>
 #include "mrcp_server.h"
 #include "mrcp_server_session.h"
 #include "mrcp_message.h"
@@ -33,10 +35,45 @@
 
 #define SERVER_TASK_NAME "MRCP Server"
 
+/** Shard of the server core processing its own subset of sessions */
+struct mrcp_server_shard_t {
+	/** Identifier (index) of the shard */
+	apr_size_t               id;
+	/** Message processing task (the main task for the first shard) */
+	apt_consumer_task_t     *task;
+	/** Table of sessions owned by the shard */
+	apr_hash_t              *session_table;
+	/** Number of sessions owned by the shard */
+	volatile apr_uint32_t    session_count;
+};
+
+/** Generation of RTP settings and profiles, which are loaded and swapped in at once */
+typedef struct mrcp_server_generation_t mrcp_server_generation_t;
+
+/** Generation of RTP settings and profiles */
+struct mrcp_server_generation_t {
+	/** Sequence number of the generation */
+	apr_size_t               id;
+	/** Table of RTP settings (mpf_rtp_settings_t*) */
+	apr_hash_t              *rtp_settings_table;
+	/** Table of profiles (mrcp_profile_t*) */
+	apr_hash_t              *profile_table;
+	/** One reference while the generation is in use, plus one per session created with it */
+	volatile apr_uint32_t    ref_count;
+	/** Memory pool the settings and profiles of the generation are allocated from */
+	apr_pool_t              *pool;
+};
+
 /** MRCP server */
 struct mrcp_server_t {
 	/** Main message processing task */
 	apt_consumer_task_t     *task;
+	/** Signal handler of the main task, which queues messages for processing */
+	apt_bool_t             (*task_msg_signal)(apt_task_t *task, apt_task_msg_t *msg);
+	/** Shards sessions are distributed across */
+	mrcp_server_shard_t    **shards;
+	/** Number of shards */
+	apr_size_t               shard_count;
 
 	/** MRCP resource factory */
 	mrcp_resource_factory_t *resource_factory;
@@ -55,13 +92,14 @@ struct mrcp_server_t {
 	apr_hash_t              *sig_agent_table;
 	/** Table of connection agents (mrcp_connection_agent_t*) */
 	apr_hash_t              *cnt_agent_table;
-	/** Table of RTP settings (mpf_rtp_settings_t*) */
-	apr_hash_t              *rtp_settings_table;
-	/** Table of profiles (mrcp_profile_t*) */
-	apr_hash_t              *profile_table;
-
-	/** Table of sessions */
-	apr_hash_t              *session_table;
+	/** Generation of RTP settings and profiles new sessions are created with */
+	mrcp_server_generation_t *generation;
+	/** Generation of RTP settings and profiles being reloaded */
+	mrcp_server_generation_t *next_generation;
+	/** Mutex guarding the swap of the generation */
+	apr_thread_mutex_t      *generation_mutex;
+	/** Number of generations created */
+	apr_size_t               generation_count;
 
 	/** Connection task message pool */
 	apt_task_msg_pool_t     *connection_msg_pool;
@@ -169,8 +207,10 @@ static void mrcp_server_on_terminate_request(apt_task_t *task);
 static void mrcp_server_on_start_complete(apt_task_t *task);
 static void mrcp_server_on_terminate_complete(apt_task_t *task);
 static apt_bool_t mrcp_server_msg_process(apt_task_t *task, apt_task_msg_t *msg);
+static apt_bool_t mrcp_server_msg_route(apt_task_t *task, apt_task_msg_t *msg);
 
 static mrcp_session_t* mrcp_server_sig_agent_session_create(mrcp_sig_agent_t *signaling_agent);
+static mrcp_server_generation_t* mrcp_server_generation_create(apr_pool_t *parent_pool, apr_size_t id);
 
 
 /** Create MRCP server instance */
@@ -198,13 +238,16 @@ MRCP_DECLARE(mrcp_server_t*) mrcp_server_create(apt_dir_layout_t *dir_layout)
 	server->rtp_factory_table = NULL;
 	server->sig_agent_table = NULL;
 	server->cnt_agent_table = NULL;
-	server->rtp_settings_table = NULL;
-	server->profile_table = NULL;
-	server->session_table = NULL;
+	server->generation = NULL;
+	server->next_generation = NULL;
+	server->generation_mutex = NULL;
+	server->generation_count = 0;
+	server->shards = NULL;
+	server->shard_count = 0;
 	server->connection_msg_pool = NULL;
 	server->engine_msg_pool = NULL;
 
-	msg_pool = apt_task_msg_pool_create_dynamic(0,pool);
+	msg_pool = apt_task_msg_pool_create_static(0,TASK_MSG_POOL_DEFAULT_SIZE,pool);
 
 	server->task = apt_consumer_task_create(server,msg_pool,pool);
 	if(!server->task) {
@@ -220,6 +263,9 @@ MRCP_DECLARE(mrcp_server_t*) mrcp_server_create(apt_dir_layout_t *dir_layout)
 		vtable->on_terminate_request = mrcp_server_on_terminate_request;
 		vtable->on_start_complete = mrcp_server_on_start_complete;
 		vtable->on_terminate_complete = mrcp_server_on_terminate_complete;
+		/* messages are routed to the shards of the sessions they belong to */
+		server->task_msg_signal = vtable->signal_msg;
+		vtable->signal_msg = mrcp_server_msg_route;
 	}
 
 	server->engine_factory = mrcp_engine_factory_create(server->pool);
@@ -227,16 +273,106 @@ MRCP_DECLARE(mrcp_server_t*) mrcp_server_create(apt_dir_layout_t *dir_layout)
 
 	server->media_engine_table = apr_hash_make(server->pool);
 	server->rtp_factory_table = apr_hash_make(server->pool);
-	server->rtp_settings_table = apr_hash_make(server->pool);
 	server->sig_agent_table = apr_hash_make(server->pool);
 	server->cnt_agent_table = apr_hash_make(server->pool);
 
-	server->profile_table = apr_hash_make(server->pool);
+	if(apr_thread_mutex_create(&server->generation_mutex,APR_THREAD_MUTEX_DEFAULT,server->pool) != APR_SUCCESS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Generation Mutex");
+		return NULL;
+	}
+	server->generation = mrcp_server_generation_create(server->pool,++server->generation_count);
+	if(!server->generation) {
+		return NULL;
+	}
 	
-	server->session_table = apr_hash_make(server->pool);
+	mrcp_server_shard_count_set(server,1);
 	return server;
 }
 
+static mrcp_server_shard_t* mrcp_server_shard_create(mrcp_server_t *server, apr_size_t id)
+{
+	apt_task_t *task;
+	apt_task_vtable_t *vtable;
+	apt_task_msg_pool_t *msg_pool;
+	mrcp_server_shard_t *shard = apr_palloc(server->pool,sizeof(mrcp_server_shard_t));
+	shard->id = id;
+	shard->session_table = apr_hash_make(server->pool);
+	apr_atomic_set32(&shard->session_count,0);
+	if(id == 0) {
+		/* the first shard is processed by the main task */
+		shard->task = server->task;
+		return shard;
+	}
+
+	msg_pool = apt_task_msg_pool_create_static(0,TASK_MSG_POOL_DEFAULT_SIZE,server->pool);
+	shard->task = apt_consumer_task_create(server,msg_pool,server->pool);
+	if(!shard->task) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Server Shard Task [%"APR_SIZE_T_FMT"]",id);
+		return NULL;
+	}
+	task = apt_consumer_task_base_get(shard->task);
+	apt_task_name_set(task,apr_psprintf(server->pool,SERVER_TASK_NAME" Shard %"APR_SIZE_T_FMT,id));
+	vtable = apt_task_vtable_get(task);
+	if(vtable) {
+		vtable->process_msg = mrcp_server_msg_process;
+	}
+	/* shard tasks are started and terminated along with the main task */
+	apt_task_add(apt_consumer_task_base_get(server->task),task);
+	return shard;
+}
+
+/** Set the number of shards */
+MRCP_DECLARE(apt_bool_t) mrcp_server_shard_count_set(mrcp_server_t *server, apr_size_t shard_count)
+{
+	apr_size_t i;
+	mrcp_server_shard_t **shards;
+	if(shard_count == 0 || shard_count > MRCP_SERVER_MAX_SHARD_COUNT) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Shard Count [%"APR_SIZE_T_FMT"]",shard_count);
+		return FALSE;
+	}
+	if(shard_count <= server->shard_count) {
+		/* shards can be added, but never removed */
+		return FALSE;
+	}
+
+	shards = apr_palloc(server->pool,shard_count * sizeof(mrcp_server_shard_t*));
+	for(i=0; i<server->shard_count; i++) {
+		shards[i] = server->shards[i];
+	}
+	for(; i<shard_count; i++) {
+		shards[i] = mrcp_server_shard_create(server,i);
+		if(!shards[i]) {
+			return FALSE;
+		}
+	}
+	server->shards = shards;
+	server->shard_count = shard_count;
+	if(shard_count > 1) {
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set Server Shard Count [%"APR_SIZE_T_FMT"]",shard_count);
+	}
+	return TRUE;
+}
+
+/** Get the number of shards */
+MRCP_DECLARE(apr_size_t) mrcp_server_shard_count_get(const mrcp_server_t *server)
+{
+	return server->shard_count;
+}
+
+/** Get the statistics of the shard */
+MRCP_DECLARE(apt_bool_t) mrcp_server_shard_stat_get(const mrcp_server_t *server, apr_size_t id, mrcp_server_shard_stat_t *stat)
+{
+	mrcp_server_shard_t *shard;
+	if(id >= server->shard_count || !stat) {
+		return FALSE;
+	}
+
+	shard = server->shards[id];
+	stat->session_count = apr_atomic_read32(&shard->session_count);
+	apt_consumer_task_stat_get(shard->task,&stat->task_stat);
+	return TRUE;
+}
+
 /** Start message processing loop */
 MRCP_DECLARE(apt_bool_t) mrcp_server_start(mrcp_server_t *server)
 {
@@ -259,6 +395,7 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_shutdown(mrcp_server_t *server)
 {
 	apt_task_t *task;
 	apr_time_t uptime;
+	apr_size_t i;
 	if(!server || !server->task) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Server");
 		return FALSE;
@@ -268,12 +405,46 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_shutdown(mrcp_server_t *server)
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Shutdown Server Task");
 		return FALSE;
 	}
-	server->session_table = NULL;
+	for(i=0; i<server->shard_count; i++) {
+		mrcp_server_shard_stat_t stat;
+		mrcp_server_shard_stat_get(server,i,&stat);
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Server Shard [%"APR_SIZE_T_FMT"] Stats: messages [%u] max queue [%u] avg latency [%u usec] max latency [%u usec]",
+			i,
+			stat.task_stat.msg_count,
+			stat.task_stat.max_queue_size,
+			stat.task_stat.msg_count ? (apr_uint32_t)(stat.task_stat.total_latency / stat.task_stat.msg_count) : 0,
+			stat.task_stat.max_latency);
+		server->shards[i]->session_table = NULL;
+	}
 	uptime = apr_time_now() - server->start_time;
 	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Server Uptime [%"APR_TIME_T_FMT" sec]", apr_time_sec(uptime));
 	return TRUE;
 }
 
+/** Destroy the message pools not owned by tasks, once all the tasks are done */
+static void mrcp_server_msg_pools_destroy(mrcp_server_t *server)
+{
+	apr_hash_index_t *it;
+	void *val;
+	mrcp_sig_agent_t *signaling_agent;
+	for(it = apr_hash_first(server->pool,server->sig_agent_table); it; it = apr_hash_next(it)) {
+		apr_hash_this(it,NULL,NULL,&val);
+		signaling_agent = val;
+		if(signaling_agent && signaling_agent->msg_pool) {
+			apt_task_msg_pool_destroy(signaling_agent->msg_pool);
+			signaling_agent->msg_pool = NULL;
+		}
+	}
+	if(server->connection_msg_pool) {
+		apt_task_msg_pool_destroy(server->connection_msg_pool);
+		server->connection_msg_pool = NULL;
+	}
+	if(server->engine_msg_pool) {
+		apt_task_msg_pool_destroy(server->engine_msg_pool);
+		server->engine_msg_pool = NULL;
+	}
+}
+
 /** Destroy MRCP server */
 MRCP_DECLARE(apt_bool_t) mrcp_server_destroy(mrcp_server_t *server)
 {
@@ -289,6 +460,7 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_destroy(mrcp_server_t *server)
 	task = apt_consumer_task_base_get(server->task);
 	apt_task_destroy(task);
 
+	mrcp_server_msg_pools_destroy(server);
 	apr_pool_destroy(server->pool);
 	return TRUE;
 }
@@ -312,7 +484,7 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_engine_register(mrcp_server_t *server, mrcp
 	}
 	
 	if(!server->engine_msg_pool) {
-		server->engine_msg_pool = apt_task_msg_pool_create_dynamic(sizeof(engine_task_msg_data_t),server->pool);
+		server->engine_msg_pool = apt_task_msg_pool_create_static(sizeof(engine_task_msg_data_t),TASK_MSG_POOL_DEFAULT_SIZE,server->pool);
 	}
 	engine->codec_manager = server->codec_manager;
 	engine->dir_layout = server->dir_layout;
@@ -385,21 +557,30 @@ MRCP_DECLARE(mpf_termination_factory_t*) mrcp_server_rtp_factory_get(const mrcp_
 	return apr_hash_get(server->rtp_factory_table,name,APR_HASH_KEY_STRING);
 }
 
+/** Get generation of RTP settings and profiles being loaded */
+static APR_INLINE mrcp_server_generation_t* mrcp_server_loading_generation_get(const mrcp_server_t *server)
+{
+	return server->next_generation ? server->next_generation : server->generation;
+}
+
 /** Register RTP settings */
 MRCP_DECLARE(apt_bool_t) mrcp_server_rtp_settings_register(mrcp_server_t *server, mpf_rtp_settings_t *rtp_settings, const char *name)
 {
+	mrcp_server_generation_t *generation;
 	if(!rtp_settings || !name) {
 		return FALSE;
 	}
+	generation = mrcp_server_loading_generation_get(server);
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Register RTP Settings [%s]",name);
-	apr_hash_set(server->rtp_settings_table,name,APR_HASH_KEY_STRING,rtp_settings);
+	apr_hash_set(generation->rtp_settings_table,name,APR_HASH_KEY_STRING,rtp_settings);
 	return TRUE;
 }
 
 /** Get RTP settings by name */
 MRCP_DECLARE(mpf_rtp_settings_t*) mrcp_server_rtp_settings_get(const mrcp_server_t *server, const char *name)
 {
-	return apr_hash_get(server->rtp_settings_table,name,APR_HASH_KEY_STRING);
+	mrcp_server_generation_t *generation = mrcp_server_loading_generation_get(server);
+	return apr_hash_get(generation->rtp_settings_table,name,APR_HASH_KEY_STRING);
 }
 
 /** Register MRCP signaling agent */
@@ -412,7 +593,7 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_signaling_agent_register(mrcp_server_t *ser
 	signaling_agent->parent = server;
 	signaling_agent->resource_factory = server->resource_factory;
 	signaling_agent->create_server_session = mrcp_server_sig_agent_session_create;
-	signaling_agent->msg_pool = apt_task_msg_pool_create_dynamic(sizeof(mrcp_signaling_message_t*),server->pool);
+	signaling_agent->msg_pool = apt_task_msg_pool_create_static(sizeof(mrcp_signaling_message_t*),TASK_MSG_POOL_DEFAULT_SIZE,server->pool);
 	apr_hash_set(server->sig_agent_table,signaling_agent->id,APR_HASH_KEY_STRING,signaling_agent);
 	if(server->task) {
 		apt_task_t *task = apt_consumer_task_base_get(server->task);
@@ -441,7 +622,9 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_connection_agent_register(mrcp_server_t *se
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Register Connection Agent [%s]",id);
 	mrcp_server_connection_resource_factory_set(connection_agent,server->resource_factory);
 	mrcp_server_connection_agent_handler_set(connection_agent,server,&connection_method_vtable);
-	server->connection_msg_pool = apt_task_msg_pool_create_dynamic(sizeof(connection_agent_task_msg_data_t),server->pool);
+	if(!server->connection_msg_pool) {
+		server->connection_msg_pool = apt_task_msg_pool_create_static(sizeof(connection_agent_task_msg_data_t),TASK_MSG_POOL_DEFAULT_SIZE,server->pool);
+	}
 	apr_hash_set(server->cnt_agent_table,id,APR_HASH_KEY_STRING,connection_agent);
 	if(server->task) {
 		apt_task_t *task = apt_consumer_task_base_get(server->task);
@@ -457,6 +640,88 @@ MRCP_DECLARE(mrcp_connection_agent_t*) mrcp_server_connection_agent_get(const mr
 	return apr_hash_get(server->cnt_agent_table,name,APR_HASH_KEY_STRING);
 }
 
+/** Create generation of RTP settings and profiles */
+static mrcp_server_generation_t* mrcp_server_generation_create(apr_pool_t *parent_pool, apr_size_t id)
+{
+	mrcp_server_generation_t *generation;
+	apr_pool_t *pool = apt_subpool_create(parent_pool);
+	if(!pool) {
+		return NULL;
+	}
+	generation = apr_palloc(pool,sizeof(mrcp_server_generation_t));
+	generation->id = id;
+	generation->rtp_settings_table = apr_hash_make(pool);
+	generation->profile_table = apr_hash_make(pool);
+	apr_atomic_set32(&generation->ref_count,1);
+	generation->pool = pool;
+	return generation;
+}
+
+/** Release reference to generation, destroy the generation on the last one */
+static void mrcp_server_generation_release(mrcp_server_generation_t *generation)
+{
+	if(apr_atomic_dec32(&generation->ref_count) == 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Destroy Profile Generation [%"APR_SIZE_T_FMT"]",generation->id);
+		apr_pool_destroy(generation->pool);
+	}
+}
+
+/** Release generation referenced by session on destruction of the session pool */
+static apr_status_t mrcp_server_generation_cleanup(void *data)
+{
+	mrcp_server_generation_release(data);
+	return APR_SUCCESS;
+}
+
+/** Get memory pool to allocate RTP settings and profiles from */
+MRCP_DECLARE(apr_pool_t*) mrcp_server_profile_pool_get(const mrcp_server_t *server)
+{
+	mrcp_server_generation_t *generation = mrcp_server_loading_generation_get(server);
+	return generation->pool;
+}
+
+/** Begin reload of RTP settings and profiles */
+MRCP_DECLARE(apt_bool_t) mrcp_server_profiles_reload_begin(mrcp_server_t *server)
+{
+	if(server->next_generation) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Begin Reload: reload is in progress");
+		return FALSE;
+	}
+	server->next_generation = mrcp_server_generation_create(server->pool,++server->generation_count);
+	if(!server->next_generation) {
+		return FALSE;
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Create Profile Generation [%"APR_SIZE_T_FMT"]",server->next_generation->id);
+	return TRUE;
+}
+
+/** End reload of RTP settings and profiles */
+MRCP_DECLARE(apt_bool_t) mrcp_server_profiles_reload_end(mrcp_server_t *server, apt_bool_t commit)
+{
+	mrcp_server_generation_t *generation = server->next_generation;
+	mrcp_server_generation_t *prev_generation;
+	if(!generation) {
+		return FALSE;
+	}
+	server->next_generation = NULL;
+	if(commit == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Discard Profile Generation [%"APR_SIZE_T_FMT"]",generation->id);
+		mrcp_server_generation_release(generation);
+		return TRUE;
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Swap Profile Generation [%"APR_SIZE_T_FMT"] -> [%"APR_SIZE_T_FMT"]",
+		server->generation->id,
+		generation->id);
+	apr_thread_mutex_lock(server->generation_mutex);
+	prev_generation = server->generation;
+	server->generation = generation;
+	apr_thread_mutex_unlock(server->generation_mutex);
+	/* established sessions keep the previous generation until they are destroyed */
+	mrcp_server_generation_release(prev_generation);
+	return TRUE;
+}
+
 /** Create MRCP profile */
 MRCP_DECLARE(mrcp_profile_t*) mrcp_server_profile_create(
 									const char *id,
@@ -487,7 +752,7 @@ static apt_bool_t mrcp_server_engine_table_make(mrcp_server_t *server, mrcp_prof
 	const char *plugin_name = NULL;
 	mrcp_engine_t *engine;
 
-	profile->engine_table = apr_hash_make(server->pool);
+	profile->engine_table = apr_hash_make(mrcp_server_profile_pool_get(server));
 	for(i=0; i<MRCP_RESOURCE_TYPE_COUNT; i++) {
 		resource = mrcp_resource_get(server->resource_factory,i);
 		if(!resource) continue;
@@ -558,14 +823,14 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_profile_register(
 	}
 
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Register Profile [%s]",profile->id);
-	apr_hash_set(server->profile_table,profile->id,APR_HASH_KEY_STRING,profile);
+	apr_hash_set(mrcp_server_loading_generation_get(server)->profile_table,profile->id,APR_HASH_KEY_STRING,profile);
 	return TRUE;
 }
 
 /** Get profile by name */
 MRCP_DECLARE(mrcp_profile_t*) mrcp_server_profile_get(const mrcp_server_t *server, const char *name)
 {
-	return apr_hash_get(server->profile_table,name,APR_HASH_KEY_STRING);
+	return apr_hash_get(server->generation->profile_table,name,APR_HASH_KEY_STRING);
 }
 
 /** Load MRCP engine */
@@ -593,25 +858,117 @@ MRCP_DECLARE(apr_pool_t*) mrcp_server_memory_pool_get(const mrcp_server_t *serve
 	return server->pool;
 }
 
+static APR_INLINE mrcp_server_shard_t* mrcp_server_shard_get(mrcp_server_t *server, const apt_str_t *session_id)
+{
+	apr_ssize_t length = session_id->length;
+	if(server->shard_count == 1) {
+		return server->shards[0];
+	}
+	return server->shards[apr_hashfunc_default(session_id->buf,&length) % server->shard_count];
+}
+
+/** Assign the session to the shard (invoked from the context of the signaling agent) */
+static void mrcp_server_session_shard_assign(mrcp_server_session_t *session)
+{
+	if(!session->base.id.length) {
+		/* the shard is selected by the session id, so generate it in advance */
+		apt_unique_id_generate(&session->base.id,MRCP_SESSION_ID_HEX_STRING_LENGTH,session->base.pool);
+	}
+	session->shard = mrcp_server_shard_get(session->server,&session->base.id);
+	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Assign Session "APT_SID_FMT" to Shard [%"APR_SIZE_T_FMT"]",
+		MRCP_SESSION_SID(&session->base),
+		session->shard->id);
+}
+
 void mrcp_server_session_add(mrcp_server_session_t *session)
 {
+	mrcp_server_shard_t *shard = session->shard ? session->shard : session->server->shards[0];
 	if(session->base.id.buf) {
 		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Add Session "APT_SID_FMT,MRCP_SESSION_SID(&session->base));
-		apr_hash_set(session->server->session_table,session->base.id.buf,session->base.id.length,session);
+		apr_hash_set(shard->session_table,session->base.id.buf,session->base.id.length,session);
+		apr_atomic_inc32(&shard->session_count);
 	}
 }
 
 void mrcp_server_session_remove(mrcp_server_session_t *session)
 {
+	mrcp_server_shard_t *shard = session->shard ? session->shard : session->server->shards[0];
 	if(session->base.id.buf) {
 		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Remove Session "APT_SID_FMT,MRCP_SESSION_SID(&session->base));
-		apr_hash_set(session->server->session_table,session->base.id.buf,session->base.id.length,NULL);
+		if(apr_hash_get(shard->session_table,session->base.id.buf,session->base.id.length)) {
+			apr_hash_set(shard->session_table,session->base.id.buf,session->base.id.length,NULL);
+			apr_atomic_dec32(&shard->session_count);
+		}
 	}
 }
 
 static APR_INLINE mrcp_server_session_t* mrcp_server_session_find(mrcp_server_t *server, const apt_str_t *session_id)
 {
-	return apr_hash_get(server->session_table,session_id->buf,session_id->length);
+	mrcp_server_shard_t *shard = mrcp_server_shard_get(server,session_id);
+	return apr_hash_get(shard->session_table,session_id->buf,session_id->length);
+}
+
+/** Get the shard the task message should be processed by */
+static mrcp_server_shard_t* mrcp_server_msg_shard_get(mrcp_server_t *server, apt_task_msg_t *msg)
+{
+	mrcp_server_session_t *session = NULL;
+	switch(msg->type) {
+		case MRCP_SERVER_SIGNALING_TASK_MSG:
+		{
+			mrcp_signaling_message_t **signaling_message = (mrcp_signaling_message_t**) msg->data;
+			session = (*signaling_message)->session;
+			break;
+		}
+		case MRCP_SERVER_CONNECTION_TASK_MSG:
+		{
+			const connection_agent_task_msg_data_t *data = (const connection_agent_task_msg_data_t*)msg->data;
+			if(data->channel) {
+				session = (mrcp_server_session_t*) mrcp_server_channel_session_get(data->channel);
+			}
+			break;
+		}
+		case MRCP_SERVER_ENGINE_TASK_MSG:
+		{
+			/* engine open/close messages are processed by the main task */
+			const engine_task_msg_data_t *data = (const engine_task_msg_data_t*)msg->data;
+			if(data->channel) {
+				session = (mrcp_server_session_t*) mrcp_server_channel_session_get(data->channel);
+			}
+			break;
+		}
+		case MRCP_SERVER_MEDIA_TASK_MSG:
+		{
+			/* all the messages in the container belong to the same context */
+			const mpf_message_container_t *container = (const mpf_message_container_t*) msg->data;
+			if(container->count && container->messages[0].context) {
+				session = mpf_engine_context_object_get(container->messages[0].context);
+			}
+			break;
+		}
+		default:
+			/* core task messages are processed by the main task */
+			break;
+	}
+
+	if(session && session->shard) {
+		return session->shard;
+	}
+	return server->shards[0];
+}
+
+static apt_bool_t mrcp_server_msg_route(apt_task_t *task, apt_task_msg_t *msg)
+{
+	apt_consumer_task_t *consumer_task = apt_task_object_get(task);
+	mrcp_server_t *server = apt_consumer_task_object_get(consumer_task);
+	mrcp_server_shard_t *shard = server->shards[0];
+	if(server->shard_count > 1) {
+		shard = mrcp_server_msg_shard_get(server,msg);
+	}
+
+	if(shard->task == server->task) {
+		return server->task_msg_signal(task,msg);
+	}
+	return apt_task_msg_signal(apt_consumer_task_base_get(shard->task),msg);
 }
 
 static void mrcp_server_on_start_request(apt_task_t *task)
@@ -751,14 +1108,21 @@ static apt_bool_t mrcp_server_msg_process(apt_task_t *task, apt_task_msg_t *msg)
 static apt_bool_t mrcp_server_signaling_task_msg_signal(mrcp_signaling_message_type_e type, mrcp_session_t *session, mrcp_session_descriptor_t *descriptor, mrcp_message_t *message)
 {
 	mrcp_signaling_message_t *signaling_message;
-	apt_task_msg_t *task_msg = apt_task_msg_acquire(session->signaling_agent->msg_pool);
-	mrcp_signaling_message_t **slot = ((mrcp_signaling_message_t**)task_msg->data);
+	apt_task_msg_t *task_msg;
+	mrcp_signaling_message_t **slot;
+	mrcp_server_session_t *server_session = (mrcp_server_session_t*)session;
+	if(!server_session->shard) {
+		mrcp_server_session_shard_assign(server_session);
+	}
+
+	task_msg = apt_task_msg_acquire(session->signaling_agent->msg_pool);
+	slot = ((mrcp_signaling_message_t**)task_msg->data);
 	task_msg->type = MRCP_SERVER_SIGNALING_TASK_MSG;
 	task_msg->sub_type = type;
 	
 	signaling_message = apr_palloc(session->pool,sizeof(mrcp_signaling_message_t));
 	signaling_message->type = type;
-	signaling_message->session = (mrcp_server_session_t*)session;
+	signaling_message->session = server_session;
 	signaling_message->descriptor = descriptor;
 	signaling_message->channel = NULL;
 	signaling_message->message = message;
@@ -836,9 +1200,18 @@ static apt_bool_t mrcp_server_channel_task_msg_signal(
 static mrcp_profile_t* mrcp_server_profile_get_by_agent(mrcp_server_t *server, mrcp_server_session_t *session, mrcp_sig_agent_t *signaling_agent)
 {
 	mrcp_profile_t *profile;
+	mrcp_server_generation_t *generation;
 	apr_hash_index_t *it;
 	void *val;
-	it = apr_hash_first(session->base.pool,server->profile_table);
+
+	/* the session keeps the generation, its profile belongs to, until the session is destroyed */
+	apr_thread_mutex_lock(server->generation_mutex);
+	generation = server->generation;
+	apr_atomic_inc32(&generation->ref_count);
+	apr_thread_mutex_unlock(server->generation_mutex);
+	apr_pool_cleanup_register(session->base.pool,generation,mrcp_server_generation_cleanup,apr_pool_cleanup_null);
+
+	it = apr_hash_first(session->base.pool,generation->profile_table);
 	for(; it; it = apr_hash_next(it)) {
 		apr_hash_this(it,NULL,NULL,&val);
 		profile = val;
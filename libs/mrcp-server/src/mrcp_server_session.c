@@ -36,8 +36,6 @@
 #define MRCP_SESSION_NAMESID(session) \
 	session->base.name, MRCP_SESSION_SID(&session->base)
 
-#define MRCP_SESSION_ID_HEX_STRING_LENGTH 16
-
 struct mrcp_channel_t {
 	/** Memory pool */
 	apr_pool_t             *pool;
@@ -59,6 +57,8 @@ struct mrcp_channel_t {
 	apt_bool_t              waiting_for_channel;
 	/** waiting state of media termination */
 	apt_bool_t              waiting_for_termination;
+	/** final messages of the requests completed while processing the current message */
+	apr_array_header_t     *completed_messages;
 };
 
 typedef struct mrcp_termination_slot_t mrcp_termination_slot_t;
@@ -102,6 +102,7 @@ static apt_bool_t state_machine_on_deactivate(mrcp_state_machine_t *state_machin
 mrcp_server_session_t* mrcp_server_session_create()
 {
 	mrcp_server_session_t *session = (mrcp_server_session_t*) mrcp_session_create(sizeof(mrcp_server_session_t)-sizeof(mrcp_session_t));
+	session->shard = NULL;
 	session->context = NULL;
 	session->terminations = apr_array_make(session->base.pool,2,sizeof(mrcp_termination_slot_t));
 	session->channels = apr_array_make(session->base.pool,2,sizeof(mrcp_channel_t*));
@@ -165,6 +166,7 @@ static mrcp_channel_t* mrcp_server_channel_create(mrcp_server_session_t *session
 	channel->cmid_arr = cmid_arr;
 	channel->waiting_for_channel = FALSE;
 	channel->waiting_for_termination = FALSE;
+	channel->completed_messages = apr_array_make(pool,1,sizeof(mrcp_message_t*));
 
 	if(resource_name && resource_name->buf) {
 		mrcp_resource_t *resource;
@@ -208,6 +210,27 @@ static mrcp_channel_t* mrcp_server_channel_create(mrcp_server_session_t *session
 	return channel;
 }
 
+/** Release the requests completed while processing the current message, nothing refers to them anymore */
+static void mrcp_server_session_completed_release(mrcp_server_session_t *session)
+{
+	mrcp_channel_t *channel;
+	mrcp_message_t *message;
+	int i, j;
+	for(i=0; i<session->channels->nelts; i++) {
+		channel = APR_ARRAY_IDX(session->channels,i,mrcp_channel_t*);
+		if(!channel || !channel->completed_messages->nelts) continue;
+
+		/* once the removal is requested, the rest is released along with the control channel */
+		if(channel->control_channel && session->state != SESSION_STATE_TERMINATING) {
+			for(j=0; j<channel->completed_messages->nelts; j++) {
+				message = APR_ARRAY_IDX(channel->completed_messages,j,mrcp_message_t*);
+				mrcp_server_control_message_release(channel->control_channel,message);
+			}
+		}
+		apr_array_clear(channel->completed_messages);
+	}
+}
+
 static APR_INLINE void mrcp_server_session_state_set(mrcp_server_session_t *session, mrcp_server_session_state_e state)
 {
 	if(session->subrequest_count != 0) {
@@ -307,13 +330,16 @@ apt_bool_t mrcp_server_on_channel_message(mrcp_channel_t *channel, mrcp_message_
 {
 	mrcp_server_session_t *session = (mrcp_server_session_t*)channel->session;
 	mrcp_signaling_message_t *signaling_message;
+	apt_bool_t status;
 	signaling_message = apr_palloc(session->base.pool,sizeof(mrcp_signaling_message_t));
 	signaling_message->type = SIGNALING_MESSAGE_CONTROL;
 	signaling_message->session = session;
 	signaling_message->descriptor = NULL;
 	signaling_message->channel = channel;
 	signaling_message->message = message;
-	return mrcp_server_signaling_message_process(signaling_message);
+	status = mrcp_server_signaling_message_process(signaling_message);
+	mrcp_server_session_completed_release(session);
+	return status;
 }
 
 apt_bool_t mrcp_server_on_disconnect(mrcp_channel_t *channel)
@@ -348,11 +374,14 @@ apt_bool_t mrcp_server_on_engine_channel_close(mrcp_channel_t *channel)
 
 apt_bool_t mrcp_server_on_engine_channel_message(mrcp_channel_t *channel, mrcp_message_t *message)
 {
+	apt_bool_t status;
 	if(!channel->state_machine) {
 		return FALSE;
 	}
 	/* update state machine */
-	return mrcp_state_machine_update(channel->state_machine,message);
+	status = mrcp_state_machine_update(channel->state_machine,message);
+	mrcp_server_session_completed_release((mrcp_server_session_t*)channel->session);
+	return status;
 }
 
 
@@ -1160,6 +1189,9 @@ static apt_bool_t state_machine_on_message_dispatch(mrcp_state_machine_t *state_
 		if(channel->control_channel) {
 			/* MRCPv2 */
 			mrcp_server_control_message_send(channel->control_channel,message);
+			if(message->start_line.request_state == MRCP_REQUEST_STATE_COMPLETE) {
+				APR_ARRAY_PUSH(channel->completed_messages,mrcp_message_t*) = message;
+			}
 		}
 		else {
 			/* MRCPv1 */
@@ -1176,6 +1208,9 @@ static apt_bool_t state_machine_on_message_dispatch(mrcp_state_machine_t *state_
 		if(channel->control_channel) {
 			/* MRCPv2 */
 			mrcp_server_control_message_send(channel->control_channel,message);
+			if(message->start_line.request_state == MRCP_REQUEST_STATE_COMPLETE) {
+				APR_ARRAY_PUSH(channel->completed_messages,mrcp_message_t*) = message;
+			}
 		}
 		else {
 			/* MRCPv1 */
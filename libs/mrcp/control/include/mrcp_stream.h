@@ -45,6 +45,18 @@ MRCP_DECLARE(void) mrcp_parser_resource_set(mrcp_parser_t *parser, const apt_str
 /** Set verbose mode for the parser */
 MRCP_DECLARE(void) mrcp_parser_verbose_set(mrcp_parser_t *parser, apt_bool_t verbose);
 
+/** Set pool to allocate the next parsed messages from */
+MRCP_DECLARE(void) mrcp_parser_pool_set(mrcp_parser_t *parser, apr_pool_t *pool);
+
+/** Get the remaining part of the body to receive directly into (0 if no body is awaited) */
+MRCP_DECLARE(apr_size_t) mrcp_parser_body_remaining_get(mrcp_parser_t *parser, char **buf);
+
+/** Advance the body by the length received directly */
+MRCP_DECLARE(void) mrcp_parser_body_advance(mrcp_parser_t *parser, apr_size_t length);
+
+/** Get the number of body bytes copied from the stream for the last parsed message */
+MRCP_DECLARE(apr_size_t) mrcp_parser_copied_length_get(const mrcp_parser_t *parser);
+
 /** Parse MRCP stream */
 MRCP_DECLARE(apt_message_status_e) mrcp_parser_run(mrcp_parser_t *parser, apt_text_stream_t *stream, mrcp_message_t **message);
 
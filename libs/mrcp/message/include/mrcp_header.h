@@ -98,7 +98,12 @@ MRCP_DECLARE(apt_bool_t) mrcp_header_fields_set(mrcp_message_header_t *header, c
 /** Get (copy) MRCP header fields */
 MRCP_DECLARE(apt_bool_t) mrcp_header_fields_get(mrcp_message_header_t *header, const mrcp_message_header_t *src_header, const mrcp_message_header_t *mask_header, apr_pool_t *pool);
 
-/** Inherit (copy) MRCP header fields */
+/**
+ * Inherit (share) MRCP header fields.
+ * @remark the header fields, which are not set yet, reference the values of the source header
+ * rather than copy them; values set by mrcp_header_fields_set() are replaced, never modified
+ * in place, so an inheriting header keeps a consistent snapshot of the source header
+ */
 MRCP_DECLARE(apt_bool_t) mrcp_header_fields_inherit(mrcp_message_header_t *header, const mrcp_message_header_t *src_header, apr_pool_t *pool);
 
 /** Parse MRCP header fields */
@@ -39,6 +39,11 @@ static const apt_str_table_item_t generic_header_string_table[] = {
 	{{"Set-Cookie2",               11},10}
 };
 
+/** Perfect hash of generic header fields (generated by strtablegen) */
+static const apr_uint16_t generic_header_string_table_hash_seeds[] = {2,1,25,5,0,10,1,0,2,1,0,0,0,11,0,2};
+static const apr_uint16_t generic_header_string_table_hash_ids[] = {14,11,12,3,1,2,10,15,4,8,9,6,7,13,0,5};
+static const apt_str_table_hash_t generic_header_string_table_hash = {{-4,0,0,0},1,generic_header_string_table_hash_seeds,generic_header_string_table_hash_ids,16};
+
 /** Parse mrcp request-id list */
 static apt_bool_t mrcp_request_id_list_parse(mrcp_request_id_list_t *request_id_list, const apt_str_t *value)
 {
@@ -302,7 +307,8 @@ static const mrcp_header_vtable_t vtable = {
 	mrcp_generic_header_generate,
 	mrcp_generic_header_duplicate,
 	generic_header_string_table,
-	GENERIC_HEADER_COUNT
+	GENERIC_HEADER_COUNT,
+	&generic_header_string_table_hash
 };
 
 
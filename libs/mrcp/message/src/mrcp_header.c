@@ -142,7 +142,8 @@ MRCP_DECLARE(apt_bool_t) mrcp_header_fields_set(mrcp_message_header_t *header, c
 
 		header_field = apt_header_section_field_get(&header->header_section,src_header_field->id);
 		if(header_field) {
-			/* this header field has already been set, just copy its value */
+			/* this header field has already been set, just copy its value;
+			the previous value is replaced, not overwritten, since it might be shared by inherited header fields */
 			apt_string_copy(&header_field->value,&src_header_field->value,pool);
 		}
 		else {
@@ -190,7 +191,7 @@ MRCP_DECLARE(apt_bool_t) mrcp_header_fields_get(mrcp_message_header_t *header, c
 	return TRUE;
 }
 
-/** Inherit (copy) MRCP header fields */
+/** Inherit (share) MRCP header fields */
 MRCP_DECLARE(apt_bool_t) mrcp_header_fields_inherit(mrcp_message_header_t *header, const mrcp_message_header_t *src_header, apr_pool_t *pool)
 {
 	apt_header_field_t *header_field;
@@ -205,9 +206,19 @@ MRCP_DECLARE(apt_bool_t) mrcp_header_fields_inherit(mrcp_message_header_t *heade
 			continue;
 		}
 
-		/* copy the entire header field and add it to the header section */
-		header_field = apt_header_field_copy(src_header_field,pool);
-		mrcp_header_accessor_value_duplicate(header,header_field,src_header,src_header_field,pool);
+		/* values of the source header are replaced but never modified in place (see mrcp_header_fields_set),
+		so the header field can reference them rather than copy */
+		header_field = apt_header_field_share(src_header_field,pool);
+		if(header_field->id == GENERIC_HEADER_VENDOR_SPECIFIC_PARAMS) {
+			const mrcp_generic_header_t *src_generic_header = src_header->generic_header_accessor.data;
+			mrcp_generic_header_t *generic_header = mrcp_header_allocate(&header->generic_header_accessor,pool);
+			if(generic_header && src_generic_header) {
+				generic_header->vendor_specific_params = src_generic_header->vendor_specific_params;
+			}
+		}
+		else {
+			mrcp_header_accessor_value_duplicate(header,header_field,src_header,src_header_field,pool);
+		}
 		apt_header_section_field_add(&header->header_section,header_field);
 	}
 	return TRUE;
@@ -67,6 +67,11 @@ static const apt_str_table_item_t v1_recog_header_string_table[] = {
 	{{"Abort-Phrase-Enrollment",          23},0}
 };
 
+/** Perfect hash of MRCPv1 recognizer header fields (generated by strtablegen) */
+static const apr_uint16_t v1_recog_header_string_table_hash_seeds[] = {4,1,0,3,1,6,3,2,0,1,1,0,0,0,9,1,2,3,2,1,2,0,8,0,3,2,0,3,2,0,0,5,1,0,0,1,9,7,1,12,0,6,44,16,22};
+static const apr_uint16_t v1_recog_header_string_table_hash_ids[] = {14,34,25,26,43,4,2,24,19,20,8,28,44,32,10,22,0,30,7,3,12,37,23,17,41,40,36,21,15,16,39,5,13,31,29,6,42,38,11,35,18,1,9,33,27};
+static const apt_str_table_hash_t v1_recog_header_string_table_hash = {{3,-2,9,0},3,v1_recog_header_string_table_hash_seeds,v1_recog_header_string_table_hash_ids,45};
+
 /** String table of MRCPv2 recognizer header fields (mrcp_recog_header_id) */
 static const apt_str_table_item_t v2_recog_header_string_table[] = {
 	{{"Confidence-Threshold",             20},16},
@@ -116,6 +121,11 @@ static const apt_str_table_item_t v2_recog_header_string_table[] = {
 	{{"Abort-Phrase-Enrollment",          23},0}
 };
 
+/** Perfect hash of MRCPv2 recognizer header fields (generated by strtablegen) */
+static const apr_uint16_t v2_recog_header_string_table_hash_seeds[] = {3,1,0,3,1,6,3,2,0,1,1,0,0,0,9,1,2,3,2,1,2,0,8,0,3,2,0,3,1,0,0,35,6,0,0,1,9,0,1,10,0,6,72,17,22};
+static const apr_uint16_t v2_recog_header_string_table_hash_ids[] = {1,41,25,26,43,4,2,24,19,20,8,16,44,32,10,22,9,30,7,3,12,37,23,17,14,40,36,34,15,21,39,5,13,31,29,6,42,38,11,35,18,28,0,33,27};
+static const apt_str_table_hash_t v2_recog_header_string_table_hash = {{3,-2,9,0},3,v2_recog_header_string_table_hash_seeds,v2_recog_header_string_table_hash_ids,45};
+
 /** String table of MRCPv1 recognizer completion-cause fields (mrcp_recog_completion_cause_e) */
 static const apt_str_table_item_t v1_completion_cause_string_table[] = {
 	{{"success",                     7},1},
@@ -749,7 +759,8 @@ static const mrcp_header_vtable_t v1_vtable = {
 	mrcp_v1_recog_header_generate,
 	mrcp_recog_header_duplicate,
 	v1_recog_header_string_table,
-	RECOGNIZER_HEADER_COUNT
+	RECOGNIZER_HEADER_COUNT,
+	&v1_recog_header_string_table_hash
 };
 
 static const mrcp_header_vtable_t v2_vtable = {
@@ -759,7 +770,8 @@ static const mrcp_header_vtable_t v2_vtable = {
 	mrcp_v2_recog_header_generate,
 	mrcp_recog_header_duplicate,
 	v2_recog_header_string_table,
-	RECOGNIZER_HEADER_COUNT
+	RECOGNIZER_HEADER_COUNT,
+	&v2_recog_header_string_table_hash
 };
 
 const mrcp_header_vtable_t* mrcp_recog_header_vtable_get(mrcp_version_e version)
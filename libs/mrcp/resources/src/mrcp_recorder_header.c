@@ -37,6 +37,11 @@ static const apt_str_table_item_t recorder_header_string_table[] = {
 	{{"New-Audio-Channel",    17},2}
 };
 
+/** Perfect hash of recorder header fields (generated by strtablegen) */
+static const apr_uint16_t recorder_header_string_table_hash_seeds[] = {1,1,1,0,0,0,0,3,5,28,4,1,5,0,1};
+static const apr_uint16_t recorder_header_string_table_hash_ids[] = {13,7,9,1,10,0,3,12,2,4,11,14,8,5,6};
+static const apt_str_table_hash_t recorder_header_string_table_hash = {{2,0,0,0},1,recorder_header_string_table_hash_seeds,recorder_header_string_table_hash_ids,15};
+
 /** String table of recorder completion-cause fields (mrcp_recorder_completion_cause_e) */
 static const apt_str_table_item_t completion_cause_string_table[] = {
 	{{"success-silence",  15},8},
@@ -266,7 +271,8 @@ static const mrcp_header_vtable_t vtable = {
 	mrcp_recorder_header_generate,
 	mrcp_recorder_header_duplicate,
 	recorder_header_string_table,
-	RECORDER_HEADER_COUNT
+	RECORDER_HEADER_COUNT,
+	&recorder_header_string_table_hash
 };
 
 const mrcp_header_vtable_t* mrcp_recorder_header_vtable_get(mrcp_version_e version)
@@ -43,6 +43,11 @@ static const apt_str_table_item_t synth_header_string_table[] = {
 	{{"Lexicon-Search-Order",20},2}
 };
 
+/** Perfect hash of synthesizer header fields (generated by strtablegen) */
+static const apr_uint16_t synth_header_string_table_hash_seeds[] = {0,0,0,2,0,2,1,3,1,0,1,2,11,2,0,4,6,2,0,25,0};
+static const apr_uint16_t synth_header_string_table_hash_ids[] = {7,20,14,5,18,0,2,11,1,17,12,8,3,16,15,19,13,4,10,9,6};
+static const apt_str_table_hash_t synth_header_string_table_hash = {{6,0,0,0},1,synth_header_string_table_hash_seeds,synth_header_string_table_hash_ids,21};
+
 /** String table of MRCP speech-unit fields (mrcp_speech_unit_t) */
 static const apt_str_table_item_t speech_unit_string_table[] = {
 	{{"Second",   6},2},
@@ -562,7 +567,8 @@ static const mrcp_header_vtable_t vtable = {
 	mrcp_synth_header_generate,
 	mrcp_synth_header_duplicate,
 	synth_header_string_table,
-	SYNTHESIZER_HEADER_COUNT
+	SYNTHESIZER_HEADER_COUNT,
+	&synth_header_string_table_hash
 };
 
 const mrcp_header_vtable_t* mrcp_synth_header_vtable_get(mrcp_version_e version)
@@ -43,6 +43,11 @@ static const apt_str_table_item_t verifier_header_string_table[] = {
 	{{"Start-Input-Timers",          18},1}
 };
 
+/** Perfect hash of verifier header fields (generated by strtablegen) */
+static const apr_uint16_t verifier_header_string_table_hash_seeds[] = {1,0,2,0,0,2,0,1,3,0,1,2,5,2,10,31,0,0,24,1,0};
+static const apr_uint16_t verifier_header_string_table_hash_ids[] = {19,11,4,10,8,1,17,2,13,12,3,5,6,20,7,15,14,18,0,9,16};
+static const apt_str_table_hash_t verifier_header_string_table_hash = {{2,5,0,0},2,verifier_header_string_table_hash_seeds,verifier_header_string_table_hash_ids,21};
+
 /** String table of MRCP verifier completion-cause fields (mrcp_verifier_completion_cause_e) */
 static const apt_str_table_item_t completion_cause_string_table[] = {
 	{{"success",                 7},2},
@@ -337,7 +342,8 @@ static const mrcp_header_vtable_t header_vtable = {
 	mrcp_verifier_header_generate,
 	mrcp_verifier_header_duplicate,
 	verifier_header_string_table,
-	VERIFIER_HEADER_COUNT
+	VERIFIER_HEADER_COUNT,
+	&verifier_header_string_table_hash
 };
 
 const mrcp_header_vtable_t* mrcp_verifier_header_vtable_get(mrcp_version_e version)
@@ -34,6 +34,11 @@ APT_BEGIN_EXTERN_C
 
 /** Size of the buffer used for MRCP rx/tx stream */
 #define MRCP_STREAM_BUFFER_SIZE 1024
+/** Max size the rx buffer may grow up to, if a start line and header section do not fit */
+#define MRCP_STREAM_BUFFER_MAX_SIZE 65536
+
+/** Index of MRCPv2 connections by remote address */
+typedef struct mrcp_connection_index_t mrcp_connection_index_t;
 
 /** MRCPv2 connection */
 struct mrcp_connection_t {
@@ -60,6 +65,8 @@ struct mrcp_connection_t {
 	apr_size_t        access_count;
 	/** Agent list element */
 	apt_list_elem_t  *it;
+	/** Next connection to the same remote IP in the index */
+	mrcp_connection_t *index_next;
 	/** Opaque agent */
 	void             *agent;
 
@@ -74,6 +81,16 @@ struct mrcp_connection_t {
 	apt_text_stream_t rx_stream;
 	/** MRCP parser to parser MRCP messages out of rx stream */
 	mrcp_parser_t    *parser;
+	/** Arena the message being parsed is allocated from */
+	mrcp_message_arena_t *rx_arena;
+	/** Number of received messages retained by the channels */
+	apr_size_t        retained_message_count;
+	/** Number of bytes of received messages retained by the channels */
+	apr_size_t        retained_bytes;
+	/** Number of received body bytes copied from the rx stream */
+	apr_size_t        rx_copied_bytes;
+	/** Number of received body bytes received directly into the messages */
+	apr_size_t        rx_direct_bytes;
 
 	/** Tx buffer */
 	char             *tx_buffer;
@@ -101,6 +118,22 @@ apt_bool_t mrcp_connection_channel_remove(mrcp_connection_t *connection, mrcp_co
 /** Raise disconnect event for each channel from the specified connection. */
 apt_bool_t mrcp_connection_disconnect_raise(mrcp_connection_t *connection, const mrcp_connection_event_vtable_t *vtable);
 
+
+/** Create index of connections by remote address. */
+mrcp_connection_index_t* mrcp_connection_index_create(apr_pool_t *pool);
+
+/** Add connection to the index (remote IP must be set). */
+apt_bool_t mrcp_connection_index_add(mrcp_connection_index_t *index, mrcp_connection_t *connection);
+
+/** Remove connection from the index. */
+apt_bool_t mrcp_connection_index_remove(mrcp_connection_index_t *index, mrcp_connection_t *connection);
+
+/** Find connection by remote IP and port (any connection to the remote IP, if port is 0). */
+mrcp_connection_t* mrcp_connection_index_find(const mrcp_connection_index_t *index, const apt_str_t *remote_ip, apr_port_t port);
+
+/** Get the number of connections in the index. */
+apr_size_t mrcp_connection_index_count_get(const mrcp_connection_index_t *index);
+
 APT_END_EXTERN_C
 
 #endif /* MRCP_CONNECTION_H */
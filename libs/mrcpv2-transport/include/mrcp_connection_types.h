@@ -43,6 +43,9 @@ typedef struct mrcp_control_channel_t mrcp_control_channel_t;
 /** Opaque MRCPv2 connection agent declaration */
 typedef struct mrcp_connection_agent_t mrcp_connection_agent_t;
 
+/** Opaque arena a received MRCPv2 message is allocated from */
+typedef struct mrcp_message_arena_t mrcp_message_arena_t;
+
 /** MRCPv2 connection event vtable declaration */
 typedef struct mrcp_connection_event_vtable_t mrcp_connection_event_vtable_t;
 
@@ -80,6 +83,13 @@ struct mrcp_control_channel_t {
 	apr_pool_t              *pool;
 	/** Channel identifier (id at resource) */
 	apt_str_t                identifier;
+
+	/** Arenas of the requests in progress received through the channel (the rest is released on destroy) */
+	mrcp_message_arena_t    *arenas;
+	/** Number of arenas (messages) accounted to the connection */
+	apr_size_t               arena_count;
+	/** Number of bytes parsed into the arenas accounted to the connection */
+	apr_size_t               arena_bytes;
 };
 
 /** Send channel add response */
@@ -169,6 +169,15 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_control_channel_destroy(mrcp_control_channe
  */
 MRCP_DECLARE(apt_bool_t) mrcp_server_control_message_send(mrcp_control_channel_t *channel, mrcp_message_t *message);
 
+/**
+ * Release MRCPv2 request the final response or event has been sent for.
+ * @param channel the control channel the request has been received through
+ * @param message the final message sent for the request
+ * @remark The memory of the request, including the messages allocated from its pool,
+ * is reused then, so the message must be released once it's not referenced anymore.
+ */
+MRCP_DECLARE(apt_bool_t) mrcp_server_control_message_release(mrcp_control_channel_t *channel, mrcp_message_t *message);
+
 
 APT_END_EXTERN_C
 
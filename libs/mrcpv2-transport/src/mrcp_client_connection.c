@@ -32,6 +32,7 @@ struct mrcp_connection_agent_t {
 	const mrcp_resource_factory_t        *resource_factory;
 
 	apt_obj_list_t                       *connection_list;
+	mrcp_connection_index_t              *connection_index;
 
 	apr_uint32_t                          request_timeout;
 	apt_bool_t                            offer_new_connection;
@@ -84,7 +85,7 @@ MRCP_DECLARE(mrcp_connection_agent_t*) mrcp_client_connection_agent_create(
 	agent->rx_buffer_size = MRCP_STREAM_BUFFER_SIZE;
 	agent->tx_buffer_size = MRCP_STREAM_BUFFER_SIZE;
 
-	msg_pool = apt_task_msg_pool_create_dynamic(sizeof(connection_task_msg_t),pool);
+	msg_pool = apt_task_msg_pool_create_static(sizeof(connection_task_msg_t),TASK_MSG_POOL_DEFAULT_SIZE,pool);
 
 	agent->task = apt_poller_task_create(
 					max_connection_count,
@@ -107,6 +108,7 @@ MRCP_DECLARE(mrcp_connection_agent_t*) mrcp_client_connection_agent_create(
 	}
 
 	agent->connection_list = apt_list_create(pool);
+	agent->connection_index = mrcp_connection_index_create(pool);
 	return agent;
 }
 
@@ -209,6 +211,9 @@ MRCP_DECLARE(mrcp_control_channel_t*) mrcp_client_control_channel_create(mrcp_co
 	channel->removed = FALSE;
 	channel->obj = obj;
 	channel->log_obj = NULL;
+	channel->arenas = NULL;
+	channel->arena_count = 0;
+	channel->arena_bytes = 0;
 	channel->pool = pool;
 
 	channel->request_timer = apt_poller_task_timer_create(
@@ -321,6 +326,8 @@ static mrcp_connection_t* mrcp_client_agent_connection_create(mrcp_connection_ag
 	connection->id = apr_psprintf(connection->pool,"%s:%hu <-> %s:%hu",
 		local_ip,connection->l_sockaddr->port,
 		remote_ip,connection->r_sockaddr->port);
+	/* the connection is indexed by the address as offered by the server */
+	apt_string_copy(&connection->remote_ip,&descriptor->ip,connection->pool);
 
 	memset(&connection->sock_pfd,0,sizeof(apr_pollfd_t));
 	connection->sock_pfd.desc_type = APR_POLL_SOCKET;
@@ -337,6 +344,7 @@ static mrcp_connection_t* mrcp_client_agent_connection_create(mrcp_connection_ag
 	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Established TCP/MRCPv2 Connection %s",connection->id);
 	connection->agent = agent;
 	connection->it = apt_list_push_back(agent->connection_list,connection,connection->pool);
+	mrcp_connection_index_add(agent->connection_index,connection);
 	
 	connection->parser = mrcp_parser_create(agent->resource_factory,connection->pool);
 	connection->generator = mrcp_generator_create(agent->resource_factory,connection->pool);
@@ -359,23 +367,10 @@ static mrcp_connection_t* mrcp_client_agent_connection_create(mrcp_connection_ag
 
 static mrcp_connection_t* mrcp_client_agent_connection_find(mrcp_connection_agent_t *agent, mrcp_control_descriptor_t *descriptor)
 {
-	apr_sockaddr_t *sockaddr;
-	mrcp_connection_t *connection = NULL;
-	apt_list_elem_t *elem = apt_list_first_elem_get(agent->connection_list);
-	/* walk through the list of connections */
-	while(elem) {
-		connection = apt_list_elem_object_get(elem);
-		if(connection) {
-			if(apr_sockaddr_info_get(&sockaddr,descriptor->ip.buf,APR_INET,descriptor->port,0,connection->pool) == APR_SUCCESS) {
-				if(apr_sockaddr_equal(sockaddr,connection->r_sockaddr) != 0 && 
-					descriptor->port == connection->r_sockaddr->port) {
-					return connection;
-				}
-			}
-		}
-		elem = apt_list_next_elem_get(agent->connection_list,elem);
+	if(!descriptor->port) {
+		return NULL;
 	}
-	return NULL;
+	return mrcp_connection_index_find(agent->connection_index,&descriptor->ip,descriptor->port);
 }
 
 static apt_bool_t mrcp_client_agent_connection_remove(mrcp_connection_agent_t *agent, mrcp_connection_t *connection)
@@ -383,6 +378,7 @@ static apt_bool_t mrcp_client_agent_connection_remove(mrcp_connection_agent_t *a
 	/* remove from the list */
 	if(connection->it) {
 		apt_list_elem_remove(agent->connection_list,connection->it);
+		mrcp_connection_index_remove(agent->connection_index,connection);
 		connection->it = NULL;
 	}
 	
@@ -37,8 +37,14 @@ mrcp_connection_t* mrcp_connection_create()
 	connection->verbose = TRUE;
 	connection->access_count = 0;
 	connection->it = NULL;
+	connection->index_next = NULL;
 	connection->channel_table = apr_hash_make(pool);
 	connection->parser = NULL;
+	connection->rx_arena = NULL;
+	connection->retained_message_count = 0;
+	connection->retained_bytes = 0;
+	connection->rx_copied_bytes = 0;
+	connection->rx_direct_bytes = 0;
 	connection->generator = NULL;
 	connection->rx_buffer = NULL;
 	connection->rx_buffer_size = 0;
@@ -102,3 +108,83 @@ apt_bool_t mrcp_connection_disconnect_raise(mrcp_connection_t *connection, const
 	}
 	return TRUE;
 }
+
+/** Index of connections by remote address */
+struct mrcp_connection_index_t {
+	/** Table of connection chains keyed by remote IP */
+	apr_hash_t *table;
+	/** Number of connections in the index */
+	apr_size_t  count;
+};
+
+mrcp_connection_index_t* mrcp_connection_index_create(apr_pool_t *pool)
+{
+	mrcp_connection_index_t *index = apr_palloc(pool,sizeof(mrcp_connection_index_t));
+	index->table = apr_hash_make(pool);
+	index->count = 0;
+	return index;
+}
+
+/* Replace the head of the chain (the key is owned by the head connection) */
+static void mrcp_connection_index_head_set(mrcp_connection_index_t *index, const apt_str_t *remote_ip, mrcp_connection_t *head)
+{
+	apr_hash_set(index->table,remote_ip->buf,remote_ip->length,NULL);
+	if(head) {
+		apr_hash_set(index->table,head->remote_ip.buf,head->remote_ip.length,head);
+	}
+}
+
+apt_bool_t mrcp_connection_index_add(mrcp_connection_index_t *index, mrcp_connection_t *connection)
+{
+	if(!index || !connection || apt_string_is_empty(&connection->remote_ip) == TRUE) {
+		return FALSE;
+	}
+	connection->index_next = apr_hash_get(index->table,connection->remote_ip.buf,connection->remote_ip.length);
+	mrcp_connection_index_head_set(index,&connection->remote_ip,connection);
+	index->count++;
+	return TRUE;
+}
+
+apt_bool_t mrcp_connection_index_remove(mrcp_connection_index_t *index, mrcp_connection_t *connection)
+{
+	mrcp_connection_t *head;
+	mrcp_connection_t *prev;
+	if(!index || !connection || apt_string_is_empty(&connection->remote_ip) == TRUE) {
+		return FALSE;
+	}
+	head = apr_hash_get(index->table,connection->remote_ip.buf,connection->remote_ip.length);
+	if(head == connection) {
+		mrcp_connection_index_head_set(index,&connection->remote_ip,connection->index_next);
+	}
+	else {
+		for(prev = head; prev && prev->index_next != connection; prev = prev->index_next);
+		if(!prev) {
+			return FALSE;
+		}
+		prev->index_next = connection->index_next;
+	}
+	connection->index_next = NULL;
+	index->count--;
+	return TRUE;
+}
+
+mrcp_connection_t* mrcp_connection_index_find(const mrcp_connection_index_t *index, const apt_str_t *remote_ip, apr_port_t port)
+{
+	mrcp_connection_t *connection;
+	if(!index || !remote_ip || apt_string_is_empty(remote_ip) == TRUE) {
+		return NULL;
+	}
+	connection = apr_hash_get(index->table,remote_ip->buf,remote_ip->length);
+	if(port) {
+		/* connections to the same remote IP differ in port only */
+		while(connection && (!connection->r_sockaddr || connection->r_sockaddr->port != port)) {
+			connection = connection->index_next;
+		}
+	}
+	return connection;
+}
+
+apr_size_t mrcp_connection_index_count_get(const mrcp_connection_index_t *index)
+{
+	return index ? index->count : 0;
+}
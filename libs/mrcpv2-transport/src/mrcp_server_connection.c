@@ -23,9 +23,26 @@
 #include "mrcp_message.h"
 #include "apt_text_stream.h"
 #include "apt_poller_task.h"
+#include "apt_lockfree_queue.h"
 #include "apt_pool.h"
 #include "apt_log.h"
 
+/** Max number of released arenas kept for reuse */
+#define MRCP_MESSAGE_ARENA_CACHE_SIZE 128
+/** Max amount of free memory the allocator of the arenas may keep */
+#define MRCP_MESSAGE_ARENA_MAX_FREE   (MRCP_MESSAGE_ARENA_CACHE_SIZE * 16384)
+
+/** Arena (pool) a received message is allocated from */
+struct mrcp_message_arena_t {
+	/** Pool to allocate message from */
+	apr_pool_t           *pool;
+	/** Number of bytes parsed into the arena */
+	apr_size_t            bytes;
+	/** Identifier of the request parsed into the arena */
+	mrcp_request_id       request_id;
+	/** Next arena retained by the same channel */
+	mrcp_message_arena_t *next;
+};
 
 struct mrcp_connection_agent_t {
 	apr_pool_t                           *pool;
@@ -33,12 +50,18 @@ struct mrcp_connection_agent_t {
 	const mrcp_resource_factory_t        *resource_factory;
 
 	apt_obj_list_t                       *connection_list;
+	mrcp_connection_index_t              *connection_index;
 	mrcp_connection_t                    *null_connection;
 
 	apt_bool_t                            force_new_connection;
 	apr_size_t                            tx_buffer_size;
 	apr_size_t                            rx_buffer_size;
 
+	/* Parent of the arenas, owns the allocator and mutex the arenas share */
+	apr_pool_t                           *arena_pool;
+	/* Released arenas (pools) to reuse, popped by the agent task only */
+	apt_lockfree_queue_t                 *arena_cache;
+
 	/* Listening socket */
 	apr_sockaddr_t                       *sockaddr;
 	apr_socket_t                         *listen_sock;
@@ -52,7 +75,8 @@ typedef enum {
 	CONNECTION_TASK_MSG_ADD_CHANNEL,
 	CONNECTION_TASK_MSG_MODIFY_CHANNEL,
 	CONNECTION_TASK_MSG_REMOVE_CHANNEL,
-	CONNECTION_TASK_MSG_SEND_MESSAGE
+	CONNECTION_TASK_MSG_SEND_MESSAGE,
+	CONNECTION_TASK_MSG_RELEASE_MESSAGE
 } connection_task_msg_type_e;
 
 typedef struct connection_task_msg_t connection_task_msg_t;
@@ -99,13 +123,22 @@ MRCP_DECLARE(mrcp_connection_agent_t*) mrcp_server_connection_agent_create(
 	agent->force_new_connection = force_new_connection;
 	agent->rx_buffer_size = MRCP_STREAM_BUFFER_SIZE;
 	agent->tx_buffer_size = MRCP_STREAM_BUFFER_SIZE;
+	agent->arena_pool = apt_pool_create();
+	if(!agent->arena_pool) {
+		return NULL;
+	}
+	if(apr_allocator_owner_get(apr_pool_allocator_get(agent->arena_pool)) == agent->arena_pool) {
+		/* the allocator is not shared with other pools */
+		apr_allocator_max_free_set(apr_pool_allocator_get(agent->arena_pool),MRCP_MESSAGE_ARENA_MAX_FREE);
+	}
+	agent->arena_cache = apt_lockfree_queue_create(MRCP_MESSAGE_ARENA_CACHE_SIZE,pool);
 
 	apr_sockaddr_info_get(&agent->sockaddr,listen_ip,APR_INET,listen_port,0,agent->pool);
 	if(!agent->sockaddr) {
 		return NULL;
 	}
 
-	msg_pool = apt_task_msg_pool_create_dynamic(sizeof(connection_task_msg_t),pool);
+	msg_pool = apt_task_msg_pool_create_static(sizeof(connection_task_msg_t),TASK_MSG_POOL_DEFAULT_SIZE,pool);
 	
 	agent->task = apt_poller_task_create(
 					max_connection_count + 1,
@@ -129,6 +162,7 @@ MRCP_DECLARE(mrcp_connection_agent_t*) mrcp_server_connection_agent_create(
 	}
 
 	agent->connection_list = NULL;
+	agent->connection_index = NULL;
 	agent->null_connection = NULL;
 
 	if(mrcp_server_agent_listening_socket_create(agent) != TRUE) {
@@ -144,9 +178,17 @@ static apt_bool_t mrcp_server_agent_on_destroy(apt_task_t *task)
 {
 	apt_poller_task_t *poller_task = apt_task_object_get(task);
 	mrcp_connection_agent_t *agent = apt_poller_task_object_get(poller_task);
+	apr_pool_t *pool;
 
 	mrcp_server_agent_listening_socket_destroy(agent);
 	apt_poller_task_cleanup(poller_task);
+
+	while((pool = apt_lockfree_queue_pop(agent->arena_cache)) != NULL) {
+		apr_pool_destroy(pool);
+	}
+	apt_lockfree_queue_destroy(agent->arena_cache);
+	/* the arenas still retained by the channels go along */
+	apr_pool_destroy(agent->arena_pool);
 	return TRUE;
 }
 
@@ -242,13 +284,80 @@ MRCP_DECLARE(mrcp_control_channel_t*) mrcp_server_control_channel_create(mrcp_co
 	channel->obj = obj;
 	channel->log_obj = NULL;
 	channel->pool = pool;
+	channel->arenas = NULL;
+	channel->arena_count = 0;
+	channel->arena_bytes = 0;
 	return channel;
 }
 
+/** Get arena to allocate the next received message from (agent task only) */
+static mrcp_message_arena_t* mrcp_message_arena_get(mrcp_connection_agent_t *agent)
+{
+	mrcp_message_arena_t *arena;
+	apr_pool_t *pool = apt_lockfree_queue_pop(agent->arena_cache);
+	if(!pool) {
+		/* the allocator mutex lives in the parent, so the arena can be cleared and reused */
+		pool = apt_subpool_create(agent->arena_pool);
+		if(!pool) {
+			return NULL;
+		}
+	}
+
+	arena = apr_palloc(pool,sizeof(mrcp_message_arena_t));
+	arena->pool = pool;
+	arena->bytes = 0;
+	arena->request_id = 0;
+	arena->next = NULL;
+	return arena;
+}
+
+/** Release arena to be reused (any thread) */
+static void mrcp_message_arena_release(mrcp_connection_agent_t *agent, mrcp_message_arena_t *arena)
+{
+	/* the arena itself is allocated from the pool */
+	apr_pool_t *pool = arena->pool;
+	apr_pool_clear(pool);
+	if(apt_lockfree_queue_push(agent->arena_cache,pool) == FALSE) {
+		apr_pool_destroy(pool);
+	}
+}
+
+/** Release arena of the request retained by the channel (agent task only) */
+static apt_bool_t mrcp_control_channel_arena_release(mrcp_control_channel_t *channel, mrcp_request_id request_id)
+{
+	mrcp_message_arena_t **link = &channel->arenas;
+	mrcp_message_arena_t *arena;
+	for(arena = *link; arena; link = &arena->next, arena = *link) {
+		if(arena->request_id != request_id) continue;
+
+		*link = arena->next;
+		channel->arena_count--;
+		channel->arena_bytes -= arena->bytes;
+		if(channel->connection) {
+			channel->connection->retained_message_count--;
+			channel->connection->retained_bytes -= arena->bytes;
+		}
+		mrcp_message_arena_release(channel->agent,arena);
+		return TRUE;
+	}
+	return FALSE;
+}
+
 /** Destroy MRCPv2 control channel */
 MRCP_DECLARE(apt_bool_t) mrcp_server_control_channel_destroy(mrcp_control_channel_t *channel)
 {
-	if(channel && channel->connection && channel->removed == TRUE) {
+	if(!channel) {
+		return FALSE;
+	}
+
+	/* the session is done with the messages received through the channel */
+	while(channel->arenas) {
+		mrcp_message_arena_t *arena = channel->arenas;
+		channel->arenas = arena->next;
+		mrcp_message_arena_release(channel->agent,arena);
+	}
+
+	if(channel->connection && channel->removed == TRUE) {
 		mrcp_connection_t *connection = channel->connection;
 		channel->connection = NULL;
 		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Destroy TCP/MRCPv2 Connection %s",connection->id);
@@ -303,6 +412,12 @@ MRCP_DECLARE(apt_bool_t) mrcp_server_control_message_send(mrcp_control_channel_t
 	return mrcp_server_control_message_signal(CONNECTION_TASK_MSG_SEND_MESSAGE,channel->agent,channel,NULL,message);
 }
 
+/** Release MRCPv2 request the final message has been sent for */
+MRCP_DECLARE(apt_bool_t) mrcp_server_control_message_release(mrcp_control_channel_t *channel, mrcp_message_t *message)
+{
+	return mrcp_server_control_message_signal(CONNECTION_TASK_MSG_RELEASE_MESSAGE,channel->agent,channel,NULL,message);
+}
+
 /** Create listening socket and add it to pollset */
 static apt_bool_t mrcp_server_agent_listening_socket_create(mrcp_connection_agent_t *agent)
 {
@@ -367,7 +482,7 @@ static mrcp_control_channel_t* mrcp_connection_channel_associate(mrcp_connection
 	if(!connection || !message) {
 		return NULL;
 	}
-	apt_id_resource_generate(&message->channel_id.session_id,&message->channel_id.resource_name,'@',&identifier,connection->pool);
+	apt_id_resource_generate(&message->channel_id.session_id,&message->channel_id.resource_name,'@',&identifier,message->pool);
 	channel = mrcp_connection_channel_find(connection,&identifier);
 	if(!channel) {
 		channel = mrcp_connection_channel_find(agent->null_connection,&identifier);
@@ -385,30 +500,18 @@ static mrcp_control_channel_t* mrcp_connection_channel_associate(mrcp_connection
 
 static mrcp_connection_t* mrcp_connection_find(mrcp_connection_agent_t *agent, const apt_str_t *remote_ip)
 {
-	mrcp_connection_t *connection = NULL;
-	apt_list_elem_t *elem;
-	if(!agent || !agent->connection_list || !remote_ip) {
+	if(!agent || !agent->connection_index || !remote_ip) {
 		return NULL;
 	}
-
-	elem = apt_list_first_elem_get(agent->connection_list);
-	/* walk through the list of connections */
-	while(elem) {
-		connection = apt_list_elem_object_get(elem);
-		if(connection) {
-			if(apt_string_compare(&connection->remote_ip,remote_ip) == TRUE) {
-				return connection;
-			}
-		}
-		elem = apt_list_next_elem_get(agent->connection_list,elem);
-	}
-	return NULL;
+	/* any connection from the remote IP can be shared */
+	return mrcp_connection_index_find(agent->connection_index,remote_ip,0);
 }
 
 static apt_bool_t mrcp_connection_remove(mrcp_connection_agent_t *agent, mrcp_connection_t *connection)
 {
 	if(connection->it) {
 		apt_list_elem_remove(agent->connection_list,connection->it);
+		mrcp_connection_index_remove(agent->connection_index,connection);
 		connection->it = NULL;
 	}
 	if(agent->null_connection) {
@@ -417,6 +520,7 @@ static apt_bool_t mrcp_connection_remove(mrcp_connection_agent_t *agent, mrcp_co
 			mrcp_connection_destroy(agent->null_connection);
 			agent->null_connection = NULL;
 			agent->connection_list = NULL;
+			agent->connection_index = NULL;
 		}
 	}
 	return TRUE;
@@ -481,6 +585,7 @@ static apt_bool_t mrcp_server_agent_connection_accept(mrcp_connection_agent_t *a
 	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Accepted TCP/MRCPv2 Connection %s",connection->id);
 	connection->agent = agent;
 	connection->it = apt_list_push_back(agent->connection_list,connection,connection->pool);
+	mrcp_connection_index_add(agent->connection_index,connection);
 
 	connection->parser = mrcp_parser_create(agent->resource_factory,connection->pool);
 	connection->generator = mrcp_generator_create(agent->resource_factory,connection->pool);
@@ -502,10 +607,20 @@ static apt_bool_t mrcp_server_agent_connection_accept(mrcp_connection_agent_t *a
 
 static apt_bool_t mrcp_server_agent_connection_close(mrcp_connection_agent_t *agent, mrcp_connection_t *connection)
 {
-	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"TCP/MRCPv2 Peer Disconnected %s",connection->id);
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"TCP/MRCPv2 Peer Disconnected %s Retained [%"APR_SIZE_T_FMT" messages %"APR_SIZE_T_FMT" bytes] Body [%"APR_SIZE_T_FMT" bytes copied %"APR_SIZE_T_FMT" bytes direct]",
+		connection->id,
+		connection->retained_message_count,
+		connection->retained_bytes,
+		connection->rx_copied_bytes,
+		connection->rx_direct_bytes);
 	apt_poller_task_descriptor_remove(agent->task,&connection->sock_pfd);
 	apr_socket_close(connection->sock);
 	connection->sock = NULL;
+	if(connection->rx_arena) {
+		/* drop partially received message */
+		mrcp_message_arena_release(agent,connection->rx_arena);
+		connection->rx_arena = NULL;
+	}
 	if(!connection->access_count) {
 		mrcp_connection_remove(agent,connection);
 		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Destroy TCP/MRCPv2 Connection %s",connection->id);
@@ -541,6 +656,7 @@ static apt_bool_t mrcp_server_agent_channel_add(mrcp_connection_agent_t *agent,
 		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Create Container for Pending Control Channels");
 		agent->null_connection = mrcp_connection_create();
 		agent->connection_list = apt_list_create(agent->null_connection->pool);
+		agent->connection_index = mrcp_connection_index_create(agent->null_connection->pool);
 	}
 	mrcp_connection_channel_add(agent->null_connection,channel);	
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Add Pending Control Channel <%s> [%d]",
@@ -565,9 +681,16 @@ static apt_bool_t mrcp_server_agent_channel_remove(mrcp_connection_agent_t *agen
 {
 	mrcp_connection_t *connection = channel->connection;
 	mrcp_connection_channel_remove(connection,channel);
-	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Remove Control Channel <%s> [%d]",
+	/* arenas are released on channel destroy, but no longer accounted to the connection */
+	connection->retained_message_count -= channel->arena_count;
+	connection->retained_bytes -= channel->arena_bytes;
+	channel->arena_count = 0;
+	channel->arena_bytes = 0;
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Remove Control Channel <%s> [%d] Retained [%"APR_SIZE_T_FMT" messages %"APR_SIZE_T_FMT" bytes]",
 			channel->identifier.buf,
-			apr_hash_count(connection->channel_table));
+			apr_hash_count(connection->channel_table),
+			connection->retained_message_count,
+			connection->retained_bytes);
 	if(!connection->access_count) {
 		if(connection == agent->null_connection) {
 			if(apt_list_is_empty(agent->connection_list) == TRUE) {
@@ -575,6 +698,7 @@ static apt_bool_t mrcp_server_agent_channel_remove(mrcp_connection_agent_t *agen
 				mrcp_connection_destroy(agent->null_connection);
 				agent->null_connection = NULL;
 				agent->connection_list = NULL;
+				agent->connection_index = NULL;
 			}
 		}
 		else if(!connection->sock) {
@@ -628,19 +752,66 @@ static apt_bool_t mrcp_server_agent_messsage_send(mrcp_connection_agent_t *agent
 	return status;
 }
 
+static apt_bool_t mrcp_server_agent_messsage_release(mrcp_connection_agent_t *agent, mrcp_control_channel_t *channel, mrcp_message_t *message)
+{
+	mrcp_request_id_list_t stopped_list;
+	mrcp_generic_header_t *generic_header;
+	const char *method_name = message->start_line.method_name.buf;
+	apr_size_t i;
+
+	/* the message may live in one of the arenas, copy what's needed before releasing them */
+	stopped_list.count = 0;
+	if(message->start_line.message_type == MRCP_MESSAGE_TYPE_RESPONSE && method_name &&
+		(strcasecmp(method_name,"STOP") == 0 || strcasecmp(method_name,"BARGE-IN-OCCURRED") == 0) &&
+		mrcp_generic_header_property_check(message,GENERIC_HEADER_ACTIVE_REQUEST_ID_LIST) == TRUE) {
+		/* the stopped requests are over as well */
+		generic_header = mrcp_generic_header_get(message);
+		if(generic_header) {
+			stopped_list = generic_header->active_request_id_list;
+		}
+	}
+
+	mrcp_control_channel_arena_release(channel,message->start_line.request_id);
+	for(i=0; i<stopped_list.count; i++) {
+		mrcp_control_channel_arena_release(channel,stopped_list.ids[i]);
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Release Request <%s> Retained [%"APR_SIZE_T_FMT" messages %"APR_SIZE_T_FMT" bytes]",
+		channel->identifier.buf,
+		channel->arena_count,
+		channel->arena_bytes);
+	return TRUE;
+}
+
 static apt_bool_t mrcp_server_message_handler(mrcp_connection_t *connection, mrcp_message_t *message, apt_message_status_e status)
 {
 	mrcp_connection_agent_t *agent = connection->agent;
+	mrcp_message_arena_t *arena = connection->rx_arena;
 	if(status == APT_MESSAGE_STATUS_COMPLETE) {
 		/* message is completely parsed */
 		mrcp_control_channel_t *channel = mrcp_connection_channel_associate(agent,connection,message);
+		apr_size_t copied_length = mrcp_parser_copied_length_get(connection->parser);
+		connection->rx_copied_bytes += copied_length;
+		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Parsed MRCPv2 Message %s Body [%"APR_SIZE_T_FMT" bytes, %"APR_SIZE_T_FMT" copied]",
+			connection->id,
+			message->body.length,
+			copied_length);
+		connection->rx_arena = NULL;
 		if(channel) {
+			/* the arena is retained until the request is over or the session destroys the channel */
+			arena->request_id = message->start_line.request_id;
+			arena->next = channel->arenas;
+			channel->arenas = arena;
+			channel->arena_count++;
+			channel->arena_bytes += arena->bytes;
+			connection->retained_message_count++;
+			connection->retained_bytes += arena->bytes;
 			mrcp_connection_message_receive(agent->vtable,channel,message);
 		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Find Channel "APT_SIDRES_FMT" in Connection %s",
 				MRCP_MESSAGE_SIDRES(message),
 				connection->id);
+			mrcp_message_arena_release(agent,arena);
 		}
 	}
 	else if(status == APT_MESSAGE_STATUS_INVALID) {
@@ -654,10 +825,68 @@ static apt_bool_t mrcp_server_message_handler(mrcp_connection_t *connection, mrc
 				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Send MRCPv2 Response");
 			}
 		}
+		/* the parser is reset to the start line, drop the invalid message */
+		connection->rx_arena = NULL;
+		mrcp_message_arena_release(agent,arena);
+	}
+	return TRUE;
+}
+
+/* Grow rx buffer, if the start line and header section being parsed do not fit */
+static apt_bool_t mrcp_server_rx_buffer_grow(mrcp_connection_t *connection)
+{
+	apt_text_stream_t *stream = &connection->rx_stream;
+	apr_size_t offset = stream->pos - stream->text.buf;
+	apr_size_t size = connection->rx_buffer_size * 2;
+	char *buffer;
+	if(connection->rx_buffer_size >= MRCP_STREAM_BUFFER_MAX_SIZE) {
+		return FALSE;
 	}
+	if(size > MRCP_STREAM_BUFFER_MAX_SIZE) {
+		size = MRCP_STREAM_BUFFER_MAX_SIZE;
+	}
+
+	buffer = apr_palloc(connection->pool,size+1);
+	memcpy(buffer,stream->text.buf,offset);
+	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Grow Rx Buffer %s [%"APR_SIZE_T_FMT" -> %"APR_SIZE_T_FMT" bytes]",
+		connection->id,
+		connection->rx_buffer_size,
+		size);
+	connection->rx_buffer = buffer;
+	connection->rx_buffer_size = size;
+	stream->text.buf = buffer;
+	stream->pos = buffer + offset;
 	return TRUE;
 }
 
+/* Receive the rest of a large body directly into the message being parsed */
+static apt_bool_t mrcp_server_body_receive(mrcp_connection_agent_t *agent, mrcp_connection_t *connection, char *buf, apr_size_t length)
+{
+	apt_text_stream_t *stream = &connection->rx_stream;
+	mrcp_message_t *message;
+	apt_message_status_e msg_status;
+	apr_status_t status;
+
+	status = apr_socket_recv(connection->sock,buf,&length);
+	if(status == APR_EOF || length == 0) {
+		return mrcp_server_agent_connection_close(agent,connection);
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Receive MRCPv2 Body %s [%"APR_SIZE_T_FMT" bytes]",
+			connection->id,
+			length);
+
+	mrcp_parser_body_advance(connection->parser,length);
+	connection->rx_arena->bytes += length;
+	connection->rx_direct_bytes += length;
+
+	/* let the parser complete the message out of an empty stream */
+	stream->text.length = 0;
+	apt_text_stream_reset(stream);
+	msg_status = mrcp_parser_run(connection->parser,stream,&message);
+	return mrcp_server_message_handler(connection,message,msg_status);
+}
+
 /* Receive MRCP message through TCP/MRCPv2 connection */
 static apt_bool_t mrcp_server_poller_signal_process(void *obj, const apr_pollfd_t *descriptor)
 {
@@ -666,9 +895,11 @@ static apt_bool_t mrcp_server_poller_signal_process(void *obj, const apr_pollfd_
 	apr_status_t status;
 	apr_size_t offset;
 	apr_size_t length;
+	const char *pos;
 	apt_text_stream_t *stream;
 	mrcp_message_t *message;
 	apt_message_status_e msg_status;
+	char *body_buf;
 
 	if(descriptor->desc.s == agent->listen_sock) {
 		return mrcp_server_agent_connection_accept(agent);
@@ -681,6 +912,22 @@ static apt_bool_t mrcp_server_poller_signal_process(void *obj, const apr_pollfd_
 
 	/* calculate offset remaining from the previous receive / if any */
 	offset = stream->pos - stream->text.buf;
+	if(!offset && connection->rx_arena) {
+		/* a body larger than the rx buffer bypasses the stream */
+		length = mrcp_parser_body_remaining_get(connection->parser,&body_buf);
+		if(length >= connection->rx_buffer_size) {
+			return mrcp_server_body_receive(agent,connection,body_buf,length);
+		}
+	}
+	else if(offset == connection->rx_buffer_size) {
+		/* nothing could be parsed out of the full rx buffer */
+		if(mrcp_server_rx_buffer_grow(connection) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Grow Rx Buffer %s [%"APR_SIZE_T_FMT" bytes]",
+				connection->id,
+				connection->rx_buffer_size);
+			return mrcp_server_agent_connection_close(agent,connection);
+		}
+	}
 	/* calculate available length */
 	length = connection->rx_buffer_size - offset;
 
@@ -703,7 +950,17 @@ static apt_bool_t mrcp_server_poller_signal_process(void *obj, const apr_pollfd_
 	apt_text_stream_reset(stream);
 
 	do {
+		if(!connection->rx_arena) {
+			/* each message is parsed into its own arena */
+			connection->rx_arena = mrcp_message_arena_get(agent);
+			if(!connection->rx_arena) {
+				return FALSE;
+			}
+			mrcp_parser_pool_set(connection->parser,connection->rx_arena->pool);
+		}
+		pos = stream->pos;
 		msg_status = mrcp_parser_run(connection->parser,stream,&message);
+		connection->rx_arena->bytes += stream->pos - pos;
 		if(mrcp_server_message_handler(connection,message,msg_status) == FALSE) {
 			return FALSE;
 		}
@@ -734,6 +991,9 @@ static apt_bool_t mrcp_server_agent_msg_process(apt_task_t *task, apt_task_msg_t
 		case CONNECTION_TASK_MSG_SEND_MESSAGE:
 			mrcp_server_agent_messsage_send(agent,msg->channel->connection,msg->message);
 			break;
+		case CONNECTION_TASK_MSG_RELEASE_MESSAGE:
+			mrcp_server_agent_messsage_release(agent,msg->channel,msg->message);
+			break;
 	}
 
 	return TRUE;
@@ -21,6 +21,7 @@
 #include <apr_getopt.h>
 #include <apr_file_info.h>
 #include <apr_thread_proc.h>
+#include <apr_atomic.h>
 #include "asr_engine.h"
 
 typedef struct {
@@ -101,6 +102,91 @@ static apt_bool_t asr_session_launch(asr_engine_t *engine, const char *grammar_f
 	return TRUE;
 }
 
+typedef struct {
+	const char        *grammar_file;
+	const char        *input_file;
+	apr_uint32_t       count;
+	volatile apr_uint32_t pending;
+	volatile apr_uint32_t succeeded;
+	apr_time_t         start_time;
+	apr_pool_t        *pool;
+} asr_batch_t;
+
+/** Complete recognition of the batch */
+static void asr_batch_complete(asr_batch_t *batch)
+{
+	if(apr_atomic_dec32(&batch->pending) == 0) {
+		printf("Batch Complete [%u/%u] in [%"APR_TIME_T_FMT" msec]\n",
+			apr_atomic_read32(&batch->succeeded),
+			batch->count,
+			(apr_time_now() - batch->start_time) / 1000);
+		/* destroy pool batch allocated from */
+		apr_pool_destroy(batch->pool);
+	}
+}
+
+/** Called on recognition completion */
+static void asr_session_on_recognize(asr_session_t *session, apt_bool_t status, const char *result, void *obj)
+{
+	asr_batch_t *batch = obj;
+	if(status == TRUE) {
+		apr_atomic_inc32(&batch->succeeded);
+		if(result) {
+			printf("Recog Result [%s]\n",result);
+		}
+	}
+	asr_session_release(session);
+	asr_batch_complete(batch);
+}
+
+/** Called once session is acquired */
+static void asr_session_on_acquire(asr_session_t *session, apt_bool_t status, const char *result, void *obj)
+{
+	asr_batch_t *batch = obj;
+	if(status == TRUE) {
+		if(asr_session_file_recognize_async(session,batch->grammar_file,batch->input_file,asr_session_on_recognize,batch) == TRUE) {
+			return;
+		}
+	}
+	asr_session_release(session);
+	asr_batch_complete(batch);
+}
+
+/** Launch batch of concurrent ASR sessions without a thread per session */
+static apt_bool_t asr_batch_launch(asr_engine_t *engine, apr_uint32_t count, const char *grammar_file, const char *input_file, const char *profile)
+{
+	apr_pool_t *pool;
+	asr_batch_t *batch;
+	apr_uint32_t i;
+
+	if(!count) {
+		return FALSE;
+	}
+
+	/* create pool to allocate batch from */
+	apr_pool_create(&pool,NULL);
+	batch = apr_palloc(pool,sizeof(asr_batch_t));
+	batch->pool = pool;
+	batch->grammar_file = apr_pstrdup(pool,grammar_file ? grammar_file : "grammar.xml");
+	batch->input_file = apr_pstrdup(pool,input_file ? input_file : "one-8kHz.pcm");
+	if(!profile) {
+		profile = "uni2";
+	}
+	batch->count = count;
+	batch->start_time = apr_time_now();
+	apr_atomic_set32(&batch->succeeded,0);
+	/* one extra reference is held while sessions are being launched */
+	apr_atomic_set32(&batch->pending,count + 1);
+
+	for(i=0; i<count; i++) {
+		if(asr_session_acquire(engine,profile,asr_session_on_acquire,batch) == FALSE) {
+			asr_batch_complete(batch);
+		}
+	}
+	asr_batch_complete(batch);
+	return TRUE;
+}
+
 static apt_bool_t cmdline_process(asr_engine_t *engine, char *cmdline)
 {
 	apt_bool_t running = TRUE;
@@ -114,6 +200,13 @@ static apt_bool_t cmdline_process(asr_engine_t *engine, char *cmdline)
 		char *profile = apr_strtok(NULL, " ", &last);
 		asr_session_launch(engine,grammar,input,profile);
 	}
+	else if(strcasecmp(name,"batch") == 0) {
+		char *count = apr_strtok(NULL, " ", &last);
+		char *grammar = apr_strtok(NULL, " ", &last);
+		char *input = apr_strtok(NULL, " ", &last);
+		char *profile = apr_strtok(NULL, " ", &last);
+		asr_batch_launch(engine,count ? atol(count) : 1,grammar,input,profile);
+	}
 	else if(strcasecmp(name,"loglevel") == 0) {
 		char *priority = apr_strtok(NULL, " ", &last);
 		if(priority) {
@@ -133,6 +226,11 @@ static apt_bool_t cmdline_process(asr_engine_t *engine, char *cmdline)
 			"           run\n"
 			"           run grammar.xml one.pcm\n"
 			"           run grammar.xml one.pcm uni1\n"
+			"\n- batch [count] [grammar_file] [audio_input_file] [profile_name] (run concurrent asr sessions)\n"
+			"       count is the number of sessions to run concurrently without a thread per session\n"
+			"\n       examples: \n"
+			"           batch 100\n"
+			"           batch 100 grammar.xml one.pcm uni1\n"
 		    "\n- loglevel [level] (set loglevel, one of 0,1...7)\n"
 		    "\n- quit, exit\n");
 	}
@@ -49,6 +49,17 @@ typedef struct asr_engine_t asr_engine_t;
 /** Opaque ASR session */
 typedef struct asr_session_t asr_session_t;
 
+/**
+ * Completion callback of asynchronous session operation.
+ * @param session the session operation has been completed in
+ * @param status the status of the operation (FALSE on failure)
+ * @param result the recognition result (input element of NLSML content), NULL for other operations
+ * @param obj the object passed on operation initiation
+ * @remark The callback is called from the context of the client stack and must not block,
+ *         however a next asynchronous operation can be initiated or the session released from there.
+ */
+typedef void (*asr_session_callback_f)(asr_session_t *session, apt_bool_t status, const char *result, void *obj);
+
 
 /**
  * Create ASR engine.
@@ -121,6 +132,69 @@ ASR_CLIENT_DECLARE(apt_bool_t) asr_session_stream_write(
 ASR_CLIENT_DECLARE(apt_bool_t) asr_session_destroy(asr_session_t *session);
 
 
+/**
+ * Set max number of idle sessions kept by the engine for reuse.
+ * @param engine the engine to set session pool size for
+ * @param max_idle_count the max number of idle sessions (0 disables reuse)
+ */
+ASR_CLIENT_DECLARE(apt_bool_t) asr_engine_session_pool_size_set(asr_engine_t *engine, apr_size_t max_idle_count);
+
+/**
+ * Acquire ASR session asynchronously.
+ * @param engine the engine session belongs to
+ * @param profile the name of UniMRCP profile to use
+ * @param callback the callback to call once the session is ready (or failed)
+ * @param obj the object to pass to the callback
+ * @remark An idle session of the same profile is reused if available,
+ *         the callback is then called immediately from the context of the caller.
+ *         Otherwise a new session is created without waiting for the response.
+ */
+ASR_CLIENT_DECLARE(apt_bool_t) asr_session_acquire(
+									asr_engine_t *engine,
+									const char *profile,
+									asr_session_callback_f callback,
+									void *obj);
+
+/**
+ * Initiate recognition based on specified grammar and input file asynchronously.
+ * @param session the session to run recognition in the scope of
+ * @param grammar_file the name of the grammar file to use (path is relative to data dir)
+ * @param input_file the name of the audio input file to use (path is relative to data dir)
+ * @param callback the callback to call on recognition completion (or failure)
+ * @param obj the object to pass to the callback
+ * @remark DEFINE-GRAMMAR and RECOGNIZE requests are pipelined, the call never blocks.
+ */
+ASR_CLIENT_DECLARE(apt_bool_t) asr_session_file_recognize_async(
+									asr_session_t *session,
+									const char *grammar_file,
+									const char *input_file,
+									asr_session_callback_f callback,
+									void *obj);
+
+/**
+ * Initiate recognition based on specified grammar and input stream asynchronously.
+ * @param session the session to run recognition in the scope of
+ * @param grammar_file the name of the grammar file to use (path is relative to data dir)
+ * @param callback the callback to call on recognition completion (or failure)
+ * @param obj the object to pass to the callback
+ * @remark Audio data can be streamed through asr_session_stream_write() right away,
+ *         it's buffered until the recognition is started.
+ */
+ASR_CLIENT_DECLARE(apt_bool_t) asr_session_stream_recognize_async(
+									asr_session_t *session,
+									const char *grammar_file,
+									asr_session_callback_f callback,
+									void *obj);
+
+/**
+ * Release ASR session acquired by asr_session_acquire().
+ * @param session the session to release
+ * @remark Idle session is returned to the pool of the engine for reuse,
+ *         otherwise it's terminated and destroyed asynchronously.
+ */
+ASR_CLIENT_DECLARE(apt_bool_t) asr_session_release(asr_session_t *session);
+
+
 /**
  * Set log priority.
  * @param priority the priority to set
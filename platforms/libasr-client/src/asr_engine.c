@@ -39,18 +39,39 @@
 
 #include "asr_engine.h"
 
+/** Default max number of idle sessions kept for reuse */
+#define DEFAULT_SESSION_POOL_SIZE 100
+
 typedef enum {
 	INPUT_MODE_NONE,
 	INPUT_MODE_FILE,
 	INPUT_MODE_STREAM
 } input_mode_e;
 
+/** States of asynchronous session operation */
+typedef enum {
+	ASYNC_STATE_NONE,           /**< no asynchronous operation in progress */
+	ASYNC_STATE_CHANNEL_ADD,    /**< waiting for response to channel add request */
+	ASYNC_STATE_DEFINE_GRAMMAR, /**< waiting for response to DEFINE-GRAMMAR request */
+	ASYNC_STATE_RECOGNIZE,      /**< waiting for response to RECOGNIZE request */
+	ASYNC_STATE_RECOGNIZING,    /**< waiting for RECOGNITION-COMPLETE event */
+	ASYNC_STATE_TERMINATE       /**< waiting for response to session terminate request */
+} async_state_e;
+
 /** ASR engine on top of UniMRCP client stack */
 struct asr_engine_t {
 	/** MRCP client stack */
 	mrcp_client_t      *mrcp_client;
 	/** MRCP client stack */
 	mrcp_application_t *mrcp_app;
+
+	/** Idle sessions available for reuse (asr_session_t*) */
+	apr_array_header_t *idle_sessions;
+	/** Max number of idle sessions */
+	apr_size_t          max_idle_count;
+	/** Mutex of idle sessions */
+	apr_thread_mutex_t *mutex;
+
 	/** Memory pool */
 	apr_pool_t         *pool;
 };
@@ -83,6 +104,17 @@ struct asr_session_t {
 
 	/** Message sent from client stack */
 	const mrcp_app_message_t *app_message;
+
+	/** Name of the profile session is created with */
+	const char               *profile;
+	/** State of asynchronous operation */
+	async_state_e             async_state;
+	/** Session is failed and cannot be reused */
+	apt_bool_t                failed;
+	/** Completion callback of asynchronous operation */
+	asr_session_callback_f    callback;
+	/** Object to pass to the callback */
+	void                     *callback_obj;
 };
 
 
@@ -100,6 +132,7 @@ static const mpf_audio_stream_vtable_t audio_stream_vtable = {
 };
 
 static apt_bool_t app_message_handler(const mrcp_app_message_t *app_message);
+static apt_bool_t asr_session_destroy_ex(asr_session_t *asr_session, apt_bool_t terminate);
 
 
 /** Create ASR engine */
@@ -134,6 +167,10 @@ ASR_CLIENT_DECLARE(asr_engine_t*) asr_engine_create(
 	engine->pool = pool;
 	engine->mrcp_client = NULL;
 	engine->mrcp_app = NULL;
+	engine->idle_sessions = apr_array_make(pool,DEFAULT_SESSION_POOL_SIZE,sizeof(asr_session_t*));
+	engine->max_idle_count = DEFAULT_SESSION_POOL_SIZE;
+	engine->mutex = NULL;
+	apr_thread_mutex_create(&engine->mutex,APR_THREAD_MUTEX_DEFAULT,pool);
 
 	/* create UniMRCP client stack */
 	mrcp_client = unimrcp_client_create(dir_layout);
@@ -174,6 +211,18 @@ ASR_CLIENT_DECLARE(asr_engine_t*) asr_engine_create(
 /** Destroy ASR engine */
 ASR_CLIENT_DECLARE(apt_bool_t) asr_engine_destroy(asr_engine_t *engine)
 {
+	asr_session_t *asr_session;
+	/* destroy idle sessions */
+	while(engine->idle_sessions->nelts) {
+		asr_session = *(asr_session_t**)apr_array_pop(engine->idle_sessions);
+		asr_session_destroy_ex(asr_session,TRUE);
+	}
+
+	if(engine->mutex) {
+		apr_thread_mutex_destroy(engine->mutex);
+		engine->mutex = NULL;
+	}
+
 	if(engine->mrcp_client) {
 		/* shutdown client stack */
 		mrcp_client_shutdown(engine->mrcp_client);
@@ -204,6 +253,7 @@ static apt_bool_t asr_session_destroy_ex(asr_session_t *asr_session, apt_bool_t
 		apr_thread_mutex_unlock(asr_session->mutex);
 	}
 
+	asr_session->streaming = FALSE;
 	if(asr_session->audio_in) {
 		fclose(asr_session->audio_in);
 		asr_session->audio_in = NULL;
@@ -396,6 +446,75 @@ static const char* nlsml_result_get(mrcp_message_t *message)
 }
 
 
+static apt_bool_t sig_response_check(const mrcp_app_message_t *app_message);
+static apt_bool_t mrcp_response_check(const mrcp_app_message_t *app_message, mrcp_request_state_e state);
+static mrcp_message_t* mrcp_event_get(const mrcp_app_message_t *app_message);
+
+/** Complete asynchronous operation */
+static void asr_session_async_complete(asr_session_t *asr_session, apt_bool_t status, const char *result)
+{
+	asr_session_callback_f callback = asr_session->callback;
+	void *obj = asr_session->callback_obj;
+
+	/* reset the state first, since a next operation can be initiated from the callback */
+	asr_session->async_state = ASYNC_STATE_NONE;
+	asr_session->callback = NULL;
+	asr_session->callback_obj = NULL;
+	if(status == FALSE) {
+		asr_session->streaming = FALSE;
+		asr_session->failed = TRUE;
+	}
+
+	if(callback) {
+		callback(asr_session,status,result,obj);
+	}
+}
+
+/** Process message of asynchronous operation (in the context of client stack) */
+static apt_bool_t asr_session_async_process(asr_session_t *asr_session, const mrcp_app_message_t *app_message)
+{
+	mrcp_message_t *mrcp_message;
+	switch(asr_session->async_state) {
+		case ASYNC_STATE_CHANNEL_ADD:
+			asr_session_async_complete(asr_session,sig_response_check(app_message),NULL);
+			break;
+		case ASYNC_STATE_DEFINE_GRAMMAR:
+			if(asr_session->failed == TRUE || mrcp_response_check(app_message,MRCP_REQUEST_STATE_COMPLETE) == FALSE) {
+				/* pipelined RECOGNIZE (if any) is still to be responded, the session is not reusable anymore */
+				asr_session_async_complete(asr_session,FALSE,NULL);
+				break;
+			}
+			asr_session->async_state = ASYNC_STATE_RECOGNIZE;
+			break;
+		case ASYNC_STATE_RECOGNIZE:
+			if(mrcp_response_check(app_message,MRCP_REQUEST_STATE_INPROGRESS) == FALSE) {
+				asr_session_async_complete(asr_session,FALSE,NULL);
+				break;
+			}
+			asr_session->async_state = ASYNC_STATE_RECOGNIZING;
+			asr_session->streaming = TRUE;
+			break;
+		case ASYNC_STATE_RECOGNIZING:
+			mrcp_message = mrcp_event_get(app_message);
+			if(mrcp_message && mrcp_message->start_line.method_id == RECOGNIZER_RECOGNITION_COMPLETE) {
+				asr_session->streaming = FALSE;
+				asr_session->recog_complete = mrcp_message;
+				asr_session_async_complete(asr_session,TRUE,nlsml_result_get(mrcp_message));
+			}
+			break;
+		case ASYNC_STATE_TERMINATE:
+			if(app_message->message_type == MRCP_APP_MESSAGE_TYPE_SIGNALING &&
+				app_message->sig_message.command_id == MRCP_SIG_COMMAND_SESSION_TERMINATE) {
+				asr_session_destroy_ex(asr_session,FALSE);
+			}
+			break;
+		default:
+			/* late message of failed operation */
+			break;
+	}
+	return TRUE;
+}
+
 /** Application message handler */
 static apt_bool_t app_message_handler(const mrcp_app_message_t *app_message)
 {
@@ -405,6 +524,10 @@ static apt_bool_t app_message_handler(const mrcp_app_message_t *app_message)
 
 		asr_session_t *asr_session = mrcp_application_session_object_get(app_message->session);
 		if(asr_session) {
+			if(asr_session->async_state != ASYNC_STATE_NONE || asr_session->failed == TRUE) {
+				return asr_session_async_process(asr_session,app_message);
+			}
+
 			apr_thread_mutex_lock(asr_session->mutex);
 			asr_session->app_message = app_message;
 			apr_thread_cond_signal(asr_session->wait_object);
@@ -457,13 +580,12 @@ static mrcp_message_t* mrcp_event_get(const mrcp_app_message_t *app_message)
 	return mrcp_message;
 }
 
-/** Create ASR session */
-ASR_CLIENT_DECLARE(asr_session_t*) asr_session_create(asr_engine_t *engine, const char *profile)
+/** Create ASR session without adding its channel */
+static asr_session_t* asr_session_create_ex(asr_engine_t *engine, const char *profile)
 {
 	mpf_termination_t *termination;
 	mrcp_channel_t *channel;
 	mrcp_session_t *session;
-	const mrcp_app_message_t *app_message;
 	apr_pool_t *pool;
 	asr_session_t *asr_session;
 	mpf_stream_capabilities_t *capabilities;
@@ -515,6 +637,11 @@ ASR_CLIENT_DECLARE(asr_session_t*) asr_session_create(asr_engine_t *engine, cons
 	asr_session->mutex = NULL;
 	asr_session->wait_object = NULL;
 	asr_session->app_message = NULL;
+	asr_session->profile = apr_pstrdup(pool,profile);
+	asr_session->async_state = ASYNC_STATE_NONE;
+	asr_session->failed = FALSE;
+	asr_session->callback = NULL;
+	asr_session->callback_obj = NULL;
 
 	/* Create cond wait object and mutex */
 	apr_thread_mutex_create(&asr_session->mutex,APR_THREAD_MUTEX_DEFAULT,pool);
@@ -522,6 +649,17 @@ ASR_CLIENT_DECLARE(asr_session_t*) asr_session_create(asr_engine_t *engine, cons
 
 	/* Create media buffer */
 	asr_session->media_buffer = mpf_frame_buffer_create(160,20,pool);
+	return asr_session;
+}
+
+/** Create ASR session */
+ASR_CLIENT_DECLARE(asr_session_t*) asr_session_create(asr_engine_t *engine, const char *profile)
+{
+	const mrcp_app_message_t *app_message;
+	asr_session_t *asr_session = asr_session_create_ex(engine,profile);
+	if(!asr_session) {
+		return NULL;
+	}
 
 	/* Send add channel request and wait for the response */
 	apr_thread_mutex_lock(asr_session->mutex);
@@ -722,6 +860,192 @@ ASR_CLIENT_DECLARE(apt_bool_t) asr_session_stream_write(
 	return TRUE;
 }
 
+/** Set max number of idle sessions kept for reuse */
+ASR_CLIENT_DECLARE(apt_bool_t) asr_engine_session_pool_size_set(asr_engine_t *engine, apr_size_t max_idle_count)
+{
+	apr_thread_mutex_lock(engine->mutex);
+	engine->max_idle_count = max_idle_count;
+	apr_thread_mutex_unlock(engine->mutex);
+	return TRUE;
+}
+
+/** Get idle session of specified profile */
+static asr_session_t* asr_engine_idle_session_get(asr_engine_t *engine, const char *profile)
+{
+	int i;
+	asr_session_t **idle_sessions;
+	asr_session_t *asr_session = NULL;
+
+	apr_thread_mutex_lock(engine->mutex);
+	idle_sessions = (asr_session_t**)engine->idle_sessions->elts;
+	for(i=engine->idle_sessions->nelts-1; i>=0; i--) {
+		if(strcasecmp(idle_sessions[i]->profile,profile) == 0) {
+			asr_session = idle_sessions[i];
+			/* replace by the last one */
+			idle_sessions[i] = *(asr_session_t**)apr_array_pop(engine->idle_sessions);
+			break;
+		}
+	}
+	apr_thread_mutex_unlock(engine->mutex);
+	return asr_session;
+}
+
+/** Acquire ASR session asynchronously */
+ASR_CLIENT_DECLARE(apt_bool_t) asr_session_acquire(
+									asr_engine_t *engine,
+									const char *profile,
+									asr_session_callback_f callback,
+									void *obj)
+{
+	asr_session_t *asr_session = asr_engine_idle_session_get(engine,profile);
+	if(asr_session) {
+		if(callback) {
+			callback(asr_session,TRUE,NULL,obj);
+		}
+		return TRUE;
+	}
+
+	asr_session = asr_session_create_ex(engine,profile);
+	if(!asr_session) {
+		return FALSE;
+	}
+
+	/* the state must be set before the request is sent */
+	asr_session->async_state = ASYNC_STATE_CHANNEL_ADD;
+	asr_session->callback = callback;
+	asr_session->callback_obj = obj;
+	if(mrcp_application_channel_add(asr_session->mrcp_session,asr_session->mrcp_channel) != TRUE) {
+		asr_session_destroy_ex(asr_session,FALSE);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Send pipelined DEFINE-GRAMMAR and RECOGNIZE requests */
+static apt_bool_t asr_session_recognize_async(
+						asr_session_t *asr_session,
+						const char *grammar_file,
+						asr_session_callback_f callback,
+						void *obj)
+{
+	mrcp_message_t *define_grammar_message;
+	mrcp_message_t *recognize_message;
+
+	if(asr_session->async_state != ASYNC_STATE_NONE || asr_session->failed == TRUE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Initiate Recognition: session is busy or failed");
+		return FALSE;
+	}
+
+	define_grammar_message = define_grammar_message_create(asr_session,grammar_file);
+	if(!define_grammar_message) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create DEFINE-GRAMMAR Request");
+		return FALSE;
+	}
+	recognize_message = recognize_message_create(asr_session);
+	if(!recognize_message) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create RECOGNIZE Request");
+		return FALSE;
+	}
+
+	/* Reset prev recog result (if any) */
+	asr_session->recog_complete = NULL;
+
+	/* the state must be set before the requests are sent,
+	the client stack queues RECOGNIZE until DEFINE-GRAMMAR is responded */
+	asr_session->async_state = ASYNC_STATE_DEFINE_GRAMMAR;
+	asr_session->callback = callback;
+	asr_session->callback_obj = obj;
+	if(mrcp_application_message_send(asr_session->mrcp_session,asr_session->mrcp_channel,define_grammar_message) != TRUE) {
+		asr_session->async_state = ASYNC_STATE_NONE;
+		asr_session->callback = NULL;
+		asr_session->callback_obj = NULL;
+		return FALSE;
+	}
+	if(mrcp_application_message_send(asr_session->mrcp_session,asr_session->mrcp_channel,recognize_message) != TRUE) {
+		/* DEFINE-GRAMMAR is in progress, mark the session as failed and let its response silently complete the operation */
+		asr_session->failed = TRUE;
+		asr_session->callback = NULL;
+		asr_session->callback_obj = NULL;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Initiate recognition based on specified grammar and input file asynchronously */
+ASR_CLIENT_DECLARE(apt_bool_t) asr_session_file_recognize_async(
+									asr_session_t *asr_session,
+									const char *grammar_file,
+									const char *input_file,
+									asr_session_callback_f callback,
+									void *obj)
+{
+	if(asr_session->async_state != ASYNC_STATE_NONE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Initiate Recognition: session is busy");
+		return FALSE;
+	}
+
+	/* Open input file, streaming is started once RECOGNIZE is in-progress */
+	asr_session->input_mode = INPUT_MODE_FILE;
+	if(asr_input_file_open(asr_session,input_file) == FALSE) {
+		return FALSE;
+	}
+	return asr_session_recognize_async(asr_session,grammar_file,callback,obj);
+}
+
+/** Initiate recognition based on specified grammar and input stream asynchronously */
+ASR_CLIENT_DECLARE(apt_bool_t) asr_session_stream_recognize_async(
+									asr_session_t *asr_session,
+									const char *grammar_file,
+									asr_session_callback_f callback,
+									void *obj)
+{
+	if(asr_session->async_state != ASYNC_STATE_NONE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Initiate Recognition: session is busy");
+		return FALSE;
+	}
+
+	/* Reset media buffer, audio written from now on is kept until RECOGNIZE is in-progress */
+	mpf_frame_buffer_restart(asr_session->media_buffer);
+	asr_session->input_mode = INPUT_MODE_STREAM;
+	return asr_session_recognize_async(asr_session,grammar_file,callback,obj);
+}
+
+/** Release ASR session */
+ASR_CLIENT_DECLARE(apt_bool_t) asr_session_release(asr_session_t *asr_session)
+{
+	asr_engine_t *engine = asr_session->engine;
+	if(asr_session->async_state == ASYNC_STATE_NONE && asr_session->failed == FALSE) {
+		apt_bool_t pooled = FALSE;
+		asr_session->streaming = FALSE;
+		asr_session->input_mode = INPUT_MODE_NONE;
+		if(asr_session->audio_in) {
+			fclose(asr_session->audio_in);
+			asr_session->audio_in = NULL;
+		}
+
+		apr_thread_mutex_lock(engine->mutex);
+		if((apr_size_t)engine->idle_sessions->nelts < engine->max_idle_count) {
+			APR_ARRAY_PUSH(engine->idle_sessions,asr_session_t*) = asr_session;
+			pooled = TRUE;
+		}
+		apr_thread_mutex_unlock(engine->mutex);
+		if(pooled == TRUE) {
+			return TRUE;
+		}
+	}
+
+	/* terminate the session without waiting, it's destroyed on the response */
+	asr_session->streaming = FALSE;
+	asr_session->failed = TRUE;
+	asr_session->callback = NULL;
+	asr_session->callback_obj = NULL;
+	asr_session->async_state = ASYNC_STATE_TERMINATE;
+	if(mrcp_application_session_terminate(asr_session->mrcp_session) != TRUE) {
+		return asr_session_destroy_ex(asr_session,FALSE);
+	}
+	return TRUE;
+}
+
 /** Destroy ASR session */
 ASR_CLIENT_DECLARE(apt_bool_t) asr_session_destroy(asr_session_t *asr_session)
 {
@@ -495,6 +495,10 @@ static apt_bool_t unimrcp_client_media_engine_load(unimrcp_client_loader_t *load
 	const apr_xml_elem *elem;
 	mpf_engine_t *media_engine;
 	unsigned long realtime_rate = 1;
+	apr_size_t worker_count = 1;
+	apt_bool_t profiling = FALSE;
+	apr_size_t profile_sample_rate = 0;
+	apr_size_t profile_dump_interval = 0;
 
 	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading Media Engine <%s>",id);
 	for(elem = root->first_child; elem; elem = elem->next) {
@@ -504,6 +508,26 @@ static apt_bool_t unimrcp_client_media_engine_load(unimrcp_client_loader_t *load
 				realtime_rate = atol(cdata_text_get(elem));
 			}
 		}
+		else if(strcasecmp(elem->name,"worker-count") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				worker_count = atol(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"profiling") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				profiling = cdata_bool_get(elem);
+			}
+		}
+		else if(strcasecmp(elem->name,"profile-sample-rate") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				profile_sample_rate = atol(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"profile-dump-interval") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				profile_dump_interval = atol(cdata_text_get(elem));
+			}
+		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
 		}
@@ -512,6 +536,12 @@ static apt_bool_t unimrcp_client_media_engine_load(unimrcp_client_loader_t *load
 	media_engine = mpf_engine_create(id,loader->pool);
 	if(media_engine) {
 		mpf_engine_scheduler_rate_set(media_engine,realtime_rate);
+		if(worker_count > 1) {
+			mpf_engine_worker_count_set(media_engine,worker_count);
+		}
+		if(profiling == TRUE) {
+			mpf_engine_profiling_set(media_engine,TRUE,profile_sample_rate,profile_dump_interval);
+		}
 	}
 	return mrcp_client_media_engine_register(loader->client,media_engine);
 }
@@ -548,6 +578,11 @@ static apt_bool_t unimrcp_client_rtp_factory_load(unimrcp_client_loader_t *loade
 				rtp_config->rtp_port_max = (apr_port_t)atol(cdata_text_get(elem));
 			}
 		}
+		else if(strcasecmp(elem->name,"rtp-poller") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				rtp_config->rtp_poller = cdata_bool_get(elem);
+			}
+		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
 		}
@@ -703,6 +738,16 @@ static apt_bool_t unimrcp_client_jb_settings_load(unimrcp_client_loader_t *loade
 				jb->time_skew_detection = (apr_byte_t) atol(cdata_text_get(elem));
 			}
 		}
+		else if(strcasecmp(elem->name,"playout-percentile") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				jb->playout_percentile = (apr_byte_t) atol(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"plc") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				jb->plc = (apr_byte_t) atol(cdata_text_get(elem));
+			}
+		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
 		}
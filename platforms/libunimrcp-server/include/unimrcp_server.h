@@ -40,6 +40,17 @@ MRCP_DECLARE(mrcp_server_t*) unimrcp_server_start(apt_dir_layout_t *dir_layout);
  */
 MRCP_DECLARE(apt_bool_t) unimrcp_server_shutdown(mrcp_server_t *server);
 
+/** 
+ * Reload configuration of running UniMRCP server.
+ * @param server the MRCP server to reload configuration of
+ * @param dir_layout the dir layout structure
+ * @remark Changed RTP settings (including codecs) and profiles are applied live,
+ * established sessions keep using the profiles they have been created with.
+ * The reload is discarded as a whole, if any changed profile fails to load.
+ * Changes of properties, server core and components require restart.
+ */
+MRCP_DECLARE(apt_bool_t) unimrcp_server_reload(mrcp_server_t *server, apt_dir_layout_t *dir_layout);
+
 APT_END_EXTERN_C
 
 #endif /* UNIMRCP_SERVER_H */
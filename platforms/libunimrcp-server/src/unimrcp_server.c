@@ -29,6 +29,7 @@
 #include "mrcp_unirtsp_server_agent.h"
 #include "mrcp_server_connection.h"
 #include "apt_net.h"
+#include "apt_pool.h"
 #include "apt_log.h"
 
 #define CONF_FILE_NAME            "unimrcpserver.xml"
@@ -51,8 +52,38 @@
 
 #define XML_FILE_BUFFER_LENGTH    16000
 
+#define SNAPSHOT_USERDATA_KEY     "unimrcp-server-snapshot"
+
 /** UniMRCP server loader */
 typedef struct unimrcp_server_loader_t unimrcp_server_loader_t;
+/** Snapshot of the loaded configuration */
+typedef struct unimrcp_server_snapshot_t unimrcp_server_snapshot_t;
+/** Time spent to load a component */
+typedef struct unimrcp_server_timing_t unimrcp_server_timing_t;
+
+/** 
+ * Snapshot of the loaded configuration.
+ * Each entry is the canonical text of the element it has been loaded from,
+ * which is compared against the configuration being reloaded.
+ */
+struct unimrcp_server_snapshot_t {
+	/** Sections, which are loaded once at startup (properties, server core, components) */
+	apr_hash_t *sections;
+	/** RTP settings, which can be updated live (id -> text) */
+	apr_hash_t *settings;
+	/** Profiles, which can be updated live (id -> text) */
+	apr_hash_t *profiles;
+	/** Memory pool of the snapshot */
+	apr_pool_t *pool;
+};
+
+/** Time spent to load a component */
+struct unimrcp_server_timing_t {
+	/** Name of the component */
+	const char          *name;
+	/** Elapsed time */
+	apr_interval_time_t  time;
+};
 
 /** UniMRCP server loader */
 struct unimrcp_server_loader_t {
@@ -64,6 +95,8 @@ struct unimrcp_server_loader_t {
 	apr_xml_doc      *doc;
 	/** Pool to allocate memory from */
 	apr_pool_t       *pool;
+	/** Pool to allocate RTP settings and profiles from */
+	apr_pool_t       *profile_pool;
 
 	/** Default ip address (named property) */
 	const char       *ip;
@@ -72,6 +105,19 @@ struct unimrcp_server_loader_t {
 	
 	/** Implicitly detected, cached ip address */
 	const char      *auto_ip;
+
+	/** Snapshot of the configuration being loaded */
+	unimrcp_server_snapshot_t *snapshot;
+	/** Snapshot of the configuration currently in use (reload only) */
+	unimrcp_server_snapshot_t *cur_snapshot;
+	/** Identifiers of changed RTP settings (reload only) */
+	apr_hash_t                *changed_settings;
+	/** Number of added, replaced and removed profiles (reload only) */
+	apr_size_t                 changed_profile_count;
+	/** Number of changed profiles, which failed to load (reload only) */
+	apr_size_t                 failed_profile_count;
+	/** Load timings (unimrcp_server_timing_t) */
+	apr_array_header_t        *timings;
 };
 
 static apt_bool_t unimrcp_server_load(mrcp_server_t *mrcp_server, apt_dir_layout_t *dir_layout, apr_pool_t *pool);
@@ -154,6 +200,41 @@ static APR_INLINE char* cdata_copy(const apr_xml_elem *elem, apr_pool_t *pool)
 	return apr_pstrdup(pool,elem->first_cdata.first->text);
 }
 
+/** Get canonical text of the element */
+static const char* elem_text_get(const apr_xml_elem *elem, apr_pool_t *pool)
+{
+	const char *text = NULL;
+	apr_xml_to_text(pool,elem,APR_XML_X2T_FULL,NULL,NULL,&text,NULL);
+	return text ? text : "";
+}
+
+/** Check whether the element differs from the one in the snapshot */
+static apt_bool_t snapshot_entry_changed(apr_hash_t *table, const char *key, const char *text)
+{
+	const char *cur_text = apr_hash_get(table,key,APR_HASH_KEY_STRING);
+	return (!cur_text || strcmp(cur_text,text) != 0) ? TRUE : FALSE;
+}
+
+/** Add load timing of the component */
+static void unimrcp_server_timing_add(unimrcp_server_loader_t *loader, const char *name, const char *id, apr_time_t start_time)
+{
+	unimrcp_server_timing_t *timing = apr_array_push(loader->timings);
+	timing->name = id ? apr_psprintf(loader->pool,"%s <%s>",name,id) : name;
+	timing->time = apr_time_now() - start_time;
+}
+
+/** Log load timings of the components */
+static void unimrcp_server_timings_log(unimrcp_server_loader_t *loader, const char *title, apr_time_t start_time)
+{
+	int i;
+	const unimrcp_server_timing_t *timing;
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"%s [%"APR_TIME_T_FMT" usec]",title,apr_time_now() - start_time);
+	for(i=0; i<loader->timings->nelts; i++) {
+		timing = &APR_ARRAY_IDX(loader->timings,i,unimrcp_server_timing_t);
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Load Time %s [%"APR_TIME_T_FMT" usec]",timing->name,timing->time);
+	}
+}
+
 /** Get generic "id" and "enable" attributes */
 static apt_bool_t header_attribs_get(const apr_xml_elem *elem, const apr_xml_attr **id, const apr_xml_attr **enable)
 {
@@ -501,6 +582,10 @@ static apt_bool_t unimrcp_server_media_engine_load(unimrcp_server_loader_t *load
 	const apr_xml_elem *elem;
 	mpf_engine_t *media_engine;
 	unsigned long realtime_rate = 1;
+	apr_size_t worker_count = 1;
+	apt_bool_t profiling = FALSE;
+	apr_size_t profile_sample_rate = 0;
+	apr_size_t profile_dump_interval = 0;
 
 	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading Media Engine <%s>",id);
 	for(elem = root->first_child; elem; elem = elem->next) {
@@ -510,6 +595,26 @@ static apt_bool_t unimrcp_server_media_engine_load(unimrcp_server_loader_t *load
 				realtime_rate = atol(cdata_text_get(elem));
 			}
 		}
+		else if(strcasecmp(elem->name,"worker-count") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				worker_count = atol(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"profiling") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				profiling = cdata_bool_get(elem);
+			}
+		}
+		else if(strcasecmp(elem->name,"profile-sample-rate") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				profile_sample_rate = atol(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"profile-dump-interval") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				profile_dump_interval = atol(cdata_text_get(elem));
+			}
+		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
 		}
@@ -518,6 +623,12 @@ static apt_bool_t unimrcp_server_media_engine_load(unimrcp_server_loader_t *load
 	media_engine = mpf_engine_create(id,loader->pool);
 	if(media_engine) {
 		mpf_engine_scheduler_rate_set(media_engine,realtime_rate);
+		if(worker_count > 1) {
+			mpf_engine_worker_count_set(media_engine,worker_count);
+		}
+		if(profiling == TRUE) {
+			mpf_engine_profiling_set(media_engine,TRUE,profile_sample_rate,profile_dump_interval);
+		}
 	}
 	return mrcp_server_media_engine_register(loader->server,media_engine);
 }
@@ -554,6 +665,11 @@ static apt_bool_t unimrcp_server_rtp_factory_load(unimrcp_server_loader_t *loade
 				rtp_config->rtp_port_max = (apr_port_t)atol(cdata_text_get(elem));
 			}
 		}
+		else if(strcasecmp(elem->name,"rtp-poller") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				rtp_config->rtp_poller = cdata_bool_get(elem);
+			}
+		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
 		}
@@ -586,6 +702,8 @@ static apt_bool_t unimrcp_server_plugin_load(unimrcp_server_loader_t *loader, co
 	const char *plugin_ext = NULL;
 	const char *plugin_path = NULL;
 	apt_bool_t plugin_enabled = TRUE;
+	apt_bool_t status;
+	apr_time_t start_time;
 	const apr_xml_attr *attr;
 	for(attr = root->attr; attr; attr = attr->next) {
 		if(strcasecmp(attr->name,"id") == 0) {
@@ -652,8 +770,11 @@ static apt_bool_t unimrcp_server_plugin_load(unimrcp_server_loader_t *loader, co
 		}
 	}
 
+	start_time = apr_time_now();
 	engine = mrcp_server_engine_load(loader->server,plugin_id,plugin_path,config);
-	return mrcp_server_engine_register(loader->server,engine);
+	status = mrcp_server_engine_register(loader->server,engine);
+	unimrcp_server_timing_add(loader,"engine",plugin_id,start_time);
+	return status;
 }
 
 /** Load plugin (engine) factory */
@@ -711,6 +832,16 @@ static apt_bool_t unimrcp_server_jb_settings_load(unimrcp_server_loader_t *loade
 				jb->time_skew_detection = (apr_byte_t) atol(cdata_text_get(elem));
 			}
 		}
+		else if(strcasecmp(elem->name,"playout-percentile") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				jb->playout_percentile = (apr_byte_t) atol(cdata_text_get(elem));
+			}
+		}
+		else if(strcasecmp(elem->name,"plc") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				jb->plc = (apr_byte_t) atol(cdata_text_get(elem));
+			}
+		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
 		}
@@ -764,7 +895,7 @@ static apt_bool_t unimrcp_server_rtcp_settings_load(unimrcp_server_loader_t *loa
 static apt_bool_t unimrcp_server_rtp_settings_load(unimrcp_server_loader_t *loader, const apr_xml_elem *root, const char *id)
 {
 	const apr_xml_elem *elem;
-	mpf_rtp_settings_t *rtp_settings = mpf_rtp_settings_alloc(loader->pool);
+	mpf_rtp_settings_t *rtp_settings = mpf_rtp_settings_alloc(loader->profile_pool);
 
 	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading RTP Settings <%s>",id);
 	for(elem = root->first_child; elem; elem = elem->next) {
@@ -785,7 +916,7 @@ static apt_bool_t unimrcp_server_rtp_settings_load(unimrcp_server_loader_t *load
 					codec_manager,
 					&rtp_settings->codec_list,
 					cdata_text_get(elem),
-					loader->pool);
+					loader->profile_pool);
 			}
 			for(attr = elem->attr; attr; attr = attr->next) {
 				if(strcasecmp(attr->name,"own-preference") == 0) {
@@ -860,7 +991,7 @@ static apt_bool_t unimrcp_server_mrcpv2_profile_load(unimrcp_server_loader_t *lo
 			rtp_settings = mrcp_server_rtp_settings_get(loader->server,cdata_text_get(elem));
 		}
 		else if(strcasecmp(elem->name,"resource-engine-map") == 0) {
-			resource_engine_map = resource_engine_map_load(elem,loader->pool);
+			resource_engine_map = resource_engine_map_load(elem,loader->profile_pool);
 		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
@@ -876,7 +1007,7 @@ static apt_bool_t unimrcp_server_mrcpv2_profile_load(unimrcp_server_loader_t *lo
 				media_engine,
 				rtp_factory,
 				rtp_settings,
-				loader->pool);
+				loader->profile_pool);
 	return mrcp_server_profile_register(loader->server,profile,resource_engine_map);
 }
 
@@ -912,7 +1043,7 @@ static apt_bool_t unimrcp_server_mrcpv1_profile_load(unimrcp_server_loader_t *lo
 			rtp_settings = mrcp_server_rtp_settings_get(loader->server,cdata_text_get(elem));
 		}
 		else if(strcasecmp(elem->name,"resource-engine-map") == 0) {
-			resource_engine_map = resource_engine_map_load(elem,loader->pool);
+			resource_engine_map = resource_engine_map_load(elem,loader->profile_pool);
 		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
@@ -928,7 +1059,7 @@ static apt_bool_t unimrcp_server_mrcpv1_profile_load(unimrcp_server_loader_t *lo
 				media_engine,
 				rtp_factory,
 				rtp_settings,
-				loader->pool);
+				loader->profile_pool);
 	return mrcp_server_profile_register(loader->server,profile,resource_engine_map);
 }
 
@@ -956,6 +1087,29 @@ static apt_bool_t unimrcp_server_properties_load(unimrcp_server_loader_t *loader
 	return TRUE;
 }
 
+/** Load settings of the server core */
+static apt_bool_t unimrcp_server_core_load(unimrcp_server_loader_t *loader, const apr_xml_elem *root)
+{
+	const apr_xml_elem *elem;
+
+	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading Server Core");
+	for(elem = root->first_child; elem; elem = elem->next) {
+		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading Element <%s>",elem->name);
+		if(strcasecmp(elem->name,"shard-count") == 0) {
+			if(is_cdata_valid(elem) == TRUE) {
+				apr_size_t shard_count = atol(cdata_text_get(elem));
+				if(shard_count > 1) {
+					mrcp_server_shard_count_set(loader->server,shard_count);
+				}
+			}
+		}
+		else {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
+		}
+	}
+	return TRUE;
+}
+
 /** Load components */
 static apt_bool_t unimrcp_server_components_load(unimrcp_server_loader_t *loader, const apr_xml_elem *root)
 {
@@ -963,6 +1117,7 @@ static apt_bool_t unimrcp_server_components_load(unimrcp_server_loader_t *loader
 	const apr_xml_attr *id_attr;
 	const apr_xml_attr *enable_attr;
 	const char *id;
+	apr_time_t start_time;
 
 	/* Create codec manager first (probably it should be loaded from config either) */
 	mpf_codec_manager_t *codec_manager = mpf_engine_codec_manager_create(loader->pool);
@@ -992,6 +1147,7 @@ static apt_bool_t unimrcp_server_components_load(unimrcp_server_loader_t *loader
 		}
 		id = apr_pstrdup(loader->pool,id_attr->value);
 
+		start_time = apr_time_now();
 		if(strcasecmp(elem->name,"sip-uas") == 0) {
 			unimrcp_server_sip_uas_load(loader,elem,id);
 		}
@@ -1012,7 +1168,9 @@ static apt_bool_t unimrcp_server_components_load(unimrcp_server_loader_t *loader
 		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
+			continue;
 		}
+		unimrcp_server_timing_add(loader,elem->name,id,start_time);
 	}
 	return TRUE;
 }
@@ -1024,6 +1182,8 @@ static apt_bool_t unimrcp_server_settings_load(unimrcp_server_loader_t *loader,
 	const apr_xml_attr *id_attr;
 	const apr_xml_attr *enable_attr;
 	const char *id;
+	const char *text;
+	apr_time_t start_time;
 
 	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading Settings");
 	for(elem = root->first_child; elem; elem = elem->next) {
@@ -1036,10 +1196,18 @@ static apt_bool_t unimrcp_server_settings_load(unimrcp_server_loader_t *loader,
 			/* disabled element, just skip it */
 			continue;
 		}
-		id = apr_pstrdup(loader->pool,id_attr->value);
+		id = apr_pstrdup(loader->profile_pool,id_attr->value);
 
 		if(strcasecmp(elem->name,"rtp-settings") == 0) {
+			text = elem_text_get(elem,loader->snapshot->pool);
+			apr_hash_set(loader->snapshot->settings,apr_pstrdup(loader->snapshot->pool,id),APR_HASH_KEY_STRING,text);
+			if(loader->cur_snapshot && snapshot_entry_changed(loader->cur_snapshot->settings,id,text) == TRUE) {
+				apr_hash_set(loader->changed_settings,id,APR_HASH_KEY_STRING,id);
+			}
+
+			start_time = apr_time_now();
 			unimrcp_server_rtp_settings_load(loader,elem,id);
+			unimrcp_server_timing_add(loader,elem->name,id,start_time);
 		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
@@ -1048,6 +1216,20 @@ static apt_bool_t unimrcp_server_settings_load(unimrcp_server_loader_t *loader,
 	return TRUE;
 }
 
+/** Check whether the profile refers to changed RTP settings (reload only) */
+static apt_bool_t unimrcp_server_profile_settings_changed(unimrcp_server_loader_t *loader, const apr_xml_elem *root)
+{
+	const apr_xml_elem *elem;
+	for(elem = root->first_child; elem; elem = elem->next) {
+		if(strcasecmp(elem->name,"rtp-settings") == 0 && is_cdata_valid(elem) == TRUE) {
+			if(apr_hash_get(loader->changed_settings,cdata_text_get(elem),APR_HASH_KEY_STRING)) {
+				return TRUE;
+			}
+		}
+	}
+	return FALSE;
+}
+
 /** Load profiles */
 static apt_bool_t unimrcp_server_profiles_load(unimrcp_server_loader_t *loader, const apr_xml_elem *root)
 {
@@ -1055,6 +1237,10 @@ static apt_bool_t unimrcp_server_profiles_load(unimrcp_server_loader_t *loader,
 	const apr_xml_attr *id_attr;
 	const apr_xml_attr *enable_attr;
 	const char *id;
+	const char *text;
+	apt_bool_t status;
+	apt_bool_t changed;
+	apr_time_t start_time;
 
 	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Loading Profiles");
 	for(elem = root->first_child; elem; elem = elem->next) {
@@ -1067,16 +1253,39 @@ static apt_bool_t unimrcp_server_profiles_load(unimrcp_server_loader_t *loader,
 			/* disabled element, just skip it */
 			continue;
 		}
-		id = apr_pstrdup(loader->pool,id_attr->value);
+		id = apr_pstrdup(loader->profile_pool,id_attr->value);
+
+		text = elem_text_get(elem,loader->snapshot->pool);
+		apr_hash_set(loader->snapshot->profiles,apr_pstrdup(loader->snapshot->pool,id),APR_HASH_KEY_STRING,text);
+		/* all the profiles are loaded into the new generation, but only changed ones are reported */
+		changed = FALSE;
+		if(loader->cur_snapshot) {
+			if(snapshot_entry_changed(loader->cur_snapshot->profiles,id,text) == TRUE ||
+				unimrcp_server_profile_settings_changed(loader,elem) == TRUE) {
+				apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"%s Profile [%s]",
+					apr_hash_get(loader->cur_snapshot->profiles,id,APR_HASH_KEY_STRING) ? "Replace" : "Add",
+					id);
+				loader->changed_profile_count++;
+				changed = TRUE;
+			}
+		}
 
+		start_time = apr_time_now();
 		if(strcasecmp(elem->name,"mrcpv2-profile") == 0) {
-			unimrcp_server_mrcpv2_profile_load(loader,elem,id);
+			status = unimrcp_server_mrcpv2_profile_load(loader,elem,id);
 		}
 		else if(strcasecmp(elem->name,"mrcpv1-profile") == 0) {
-			unimrcp_server_mrcpv1_profile_load(loader,elem,id);
+			status = unimrcp_server_mrcpv1_profile_load(loader,elem,id);
 		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
+			continue;
+		}
+		unimrcp_server_timing_add(loader,elem->name,id,start_time);
+
+		if(status == FALSE && changed == TRUE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Load Changed Profile [%s]",id);
+			loader->failed_profile_count++;
 		}
 	}    
 	return TRUE;
@@ -1107,34 +1316,33 @@ static apr_xml_doc* unimrcp_server_doc_parse(const char *file_path, apr_pool_t *
 	return xml_doc;
 }
 
-static apt_bool_t unimrcp_server_load(mrcp_server_t *mrcp_server, apt_dir_layout_t *dir_layout, apr_pool_t *pool)
+/** Parse XML document and validate its root element */
+static const apr_xml_elem* unimrcp_server_doc_load(apt_dir_layout_t *dir_layout, apr_pool_t *pool)
 {
 	const char *file_path;
 	apr_xml_doc *doc;
-	const apr_xml_elem *elem;
 	const apr_xml_elem *root;
 	const apr_xml_attr *attr;
-	unimrcp_server_loader_t *loader;
 	const char *version = NULL;
 
 	file_path = apt_confdir_filepath_get(dir_layout,CONF_FILE_NAME,pool);
 	if(!file_path) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Get Path to Conf File [%s]",CONF_FILE_NAME);
-		return FALSE;
+		return NULL;
 	}
 
 	/* Parse XML document */
 	doc = unimrcp_server_doc_parse(file_path,pool);
 	if(!doc) {
-		return FALSE;
+		return NULL;
 	}
 
 	root = doc->root;
 
 	/* Match document name */
 	if(!root || strcasecmp(root->name,"unimrcpserver") != 0) {
-		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Document <%s>",root->name);
-		return FALSE;
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Document <%s>",root ? root->name : "null");
+		return NULL;
 	}
 
 	/* Read attributes */
@@ -1147,35 +1355,188 @@ static apt_bool_t unimrcp_server_load(mrcp_server_t *mrcp_server, apt_dir_layout
 	/* Check version number first */
 	if(!version) {
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Version");
-		return FALSE;
+		return NULL;
 	}
+	return root;
+}
+
+/** Create snapshot of the configuration */
+static unimrcp_server_snapshot_t* unimrcp_server_snapshot_create(apr_pool_t *parent_pool)
+{
+	apr_pool_t *pool = apt_subpool_create(parent_pool);
+	unimrcp_server_snapshot_t *snapshot = apr_palloc(pool,sizeof(unimrcp_server_snapshot_t));
+	snapshot->sections = apr_hash_make(pool);
+	snapshot->settings = apr_hash_make(pool);
+	snapshot->profiles = apr_hash_make(pool);
+	snapshot->pool = pool;
+	return snapshot;
+}
 
-	loader = apr_palloc(pool,sizeof(unimrcp_server_loader_t));
-	loader->doc = doc;
+/** Create loader */
+static unimrcp_server_loader_t* unimrcp_server_loader_create(mrcp_server_t *mrcp_server, apt_dir_layout_t *dir_layout, apr_pool_t *pool)
+{
+	unimrcp_server_loader_t *loader = apr_palloc(pool,sizeof(unimrcp_server_loader_t));
+	loader->doc = NULL;
 	loader->server = mrcp_server;
 	loader->dir_layout = dir_layout;
 	loader->pool = pool;
+	loader->profile_pool = mrcp_server_profile_pool_get(mrcp_server);
 	loader->ip = DEFAULT_IP_ADDRESS;
 	loader->ext_ip = NULL;
 	loader->auto_ip = NULL;
+	loader->snapshot = unimrcp_server_snapshot_create(mrcp_server_memory_pool_get(mrcp_server));
+	loader->cur_snapshot = NULL;
+	loader->changed_settings = NULL;
+	loader->changed_profile_count = 0;
+	loader->failed_profile_count = 0;
+	loader->timings = apr_array_make(pool,10,sizeof(unimrcp_server_timing_t));
+	return loader;
+}
+
+static apt_bool_t unimrcp_server_load(mrcp_server_t *mrcp_server, apt_dir_layout_t *dir_layout, apr_pool_t *pool)
+{
+	const apr_xml_elem *elem;
+	const apr_xml_elem *root;
+	unimrcp_server_loader_t *loader;
+	apr_time_t start_time = apr_time_now();
+	apr_time_t section_start_time;
+
+	root = unimrcp_server_doc_load(dir_layout,pool);
+	if(!root) {
+		return FALSE;
+	}
+
+	loader = unimrcp_server_loader_create(mrcp_server,dir_layout,pool);
+	unimrcp_server_timing_add(loader,"config",NULL,start_time);
 
 	/* Navigate through document */
 	for(elem = root->first_child; elem; elem = elem->next) {
+		section_start_time = apr_time_now();
 		if(strcasecmp(elem->name,"properties") == 0) {
 			unimrcp_server_properties_load(loader,elem);
 		}
+		else if(strcasecmp(elem->name,"server") == 0) {
+			unimrcp_server_core_load(loader,elem);
+		}
 		else if(strcasecmp(elem->name,"components") == 0) {
 			unimrcp_server_components_load(loader,elem);
 		}
 		else if(strcasecmp(elem->name,"settings") == 0) {
 			unimrcp_server_settings_load(loader,elem);
+			continue;
 		}
 		else if(strcasecmp(elem->name,"profiles") == 0) {
 			unimrcp_server_profiles_load(loader,elem);
+			continue;
 		}
 		else {
 			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Element <%s>",elem->name);
+			continue;
+		}
+		/* sections, which are loaded once, are kept as a whole */
+		apr_hash_set(loader->snapshot->sections,
+			apr_pstrdup(loader->snapshot->pool,elem->name),APR_HASH_KEY_STRING,
+			elem_text_get(elem,loader->snapshot->pool));
+		if(strcasecmp(elem->name,"components") != 0) {
+			unimrcp_server_timing_add(loader,elem->name,NULL,section_start_time);
 		}
 	}
+
+	apr_pool_userdata_set(loader->snapshot,SNAPSHOT_USERDATA_KEY,NULL,pool);
+	unimrcp_server_timings_log(loader,"Load UniMRCP Server Document",start_time);
 	return TRUE;
 }
+
+/** Reload UniMRCP server configuration */
+MRCP_DECLARE(apt_bool_t) unimrcp_server_reload(mrcp_server_t *server, apt_dir_layout_t *dir_layout)
+{
+	apr_pool_t *pool;
+	apr_pool_t *doc_pool;
+	const apr_xml_elem *elem;
+	const apr_xml_elem *root;
+	unimrcp_server_loader_t *loader;
+	unimrcp_server_snapshot_t *cur_snapshot = NULL;
+	apr_hash_index_t *it;
+	const void *key;
+	apt_bool_t status = FALSE;
+	apr_time_t start_time = apr_time_now();
+
+	if(!server || !dir_layout) {
+		return FALSE;
+	}
+	pool = mrcp_server_memory_pool_get(server);
+	if(!pool) {
+		return FALSE;
+	}
+	apr_pool_userdata_get((void**)&cur_snapshot,SNAPSHOT_USERDATA_KEY,pool);
+	if(!cur_snapshot) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Reload UniMRCP Server Document: not loaded");
+		return FALSE;
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Reload UniMRCP Server Document");
+	/* the document and the loader are only needed while reloading, while the reloaded
+	settings and profiles make up a new generation, which has its own pool */
+	doc_pool = apt_subpool_create(pool);
+	root = unimrcp_server_doc_load(dir_layout,doc_pool);
+	if(root && mrcp_server_profiles_reload_begin(server) == TRUE) {
+		loader = unimrcp_server_loader_create(server,dir_layout,doc_pool);
+		loader->cur_snapshot = cur_snapshot;
+		loader->changed_settings = apr_hash_make(doc_pool);
+
+		for(elem = root->first_child; elem; elem = elem->next) {
+			if(strcasecmp(elem->name,"settings") == 0) {
+				unimrcp_server_settings_load(loader,elem);
+			}
+			else if(strcasecmp(elem->name,"profiles") == 0) {
+				unimrcp_server_profiles_load(loader,elem);
+			}
+			else {
+				const char *text = elem_text_get(elem,doc_pool);
+				if(snapshot_entry_changed(cur_snapshot->sections,elem->name,text) == TRUE) {
+					apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Changed Element <%s> Requires Restart",elem->name);
+				}
+			}
+		}
+
+		for(it = apr_hash_first(doc_pool,cur_snapshot->profiles); it; it = apr_hash_next(it)) {
+			apr_hash_this(it,&key,NULL,NULL);
+			if(!apr_hash_get(loader->snapshot->profiles,key,APR_HASH_KEY_STRING)) {
+				apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Remove Profile [%s]",(const char*)key);
+				loader->changed_profile_count++;
+			}
+		}
+
+		if(loader->failed_profile_count) {
+			/* the reloaded generation is discarded as a whole, the current one stays in use */
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Reload UniMRCP Server Document: invalid profiles [%"APR_SIZE_T_FMT"]",
+				loader->failed_profile_count);
+			mrcp_server_profiles_reload_end(server,FALSE);
+			apr_pool_destroy(loader->snapshot->pool);
+		}
+		else {
+			if(loader->changed_profile_count) {
+				mrcp_server_profiles_reload_end(server,TRUE);
+			}
+			else {
+				apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"No Profile Changed");
+				mrcp_server_profiles_reload_end(server,FALSE);
+			}
+
+			/* sections requiring restart are compared against the initially loaded ones */
+			for(it = apr_hash_first(doc_pool,cur_snapshot->sections); it; it = apr_hash_next(it)) {
+				void *val;
+				apr_hash_this(it,&key,NULL,&val);
+				apr_hash_set(loader->snapshot->sections,
+					apr_pstrdup(loader->snapshot->pool,key),APR_HASH_KEY_STRING,
+					apr_pstrdup(loader->snapshot->pool,val));
+			}
+			apr_pool_userdata_set(loader->snapshot,SNAPSHOT_USERDATA_KEY,NULL,pool);
+			apr_pool_destroy(cur_snapshot->pool);
+			unimrcp_server_timings_log(loader,"Reload UniMRCP Server Document",start_time);
+			status = TRUE;
+		}
+	}
+	apr_pool_destroy(doc_pool);
+	return status;
+}
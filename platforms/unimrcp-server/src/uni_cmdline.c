@@ -21,7 +21,7 @@
 #include "unimrcp_server.h"
 #include "apt_log.h"
 
-static apt_bool_t cmdline_process(char *cmdline)
+static apt_bool_t cmdline_process(mrcp_server_t *server, apt_dir_layout_t *dir_layout, char *cmdline)
 {
 	apt_bool_t running = TRUE;
 	char *name;
@@ -34,12 +34,16 @@ static apt_bool_t cmdline_process(char *cmdline)
 			apt_log_priority_set(atol(priority));
 		}
 	}
+	else if(strcasecmp(name,"reload") == 0) {
+		unimrcp_server_reload(server,dir_layout);
+	}
 	else if(strcasecmp(name,"exit") == 0 || strcmp(name,"quit") == 0) {
 		running = FALSE;
 	}
 	else if(strcasecmp(name,"help") == 0) {
 		printf("usage:\n");
 		printf("- loglevel [level] (set loglevel, one of 0,1...7)\n");
+		printf("- reload (apply changed settings and profiles)\n");
 		printf("- quit, exit\n");
 	}
 	else {
@@ -72,7 +76,7 @@ apt_bool_t uni_cmdline_run(apt_dir_layout_t *dir_layout, apr_pool_t *pool)
 			}
 		}
 		if(*cmdline) {
-			running = cmdline_process(cmdline);
+			running = cmdline_process(server,dir_layout,cmdline);
 		}
 	}
 	while(running != 0);
@@ -16,24 +16,37 @@
  * $Id$
  */
 
+#include <signal.h>
 #include <apr_signal.h>
 #include <apr_thread_proc.h>
 #include "unimrcp_server.h"
 #include "apt_log.h"
 
 static apt_bool_t daemon_running;
+static volatile sig_atomic_t daemon_reload;
 
 static void sigterm_handler(int signo)
 {
 	daemon_running = FALSE;
 }
 
+#ifdef SIGHUP
+static void sighup_handler(int signo)
+{
+	daemon_reload = 1;
+}
+#endif
+
 apt_bool_t uni_daemon_run(apt_dir_layout_t *dir_layout, apr_pool_t *pool)
 {
 	mrcp_server_t *server;
 
 	daemon_running = TRUE;
+	daemon_reload = 0;
 	apr_signal(SIGTERM,sigterm_handler);
+#ifdef SIGHUP
+	apr_signal(SIGHUP,sighup_handler);
+#endif
 
 	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Run as Daemon");
 	apr_proc_detach(APR_PROC_DETACH_DAEMONIZE);
@@ -44,7 +57,13 @@ apt_bool_t uni_daemon_run(apt_dir_layout_t *dir_layout, apr_pool_t *pool)
 		return FALSE;
 	}
 
-	while(daemon_running) apr_sleep(1000000);
+	while(daemon_running) {
+		apr_sleep(1000000);
+		if(daemon_reload) {
+			daemon_reload = 0;
+			unimrcp_server_reload(server,dir_layout);
+		}
+	}
 
 	/* shutdown server */
 	unimrcp_server_shutdown(server);
@@ -195,6 +195,7 @@ static mrcp_engine_channel_t* demo_recog_engine_channel_create(mrcp_engine_t *en
 {
 	mpf_stream_capabilities_t *capabilities;
 	mpf_termination_t *termination; 
+	const char *vad_mode;
 
 	/* create demo recog channel */
 	demo_recog_channel_t *recog_channel = apr_palloc(pool,sizeof(demo_recog_channel_t));
@@ -204,6 +205,11 @@ static mrcp_engine_channel_t* demo_recog_engine_channel_create(mrcp_engine_t *en
 	recog_channel->detector = mpf_activity_detector_create(pool);
 	recog_channel->audio_out = NULL;
 
+	vad_mode = mrcp_engine_param_get(engine,"vad-mode");
+	if(vad_mode && strcasecmp(vad_mode,"adaptive") == 0) {
+		mpf_activity_detector_mode_set(recog_channel->detector,MPF_DETECTOR_MODE_ADAPTIVE);
+	}
+
 	capabilities = mpf_sink_stream_capabilities_create(pool);
 	mpf_codec_capabilities_add(
 			&capabilities->codecs,
@@ -281,6 +287,9 @@ static apt_bool_t demo_recog_channel_recognize(mrcp_engine_channel_t *channel, m
 		if(mrcp_resource_header_property_check(request,RECOGNIZER_HEADER_SPEECH_COMPLETE_TIMEOUT) == TRUE) {
 			mpf_activity_detector_silence_timeout_set(recog_channel->detector,recog_header->speech_complete_timeout);
 		}
+		if(mrcp_resource_header_property_check(request,RECOGNIZER_HEADER_SENSITIVITY_LEVEL) == TRUE) {
+			mpf_activity_detector_sensitivity_set(recog_channel->detector,recog_header->sensitivity_level);
+		}
 	}
 
 	if(!recog_channel->audio_out) {
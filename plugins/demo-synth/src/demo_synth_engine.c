@@ -30,6 +30,7 @@
  */
 
 #include "mrcp_synth_engine.h"
+#include "mpf_file_io.h"
 #include "apt_consumer_task.h"
 #include "apt_log.h"
 
@@ -85,6 +86,8 @@ static const mpf_audio_stream_vtable_t audio_stream_vtable = {
 /** Declaration of demo synthesizer engine */
 struct demo_synth_engine_t {
 	apt_consumer_task_t    *task;
+	/** File I/O shared by the channels */
+	mpf_file_io_t          *file_io;
 };
 
 /** Declaration of demo synthesizer channel */
@@ -102,8 +105,8 @@ struct demo_synth_channel_t {
 	apr_size_t             time_to_complete;
 	/** Is paused */
 	apt_bool_t             paused;
-	/** Speech source (used instead of actual synthesis) */
-	FILE                  *audio_file;
+	/** Speech source (used instead of actual synthesis, read in background) */
+	mpf_async_file_t      *audio_file;
 };
 
 typedef enum {
@@ -151,6 +154,11 @@ MRCP_PLUGIN_DECLARE(mrcp_engine_t*) mrcp_plugin_create(apr_pool_t *pool)
 		vtable->process_msg = demo_synth_msg_process;
 	}
 
+	demo_engine->file_io = mpf_file_io_create(MPF_FILE_IO_DEFAULT_BUFFER_SIZE,pool);
+	if(!demo_engine->file_io) {
+		return NULL;
+	}
+
 	/* create engine base */
 	return mrcp_engine_create(
 				MRCP_SYNTHESIZER_RESOURCE, /* MRCP resource identifier */
@@ -175,6 +183,10 @@ static apt_bool_t demo_synth_engine_destroy(mrcp_engine_t *engine)
 static apt_bool_t demo_synth_engine_open(mrcp_engine_t *engine)
 {
 	demo_synth_engine_t *demo_engine = engine->obj;
+	if(mpf_file_io_start(demo_engine->file_io) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Start Demo Synth File I/O");
+		return mrcp_engine_open_respond(engine,FALSE);
+	}
 	if(demo_engine->task) {
 		apt_task_t *task = apt_consumer_task_base_get(demo_engine->task);
 		apt_task_start(task);
@@ -190,6 +202,7 @@ static apt_bool_t demo_synth_engine_close(mrcp_engine_t *engine)
 		apt_task_t *task = apt_consumer_task_base_get(demo_engine->task);
 		apt_task_terminate(task,TRUE);
 	}
+	mpf_file_io_stop(demo_engine->file_io);
 	return mrcp_engine_close_respond(engine);
 }
 
@@ -276,7 +289,7 @@ static apt_bool_t demo_synth_channel_speak(mrcp_engine_channel_t *channel, mrcp_
 		file_path = apt_datadir_filepath_get(channel->engine->dir_layout,file_name,channel->pool);
 	}
 	if(file_path) {
-		synth_channel->audio_file = fopen(file_path,"rb");
+		synth_channel->audio_file = mpf_async_file_open(synth_channel->demo_engine->file_io,file_path,MPF_ASYNC_FILE_READ);
 		if(synth_channel->audio_file) {
 			apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Set [%s] as Speech Source "APT_SIDRES_FMT,
 				file_path,
@@ -425,6 +438,11 @@ static apt_bool_t demo_synth_channel_request_dispatch(mrcp_engine_channel_t *cha
 /** Callback is called from MPF engine context to destroy any additional data associated with audio stream */
 static apt_bool_t demo_synth_stream_destroy(mpf_audio_stream_t *stream)
 {
+	demo_synth_channel_t *synth_channel = stream->obj;
+	if(synth_channel->audio_file) {
+		mpf_async_file_close(synth_channel->audio_file);
+		synth_channel->audio_file = NULL;
+	}
 	return TRUE;
 }
 
@@ -452,7 +470,7 @@ static apt_bool_t demo_synth_stream_read(mpf_audio_stream_t *stream, mpf_frame_t
 		synth_channel->speak_request = NULL;
 		synth_channel->paused = FALSE;
 		if(synth_channel->audio_file) {
-			fclose(synth_channel->audio_file);
+			mpf_async_file_close(synth_channel->audio_file);
 			synth_channel->audio_file = NULL;
 		}
 		return TRUE;
@@ -463,12 +481,11 @@ static apt_bool_t demo_synth_stream_read(mpf_audio_stream_t *stream, mpf_frame_t
 		/* normal processing */
 		apt_bool_t completed = FALSE;
 		if(synth_channel->audio_file) {
-			/* read speech from file */
-			apr_size_t size = frame->codec_frame.size;
-			if(fread(frame->codec_frame.buffer,1,size,synth_channel->audio_file) == size) {
+			/* read speech prefetched from file */
+			if(mpf_async_file_read(synth_channel->audio_file,frame->codec_frame.buffer,frame->codec_frame.size) == TRUE) {
 				frame->type |= MEDIA_FRAME_TYPE_AUDIO;
 			}
-			else {
+			else if(mpf_async_file_eof(synth_channel->audio_file) == TRUE) {
 				completed = TRUE;
 			}
 		}
@@ -503,7 +520,7 @@ static apt_bool_t demo_synth_stream_read(mpf_audio_stream_t *stream, mpf_frame_t
 
 				synth_channel->speak_request = NULL;
 				if(synth_channel->audio_file) {
-					fclose(synth_channel->audio_file);
+					mpf_async_file_close(synth_channel->audio_file);
 					synth_channel->audio_file = NULL;
 				}
 				/* send asynch event */
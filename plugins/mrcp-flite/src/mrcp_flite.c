@@ -36,6 +36,11 @@
 #include "apt_consumer_task.h"
 #include "apt_log.h"
 
+/* max size of audio fed to the stream at once (bytes) */
+#define FLITE_AUDIO_CHUNK_SIZE 3200
+/* time to wait for the stream to consume audio (usec) */
+#define FLITE_AUDIO_WAIT_TIME  (CODEC_FRAME_TIME_BASE * 2 * 1000)
+
 typedef struct flite_synth_engine_t flite_synth_engine_t;
 typedef struct flite_synth_channel_t flite_synth_channel_t;
 
@@ -100,6 +105,7 @@ struct flite_synth_channel_t {
 	mrcp_message_t        *stop_response; /* Pending stop response */
 	apt_bool_t             synthesizing;  /* Is synthesizer task processing speak request */
 	apt_bool_t             paused;        /* Is paused */
+	apt_bool_t             closing;       /* Is channel being closed */
 	mpf_buffer_t          *audio_buffer;  /* Audio buffer */
 	int                    iId;           /* Synth channel simultaneous reference count */
 	apr_pool_t            *pool;
@@ -218,6 +224,7 @@ static mrcp_engine_channel_t* flite_synth_engine_channel_create(mrcp_engine_t *e
 	synth_channel->synthesizing = FALSE;
 	synth_channel->paused = FALSE;
 	synth_channel->pool = pool;
+	synth_channel->closing = FALSE;
 	synth_channel->audio_buffer = NULL;
 	synth_channel->iId = 0;
 	synth_channel->task = NULL;
@@ -300,6 +307,8 @@ static apt_bool_t flite_synth_channel_close(mrcp_engine_channel_t *channel)
 	flite_synth_channel_t *synth_channel = (flite_synth_channel_t *) channel->method_obj;
 	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "flite_synth_channel_close - channel %d", synth_channel->iId);
 
+	/* make sure speak task doesn't wait for the stream to consume the audio anymore */
+	synth_channel->closing = TRUE;
 	if(synth_channel->task) {
 		if(apt_task_terminate(synth_channel->task,FALSE) == TRUE) {
 			/* async response will be sent */
@@ -418,6 +427,28 @@ static apt_bool_t flite_synth_channel_speak(mrcp_engine_channel_t *channel, mrcp
 	return TRUE;
 }
 
+/** Feed synthesized audio to the stream, waiting for room in the bounded buffer */
+static void flite_synth_audio_write(flite_synth_channel_t *synth_channel, char *data, apr_size_t size)
+{
+	apr_size_t chunk_size;
+	while(size) {
+		if(synth_channel->stop_response || synth_channel->closing == TRUE) {
+			/* the rest of the speech is not going to be played */
+			break;
+		}
+
+		chunk_size = size < FLITE_AUDIO_CHUNK_SIZE ? size : FLITE_AUDIO_CHUNK_SIZE;
+		if(mpf_buffer_audio_write(synth_channel->audio_buffer, data, chunk_size) == TRUE) {
+			data += chunk_size;
+			size -= chunk_size;
+		}
+		else {
+			/* buffer is full, let the stream consume some audio */
+			apr_sleep(FLITE_AUDIO_WAIT_TIME);
+		}
+	}
+}
+
 static apt_bool_t flite_speak(apt_task_t *task, apt_task_msg_t *msg)
 {
 	flite_speak_msg_t *flite_msg = (flite_speak_msg_t*)msg->data;
@@ -490,7 +521,7 @@ static apt_bool_t flite_speak(apt_task_t *task, apt_task_msg_t *msg)
 			elapsed = (apr_time_now() - stamp)/1000;
 			apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "TTS resampling to %d on (chan %d) took %"APR_TIME_T_FMT" millisec", rate, synth_channel->iId, elapsed);
 		}
-		mpf_buffer_audio_write(synth_channel->audio_buffer, cst_wave_samples(wave), cst_wave_num_samples(wave) * 2);
+		flite_synth_audio_write(synth_channel, (char*)cst_wave_samples(wave), cst_wave_num_samples(wave) * 2);
 		delete_wave(wave);
 	}
 
@@ -601,6 +632,8 @@ static apt_bool_t flite_synth_stream_read(mpf_audio_stream_t *stream, mpf_frame_
 		synth_channel->stop_response = NULL;
 		synth_channel->speak_request = NULL;
 		synth_channel->paused = FALSE;
+		/* drop the audio not played yet */
+		mpf_buffer_restart(synth_channel->audio_buffer);
 		mrcp_engine_channel_message_send(synth_channel->channel,stop_response);
 		return TRUE;
 	}
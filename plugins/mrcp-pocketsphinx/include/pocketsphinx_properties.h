@@ -50,6 +50,9 @@ struct pocketsphinx_properties_t {
 	/** Preferred (default) model */
 	pocketsphinx_model_e preferred_model;
 
+	/** Number of decoder worker threads shared by all the channels */
+	apr_size_t           worker_count;
+
 	/** Sensitivity level */
 	apr_size_t           sensitivity_level;
 	/** Activity timeout (timeout to be used to switch to the activity state) */
@@ -29,10 +29,13 @@
  * 5. Methods (callbacks) of the MPF engine stream MUST not block.
  */
 
+#include <stdlib.h>
 #include <pocketsphinx.h>
+#include <jsgf.h>
 #include <apr_thread_cond.h>
 #include <apr_thread_proc.h>
-#include <apr_tables.h>
+#include <apr_hash.h>
+#include <apr_ring.h>
 #include <apr_file_io.h>
 #include "mrcp_recog_engine.h"
 #include "mpf_activity_detector.h"
@@ -43,8 +46,16 @@
 
 #define RECOGNIZER_SIDRES(recognizer) (recognizer)->channel->id.buf, "pocketsphinx"
 
+/** Max number of grammars kept compiled in a decoder */
+#define POCKETSPHINX_DECODER_GRAMMAR_MAX 16
+/** Size of grammar digest string (hash and length of the content) */
+#define POCKETSPHINX_DIGEST_SIZE         40
+
 typedef struct pocketsphinx_engine_t pocketsphinx_engine_t;
 typedef struct pocketsphinx_recognizer_t pocketsphinx_recognizer_t;
+typedef struct pocketsphinx_model_t pocketsphinx_model_t;
+typedef struct pocketsphinx_decoder_t pocketsphinx_decoder_t;
+typedef struct pocketsphinx_grammar_t pocketsphinx_grammar_t;
 
 /** Methods of recognition engine */
 static apt_bool_t pocketsphinx_engine_destroy(mrcp_engine_t *engine);
@@ -86,12 +97,79 @@ static const mpf_audio_stream_vtable_t audio_stream_vtable = {
 	pocketsphinx_stream_write
 };
 
+/** Grammar compiled into decoder */
+typedef struct pocketsphinx_compiled_grammar_t pocketsphinx_compiled_grammar_t;
+struct pocketsphinx_compiled_grammar_t {
+	/** Digest of the grammar (also used as the name of FSG) */
+	char       digest[POCKETSPHINX_DIGEST_SIZE];
+	/** Sequence number of the last use */
+	apr_size_t last_used;
+};
+
+/** Decoder loaded with acoustic model (reused across recognizers) */
+struct pocketsphinx_decoder_t {
+	/** Ring entry */
+	APR_RING_ENTRY(pocketsphinx_decoder_t) link;
+	/** Actual decoder object */
+	ps_decoder_t                   *ps;
+	/** Model the decoder is loaded with */
+	pocketsphinx_model_t           *model;
+	/** Grammars compiled into the decoder */
+	pocketsphinx_compiled_grammar_t grammars[POCKETSPHINX_DECODER_GRAMMAR_MAX];
+	/** Active (selected) grammar */
+	pocketsphinx_compiled_grammar_t *active_grammar;
+	/** Sequence number of grammar uses */
+	apr_size_t                      use_count;
+};
+
+/** Acoustic model shared by the decoders of the same sampling rate */
+struct pocketsphinx_model_t {
+	/** Sampling rate */
+	const char          *rate;
+	/** Path to model */
+	const char          *path;
+	/** Configuration retained by each decoder */
+	cmd_ln_t            *config;
+	/** Idle decoders ready to be reused */
+	APR_RING_HEAD(pocketsphinx_decoder_head_t, pocketsphinx_decoder_t) idle_decoders;
+};
+
+/** Grammar shared by the recognizers defining the same content */
+struct pocketsphinx_grammar_t {
+	/** Digest of the content (key of the cache) */
+	char        digest[POCKETSPHINX_DIGEST_SIZE];
+	/** Path to grammar file */
+	char       *file_path;
+	/** Number of definitions referencing the grammar */
+	apr_size_t  ref_count;
+};
+
 /** Pocketsphinx engine (engine is an aggregation of recognizers) */
 struct pocketsphinx_engine_t {
 	/* Engine base */
 	mrcp_engine_t   *base;
 	/** Properties loaded from config file */
 	pocketsphinx_properties_t properties;
+
+	/** Worker threads to run recognition in */
+	apr_thread_t   **workers;
+	/** Number of worker threads */
+	apr_size_t       worker_count;
+	/** Conditional wait object */
+	apr_thread_cond_t  *wait_object;
+	/** Mutex of the wait object and the run queue */
+	apr_thread_mutex_t *mutex;
+	/** Recognizers having pending messages to process */
+	APR_RING_HEAD(pocketsphinx_recognizer_head_t, pocketsphinx_recognizer_t) run_queue;
+	/** Are worker threads being terminated */
+	apt_bool_t       terminating;
+
+	/** Mutex of the models and the grammar cache */
+	apr_thread_mutex_t *cache_mutex;
+	/** Narrowband and wideband models */
+	pocketsphinx_model_t models[2];
+	/** Cache of grammars (key=content digest, value=pocketsphinx_grammar_t) */
+	apr_hash_t      *grammar_cache;
 };
 
 /** Pocketsphinx channel (recognizer) */
@@ -99,10 +177,11 @@ struct pocketsphinx_recognizer_t {
 	/** Engine channel base */
 	mrcp_engine_channel_t    *channel;
 
-	/** Actual recognizer object */
-	ps_decoder_t             *decoder;
-	/** Configuration */
-	cmd_ln_t                 *config;
+	/** Ring entry of the run queue */
+	APR_RING_ENTRY(pocketsphinx_recognizer_t) link;
+
+	/** Decoder acquired from the engine */
+	pocketsphinx_decoder_t   *decoder;
 	/** Recognizer properties coppied from default engine properties */
 	pocketsphinx_properties_t properties;
 	/** Whether input timer has been started or not */
@@ -119,21 +198,14 @@ struct pocketsphinx_recognizer_t {
 	const char               *last_result;
 	/** Active grammar identifier (content-id) */
 	const char               *grammar_id;
-	/** Table of defined grammars (key=content-id, value=grammar-file-path) */
-	apr_table_t              *grammar_table;
+	/** Table of defined grammars (key=content-id, value=pocketsphinx_grammar_t) */
+	apr_hash_t               *grammar_table;
 	/** File to write waveform to if save_waveform is on */
 	apr_file_t               *waveform;
 
 	/** Voice activity detector */
 	mpf_activity_detector_t  *detector;
 
-	/** Thread to run recognition in */
-	apr_thread_t             *thread;
-	/** Conditional wait object */
-	apr_thread_cond_t        *wait_object;
-	/** Mutex of the wait object */
-	apr_thread_mutex_t       *mutex;
-
 	/** Pending request from client stack to recognizer */
 	mrcp_message_t           *request;
 	/** Pending event from mpf layer to recognizer */
@@ -146,9 +218,13 @@ struct pocketsphinx_recognizer_t {
 	apt_bool_t                close_requested;
 	/** Flag to prevent race condition when checking if a message is present */
 	apt_bool_t                message_waiting;
+	/** Is recognizer in the run queue */
+	apt_bool_t                is_queued;
+	/** Is recognizer being processed by a worker */
+	apt_bool_t                is_busy;
 };
 
-static void* APR_THREAD_FUNC pocketsphinx_recognizer_run(apr_thread_t *thread, void *data);
+static void* APR_THREAD_FUNC pocketsphinx_worker_run(apr_thread_t *thread, void *data);
 
 /** Declare this macro to set plugin version */
 MRCP_PLUGIN_VERSION_DECLARE
@@ -161,6 +237,17 @@ MRCP_PLUGIN_DECLARE(mrcp_engine_t*) mrcp_plugin_create(apr_pool_t *pool)
 {
 	pocketsphinx_engine_t *engine = apr_palloc(pool,sizeof(pocketsphinx_engine_t));
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Create PocketSphinx Engine");
+	engine->workers = NULL;
+	engine->worker_count = 0;
+	engine->wait_object = NULL;
+	engine->mutex = NULL;
+	APR_RING_INIT(&engine->run_queue, pocketsphinx_recognizer_t, link);
+	engine->terminating = FALSE;
+	engine->cache_mutex = NULL;
+	engine->grammar_cache = apr_hash_make(pool);
+	apr_thread_mutex_create(&engine->mutex,APR_THREAD_MUTEX_DEFAULT,pool);
+	apr_thread_cond_create(&engine->wait_object,pool);
+	apr_thread_mutex_create(&engine->cache_mutex,APR_THREAD_MUTEX_DEFAULT,pool);
 	
 	/* create engine base */
 	engine->base = mrcp_engine_create(
@@ -174,26 +261,110 @@ MRCP_PLUGIN_DECLARE(mrcp_engine_t*) mrcp_plugin_create(apr_pool_t *pool)
 /** Destroy pocketsphinx engine */
 static apt_bool_t pocketsphinx_engine_destroy(mrcp_engine_t *engine_base)
 {
+	pocketsphinx_engine_t *engine = engine_base->obj;
+	if(engine->mutex) {
+		apr_thread_mutex_destroy(engine->mutex);
+		engine->mutex = NULL;
+	}
+	if(engine->wait_object) {
+		apr_thread_cond_destroy(engine->wait_object);
+		engine->wait_object = NULL;
+	}
+	if(engine->cache_mutex) {
+		apr_thread_mutex_destroy(engine->cache_mutex);
+		engine->cache_mutex = NULL;
+	}
 	return TRUE;
 }
 
+/** Init acoustic model (loaded on demand) */
+static void pocketsphinx_model_init(pocketsphinx_model_t *model, const char *rate, const char *path)
+{
+	model->rate = rate;
+	model->path = path;
+	model->config = NULL;
+	APR_RING_INIT(&model->idle_decoders, pocketsphinx_decoder_t, link);
+}
+
+/** Free acoustic model and the decoders loaded with it */
+static void pocketsphinx_model_free(pocketsphinx_model_t *model)
+{
+	pocketsphinx_decoder_t *decoder;
+	while(!APR_RING_EMPTY(&model->idle_decoders, pocketsphinx_decoder_t, link)) {
+		decoder = APR_RING_FIRST(&model->idle_decoders);
+		APR_RING_REMOVE(decoder,link);
+		ps_free(decoder->ps);
+		free(decoder);
+	}
+	if(model->config) {
+		cmd_ln_free_r(model->config);
+		model->config = NULL;
+	}
+}
+
 /** Open pocketsphinx engine */
 static apt_bool_t pocketsphinx_engine_open(mrcp_engine_t *engine_base)
 {
 	pocketsphinx_engine_t *engine = engine_base->obj;
 	const apt_dir_layout_t *dir_layout = engine_base->dir_layout;
-
 	char *file_path = NULL;
+	apr_size_t i;
+
 	apr_filepath_merge(&file_path,dir_layout->conf_dir_path,POCKETSPHINX_CONFFILE_NAME,0,engine_base->pool);
 
 	/* load properties */
 	pocketsphinx_properties_load(&engine->properties,file_path,dir_layout,engine_base->pool);
-	return mrcp_engine_open_respond(engine_base,TRUE);
+
+	pocketsphinx_model_init(&engine->models[POCKETSPHINX_MODEL_NARROWBAND],"8000",engine->properties.model_8k);
+	pocketsphinx_model_init(&engine->models[POCKETSPHINX_MODEL_WIDEBAND],"16000",engine->properties.model_16k);
+
+	/* launch worker threads shared by all the recognizers */
+	engine->terminating = FALSE;
+	engine->worker_count = 0;
+	engine->workers = apr_palloc(engine_base->pool,sizeof(apr_thread_t*) * engine->properties.worker_count);
+	for(i=0; i<engine->properties.worker_count; i++) {
+		if(apr_thread_create(&engine->workers[engine->worker_count],NULL,pocketsphinx_worker_run,engine,engine_base->pool) != APR_SUCCESS) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Launch PocketSphinx Worker Thread");
+			continue;
+		}
+		engine->worker_count++;
+	}
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Launched PocketSphinx Worker Threads [%"APR_SIZE_T_FMT"]",engine->worker_count);
+	return mrcp_engine_open_respond(engine_base,engine->worker_count ? TRUE : FALSE);
 }
 
 /** Close pocketsphinx engine */
 static apt_bool_t pocketsphinx_engine_close(mrcp_engine_t *engine_base)
 {
+	pocketsphinx_engine_t *engine = engine_base->obj;
+	apr_hash_index_t *it;
+	void *val;
+	apr_status_t s;
+	apr_size_t i;
+
+	/* signal worker threads to terminate once the run queue is drained */
+	apr_thread_mutex_lock(engine->mutex);
+	engine->terminating = TRUE;
+	apr_thread_cond_broadcast(engine->wait_object);
+	apr_thread_mutex_unlock(engine->mutex);
+
+	for(i=0; i<engine->worker_count; i++) {
+		apr_thread_join(&s,engine->workers[i]);
+	}
+	engine->worker_count = 0;
+
+	pocketsphinx_model_free(&engine->models[POCKETSPHINX_MODEL_NARROWBAND]);
+	pocketsphinx_model_free(&engine->models[POCKETSPHINX_MODEL_WIDEBAND]);
+
+	/* grammars are normally released by the channels */
+	for(it = apr_hash_first(engine_base->pool,engine->grammar_cache); it; it = apr_hash_next(it)) {
+		pocketsphinx_grammar_t *grammar;
+		apr_hash_this(it,NULL,NULL,&val);
+		grammar = val;
+		apr_hash_set(engine->grammar_cache,grammar->digest,APR_HASH_KEY_STRING,NULL);
+		apr_file_remove(grammar->file_path,engine_base->pool);
+		free(grammar);
+	}
 	return mrcp_engine_close_respond(engine_base);
 }
 
@@ -207,8 +378,8 @@ static mrcp_engine_channel_t* pocketsphinx_engine_recognizer_create(mrcp_engine_
 
 	/* create pocketsphinx recognizer */
 	pocketsphinx_recognizer_t *recognizer = apr_palloc(pool,sizeof(pocketsphinx_recognizer_t));
+	APR_RING_ELEM_INIT(recognizer,link);
 	recognizer->decoder = NULL;
-	recognizer->config = NULL;
 	recognizer->is_input_timer_on = FALSE;
 	recognizer->no_input_timeout = 0;
 	recognizer->is_recognition_timer_on = FALSE;
@@ -216,18 +387,17 @@ static mrcp_engine_channel_t* pocketsphinx_engine_recognizer_create(mrcp_engine_
 	recognizer->partial_result_timeout = 0;
 	recognizer->last_result = NULL;
 	recognizer->detector = NULL;
-	recognizer->thread = NULL;
-	recognizer->wait_object = NULL;
-	recognizer->mutex = NULL;
 	recognizer->request = NULL;
 	recognizer->complete_event = NULL;
 	recognizer->inprogress_recog = FALSE;
 	recognizer->stop_response = NULL;
 	recognizer->close_requested = FALSE;
 	recognizer->grammar_id = NULL;
-	recognizer->grammar_table = apr_table_make(pool,1);
+	recognizer->grammar_table = apr_hash_make(pool);
 	recognizer->waveform = NULL;
 	recognizer->message_waiting = FALSE;
+	recognizer->is_queued = FALSE;
+	recognizer->is_busy = FALSE;
 
 	/* copy default properties loaded from config */
 	recognizer->properties = engine->properties;
@@ -253,9 +423,6 @@ static mrcp_engine_channel_t* pocketsphinx_engine_recognizer_create(mrcp_engine_
 			termination,          /* associated media termination */
 			pool);                /* pool to allocate memory from */
 
-	apr_thread_mutex_create(&recognizer->mutex,APR_THREAD_MUTEX_DEFAULT,channel->pool);
-	apr_thread_cond_create(&recognizer->wait_object,channel->pool);
-
 	recognizer->channel = channel;
 	return channel;
 }
@@ -263,123 +430,234 @@ static mrcp_engine_channel_t* pocketsphinx_engine_recognizer_create(mrcp_engine_
 /** Destroy pocketsphinx recognizer */
 static apt_bool_t pocketsphinx_recognizer_destroy(mrcp_engine_channel_t *channel)
 {
-	pocketsphinx_recognizer_t *recognizer = channel->method_obj;
-	if(recognizer->mutex) {
-		apr_thread_mutex_destroy(recognizer->mutex);
-		recognizer->mutex = NULL;
-	}
-	if(recognizer->wait_object) {
-		apr_thread_cond_destroy(recognizer->wait_object);
-		recognizer->wait_object = NULL;
-	}
 	return TRUE;
 }
 
+/** Put recognizer into the run queue unless it is already there or being processed (engine mutex must be locked) */
+static void pocketsphinx_recognizer_schedule(pocketsphinx_engine_t *engine, pocketsphinx_recognizer_t *recognizer)
+{
+	recognizer->message_waiting = TRUE;
+	if(recognizer->is_queued == FALSE && recognizer->is_busy == FALSE) {
+		recognizer->is_queued = TRUE;
+		APR_RING_INSERT_TAIL(&engine->run_queue,recognizer,pocketsphinx_recognizer_t,link);
+		apr_thread_cond_signal(engine->wait_object);
+	}
+}
+
 /** Open pocketsphinx recognizer (asynchronous response MUST be sent) */
 static apt_bool_t pocketsphinx_recognizer_open(mrcp_engine_channel_t *channel)
 {
-	apr_status_t rv;
 	pocketsphinx_recognizer_t *recognizer = channel->method_obj;
 
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Open Channel "APT_SIDRES_FMT,RECOGNIZER_SIDRES(recognizer));
 
-	/* Launch a thread to run recognition in */
-	rv = apr_thread_create(&recognizer->thread,NULL,pocketsphinx_recognizer_run,recognizer,channel->pool);
-	if(rv != APR_SUCCESS) {
-		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Failed to Launch Thread "APT_SIDRES_FMT,RECOGNIZER_SIDRES(recognizer));
-		return mrcp_engine_channel_open_respond(channel,FALSE);
-	}
-
-	return TRUE;
+	/* decoder is acquired from the engine on the first grammar load */
+	return mrcp_engine_channel_open_respond(channel,TRUE);
 }
 
 /** Close pocketsphinx recognizer (asynchronous response MUST be sent)*/
 static apt_bool_t pocketsphinx_recognizer_close(mrcp_engine_channel_t *channel)
 {
 	pocketsphinx_recognizer_t *recognizer = channel->method_obj;
+	pocketsphinx_engine_t *engine = channel->engine->obj;
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Close Channel "APT_SIDRES_FMT,RECOGNIZER_SIDRES(recognizer));
-	if(recognizer->thread) {
-		apr_status_t s;
-		apr_thread_mutex_lock(recognizer->mutex);
-		
-		/* Signal recognition thread to terminate */
-		recognizer->close_requested = TRUE;
-		recognizer->message_waiting = TRUE;
-		apr_thread_cond_signal(recognizer->wait_object);
-		
-		apr_thread_mutex_unlock(recognizer->mutex);
 
-		/* Wait for thread to be finally terminated */
-		apr_thread_join(&s,recognizer->thread);
-		recognizer->thread = NULL;
-	}
-
-	return mrcp_engine_channel_close_respond(channel);
+	/* Signal worker thread to release resources and respond */
+	apr_thread_mutex_lock(engine->mutex);
+	recognizer->close_requested = TRUE;
+	pocketsphinx_recognizer_schedule(engine,recognizer);
+	apr_thread_mutex_unlock(engine->mutex);
+	return TRUE;
 }
 
 /** Process MRCP request (asynchronous response MUST be sent)*/
 static apt_bool_t pocketsphinx_recognizer_request_process(mrcp_engine_channel_t *channel, mrcp_message_t *request)
 {
 	pocketsphinx_recognizer_t *recognizer = channel->method_obj;
+	pocketsphinx_engine_t *engine = channel->engine->obj;
 
-	/* Store request and signal recognition thread to process the request */
-	apr_thread_mutex_lock(recognizer->mutex);
+	/* Store request and signal worker thread to process the request */
+	apr_thread_mutex_lock(engine->mutex);
 	recognizer->request = request;
-	recognizer->message_waiting = TRUE;
-	apr_thread_cond_signal(recognizer->wait_object);
-	apr_thread_mutex_unlock(recognizer->mutex);
+	pocketsphinx_recognizer_schedule(engine,recognizer);
+	apr_thread_mutex_unlock(engine->mutex);
 	return TRUE;
 }
 
-/** Initialize pocketsphinx decoder [RECOG] */
-static apt_bool_t pocketsphinx_decoder_init(pocketsphinx_recognizer_t *recognizer, const char *grammar)
+/** Acquire decoder loaded with the model matching the sampling rate of the channel [RECOG] */
+static pocketsphinx_decoder_t* pocketsphinx_decoder_acquire(pocketsphinx_engine_t *engine, pocketsphinx_recognizer_t *recognizer)
 {
 	const mpf_codec_descriptor_t *descriptor = mrcp_engine_sink_stream_codec_get(recognizer->channel);
-	const char *model = recognizer->properties.model_8k;
-	const char *rate = "8000";
+	pocketsphinx_model_t *model = &engine->models[POCKETSPHINX_MODEL_NARROWBAND];
+	pocketsphinx_decoder_t *decoder = NULL;
+	cmd_ln_t *config = NULL;
+	ps_decoder_t *ps;
 	if(descriptor && descriptor->sampling_rate == 16000) {
-		model = recognizer->properties.model_16k;
-		rate = "16000";
+		model = &engine->models[POCKETSPHINX_MODEL_WIDEBAND];
 	}
 
-	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Init Config rate [%s] dictionary [%s] "APT_SIDRES_FMT,
-		rate,
-		recognizer->properties.dictionary,
-		RECOGNIZER_SIDRES(recognizer));
-	recognizer->config = cmd_ln_init(recognizer->config, ps_args(), FALSE,
-							 "-samprate", rate,
-							 "-hmm", model,
-							 "-jsgf", grammar,
-							 "-dict", recognizer->properties.dictionary,
-							 "-frate", "50",
-							 "-silprob", "0.005",
-							 NULL);
-	if(!recognizer->config) {
-		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Init Config "APT_SIDRES_FMT,RECOGNIZER_SIDRES(recognizer));
+	apr_thread_mutex_lock(engine->cache_mutex);
+	if(!model->config) {
+		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Init Config rate [%s] dictionary [%s] "APT_SIDRES_FMT,
+			model->rate,
+			recognizer->properties.dictionary,
+			RECOGNIZER_SIDRES(recognizer));
+		model->config = cmd_ln_init(NULL, ps_args(), FALSE,
+								 "-samprate", model->rate,
+								 "-hmm", model->path,
+								 "-dict", recognizer->properties.dictionary,
+								 "-frate", "50",
+								 "-silprob", "0.005",
+								 NULL);
+		if(!model->config) {
+			apr_thread_mutex_unlock(engine->cache_mutex);
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Init Config "APT_SIDRES_FMT,RECOGNIZER_SIDRES(recognizer));
+			return NULL;
+		}
+	}
+	if(!APR_RING_EMPTY(&model->idle_decoders, pocketsphinx_decoder_t, link)) {
+		decoder = APR_RING_FIRST(&model->idle_decoders);
+		APR_RING_REMOVE(decoder,link);
+	}
+	else {
+		/* the new decoder owns a reference to the shared config */
+		config = cmd_ln_retain(model->config);
+	}
+	apr_thread_mutex_unlock(engine->cache_mutex);
+
+	if(decoder) {
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Reuse Decoder rate [%s] "APT_SIDRES_FMT,model->rate,RECOGNIZER_SIDRES(recognizer));
+		return decoder;
+	}
+
+	/* load the model outside of the lock, it may take a while */
+	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Init Decoder rate [%s] "APT_SIDRES_FMT,model->rate,RECOGNIZER_SIDRES(recognizer));
+	ps = ps_init(config);
+	if(!ps) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Init Decoder "APT_SIDRES_FMT,RECOGNIZER_SIDRES(recognizer));
+		return NULL;
+	}
+
+	decoder = calloc(1,sizeof(pocketsphinx_decoder_t));
+	APR_RING_ELEM_INIT(decoder,link);
+	decoder->ps = ps;
+	decoder->model = model;
+	decoder->active_grammar = NULL;
+	decoder->use_count = 0;
+	return decoder;
+}
+
+/** Release decoder to be reused by other recognizers [RECOG] */
+static void pocketsphinx_decoder_release(pocketsphinx_engine_t *engine, pocketsphinx_decoder_t *decoder)
+{
+	pocketsphinx_model_t *model = decoder->model;
+	apr_thread_mutex_lock(engine->cache_mutex);
+	/* the most recently used decoder is the first to reuse */
+	APR_RING_INSERT_HEAD(&model->idle_decoders,decoder,pocketsphinx_decoder_t,link);
+	apr_thread_mutex_unlock(engine->cache_mutex);
+}
+
+/** Compile JSGF grammar file into FSG [RECOG] */
+static fsg_model_t* pocketsphinx_grammar_compile(pocketsphinx_decoder_t *decoder, const pocketsphinx_grammar_t *grammar)
+{
+	jsgf_t *jsgf;
+	jsgf_rule_t *rule = NULL;
+	jsgf_rule_iter_t *it;
+	fsg_model_t *fsg = NULL;
+
+	jsgf = jsgf_parse_file(grammar->file_path,NULL);
+	if(!jsgf) {
+		return NULL;
+	}
+
+	/* the first public rule is the root of the grammar */
+	for(it = jsgf_rule_iter(jsgf); it; it = jsgf_rule_iter_next(it)) {
+		rule = jsgf_rule_iter_rule(it);
+		if(jsgf_rule_public(rule)) {
+			jsgf_rule_iter_free(it);
+			break;
+		}
+		rule = NULL;
+	}
+
+	if(rule) {
+		fsg = jsgf_build_fsg(jsgf,rule,ps_get_logmath(decoder->ps),cmd_ln_float32_r(decoder->model->config,"-lw"));
+	}
+	jsgf_grammar_free(jsgf);
+	return fsg;
+}
+
+/** Activate grammar in the decoder compiling it unless already compiled [RECOG] */
+static apt_bool_t pocketsphinx_decoder_grammar_set(pocketsphinx_decoder_t *decoder, const pocketsphinx_grammar_t *grammar, pocketsphinx_recognizer_t *recognizer)
+{
+	pocketsphinx_compiled_grammar_t *compiled = NULL;
+	pocketsphinx_compiled_grammar_t *lru = &decoder->grammars[0];
+	fsg_set_t *fsgs;
+	fsg_model_t *fsg;
+	apr_size_t i;
+
+	if(decoder->active_grammar && strcmp(decoder->active_grammar->digest,grammar->digest) == 0) {
+		/* nothing to do, the grammar is already active */
+		decoder->active_grammar->last_used = ++decoder->use_count;
+		return TRUE;
+	}
+
+	fsgs = ps_get_fsgset(decoder->ps);
+	if(!fsgs) {
 		return FALSE;
 	}
-	
-	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Init Decoder "APT_SIDRES_FMT,RECOGNIZER_SIDRES(recognizer));
-	if(recognizer->decoder) {
-		if(ps_reinit(recognizer->decoder,recognizer->config) < 0) {
-			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Reinit Decoder "APT_SIDRES_FMT,RECOGNIZER_SIDRES(recognizer));
-			return FALSE;
+
+	for(i=0; i<POCKETSPHINX_DECODER_GRAMMAR_MAX; i++) {
+		if(strcmp(decoder->grammars[i].digest,grammar->digest) == 0) {
+			compiled = &decoder->grammars[i];
+			break;
+		}
+		if(decoder->grammars[i].last_used < lru->last_used) {
+			lru = &decoder->grammars[i];
 		}
 	}
-	else {
-		recognizer->decoder = ps_init(recognizer->config);
-		if(!recognizer->decoder) {
-			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Init Decoder "APT_SIDRES_FMT,RECOGNIZER_SIDRES(recognizer));
+
+	if(!compiled) {
+		if(*lru->digest != '\0') {
+			/* evict the least recently used grammar */
+			apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Evict Compiled Grammar [%s] "APT_SIDRES_FMT,
+				lru->digest,RECOGNIZER_SIDRES(recognizer));
+			fsg = fsg_set_remove_byname(fsgs,lru->digest);
+			if(fsg) {
+				fsg_model_free(fsg);
+			}
+			if(decoder->active_grammar == lru) {
+				decoder->active_grammar = NULL;
+			}
+			*lru->digest = '\0';
+			lru->last_used = 0;
+		}
+
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Compile Grammar [%s] "APT_SIDRES_FMT,
+			grammar->digest,RECOGNIZER_SIDRES(recognizer));
+		fsg = pocketsphinx_grammar_compile(decoder,grammar);
+		if(!fsg) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Compile Grammar [%s] "APT_SIDRES_FMT,
+				grammar->file_path,RECOGNIZER_SIDRES(recognizer));
+			return FALSE;
+		}
+		/* the set keeps the name by reference, the slot outlives the entry */
+		compiled = lru;
+		apr_cpystrn(compiled->digest,grammar->digest,sizeof(compiled->digest));
+		if(fsg_set_add(fsgs,compiled->digest,fsg) == NULL) {
+			fsg_model_free(fsg);
+			*compiled->digest = '\0';
 			return FALSE;
 		}
 	}
 
-	if(!recognizer->detector) {
-		recognizer->detector = mpf_activity_detector_create(recognizer->channel->pool);
-		mpf_activity_detector_level_set(recognizer->detector,recognizer->properties.sensitivity_level);
-		mpf_activity_detector_speech_timeout_set(recognizer->detector,recognizer->properties.activity_timeout);
-		mpf_activity_detector_silence_timeout_set(recognizer->detector,recognizer->properties.inactivity_timeout);
+	if(fsg_set_select(fsgs,compiled->digest) == NULL || ps_update_fsgset(decoder->ps) == NULL) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Select Grammar [%s] "APT_SIDRES_FMT,
+			compiled->digest,RECOGNIZER_SIDRES(recognizer));
+		return FALSE;
 	}
+	compiled->last_used = ++decoder->use_count;
+	decoder->active_grammar = compiled;
 	return TRUE;
 }
 
@@ -418,44 +696,48 @@ static apt_bool_t pocketsphinx_result_build(pocketsphinx_recognizer_t *recognize
 	return TRUE;
 }
 
-/** Clear pocketsphinx grammars [RECOG] */
-static apt_bool_t pocketsphinx_grammars_clear(pocketsphinx_recognizer_t *recognizer)
+/** Compute digest of grammar content (64-bit FNV-1a hash and length) */
+static void pocketsphinx_grammar_digest(const apt_str_t *content, char *digest)
 {
-	const apr_array_header_t *tarr = apr_table_elts(recognizer->grammar_table);
-	const apr_table_entry_t *telts = (const apr_table_entry_t*)tarr->elts;
-	int i;
-	for(i = 0; i < tarr->nelts; i++) {
-		const char *grammar_file_path = telts[i].val;
-		if(grammar_file_path) {
-			apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Remove Grammar File [%s] "APT_SIDRES_FMT,
-				grammar_file_path,RECOGNIZER_SIDRES(recognizer));
-			apr_file_remove(grammar_file_path,recognizer->channel->pool);
-		}
+	apr_uint64_t hash = ((apr_uint64_t)0xcbf29ce4 << 32) | 0x84222325;
+	const apr_uint64_t prime = ((apr_uint64_t)0x100 << 32) | 0x1b3;
+	apr_size_t i;
+	for(i=0; i<content->length; i++) {
+		hash ^= (apr_byte_t)content->buf[i];
+		hash *= prime;
 	}
-	apr_table_clear(recognizer->grammar_table);
-	return TRUE;
+	apr_snprintf(digest,POCKETSPHINX_DIGEST_SIZE,"%08x%08x-%"APR_SIZE_T_FMT,
+		(apr_uint32_t)(hash >> 32),
+		(apr_uint32_t)hash,
+		content->length);
 }
 
-/** Load pocketsphinx grammar [RECOG] */
-static mrcp_status_code_e pocketsphinx_grammar_load(pocketsphinx_recognizer_t *recognizer, const char *content_id, const char *content_type, const apt_str_t *content)
+/** Get grammar from the cache or create grammar file unless cached [RECOG] */
+static pocketsphinx_grammar_t* pocketsphinx_grammar_acquire(pocketsphinx_engine_t *engine, pocketsphinx_recognizer_t *recognizer, const apt_str_t *content)
 {
-	/* load grammar */
 	mrcp_engine_channel_t *channel = recognizer->channel;
 	const apt_dir_layout_t *dir_layout = channel->engine->dir_layout;
-	const char *grammar_file_path = NULL;
-	const char *grammar_file_name = NULL;
+	pocketsphinx_grammar_t *grammar;
+	char digest[POCKETSPHINX_DIGEST_SIZE];
+	const char *grammar_file_path;
+	const char *grammar_file_name;
 	apr_file_t *fd = NULL;
 	apr_status_t rv;
 	apr_size_t size;
 
-	/* only JSGF grammar is supported */
-	if(strstr(content_type,"jsgf") == NULL) {
-		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Not Supported Content-Type [%s] "APT_SIDRES_FMT,
-			content_type,RECOGNIZER_SIDRES(recognizer));
-		return MRCP_STATUS_CODE_UNSUPPORTED_PARAM_VALUE;
+	pocketsphinx_grammar_digest(content,digest);
+
+	apr_thread_mutex_lock(engine->cache_mutex);
+	grammar = apr_hash_get(engine->grammar_cache,digest,APR_HASH_KEY_STRING);
+	if(grammar) {
+		grammar->ref_count++;
+		apr_thread_mutex_unlock(engine->cache_mutex);
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Reuse Cached Grammar [%s] "APT_SIDRES_FMT,
+			grammar->file_path,RECOGNIZER_SIDRES(recognizer));
+		return grammar;
 	}
 
-	grammar_file_name = apr_psprintf(channel->pool,"%s-%s.gram",channel->id.buf,content_id);
+	grammar_file_name = apr_psprintf(channel->pool,"grammar-%s.gram",digest);
 	grammar_file_path = apt_datadir_filepath_get(dir_layout,grammar_file_name,channel->pool);
 
 	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Create Grammar File [%s] "APT_SIDRES_FMT,
@@ -463,22 +745,107 @@ static mrcp_status_code_e pocketsphinx_grammar_load(pocketsphinx_recognizer_t *r
 	rv = apr_file_open(&fd,grammar_file_path,APR_CREATE|APR_TRUNCATE|APR_WRITE|APR_BINARY,
 		APR_OS_DEFAULT,channel->pool);
 	if(rv != APR_SUCCESS) {
+		apr_thread_mutex_unlock(engine->cache_mutex);
 		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Cannot Open Grammar File to Write [%s] "APT_SIDRES_FMT,
 			grammar_file_path,RECOGNIZER_SIDRES(recognizer));
-		return MRCP_STATUS_CODE_METHOD_FAILED;
+		return NULL;
 	}
 
 	size = content->length;
 	apr_file_write(fd,content->buf,&size);
 	apr_file_close(fd);
 
-	/* init pocketsphinx decoder */
-	if(pocketsphinx_decoder_init(recognizer,grammar_file_path) != TRUE) {
-		apr_file_remove(grammar_file_path,channel->pool);
+	/* cached grammars outlive the channels, allocate them on the heap */
+	grammar = malloc(sizeof(pocketsphinx_grammar_t) + strlen(grammar_file_path) + 1);
+	apr_cpystrn(grammar->digest,digest,sizeof(grammar->digest));
+	grammar->file_path = (char*)(grammar + 1);
+	strcpy(grammar->file_path,grammar_file_path);
+	grammar->ref_count = 1;
+	apr_hash_set(engine->grammar_cache,grammar->digest,APR_HASH_KEY_STRING,grammar);
+	apr_thread_mutex_unlock(engine->cache_mutex);
+	return grammar;
+}
+
+/** Release grammar removing it from the cache once unreferenced [RECOG] */
+static void pocketsphinx_grammar_release(pocketsphinx_engine_t *engine, pocketsphinx_recognizer_t *recognizer, pocketsphinx_grammar_t *grammar)
+{
+	apr_thread_mutex_lock(engine->cache_mutex);
+	grammar->ref_count--;
+	if(!grammar->ref_count) {
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Remove Grammar File [%s] "APT_SIDRES_FMT,
+			grammar->file_path,RECOGNIZER_SIDRES(recognizer));
+		apr_hash_set(engine->grammar_cache,grammar->digest,APR_HASH_KEY_STRING,NULL);
+		apr_file_remove(grammar->file_path,recognizer->channel->pool);
+		free(grammar);
+	}
+	apr_thread_mutex_unlock(engine->cache_mutex);
+}
+
+/** Clear pocketsphinx grammars [RECOG] */
+static apt_bool_t pocketsphinx_grammars_clear(pocketsphinx_recognizer_t *recognizer)
+{
+	pocketsphinx_engine_t *engine = recognizer->channel->engine->obj;
+	apr_hash_index_t *it;
+	const void *key;
+	void *val;
+	for(it = apr_hash_first(recognizer->channel->pool,recognizer->grammar_table); it; it = apr_hash_next(it)) {
+		apr_hash_this(it,&key,NULL,&val);
+		pocketsphinx_grammar_release(engine,recognizer,val);
+		apr_hash_set(recognizer->grammar_table,key,APR_HASH_KEY_STRING,NULL);
+	}
+	recognizer->grammar_id = NULL;
+	return TRUE;
+}
+
+/** Load pocketsphinx grammar [RECOG] */
+static mrcp_status_code_e pocketsphinx_grammar_load(pocketsphinx_recognizer_t *recognizer, const char *content_id, const char *content_type, const apt_str_t *content)
+{
+	/* load grammar */
+	mrcp_engine_channel_t *channel = recognizer->channel;
+	pocketsphinx_engine_t *engine = channel->engine->obj;
+	pocketsphinx_grammar_t *grammar;
+	pocketsphinx_grammar_t *prev_grammar;
+
+	/* only JSGF grammar is supported */
+	if(strstr(content_type,"jsgf") == NULL) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Not Supported Content-Type [%s] "APT_SIDRES_FMT,
+			content_type,RECOGNIZER_SIDRES(recognizer));
+		return MRCP_STATUS_CODE_UNSUPPORTED_PARAM_VALUE;
+	}
+
+	/* acquire pocketsphinx decoder */
+	if(!recognizer->decoder) {
+		recognizer->decoder = pocketsphinx_decoder_acquire(engine,recognizer);
+		if(!recognizer->decoder) {
+			return MRCP_STATUS_CODE_METHOD_FAILED;
+		}
+	}
+
+	grammar = pocketsphinx_grammar_acquire(engine,recognizer,content);
+	if(!grammar) {
+		return MRCP_STATUS_CODE_METHOD_FAILED;
+	}
+
+	if(pocketsphinx_decoder_grammar_set(recognizer->decoder,grammar,recognizer) != TRUE) {
+		pocketsphinx_grammar_release(engine,recognizer,grammar);
 		return MRCP_STATUS_CODE_METHOD_FAILED;
 	}
+
+	if(!recognizer->detector) {
+		recognizer->detector = mpf_activity_detector_create(channel->pool);
+		mpf_activity_detector_level_set(recognizer->detector,recognizer->properties.sensitivity_level);
+		mpf_activity_detector_speech_timeout_set(recognizer->detector,recognizer->properties.activity_timeout);
+		mpf_activity_detector_silence_timeout_set(recognizer->detector,recognizer->properties.inactivity_timeout);
+	}
+
+	/* content-id belongs to the request, copy it */
+	content_id = apr_pstrdup(channel->pool,content_id);
+	prev_grammar = apr_hash_get(recognizer->grammar_table,content_id,APR_HASH_KEY_STRING);
+	apr_hash_set(recognizer->grammar_table,content_id,APR_HASH_KEY_STRING,grammar);
+	if(prev_grammar) {
+		pocketsphinx_grammar_release(engine,recognizer,prev_grammar);
+	}
 	recognizer->grammar_id = content_id;
-	apr_table_setn(recognizer->grammar_table,content_id,grammar_file_path);
 	return MRCP_STATUS_CODE_SUCCESS;
 }
 
@@ -486,15 +853,13 @@ static mrcp_status_code_e pocketsphinx_grammar_load(pocketsphinx_recognizer_t *r
 static mrcp_status_code_e pocketsphinx_grammar_unload(pocketsphinx_recognizer_t *recognizer, const char *content_id)
 {
 	/* unload grammar */
-	const char *grammar_file_path = apr_table_get(recognizer->grammar_table,content_id);
-	if(!grammar_file_path) {
+	pocketsphinx_grammar_t *grammar = apr_hash_get(recognizer->grammar_table,content_id,APR_HASH_KEY_STRING);
+	if(!grammar) {
 		return MRCP_STATUS_CODE_ILLEGAL_PARAM_VALUE;
 	}
 
-	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Remove Grammar File [%s] "APT_SIDRES_FMT,
-		grammar_file_path,RECOGNIZER_SIDRES(recognizer));
-	apr_file_remove(grammar_file_path,recognizer->channel->pool);
-	apr_table_unset(recognizer->grammar_table,content_id);
+	apr_hash_set(recognizer->grammar_table,content_id,APR_HASH_KEY_STRING,NULL);
+	pocketsphinx_grammar_release(recognizer->channel->engine->obj,recognizer,grammar);
 	return MRCP_STATUS_CODE_SUCCESS;
 }
 
@@ -604,7 +969,7 @@ static apt_bool_t pocketsphinx_recognize(pocketsphinx_recognizer_t *recognizer,
 		}
 	}
 
-	if(!recognizer->decoder || ps_start_utt(recognizer->decoder, NULL) < 0) {
+	if(!recognizer->decoder || ps_start_utt(recognizer->decoder->ps, NULL) < 0) {
 		response->start_line.status_code = MRCP_STATUS_CODE_METHOD_FAILED;
 		response_recog_header->completion_cause = RECOGNIZER_COMPLETION_CAUSE_ERROR;
 		mrcp_resource_header_property_add(response,RECOGNIZER_HEADER_COMPLETION_CAUSE);
@@ -713,7 +1078,7 @@ static apt_bool_t pocketsphinx_recognition_complete(pocketsphinx_recognizer_t *r
 	}
 
 	recognizer->inprogress_recog = NULL;
-	ps_end_utt(recognizer->decoder);
+	ps_end_utt(recognizer->decoder->ps);
 
 	if(recognizer->waveform) {
 		apr_file_close(recognizer->waveform);
@@ -737,11 +1102,11 @@ static apt_bool_t pocketsphinx_recognition_complete(pocketsphinx_recognizer_t *r
 		char const *hyp;
 		char const *uttid;
 
-		hyp = ps_get_hyp(recognizer->decoder, &score, &uttid);
+		hyp = ps_get_hyp(recognizer->decoder->ps, &score, &uttid);
 		if(hyp && strlen(hyp) > 0) {
 			int32 prob;
 			recognizer->last_result = apr_pstrdup(recognizer->channel->pool,hyp);
-			prob = ps_get_prob(recognizer->decoder, &uttid); 
+			prob = ps_get_prob(recognizer->decoder->ps, &uttid); 
 			apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Get Recognition Final Result [%s] Prob [%d] Score [%d] "APT_SIDRES_FMT,
 				hyp,prob,score,RECOGNIZER_SIDRES(recognizer));
 			if(pocketsphinx_result_build(recognizer,complete_event) == TRUE) {
@@ -804,47 +1169,87 @@ static apt_bool_t pocketsphinx_request_dispatch(pocketsphinx_recognizer_t *recog
 }
 
 
-/** Recognition thread [RECOG] */
-static void* APR_THREAD_FUNC pocketsphinx_recognizer_run(apr_thread_t *thread, void *data)
+/** Release resources of the recognizer being closed [RECOG] */
+static void pocketsphinx_recognizer_cleanup(pocketsphinx_recognizer_t *recognizer)
 {
-	pocketsphinx_recognizer_t *recognizer = data;
+	pocketsphinx_engine_t *engine = recognizer->channel->engine->obj;
+
+	/** Clear all the defined grammars */
+	pocketsphinx_grammars_clear(recognizer);
 
-	apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Run Recognition Thread "APT_SIDRES_FMT, RECOGNIZER_SIDRES(recognizer));
-	/** Send response to channel_open request */
-	mrcp_engine_channel_open_respond(recognizer->channel,TRUE);
+	if(recognizer->waveform) {
+		apr_file_close(recognizer->waveform);
+		recognizer->waveform = NULL;
+	}
 
-	do {
-		apr_thread_mutex_lock(recognizer->mutex);
-		/** Wait for MRCP requests */
-		apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Wait for incoming messages "APT_SIDRES_FMT, RECOGNIZER_SIDRES(recognizer));
-		if (!recognizer->message_waiting) {
-			apr_thread_cond_wait(recognizer->wait_object,recognizer->mutex);
+	if(recognizer->decoder) {
+		if(recognizer->inprogress_recog) {
+			/* the decoder must be idle to be reused */
+			ps_end_utt(recognizer->decoder->ps);
+			recognizer->inprogress_recog = NULL;
 		}
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Release Decoder "APT_SIDRES_FMT, RECOGNIZER_SIDRES(recognizer));
+		pocketsphinx_decoder_release(engine,recognizer->decoder);
+		recognizer->decoder = NULL;
+	}
+}
+
+/** Worker thread processing the recognizers in the run queue [RECOG] */
+static void* APR_THREAD_FUNC pocketsphinx_worker_run(apr_thread_t *thread, void *data)
+{
+	pocketsphinx_engine_t *engine = data;
+	pocketsphinx_recognizer_t *recognizer;
+	mrcp_message_t *request;
+	apt_bool_t close_requested;
+
+	apt_log(APT_LOG_MARK,APT_PRIO_DEBUG,"Run PocketSphinx Worker Thread");
+	apr_thread_mutex_lock(engine->mutex);
+	for(;;) {
+		if(APR_RING_EMPTY(&engine->run_queue, pocketsphinx_recognizer_t, link)) {
+			if(engine->terminating == TRUE) {
+				break;
+			}
+			/** Wait for MRCP requests and MPF events */
+			apr_thread_cond_wait(engine->wait_object,engine->mutex);
+			continue;
+		}
+
+		/* a recognizer is processed by one worker at a time */
+		recognizer = APR_RING_FIRST(&engine->run_queue);
+		APR_RING_REMOVE(recognizer,link);
+		recognizer->is_queued = FALSE;
+		recognizer->is_busy = TRUE;
 		recognizer->message_waiting = FALSE;
+		request = recognizer->request;
+		recognizer->request = NULL;
+		close_requested = recognizer->close_requested;
+		apr_thread_mutex_unlock(engine->mutex);
 
-		if(recognizer->request) {
-			/* store request message and further dispatch it */
-			mrcp_message_t *request = recognizer->request;
-			recognizer->request = NULL;
+		if(request) {
+			/* dispatch request message */
 			pocketsphinx_request_dispatch(recognizer,request);
 		}
 		if(recognizer->complete_event) {
 			/* end of input detected, get recognition result and raise recognition complete event */
 			pocketsphinx_recognition_complete(recognizer,recognizer->complete_event);
 		}
-		apr_thread_mutex_unlock(recognizer->mutex);
-	}
-	while(recognizer->close_requested == FALSE);
+		if(close_requested == TRUE) {
+			/* the recognizer must not be referenced after the response */
+			pocketsphinx_recognizer_cleanup(recognizer);
+			mrcp_engine_channel_close_respond(recognizer->channel);
+			apr_thread_mutex_lock(engine->mutex);
+			continue;
+		}
 
-	/** Clear all the defined grammars */
-	pocketsphinx_grammars_clear(recognizer);
-	
-	if(recognizer->decoder) {
-		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"Free Decoder "APT_SIDRES_FMT, RECOGNIZER_SIDRES(recognizer));
-		/** Free pocketsphinx decoder */
-		ps_free(recognizer->decoder);
-		recognizer->decoder = NULL;
+		apr_thread_mutex_lock(engine->mutex);
+		recognizer->is_busy = FALSE;
+		if(recognizer->message_waiting == TRUE) {
+			/* more messages arrived meanwhile */
+			recognizer->is_queued = TRUE;
+			APR_RING_INSERT_TAIL(&engine->run_queue,recognizer,pocketsphinx_recognizer_t,link);
+		}
 	}
+	apr_thread_mutex_unlock(engine->mutex);
 
 	/** Exit thread */
 	apr_thread_exit(thread,APR_SUCCESS);
@@ -877,6 +1282,7 @@ static apt_bool_t pocketsphinx_start_of_input(pocketsphinx_recognizer_t *recogni
 /* End of input (utterance) [MPF] */
 static apt_bool_t pocketsphinx_end_of_input(pocketsphinx_recognizer_t *recognizer, mrcp_recog_completion_cause_e cause)
 {
+	pocketsphinx_engine_t *engine = recognizer->channel->engine->obj;
 	mrcp_recog_header_t *recog_header;
 	/* create RECOGNITION-COMPLETE event */
 	mrcp_message_t *message = mrcp_event_create(
@@ -897,12 +1303,11 @@ static apt_bool_t pocketsphinx_end_of_input(pocketsphinx_recognizer_t *recognize
 	/* set request state */
 	message->start_line.request_state = MRCP_REQUEST_STATE_COMPLETE;
 
-	/* signal recognition thread first */
-	apr_thread_mutex_lock(recognizer->mutex);
+	/* signal worker thread first */
+	apr_thread_mutex_lock(engine->mutex);
 	recognizer->complete_event = message;
-	recognizer->message_waiting = TRUE;
-	apr_thread_cond_signal(recognizer->wait_object);
-	apr_thread_mutex_unlock(recognizer->mutex);
+	pocketsphinx_recognizer_schedule(engine,recognizer);
+	apr_thread_mutex_unlock(engine->mutex);
 	return TRUE;
 }
 
@@ -929,7 +1334,7 @@ static apt_bool_t pocketsphinx_stream_write(mpf_audio_stream_t *stream, const mp
 		}
 
 		if(ps_process_raw(
-					recognizer->decoder, 
+					recognizer->decoder->ps, 
 					(const int16 *)frame->codec_frame.buffer, 
 					frame->codec_frame.size / sizeof(int16),
 					FALSE, 
@@ -946,7 +1351,7 @@ static apt_bool_t pocketsphinx_stream_write(mpf_audio_stream_t *stream, const mp
 			char const *uttid;
 
 			recognizer->partial_result_timeout = 0;
-			hyp = ps_get_hyp(recognizer->decoder, &score, &uttid);
+			hyp = ps_get_hyp(recognizer->decoder->ps, &score, &uttid);
 			if(hyp && strlen(hyp) > 0) {
 				if(recognizer->last_result == NULL || 0 != strcmp(recognizer->last_result, hyp)) {
 					recognizer->last_result = apr_pstrdup(recognizer->channel->pool,hyp);
@@ -122,6 +122,20 @@ static apt_bool_t model_properties_load(pocketsphinx_properties_t *properties, c
 	return TRUE;
 }
 
+static apt_bool_t decoder_properties_load(pocketsphinx_properties_t *properties, const apr_xml_elem *elem, apr_pool_t *pool)
+{
+	const apr_xml_attr *attr;
+	for(attr = elem->attr; attr; attr = attr->next) {
+		if(strcasecmp(attr->name,"workers") == 0) {
+			properties->worker_count = atol(attr->value);
+		}
+		else {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unknown Attribute <%s>",attr->name);
+		}
+	}
+	return TRUE;
+}
+
 static apt_bool_t save_waveform_properties_load(pocketsphinx_properties_t *properties, const apr_xml_elem *elem, apr_pool_t *pool)
 {
 	const apr_xml_attr *attr;
@@ -154,6 +168,7 @@ apt_bool_t pocketsphinx_properties_load(pocketsphinx_properties_t *properties,
 	properties->model_8k = NULL;
 	properties->model_16k = NULL;
 	properties->preferred_model = POCKETSPHINX_MODEL_NARROWBAND;
+	properties->worker_count = 4;
 
 	properties->no_input_timeout = 10000;
 	properties->recognition_timeout = 15000;
@@ -174,6 +189,9 @@ apt_bool_t pocketsphinx_properties_load(pocketsphinx_properties_t *properties,
 			else if(strcasecmp(elem->name,"model") == 0) {
 				model_properties_load(properties,elem,pool);
 			}
+			else if(strcasecmp(elem->name,"decoder") == 0) {
+				decoder_properties_load(properties,elem,pool);
+			}
 			else if(strcasecmp(elem->name,"save-waveform") == 0) {
 				save_waveform_properties_load(properties,elem,pool);
 			}
@@ -191,6 +209,10 @@ apt_bool_t pocketsphinx_properties_load(pocketsphinx_properties_t *properties,
 		properties->save_waveform_dir = dir_layout->data_dir_path;
 	}
 
+	if(!properties->worker_count) {
+		properties->worker_count = 1;
+	}
+
 	if(!properties->dictionary) {
 		properties->dictionary = "default.dic";
 	}
@@ -31,6 +31,7 @@
 
 #include "mrcp_recorder_engine.h"
 #include "mpf_activity_detector.h"
+#include "mpf_file_io.h"
 #include "apt_log.h"
 
 #define RECORDER_ENGINE_TASK_NAME "Recorder Engine"
@@ -101,8 +102,8 @@ struct recorder_channel_t {
 	apr_size_t               cur_size;
 	/** File name of the recording */
 	const char              *file_name;
-	/** File to write to */
-	FILE                    *audio_out;
+	/** File to write to (written in background) */
+	mpf_async_file_t        *audio_out;
 };
 
 
@@ -115,10 +116,16 @@ MRCP_PLUGIN_LOGGER_IMPLEMENT
 /** Create recorder engine */
 MRCP_PLUGIN_DECLARE(mrcp_engine_t*) mrcp_plugin_create(apr_pool_t *pool)
 {
+	/* create file I/O shared by the channels */
+	mpf_file_io_t *file_io = mpf_file_io_create(MPF_FILE_IO_DEFAULT_BUFFER_SIZE,pool);
+	if(!file_io) {
+		return NULL;
+	}
+
 	/* create engine base */
 	return mrcp_engine_create(
 				MRCP_RECORDER_RESOURCE,    /* MRCP resource identifier */
-				NULL,                      /* object to associate */
+				file_io,                   /* object to associate */
 				&engine_vtable,            /* virtual methods table of engine */
 				pool);                     /* pool to allocate memory from */
 }
@@ -132,12 +139,15 @@ static apt_bool_t recorder_engine_destroy(mrcp_engine_t *engine)
 /** Open recorder engine */
 static apt_bool_t recorder_engine_open(mrcp_engine_t *engine)
 {
-	return mrcp_engine_open_respond(engine,TRUE);
+	mpf_file_io_t *file_io = engine->obj;
+	return mrcp_engine_open_respond(engine,mpf_file_io_start(file_io));
 }
 
 /** Close recorder engine */
 static apt_bool_t recorder_engine_close(mrcp_engine_t *engine)
 {
+	mpf_file_io_t *file_io = engine->obj;
+	mpf_file_io_stop(file_io);
 	return mrcp_engine_close_respond(engine);
 }
 
@@ -226,11 +236,11 @@ static apt_bool_t recorder_file_open(recorder_channel_t *recorder_channel, mrcp_
 	}
 
 	if(recorder_channel->audio_out) {
-		fclose(recorder_channel->audio_out);
+		mpf_async_file_close(recorder_channel->audio_out);
 		recorder_channel->audio_out = NULL;
 	}
 
-	recorder_channel->audio_out = fopen(file_path,"wb");
+	recorder_channel->audio_out = mpf_async_file_open(channel->engine->obj,file_path,MPF_ASYNC_FILE_WRITE);
 	if(!recorder_channel->audio_out) {
 		return FALSE;
 	}
@@ -380,7 +390,7 @@ static apt_bool_t recorder_record_complete(recorder_channel_t *recorder_channel,
 	}
 
 	if(recorder_channel->audio_out) {
-		fclose(recorder_channel->audio_out);
+		mpf_async_file_close(recorder_channel->audio_out);
 		recorder_channel->audio_out = NULL;
 	}
 
@@ -404,6 +414,11 @@ static apt_bool_t recorder_record_complete(recorder_channel_t *recorder_channel,
 /** Callback is called from MPF engine context to destroy any additional data associated with audio stream */
 static apt_bool_t recorder_stream_destroy(mpf_audio_stream_t *stream)
 {
+	recorder_channel_t *recorder_channel = stream->obj;
+	if(recorder_channel->audio_out) {
+		mpf_async_file_close(recorder_channel->audio_out);
+		recorder_channel->audio_out = NULL;
+	}
 	return TRUE;
 }
 
@@ -425,7 +440,7 @@ static apt_bool_t recorder_stream_write(mpf_audio_stream_t *stream, const mpf_fr
 	recorder_channel_t *recorder_channel = stream->obj;
 	if(recorder_channel->stop_response) {
 		if(recorder_channel->audio_out) {
-			fclose(recorder_channel->audio_out);
+			mpf_async_file_close(recorder_channel->audio_out);
 			recorder_channel->audio_out = NULL;
 		}
 		
@@ -465,9 +480,9 @@ static apt_bool_t recorder_stream_write(mpf_audio_stream_t *stream, const mpf_fr
 		}
 
 		if(recorder_channel->audio_out) {
-			fwrite(frame->codec_frame.buffer,1,frame->codec_frame.size,recorder_channel->audio_out);
-			
-			recorder_channel->cur_size += frame->codec_frame.size;
+			if(mpf_async_file_write(recorder_channel->audio_out,frame->codec_frame.buffer,frame->codec_frame.size) == TRUE) {
+				recorder_channel->cur_size += frame->codec_frame.size;
+			}
 			recorder_channel->cur_time += CODEC_FRAME_TIME_BASE;
 			if(recorder_channel->max_time && recorder_channel->cur_time >= recorder_channel->max_time) {
 				recorder_record_complete(recorder_channel,RECORDER_COMPLETION_CAUSE_SUCCESS_MAXTIME);
@@ -0,0 +1,194 @@
+/*
+ * Copyright 2008-2010 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <apr_thread_proc.h>
+#include "apt_test_suite.h"
+#include "apt_lockfree_queue.h"
+#include "apt_log.h"
+
+#define PRODUCER_COUNT  4
+#define PUSH_COUNT      10000
+#define QUEUE_SIZE      64
+
+/** Producer pushing sequence numbers tagged with its own id */
+typedef struct queue_producer_t queue_producer_t;
+struct queue_producer_t {
+	apt_lockfree_queue_t *queue;
+	apr_size_t            id;
+	apr_size_t           *items;
+};
+
+static void* APR_THREAD_FUNC queue_producer_run(apr_thread_t *thread, void *data)
+{
+	queue_producer_t *producer = data;
+	apr_size_t i;
+	for(i=0; i<PUSH_COUNT; i++) {
+		/* bounded queue rejects the object once full, retry until the consumer makes room */
+		while(apt_lockfree_queue_push(producer->queue,&producer->items[i]) == FALSE) {
+			apr_thread_yield();
+		}
+	}
+	return NULL;
+}
+
+/** Fill the queue up and beyond its capacity */
+static apt_bool_t lockfree_queue_fill_run(apr_pool_t *pool)
+{
+	apt_lockfree_queue_t *queue;
+	apr_size_t items[QUEUE_SIZE * 3 + 1];
+	apr_size_t *item;
+	apr_size_t count = sizeof(items)/sizeof(items[0]);
+	apr_size_t next = 0;
+	apr_size_t i;
+
+	for(i=0; i<count; i++) {
+		items[i] = i;
+	}
+
+	/* bounded queue rejects the object once full */
+	queue = apt_lockfree_queue_create(QUEUE_SIZE,pool);
+	for(i=0; i<QUEUE_SIZE; i++) {
+		if(apt_lockfree_queue_push(queue,&items[i]) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Push Object [%"APR_SIZE_T_FMT"]",i);
+			return FALSE;
+		}
+	}
+	if(apt_lockfree_queue_push(queue,&items[i]) == TRUE || apt_lockfree_queue_overflow_count_get(queue) != 1) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Object Pushed to Full Queue");
+		return FALSE;
+	}
+	apt_lockfree_queue_destroy(queue);
+
+	/* queue with overflow list spills the objects, keeping them in order */
+	queue = apt_lockfree_queue_create_ex(QUEUE_SIZE,TRUE,pool);
+	for(i=0; i<count-1; i++) {
+		if(apt_lockfree_queue_push(queue,&items[i]) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Push Object [%"APR_SIZE_T_FMT"]",i);
+			return FALSE;
+		}
+	}
+	/* there is room in the ring again, but the overflow list is to be drained first */
+	item = apt_lockfree_queue_pop(queue);
+	if(!item || *item != next++ || apt_lockfree_queue_push(queue,&items[i]) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Push Object to Spilled Queue");
+		return FALSE;
+	}
+	while((item = apt_lockfree_queue_pop(queue)) != NULL) {
+		if(*item != next) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Object [%"APR_SIZE_T_FMT"] expected [%"APR_SIZE_T_FMT"]",*item,next);
+			return FALSE;
+		}
+		next++;
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Popped %"APR_SIZE_T_FMT" Objects from Filled Queue, Overflows [%u]",
+		next,
+		apt_lockfree_queue_overflow_count_get(queue));
+	if(next != count || apt_lockfree_queue_is_empty(queue) == FALSE ||
+		apt_lockfree_queue_overflow_count_get(queue) != count - QUEUE_SIZE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Objects Lost in Filled Queue");
+		return FALSE;
+	}
+	apt_lockfree_queue_destroy(queue);
+	return TRUE;
+}
+
+/** Run producer threads against a single consumer */
+static apt_bool_t lockfree_queue_threads_run(apt_lockfree_queue_t *queue, apr_pool_t *pool)
+{
+	queue_producer_t producers[PRODUCER_COUNT];
+	apr_thread_t *threads[PRODUCER_COUNT];
+	apr_size_t next[PRODUCER_COUNT];
+	apr_size_t popped = 0;
+	apr_size_t *item;
+	apr_size_t i;
+	apr_status_t rv;
+	apt_bool_t status = TRUE;
+
+	if(apt_lockfree_queue_is_empty(queue) == FALSE || apt_lockfree_queue_pop(queue) != NULL) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Newly Created Queue is not Empty");
+		return FALSE;
+	}
+
+	for(i=0; i<PRODUCER_COUNT; i++) {
+		apr_size_t j;
+		producers[i].queue = queue;
+		producers[i].id = i;
+		producers[i].items = apr_palloc(pool,sizeof(apr_size_t) * PUSH_COUNT);
+		for(j=0; j<PUSH_COUNT; j++) {
+			producers[i].items[j] = i * PUSH_COUNT + j;
+		}
+		next[i] = 0;
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Start %d Producers Pushing %d Objects Each",PRODUCER_COUNT,PUSH_COUNT);
+	for(i=0; i<PRODUCER_COUNT; i++) {
+		if(apr_thread_create(&threads[i],NULL,queue_producer_run,&producers[i],pool) != APR_SUCCESS) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Producer Thread");
+			return FALSE;
+		}
+	}
+
+	/* objects of each producer must come out in the order they were pushed */
+	while(popped < PRODUCER_COUNT * PUSH_COUNT) {
+		item = apt_lockfree_queue_pop(queue);
+		if(!item) {
+			apr_thread_yield();
+			continue;
+		}
+		i = *item / PUSH_COUNT;
+		if(*item % PUSH_COUNT != next[i]) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Object [%"APR_SIZE_T_FMT"] from Producer [%"APR_SIZE_T_FMT"]",
+				*item,i);
+			status = FALSE;
+		}
+		next[i] = *item % PUSH_COUNT + 1;
+		popped++;
+	}
+
+	for(i=0; i<PRODUCER_COUNT; i++) {
+		apr_thread_join(&rv,threads[i]);
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Popped %"APR_SIZE_T_FMT" Objects, Overflows [%u]",
+		popped,
+		apt_lockfree_queue_overflow_count_get(queue));
+	if(apt_lockfree_queue_is_empty(queue) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Queue is not Empty");
+		status = FALSE;
+	}
+	apt_lockfree_queue_destroy(queue);
+	return status;
+}
+
+static apt_bool_t lockfree_queue_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	if(lockfree_queue_fill_run(suite->pool) == FALSE) {
+		return FALSE;
+	}
+	if(lockfree_queue_threads_run(apt_lockfree_queue_create(QUEUE_SIZE,suite->pool),suite->pool) == FALSE) {
+		return FALSE;
+	}
+	return lockfree_queue_threads_run(apt_lockfree_queue_create_ex(QUEUE_SIZE,TRUE,suite->pool),suite->pool);
+}
+
+apt_test_suite_t* lockfree_queue_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"lockfree",NULL,lockfree_queue_test_run);
+	return suite;
+}
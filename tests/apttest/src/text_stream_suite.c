@@ -0,0 +1,289 @@
+/*
+ * Copyright 2008-2010 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <stdlib.h>
+#include <apr_time.h>
+#include "apt_test_suite.h"
+#include "apt_text_stream.h"
+#include "apt_log.h"
+
+#define TEXT_STREAM_ITERATION_COUNT 100000
+
+/** Start lines and header sections of real MRCPv2 messages (bodies are not scanned by these readers) */
+static const char *text_stream_corpus[] = {
+	"MRCP/2.0 732 SPEAK 543257\r\n"
+	"Channel-Identifier:32AECB23433802@speechsynth\r\n"
+	"Voice-gender:neutral\r\n"
+	"Voice-Age:25\r\n"
+	"Prosody-volume:medium\r\n"
+	"Content-Type:application/ssml+xml\r\n"
+	"Content-Length:542\r\n"
+	"\r\n",
+
+	"MRCP/2.0 903 RECOGNIZE 543257\r\n"
+	"Channel-Identifier:32AECB23433801@speechrecog\r\n"
+	"Confidence-Threshold:0.9\r\n"
+	"Content-Type:application/srgs+xml\r\n"
+	"Content-ID:<request1@form-level.store>\r\n"
+	"Content-Length:702\r\n"
+	"\r\n",
+
+	"MRCP/2.0 616 RECOGNITION-COMPLETE 543257 COMPLETE\r\n"
+	"Channel-Identifier:32AECB23433801@speechrecog\r\n"
+	"Completion-Cause:000 success\r\n"
+	"Waveform-URI:<http://web.media.com/session123/audio.wav>;size=342456;duration=25435\r\n"
+	"Content-Type:application/nlsml+xml\r\n"
+	"Content-Length:430\r\n"
+	"\r\n",
+
+	/* unusual but valid and malformed header fields */
+	"MRCP/2.0 120 SET-PARAMS 543258\n"
+	"  Channel-Identifier:   32AECB23433802@speechsynth   \n"
+	"Voice-Name:\r\n"
+	":Kill-On-Barge-In:false\r"
+	"Speech-Language\r\n"
+	"Logging-Tag: \t\r\n"
+	"\t \r\n"
+	"\r\n"
+};
+
+/** Reference (char by char) line reader */
+static apt_bool_t ref_line_read(apt_text_stream_t *stream, apt_str_t *line)
+{
+	char *pos = stream->pos;
+	apt_bool_t status = FALSE;
+	line->length = 0;
+	line->buf = pos;
+	while(pos < stream->end) {
+		if(*pos == APT_TOKEN_CR) {
+			line->length = pos - line->buf;
+			pos++;
+			if(pos < stream->end && *pos == APT_TOKEN_LF) {
+				pos++;
+			}
+			status = TRUE;
+			break;
+		}
+		else if(*pos == APT_TOKEN_LF) {
+			line->length = pos - line->buf;
+			pos++;
+			status = TRUE;
+			break;
+		}
+		pos++;
+	}
+
+	if(status == TRUE) {
+		stream->pos = pos;
+	}
+	else {
+		stream->is_eos = TRUE;
+		line->length = pos - line->buf;
+	}
+	return status;
+}
+
+/** Reference (char by char) header reader */
+static apt_bool_t ref_header_read(apt_text_stream_t *stream, apt_pair_t *pair)
+{
+	char *pos = stream->pos;
+	apt_bool_t status = FALSE;
+	apt_string_reset(&pair->name);
+	apt_string_reset(&pair->value);
+	while(pos < stream->end) {
+		if(*pos == APT_TOKEN_CR) {
+			if(pair->value.buf) {
+				pair->value.length = pos - pair->value.buf;
+			}
+			pos++;
+			if(pos < stream->end && *pos == APT_TOKEN_LF) {
+				pos++;
+			}
+			status = TRUE;
+			break;
+		}
+		else if(*pos == APT_TOKEN_LF) {
+			if(pair->value.buf) {
+				pair->value.length = pos - pair->value.buf;
+			}
+			pos++;
+			status = TRUE;
+			break;
+		}
+		else if(!pair->name.length) {
+			if(!pair->name.buf && apt_text_is_wsp(*pos) == FALSE) {
+				pair->name.buf = pos;
+			}
+			if(*pos == ':') {
+				pair->name.length = pos - pair->name.buf;
+			}
+		}
+		else if(!pair->value.length) {
+			if(!pair->value.buf && apt_text_is_wsp(*pos) == FALSE) {
+				pair->value.buf = pos;
+			}
+		}
+		pos++;
+	}
+
+	if(status == TRUE) {
+		stream->pos = pos;
+		if(!pair->name.length && pair->name.buf) {
+			status = FALSE;
+		}
+	}
+	else {
+		stream->is_eos = TRUE;
+	}
+	return status;
+}
+
+static apt_bool_t text_stream_str_compare(const apt_str_t *str, const apt_str_t *ref_str)
+{
+	if(str->length != ref_str->length) {
+		return FALSE;
+	}
+	/* the contents of an empty string is irrelevant */
+	return (!str->length || str->buf == ref_str->buf) ? TRUE : FALSE;
+}
+
+/** Scan the start line and header fields of the first length chars by both readers and compare the segmentation */
+static apt_bool_t text_stream_segmentation_check(const char *text, apr_size_t length)
+{
+	apt_text_stream_t stream;
+	apt_text_stream_t ref_stream;
+	apt_str_t line, ref_line;
+	apt_pair_t pair, ref_pair;
+	apt_bool_t status, ref_status;
+
+	stream.text.buf = (char*)text;
+	stream.text.length = length;
+	apt_text_stream_reset(&stream);
+	ref_stream = stream;
+
+	status = apt_text_line_read(&stream,&line);
+	ref_status = ref_line_read(&ref_stream,&ref_line);
+	if(status != ref_status || text_stream_str_compare(&line,&ref_line) == FALSE) {
+		return FALSE;
+	}
+
+	while(status == TRUE || stream.is_eos == FALSE) {
+		status = apt_text_header_read(&stream,&pair);
+		ref_status = ref_header_read(&ref_stream,&ref_pair);
+		if(status != ref_status ||
+			stream.pos != ref_stream.pos || stream.is_eos != ref_stream.is_eos) {
+			return FALSE;
+		}
+		if(status == FALSE) {
+			/* pair is undefined once reading failed */
+			continue;
+		}
+		if(text_stream_str_compare(&pair.name,&ref_pair.name) == FALSE ||
+			text_stream_str_compare(&pair.value,&ref_pair.value) == FALSE) {
+			return FALSE;
+		}
+		if(!pair.name.length) {
+			/* empty header terminates the header section */
+			break;
+		}
+	}
+	return (stream.pos == ref_stream.pos && stream.is_eos == ref_stream.is_eos) ? TRUE : FALSE;
+}
+
+static apr_size_t text_stream_headers_read(const char *text, apr_size_t length,
+	apt_bool_t (*line_read)(apt_text_stream_t*, apt_str_t*),
+	apt_bool_t (*header_read)(apt_text_stream_t*, apt_pair_t*))
+{
+	apt_text_stream_t stream;
+	apt_str_t line;
+	apt_pair_t pair;
+	apr_size_t count = 0;
+
+	stream.text.buf = (char*)text;
+	stream.text.length = length;
+	apt_text_stream_reset(&stream);
+
+	line_read(&stream,&line);
+	while(stream.pos < stream.end) {
+		if(header_read(&stream,&pair) == TRUE && !pair.name.length) {
+			break;
+		}
+		count++;
+	}
+	return count;
+}
+
+static apr_interval_time_t text_stream_measure(
+	apt_bool_t (*line_read)(apt_text_stream_t*, apt_str_t*),
+	apt_bool_t (*header_read)(apt_text_stream_t*, apt_pair_t*),
+	apr_size_t iteration_count,
+	apr_size_t *field_count)
+{
+	apr_size_t i,j;
+	apr_time_t start = apr_time_now();
+	*field_count = 0;
+	for(i=0; i<iteration_count; i++) {
+		for(j=0; j<sizeof(text_stream_corpus)/sizeof(text_stream_corpus[0]); j++) {
+			*field_count += text_stream_headers_read(text_stream_corpus[j],strlen(text_stream_corpus[j]),line_read,header_read);
+		}
+	}
+	return apr_time_now() - start;
+}
+
+static apt_bool_t text_stream_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apr_size_t iteration_count = TEXT_STREAM_ITERATION_COUNT;
+	apr_interval_time_t ref_time;
+	apr_interval_time_t time;
+	apr_size_t ref_field_count;
+	apr_size_t field_count;
+	apr_size_t i;
+	apr_size_t length;
+
+	if(argc > 0) {
+		iteration_count = atol(argv[0]);
+	}
+
+	/* every prefix simulates a message received partially (CR and LF may be split too) */
+	for(i=0; i<sizeof(text_stream_corpus)/sizeof(text_stream_corpus[0]); i++) {
+		for(length=0; length<=strlen(text_stream_corpus[i]); length++) {
+			if(text_stream_segmentation_check(text_stream_corpus[i],length) == FALSE) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Segmentation Mismatch Message [%"APR_SIZE_T_FMT"] Length [%"APR_SIZE_T_FMT"]",
+					i,length);
+				return FALSE;
+			}
+		}
+	}
+
+	ref_time = text_stream_measure(ref_line_read,ref_header_read,iteration_count,&ref_field_count);
+	time = text_stream_measure(apt_text_line_read,apt_text_header_read,iteration_count,&field_count);
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Read %"APR_SIZE_T_FMT" Header Fields: char by char [%"APR_TIME_T_FMT" usec] vectorized [%"APR_TIME_T_FMT" usec]",
+		field_count,ref_time,time);
+	if(field_count != ref_field_count) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Header Field Count Mismatch [%"APR_SIZE_T_FMT"] expected [%"APR_SIZE_T_FMT"]",
+			field_count,ref_field_count);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+apt_test_suite_t* text_stream_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"text-stream",NULL,text_stream_test_run);
+	return suite;
+}
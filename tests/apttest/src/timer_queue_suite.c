@@ -0,0 +1,261 @@
+/*
+ * Copyright 2008-2010 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include "apt_test_suite.h"
+#include "apt_timer_queue.h"
+#include "apt_log.h"
+
+/** Time the queue is advanced by before the timers are set, so the wheels aren't aligned */
+#define TQ_OFFSET        100
+/** Max number of timer expirations recorded */
+#define TQ_MAX_RECORDS   32
+
+/** Timer of the scenario */
+typedef struct {
+	/** Timeout the timer is set to first */
+	apr_uint32_t timeout;
+	/** Timeout the timer is re-armed to from its proc */
+	apr_uint32_t period;
+	/** Number of times the timer is re-armed */
+	apr_uint32_t rearm_count;
+} tq_timer_spec_t;
+
+/*
+ * The timeouts straddle the boundaries of the wheels: the root one spans
+ * 2^8 ticks, the node ones 2^14, 2^20 and 2^26 ticks respectively.
+ */
+static const tq_timer_spec_t tq_timer_specs[] = {
+	{1,                0,     0},
+	{255,              0,     0},
+	{256,              0,     0},
+	{257,              0,     0},
+	{1000,             300,   3},
+	{16000,            16384, 2},
+	{16383,            0,     0},
+	{16384,            0,     0},
+	{16385,            0,     0},
+	{(1 << 20) - 1,    0,     0},
+	{(1 << 20) + 1,    0,     0},
+	{(1 << 26) + 3,    0,     0}
+};
+
+#define TQ_TIMER_COUNT   (sizeof(tq_timer_specs)/sizeof(tq_timer_specs[0]))
+/** Time to advance the queue by, until all the timers elapse */
+#define TQ_DURATION      ((1 << 26) + 4)
+
+/** Timer expiration */
+typedef struct {
+	apr_size_t   id;
+	apr_uint32_t time;
+} tq_record_t;
+
+/** Scenario context */
+typedef struct {
+	/** Current time, maintained while advancing tick by tick */
+	apr_uint32_t now;
+	tq_record_t  records[TQ_MAX_RECORDS];
+	apr_size_t   count;
+} tq_context_t;
+
+/** Timer object */
+typedef struct {
+	tq_context_t *context;
+	apr_size_t    id;
+	apr_uint32_t  rearm_count;
+} tq_timer_t;
+
+static void tq_timer_proc(apt_timer_t *timer, void *obj)
+{
+	tq_timer_t *tq_timer = obj;
+	tq_context_t *context = tq_timer->context;
+	if(context->count < TQ_MAX_RECORDS) {
+		context->records[context->count].id = tq_timer->id;
+		context->records[context->count].time = context->now;
+	}
+	context->count++;
+
+	if(tq_timer->rearm_count) {
+		tq_timer->rearm_count--;
+		apt_timer_set(timer,tq_timer_specs[tq_timer->id].period);
+	}
+}
+
+static void tq_killed_timer_proc(apt_timer_t *timer, void *obj)
+{
+	tq_context_t *context = obj;
+	apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Killed Timer Elapsed at [%u]",context->now);
+	context->count = TQ_MAX_RECORDS + 1;
+}
+
+/** Set the timers, advance the queue either tick by tick or at once and record the expirations */
+static apt_bool_t tq_scenario_run(tq_context_t *context, apt_bool_t single_tick, apr_pool_t *pool)
+{
+	apt_timer_queue_t *queue = apt_timer_queue_create(pool);
+	apt_timer_t *timers[TQ_TIMER_COUNT];
+	tq_timer_t tq_timers[TQ_TIMER_COUNT];
+	apt_timer_t *root_timer = apt_timer_create(queue,tq_killed_timer_proc,context,pool);
+	apt_timer_t *node_timer = apt_timer_create(queue,tq_killed_timer_proc,context,pool);
+	apr_uint32_t timeout = 0;
+	apr_uint32_t i;
+
+	context->now = 0;
+	context->count = 0;
+	/* nothing is set, the queue just moves on */
+	apt_timer_queue_advance(queue,TQ_OFFSET);
+	context->now += TQ_OFFSET;
+
+	for(i=0; i<TQ_TIMER_COUNT; i++) {
+		tq_timers[i].context = context;
+		tq_timers[i].id = i;
+		tq_timers[i].rearm_count = tq_timer_specs[i].rearm_count;
+		timers[i] = apt_timer_create(queue,tq_timer_proc,&tq_timers[i],pool);
+		apt_timer_set(timers[i],tq_timer_specs[i].timeout);
+	}
+	if(apt_timer_queue_timeout_get(queue,&timeout) == FALSE || timeout != tq_timer_specs[0].timeout) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Queue Timeout [%u]",timeout);
+		return FALSE;
+	}
+
+	/* armed timers are killed before they cascade or elapse */
+	apt_timer_set(root_timer,10);
+	apt_timer_set(node_timer,20000);
+	if(apt_timer_kill(root_timer) == FALSE || apt_timer_kill(node_timer) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Kill Armed Timer");
+		return FALSE;
+	}
+	if(apt_timer_kill(root_timer) == TRUE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Killed Timer Twice");
+		return FALSE;
+	}
+
+	if(single_tick == TRUE) {
+		for(i=0; i<TQ_DURATION; i++) {
+			/* the procs are called once the tick is over */
+			context->now++;
+			apt_timer_queue_advance(queue,1);
+		}
+	}
+	else {
+		apt_timer_queue_advance(queue,TQ_DURATION);
+		context->now += TQ_DURATION;
+	}
+
+	if(apt_timer_queue_is_empty(queue) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Timers Left in Queue");
+		return FALSE;
+	}
+	/* the elapsed timers are not set anymore */
+	for(i=0; i<TQ_TIMER_COUNT; i++) {
+		if(apt_timer_kill(timers[i]) == TRUE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Killed Elapsed Timer [%u]",i);
+			return FALSE;
+		}
+	}
+	if(context->count > TQ_MAX_RECORDS) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Too Many Timers Elapsed [%"APR_SIZE_T_FMT"]",context->count);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Compose the expected expirations ordered by time */
+static apr_size_t tq_expected_records_get(tq_record_t *records)
+{
+	apr_size_t count = 0;
+	apr_size_t i, j;
+	apr_uint32_t k;
+	apr_uint32_t time;
+	tq_record_t record;
+	for(i=0; i<TQ_TIMER_COUNT; i++) {
+		time = TQ_OFFSET + tq_timer_specs[i].timeout;
+		for(k=0; k<=tq_timer_specs[i].rearm_count; k++) {
+			records[count].id = i;
+			records[count].time = time;
+			count++;
+			time += tq_timer_specs[i].period;
+		}
+	}
+
+	for(i=1; i<count; i++) {
+		record = records[i];
+		for(j=i; j>0 && records[j-1].time > record.time; j--) {
+			records[j] = records[j-1];
+		}
+		records[j] = record;
+	}
+	return count;
+}
+
+static apt_bool_t timer_queue_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	tq_record_t expected[TQ_MAX_RECORDS];
+	apr_size_t expected_count;
+	tq_context_t single_context;
+	tq_context_t long_context;
+	apr_size_t i;
+
+	expected_count = tq_expected_records_get(expected);
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Advance Timer Queue Tick by Tick [%u ticks]",TQ_DURATION);
+	if(tq_scenario_run(&single_context,TRUE,suite->pool) == FALSE) {
+		return FALSE;
+	}
+	if(single_context.count != expected_count) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Number of Expirations [%"APR_SIZE_T_FMT"] expected [%"APR_SIZE_T_FMT"]",
+			single_context.count,
+			expected_count);
+		return FALSE;
+	}
+	for(i=0; i<expected_count; i++) {
+		if(single_context.records[i].id != expected[i].id || single_context.records[i].time != expected[i].time) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Expiration [%"APR_SIZE_T_FMT"]: timer [%"APR_SIZE_T_FMT"] at [%u] expected timer [%"APR_SIZE_T_FMT"] at [%u]",
+				i,
+				single_context.records[i].id,
+				single_context.records[i].time,
+				expected[i].id,
+				expected[i].time);
+			return FALSE;
+		}
+	}
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Advance Timer Queue at Once [%u ticks]",TQ_DURATION);
+	if(tq_scenario_run(&long_context,FALSE,suite->pool) == FALSE) {
+		return FALSE;
+	}
+	/* the time is not observable within a single advance, the order is */
+	if(long_context.count != expected_count) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Number of Expirations [%"APR_SIZE_T_FMT"]",long_context.count);
+		return FALSE;
+	}
+	for(i=0; i<expected_count; i++) {
+		if(long_context.records[i].id != single_context.records[i].id) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Expiration Order [%"APR_SIZE_T_FMT"]: timer [%"APR_SIZE_T_FMT"] expected [%"APR_SIZE_T_FMT"]",
+				i,
+				long_context.records[i].id,
+				single_context.records[i].id);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+apt_test_suite_t* timer_queue_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"timer-queue",NULL,timer_queue_test_run);
+	return suite;
+}
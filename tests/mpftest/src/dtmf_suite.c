@@ -0,0 +1,417 @@
+/*
+ * Copyright 2008-2010 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <stdlib.h>
+#include <math.h>
+#include <apr_time.h>
+#include "apt_test_suite.h"
+#include "apt_log.h"
+#include "mpf_dtmf_detector.h"
+#include "mpf_named_event.h"
+
+#ifndef M_PI
+#	define M_PI 3.141592653589793238462643
+#endif
+
+/** Number of channels analyzed by the benchmark */
+#define DTMF_CHANNEL_COUNT   64
+/** Default number of frames per channel analyzed by the benchmark */
+#define DTMF_FRAME_COUNT     5000
+/** Frame duration in msec */
+#define DTMF_FRAME_DURATION  10
+/** Max number of samples in a frame (16 kHz) */
+#define DTMF_FRAME_MAX_SAMPLES (16000 * DTMF_FRAME_DURATION / 1000)
+/** Tone and pause durations in msec */
+#define DTMF_TONE_DURATION   60
+#define DTMF_PAUSE_DURATION  60
+
+static const char dtmf_digits[] = "1234567890*#ABCD";
+
+/** Reference detector (double precision Goertzel filters run one by one) */
+typedef struct dtmf_ref_detector_t dtmf_ref_detector_t;
+struct dtmf_ref_detector_t {
+	double     coef[8];
+	double     s1[8];
+	double     s2[8];
+	double     totenergy;
+	apr_size_t wsamples;
+	apr_size_t nsamples;
+	char       last1, last2, curr;
+	char       digits[64];
+	apr_size_t digit_count;
+};
+
+static void dtmf_ref_detector_init(dtmf_ref_detector_t *det, apr_uint16_t sampling_rate)
+{
+	static const double freqs[8] = {697, 770, 852, 941, 1209, 1336, 1477, 1633};
+	apr_size_t i;
+	memset(det,0,sizeof(dtmf_ref_detector_t));
+	for(i=0; i<8; i++) {
+		det->coef[i] = 2 * cos(2 * M_PI * freqs[i] / sampling_rate);
+	}
+	det->wsamples = 102 * (sampling_rate / 8000);
+}
+
+static void dtmf_ref_window_process(dtmf_ref_detector_t *det)
+{
+	static const char freq2digits[4][4] = {{'1','2','3','A'},{'4','5','6','B'},{'7','8','9','C'},{'*','0','#','D'}};
+	apr_size_t i, rmax = 0, cmax = 0;
+	double reng = 0, ceng = 0, eng;
+	char digit = 0;
+
+	for(i=0; i<8; i++) {
+		eng = det->s1[i] * det->s1[i] + det->s2[i] * det->s2[i] - det->coef[i] * det->s1[i] * det->s2[i];
+		if(i < 4) {
+			if(eng > reng) {
+				rmax = i;
+				reng = eng;
+			}
+		}
+		else if(eng > ceng) {
+			cmax = i;
+			ceng = eng;
+		}
+	}
+
+	if(reng < 8.0e10 * det->wsamples / 102 || ceng < 8.0e10 * det->wsamples / 102) {
+	}
+	else if(ceng > reng && reng < ceng * 0.398) {
+	}
+	else if(ceng < reng && ceng < reng * 0.158) {
+	}
+	else if(0.25 * det->totenergy > reng + ceng) {
+	}
+	else {
+		digit = freq2digits[rmax][cmax - 4];
+	}
+
+	if(digit != det->curr) {
+		if(digit && det->last1 == digit && det->last2 == digit) {
+			det->curr = digit;
+			if(det->digit_count < sizeof(det->digits) - 1) {
+				det->digits[det->digit_count++] = digit;
+			}
+		}
+		else if(det->last1 != det->curr && det->last2 != det->curr) {
+			det->curr = 0;
+		}
+	}
+	det->last1 = det->last2;
+	det->last2 = digit;
+
+	for(i=0; i<8; i++) {
+		det->s1[i] = det->s2[i] = 0;
+	}
+	det->totenergy = 0;
+}
+
+static void dtmf_ref_detector_process(dtmf_ref_detector_t *det, const apr_int16_t *samples, apr_size_t count)
+{
+	apr_size_t i,j;
+	double s;
+	for(i=0; i<count; i++) {
+		for(j=0; j<8; j++) {
+			s = det->s1[j];
+			det->s1[j] = det->s2[j];
+			det->s2[j] = samples[i] + det->coef[j] * det->s1[j] - s;
+		}
+		det->totenergy += samples[i] * samples[i];
+		if(++det->nsamples >= det->wsamples) {
+			dtmf_ref_window_process(det);
+			det->nsamples = 0;
+		}
+	}
+}
+
+/** Synthesize the digits as tones separated by pauses, noise and a channel specific offset are added */
+static apr_int16_t* dtmf_signal_create(const char *digits, apr_uint16_t sampling_rate, apr_size_t offset, apr_size_t *sample_count, apr_pool_t *pool)
+{
+	static const double rows[4] = {697, 770, 852, 941};
+	static const double cols[4] = {1209, 1336, 1477, 1633};
+	static const char *layout = "123A456B789C*0#D";
+	apr_size_t tone_samples = sampling_rate * DTMF_TONE_DURATION / 1000;
+	apr_size_t pause_samples = sampling_rate * DTMF_PAUSE_DURATION / 1000;
+	apr_size_t count = offset + strlen(digits) * (tone_samples + pause_samples);
+	apr_int16_t *signal;
+	apr_size_t i,j,pos;
+	double row,col,value;
+
+	/* round up to whole frames */
+	j = sampling_rate * DTMF_FRAME_DURATION / 1000;
+	count = (count + j - 1) / j * j;
+	signal = apr_palloc(pool,count * sizeof(apr_int16_t));
+	for(i=0; i<count; i++) {
+		signal[i] = (apr_int16_t)(rand() % 201 - 100);
+	}
+
+	pos = offset;
+	for(i=0; digits[i]; i++) {
+		j = strchr(layout,digits[i]) - layout;
+		row = rows[j / 4];
+		col = cols[j % 4];
+		for(j=0; j<tone_samples; j++, pos++) {
+			value = 7000 * sin(2 * M_PI * row * j / sampling_rate) + 9000 * sin(2 * M_PI * col * j / sampling_rate);
+			signal[pos] = (apr_int16_t)(signal[pos] + value);
+		}
+		pos += pause_samples;
+	}
+	*sample_count = count;
+	return signal;
+}
+
+static mpf_dtmf_detector_t* dtmf_detector_create(mpf_audio_stream_t *stream, mpf_codec_descriptor_t *descriptor, apr_uint16_t sampling_rate, apr_pool_t *pool)
+{
+	memset(descriptor,0,sizeof(mpf_codec_descriptor_t));
+	descriptor->sampling_rate = sampling_rate;
+	descriptor->channel_count = 1;
+	memset(stream,0,sizeof(mpf_audio_stream_t));
+	stream->tx_descriptor = descriptor;
+	return mpf_dtmf_detector_create_ex(stream,MPF_DTMF_DETECTOR_INBAND,pool);
+}
+
+static void dtmf_frame_set(mpf_frame_t *frame, const apr_int16_t *samples, apr_size_t sample_count)
+{
+	frame->type = MEDIA_FRAME_TYPE_AUDIO;
+	frame->marker = MPF_MARKER_NONE;
+	frame->codec_frame.buffer = (void*)samples;
+	frame->codec_frame.size = sample_count * sizeof(apr_int16_t);
+}
+
+static apt_bool_t dtmf_digits_check(const char *name, mpf_dtmf_detector_t *detector, const char *expected)
+{
+	char digits[64];
+	apr_size_t count = 0;
+	char digit;
+	while((digit = mpf_dtmf_detector_digit_get(detector)) != 0 && count < sizeof(digits) - 1) {
+		digits[count++] = digit;
+	}
+	digits[count] = '\0';
+	if(strcmp(digits,expected) != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"%s Detected [%s] expected [%s]",name,digits,expected);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Detect digits by the reference detector and a single detector */
+static apt_bool_t dtmf_detection_check(apr_uint16_t sampling_rate, apr_pool_t *pool)
+{
+	mpf_audio_stream_t stream;
+	mpf_codec_descriptor_t descriptor;
+	mpf_dtmf_detector_t *detector;
+	mpf_frame_t frame;
+	apr_int16_t *signal;
+	apr_size_t count;
+	apr_size_t frame_samples = sampling_rate * DTMF_FRAME_DURATION / 1000;
+	dtmf_ref_detector_t ref_detector;
+	apr_size_t i;
+	char name[32];
+
+	signal = dtmf_signal_create(dtmf_digits,sampling_rate,0,&count,pool);
+	dtmf_ref_detector_init(&ref_detector,sampling_rate);
+	dtmf_ref_detector_process(&ref_detector,signal,count);
+	if(strcmp(ref_detector.digits,dtmf_digits) != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Reference Detected [%s] at [%hu Hz]",ref_detector.digits,sampling_rate);
+		return FALSE;
+	}
+
+	detector = dtmf_detector_create(&stream,&descriptor,sampling_rate,pool);
+	for(i=0; i<count; i+=frame_samples) {
+		dtmf_frame_set(&frame,signal + i,frame_samples);
+		mpf_dtmf_detector_get_frame(detector,&frame);
+	}
+	sprintf(name,"Single [%hu Hz]",sampling_rate);
+	return dtmf_digits_check(name,detector,ref_detector.digits);
+}
+
+static apt_bool_t dtmf_batch_check(apr_uint16_t sampling_rate, apr_pool_t *pool)
+{
+	static const char *expected[5] = {"1234567890*#ABCD", "#0*", "", "DCBA9876", "5"};
+	mpf_audio_stream_t streams[5];
+	mpf_codec_descriptor_t descriptors[5];
+	mpf_dtmf_detector_t *detectors[5];
+	mpf_dtmf_detector_t *batch[5];
+	const mpf_frame_t *frame_ptrs[5];
+	mpf_frame_t frames[5];
+	apr_int16_t *signals[5];
+	apr_size_t counts[5];
+	apr_size_t frame_samples = sampling_rate * DTMF_FRAME_DURATION / 1000;
+	apr_size_t i,j,active;
+	char name[32];
+
+	for(i=0; i<5; i++) {
+		signals[i] = dtmf_signal_create(expected[i],sampling_rate,i * 37,&counts[i],pool);
+		detectors[i] = dtmf_detector_create(&streams[i],&descriptors[i],sampling_rate,pool);
+	}
+
+	/* channels end at different times, so the batch shrinks */
+	for(j=0; ; j+=frame_samples) {
+		active = 0;
+		for(i=0; i<5; i++) {
+			if(j < counts[i]) {
+				dtmf_frame_set(&frames[i],signals[i] + j,frame_samples);
+				batch[active] = detectors[i];
+				frame_ptrs[active] = &frames[i];
+				active++;
+			}
+		}
+		if(!active) {
+			break;
+		}
+		mpf_dtmf_detector_get_frames(batch,frame_ptrs,active);
+	}
+
+	for(i=0; i<5; i++) {
+		sprintf(name,"Batch [%hu Hz] #%d",sampling_rate,(int)i);
+		if(dtmf_digits_check(name,detectors[i],expected[i]) == FALSE) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/** Fill the ring by out-of-band digits without taking them */
+static apt_bool_t dtmf_ring_check(apr_pool_t *pool)
+{
+	mpf_audio_stream_t stream;
+	mpf_dtmf_detector_t *detector;
+	mpf_frame_t frame;
+	char expected[64];
+	apr_size_t i;
+
+	memset(&stream,0,sizeof(stream));
+	detector = mpf_dtmf_detector_create_ex(&stream,MPF_DTMF_DETECTOR_OUTBAND,pool);
+	if(!detector) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Out-of-band Detector");
+		return FALSE;
+	}
+
+	memset(&frame,0,sizeof(frame));
+	frame.type = MEDIA_FRAME_TYPE_EVENT;
+	frame.marker = MPF_MARKER_START_OF_EVENT;
+	for(i=0; i<40; i++) {
+		frame.event_frame.event_id = mpf_dtmf_char_to_event_id(dtmf_digits[i % 16]);
+		mpf_dtmf_detector_get_frame(detector,&frame);
+		if(i < 32) {
+			expected[i] = dtmf_digits[i % 16];
+		}
+	}
+	expected[32] = '\0';
+	if(mpf_dtmf_detector_digits_lost(detector) != 8) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Lost [%"APR_SIZE_T_FMT"] Digits expected [8]",mpf_dtmf_detector_digits_lost(detector));
+		return FALSE;
+	}
+	if(dtmf_digits_check("Ring",detector,expected) == FALSE) {
+		return FALSE;
+	}
+
+	/* wrap around the ring */
+	for(i=0; i<20; i++) {
+		frame.event_frame.event_id = mpf_dtmf_char_to_event_id(dtmf_digits[i % 16]);
+		mpf_dtmf_detector_get_frame(detector,&frame);
+	}
+	mpf_dtmf_detector_reset(detector);
+	if(mpf_dtmf_detector_digit_get(detector) || mpf_dtmf_detector_digits_lost(detector)) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Ring not Empty after Reset");
+		return FALSE;
+	}
+	frame.event_frame.event_id = mpf_dtmf_char_to_event_id('7');
+	mpf_dtmf_detector_get_frame(detector,&frame);
+	return dtmf_digits_check("Ring after Reset",detector,"7");
+}
+
+static void dtmf_benchmark_run(apr_uint16_t sampling_rate, apr_size_t frame_count, apr_pool_t *pool)
+{
+	mpf_audio_stream_t *streams = apr_palloc(pool,sizeof(mpf_audio_stream_t) * DTMF_CHANNEL_COUNT);
+	mpf_codec_descriptor_t *descriptors = apr_palloc(pool,sizeof(mpf_codec_descriptor_t) * DTMF_CHANNEL_COUNT);
+	mpf_dtmf_detector_t *detectors[DTMF_CHANNEL_COUNT];
+	dtmf_ref_detector_t *ref_detectors = apr_palloc(pool,sizeof(dtmf_ref_detector_t) * DTMF_CHANNEL_COUNT);
+	mpf_frame_t frames[DTMF_CHANNEL_COUNT];
+	const mpf_frame_t *frame_ptrs[DTMF_CHANNEL_COUNT];
+	apr_size_t frame_samples = sampling_rate * DTMF_FRAME_DURATION / 1000;
+	apr_size_t signal_frames;
+	apr_int16_t *signal;
+	apr_size_t count;
+	apr_interval_time_t ref_time, single_time, batch_time;
+	apr_time_t start;
+	apr_size_t i,j;
+
+	signal = dtmf_signal_create(dtmf_digits,sampling_rate,0,&count,pool);
+	signal_frames = count / frame_samples;
+	for(i=0; i<DTMF_CHANNEL_COUNT; i++) {
+		dtmf_ref_detector_init(&ref_detectors[i],sampling_rate);
+		detectors[i] = dtmf_detector_create(&streams[i],&descriptors[i],sampling_rate,pool);
+		frame_ptrs[i] = &frames[i];
+	}
+
+	start = apr_time_now();
+	for(j=0; j<frame_count; j++) {
+		for(i=0; i<DTMF_CHANNEL_COUNT; i++) {
+			dtmf_ref_detector_process(&ref_detectors[i],signal + ((i + j) % signal_frames) * frame_samples,frame_samples);
+		}
+	}
+	ref_time = apr_time_now() - start;
+
+	start = apr_time_now();
+	for(j=0; j<frame_count; j++) {
+		for(i=0; i<DTMF_CHANNEL_COUNT; i++) {
+			dtmf_frame_set(&frames[i],signal + ((i + j) % signal_frames) * frame_samples,frame_samples);
+			mpf_dtmf_detector_get_frame(detectors[i],&frames[i]);
+		}
+	}
+	single_time = apr_time_now() - start;
+
+	start = apr_time_now();
+	for(j=0; j<frame_count; j++) {
+		for(i=0; i<DTMF_CHANNEL_COUNT; i++) {
+			dtmf_frame_set(&frames[i],signal + ((i + j) % signal_frames) * frame_samples,frame_samples);
+		}
+		mpf_dtmf_detector_get_frames(detectors,frame_ptrs,DTMF_CHANNEL_COUNT);
+	}
+	batch_time = apr_time_now() - start;
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Analyze %d x %"APR_SIZE_T_FMT" Frames [%hu Hz]: double [%"APR_TIME_T_FMT" usec] vectorized [%"APR_TIME_T_FMT" usec] batched [%"APR_TIME_T_FMT" usec]",
+		DTMF_CHANNEL_COUNT,frame_count,sampling_rate,ref_time,single_time,batch_time);
+}
+
+static apt_bool_t dtmf_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apr_size_t frame_count = DTMF_FRAME_COUNT;
+	if(argc > 0) {
+		frame_count = atol(argv[0]);
+	}
+
+	srand(1);
+	if(dtmf_detection_check(8000,suite->pool) == FALSE ||
+		dtmf_detection_check(16000,suite->pool) == FALSE ||
+		dtmf_batch_check(8000,suite->pool) == FALSE ||
+		dtmf_batch_check(16000,suite->pool) == FALSE ||
+		dtmf_ring_check(suite->pool) == FALSE) {
+		return FALSE;
+	}
+
+	dtmf_benchmark_run(8000,frame_count,suite->pool);
+	dtmf_benchmark_run(16000,frame_count,suite->pool);
+	return TRUE;
+}
+
+apt_test_suite_t* dtmf_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"dtmf",NULL,dtmf_test_run);
+	return suite;
+}
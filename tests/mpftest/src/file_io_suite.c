@@ -0,0 +1,284 @@
+/*
+ * Copyright 2008-2010 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <stdio.h>
+#include <apr_time.h>
+#include "apt_test_suite.h"
+#include "apt_dir_layout.h"
+#include "apt_log.h"
+#include "mpf_file_io.h"
+
+/** Size of a chunk (10 msec of 8 kHz linear PCM) */
+#define FIO_CHUNK_SIZE       160
+/** Number of chunks written, fits the default buffer */
+#define FIO_CHUNK_COUNT      300
+/** Size of the small buffer (minimal one) */
+#define FIO_SMALL_BUFFER     4096
+/** Number of writes expected to be dropped */
+#define FIO_OVERFLOW_COUNT   5
+/** Max number of attempts to read a chunk not fetched yet */
+#define FIO_READ_ATTEMPTS    1000
+
+/** Byte of the stream at specified offset */
+static APR_INLINE apr_byte_t fio_stream_byte(apr_size_t offset)
+{
+	return (apr_byte_t)((offset * 7 + offset / 251) & 0xFF);
+}
+
+/** Write a chunk of the stream starting at specified offset */
+static apt_bool_t fio_stream_write(mpf_async_file_t *file, apr_size_t offset)
+{
+	apr_byte_t data[FIO_CHUNK_SIZE];
+	apr_size_t i;
+	for(i=0; i<FIO_CHUNK_SIZE; i++) {
+		data[i] = fio_stream_byte(offset + i);
+	}
+	return mpf_async_file_write(file,data,FIO_CHUNK_SIZE);
+}
+
+/** Check the chunk read to contain bytes of the stream starting at specified offset */
+static apt_bool_t fio_stream_check(const apr_byte_t *data, apr_size_t offset)
+{
+	apr_size_t i;
+	for(i=0; i<FIO_CHUNK_SIZE; i++) {
+		if(data[i] != fio_stream_byte(offset + i)) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/** Read the whole file back, return the number of bytes matching the stream */
+static apr_size_t fio_stream_read(mpf_async_file_t *file)
+{
+	apr_byte_t data[FIO_CHUNK_SIZE];
+	apr_size_t offset = 0;
+	int attempts = 0;
+	while(attempts < FIO_READ_ATTEMPTS) {
+		if(mpf_async_file_read(file,data,FIO_CHUNK_SIZE) == TRUE) {
+			if(fio_stream_check(data,offset) == FALSE) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected File Data at [%"APR_SIZE_T_FMT"]",offset);
+				break;
+			}
+			offset += FIO_CHUNK_SIZE;
+			attempts = 0;
+			continue;
+		}
+		if(mpf_async_file_eof(file) == TRUE) {
+			break;
+		}
+		/* not fetched yet */
+		apr_sleep(1000);
+		attempts++;
+	}
+	return offset;
+}
+
+/** Get the size of the file on disk */
+static long fio_file_size_get(const char *file_path)
+{
+	long size = -1;
+	FILE *handle = fopen(file_path,"rb");
+	if(handle) {
+		if(fseek(handle,0,SEEK_END) == 0) {
+			size = ftell(handle);
+		}
+		fclose(handle);
+	}
+	return size;
+}
+
+/** Write the stream, close the file before stop, then read it back */
+static apt_bool_t fio_transfer_run(const char *file_path, apr_pool_t *pool)
+{
+	apr_size_t i;
+	apr_size_t read;
+	mpf_async_file_t *file;
+	mpf_file_io_t *file_io = mpf_file_io_create(MPF_FILE_IO_DEFAULT_BUFFER_SIZE,pool);
+	if(!file_io || mpf_file_io_start(file_io) == FALSE) {
+		return FALSE;
+	}
+
+	file = mpf_async_file_open(file_io,file_path,MPF_ASYNC_FILE_WRITE);
+	if(!file) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Open File for Writing [%s]",file_path);
+		mpf_file_io_stop(file_io);
+		return FALSE;
+	}
+	for(i=0; i<FIO_CHUNK_COUNT; i++) {
+		fio_stream_write(file,i * FIO_CHUNK_SIZE);
+	}
+	if(mpf_async_file_overflow_count_get(file) != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Overflows [%u]",mpf_async_file_overflow_count_get(file));
+		mpf_async_file_close(file);
+		mpf_file_io_stop(file_io);
+		return FALSE;
+	}
+	/* the pending data is flushed by the time stop returns */
+	mpf_async_file_close(file);
+	mpf_file_io_stop(file_io);
+
+	if(fio_file_size_get(file_path) != FIO_CHUNK_COUNT * FIO_CHUNK_SIZE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected File Size [%ld]",fio_file_size_get(file_path));
+		return FALSE;
+	}
+
+	/* the small buffer is prefilled partially, the rest is fetched in background */
+	file_io = mpf_file_io_create(FIO_SMALL_BUFFER,pool);
+	if(!file_io || mpf_file_io_start(file_io) == FALSE) {
+		return FALSE;
+	}
+	file = mpf_async_file_open(file_io,file_path,MPF_ASYNC_FILE_READ);
+	if(!file) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Open File for Reading [%s]",file_path);
+		mpf_file_io_stop(file_io);
+		return FALSE;
+	}
+	read = fio_stream_read(file);
+	mpf_async_file_close(file);
+	mpf_file_io_stop(file_io);
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"FIO Transfer: read [%"APR_SIZE_T_FMT" bytes]",read);
+	if(read != FIO_CHUNK_COUNT * FIO_CHUNK_SIZE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Number of Bytes Read");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Stop with the files still open, then use and close them */
+static apt_bool_t fio_stop_run(const char *file_path, const char *out_file_path, apr_pool_t *pool)
+{
+	apr_size_t read;
+	apt_bool_t status = TRUE;
+	mpf_async_file_t *file;
+	mpf_async_file_t *out_file;
+	mpf_file_io_t *file_io = mpf_file_io_create(FIO_SMALL_BUFFER,pool);
+	if(!file_io || mpf_file_io_start(file_io) == FALSE) {
+		return FALSE;
+	}
+
+	file = mpf_async_file_open(file_io,file_path,MPF_ASYNC_FILE_READ);
+	out_file = mpf_async_file_open(file_io,out_file_path,MPF_ASYNC_FILE_WRITE);
+	if(!file || !out_file) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Open Files");
+		if(file) {
+			mpf_async_file_close(file);
+		}
+		if(out_file) {
+			mpf_async_file_close(out_file);
+		}
+		mpf_file_io_stop(file_io);
+		return FALSE;
+	}
+	/* less than a batch, written on stop only */
+	fio_stream_write(out_file,0);
+	fio_stream_write(out_file,FIO_CHUNK_SIZE);
+	mpf_file_io_stop(file_io);
+
+	if(mpf_async_file_open(file_io,file_path,MPF_ASYNC_FILE_READ) != NULL) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"File Opened after Stop");
+		status = FALSE;
+	}
+	if(fio_file_size_get(out_file_path) != 2 * FIO_CHUNK_SIZE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Pending Data not Flushed on Stop [%ld]",fio_file_size_get(out_file_path));
+		status = FALSE;
+	}
+
+	/* the data fetched before stop is still readable, then the stream runs out */
+	read = fio_stream_read(file);
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"FIO Stop: read [%"APR_SIZE_T_FMT" bytes] after stop",read);
+	if(read == 0 || read > FIO_SMALL_BUFFER || mpf_async_file_eof(file) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Read after Stop");
+		status = FALSE;
+	}
+
+	/* the files are freed on close */
+	mpf_async_file_close(file);
+	mpf_async_file_close(out_file);
+	return status;
+}
+
+/** Fill the buffer of the file detached on stop and count the dropped writes */
+static apt_bool_t fio_overflow_run(const char *out_file_path, apr_pool_t *pool)
+{
+	apr_size_t i;
+	apr_size_t written = 0;
+	apr_size_t count = FIO_SMALL_BUFFER / FIO_CHUNK_SIZE + FIO_OVERFLOW_COUNT;
+	apr_uint32_t overflow_count;
+	mpf_async_file_t *file;
+	mpf_file_io_t *file_io = mpf_file_io_create(FIO_SMALL_BUFFER,pool);
+	if(!file_io || mpf_file_io_start(file_io) == FALSE) {
+		return FALSE;
+	}
+
+	file = mpf_async_file_open(file_io,out_file_path,MPF_ASYNC_FILE_WRITE);
+	/* nothing is drained once stopped */
+	mpf_file_io_stop(file_io);
+	if(!file) {
+		return FALSE;
+	}
+
+	for(i=0; i<count; i++) {
+		if(fio_stream_write(file,i * FIO_CHUNK_SIZE) == TRUE) {
+			written++;
+		}
+	}
+	overflow_count = mpf_async_file_overflow_count_get(file);
+	mpf_async_file_close(file);
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"FIO Overflow: written [%"APR_SIZE_T_FMT"] overflow [%u]",
+		written,
+		overflow_count);
+	if(written != FIO_SMALL_BUFFER / FIO_CHUNK_SIZE || overflow_count != FIO_OVERFLOW_COUNT) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Number of Overflows");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static apt_bool_t file_io_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apt_bool_t status = TRUE;
+	apt_dir_layout_t *dir_layout = apt_default_dir_layout_create("../",suite->pool);
+	const char *file_path = apt_datadir_filepath_get(dir_layout,"file-io-8kHz.pcm",suite->pool);
+	const char *out_file_path = apt_datadir_filepath_get(dir_layout,"file-io-output-8kHz.pcm",suite->pool);
+	if(!file_path || !out_file_path) {
+		return FALSE;
+	}
+
+	if(fio_transfer_run(file_path,suite->pool) == FALSE) {
+		status = FALSE;
+	}
+	else if(fio_stop_run(file_path,out_file_path,suite->pool) == FALSE) {
+		status = FALSE;
+	}
+	if(fio_overflow_run(out_file_path,suite->pool) == FALSE) {
+		status = FALSE;
+	}
+
+	remove(file_path);
+	remove(out_file_path);
+	return status;
+}
+
+apt_test_suite_t* file_io_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"file-io",NULL,file_io_test_run);
+	return suite;
+}
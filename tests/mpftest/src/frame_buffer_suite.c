@@ -0,0 +1,278 @@
+/*
+ * Copyright 2008-2010 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <apr_thread_proc.h>
+#include <apr_atomic.h>
+#include "apt_test_suite.h"
+#include "apt_log.h"
+#include "mpf_frame_buffer.h"
+
+/** Size of a frame (10 msec of 8 kHz linear PCM) */
+#define FB_FRAME_SIZE        160
+/** Max number of buffered frames */
+#define FB_FRAME_COUNT       20
+/** Number of frames transferred between threads */
+#define FB_THREAD_FRAMES     100000
+
+/** Byte of the stream at specified offset */
+static APR_INLINE apr_byte_t fb_stream_byte(apr_size_t offset)
+{
+	return (apr_byte_t)((offset * 7 + offset / 251) & 0xFF);
+}
+
+/** Write bytes of the stream starting at specified offset */
+static apt_bool_t fb_stream_write(mpf_frame_buffer_t *buffer, apr_size_t offset, apr_size_t size)
+{
+	apr_byte_t data[FB_FRAME_SIZE * 4];
+	apr_size_t i;
+	mpf_frame_t frame;
+	for(i=0; i<size; i++) {
+		data[i] = fb_stream_byte(offset + i);
+	}
+	frame.type = MEDIA_FRAME_TYPE_AUDIO;
+	frame.marker = MPF_MARKER_NONE;
+	frame.codec_frame.buffer = data;
+	frame.codec_frame.size = size;
+	return mpf_frame_buffer_write(buffer,&frame);
+}
+
+/** Check frame read to contain bytes of the stream starting at specified offset */
+static apt_bool_t fb_stream_check(const mpf_frame_t *frame, apr_size_t offset)
+{
+	apr_size_t i;
+	const apr_byte_t *data = frame->codec_frame.buffer;
+	if(!(frame->type & MEDIA_FRAME_TYPE_AUDIO) || frame->codec_frame.size != FB_FRAME_SIZE) {
+		return FALSE;
+	}
+	for(i=0; i<FB_FRAME_SIZE; i++) {
+		if(data[i] != fb_stream_byte(offset + i)) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/** Write unaligned chunks and read them back as whole frames */
+static apt_bool_t fb_partial_run(apr_pool_t *pool)
+{
+	static const apr_size_t chunk_sizes[] = {1, 60, 159, 161, 320, 7, 100};
+	apr_byte_t data[FB_FRAME_SIZE];
+	mpf_frame_t frame;
+	mpf_frame_buffer_stat_t stat;
+	apr_size_t written = 0;
+	apr_size_t read = 0;
+	apr_size_t i;
+	mpf_frame_buffer_t *buffer = mpf_frame_buffer_create(FB_FRAME_SIZE,FB_FRAME_COUNT,pool);
+
+	frame.codec_frame.buffer = data;
+	for(i=0; i<sizeof(chunk_sizes)/sizeof(chunk_sizes[0]); i++) {
+		if(fb_stream_write(buffer,written,chunk_sizes[i]) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Write Chunk [%"APR_SIZE_T_FMT"]",chunk_sizes[i]);
+			return FALSE;
+		}
+		written += chunk_sizes[i];
+	}
+
+	for(;;) {
+		mpf_frame_buffer_read(buffer,&frame);
+		if(frame.type == MEDIA_FRAME_TYPE_NONE) {
+			break;
+		}
+		if(fb_stream_check(&frame,read) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Frame Data at [%"APR_SIZE_T_FMT"]",read);
+			return FALSE;
+		}
+		read += FB_FRAME_SIZE;
+	}
+
+	mpf_frame_buffer_stat_get(buffer,&stat);
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"FB Partial: written [%"APR_SIZE_T_FMT" bytes] read [%u frames]",
+		written,
+		stat.read_count);
+	if(read != written / FB_FRAME_SIZE * FB_FRAME_SIZE || stat.underrun_count != 1) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Number of Frames Read");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Overflow the buffer, then check restart and underrun policies */
+static apt_bool_t fb_policy_run(apr_pool_t *pool)
+{
+	apr_byte_t data[FB_FRAME_SIZE];
+	mpf_frame_t frame;
+	mpf_frame_buffer_stat_t stat;
+	apr_size_t i;
+	mpf_frame_buffer_t *buffer = mpf_frame_buffer_create(FB_FRAME_SIZE,FB_FRAME_COUNT,pool);
+
+	frame.codec_frame.buffer = data;
+	for(i=0; i<FB_FRAME_COUNT; i++) {
+		fb_stream_write(buffer,i * FB_FRAME_SIZE,FB_FRAME_SIZE);
+	}
+	/* the buffer is full, 2 frames are dropped */
+	if(fb_stream_write(buffer,0,FB_FRAME_SIZE * 2) == TRUE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Write to Full Buffer Succeeded");
+		return FALSE;
+	}
+
+	/* the last read frame is held on underrun */
+	mpf_frame_buffer_underrun_policy_set(buffer,MPF_FRAME_BUFFER_UNDERRUN_HOLD);
+	mpf_frame_buffer_read(buffer,&frame);
+	mpf_frame_buffer_restart(buffer);
+	mpf_frame_buffer_read(buffer,&frame);
+	if(frame.type != MEDIA_FRAME_TYPE_NONE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Frame Read after Restart");
+		return FALSE;
+	}
+	fb_stream_write(buffer,FB_FRAME_SIZE,FB_FRAME_SIZE);
+	mpf_frame_buffer_read(buffer,&frame);
+	mpf_frame_buffer_read(buffer,&frame);
+	if(fb_stream_check(&frame,FB_FRAME_SIZE) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Frame not Held on Underrun");
+		return FALSE;
+	}
+
+	/* silence is generated on underrun */
+	mpf_frame_buffer_underrun_policy_set(buffer,MPF_FRAME_BUFFER_UNDERRUN_SILENCE);
+	mpf_frame_buffer_read(buffer,&frame);
+	if(!(frame.type & MEDIA_FRAME_TYPE_AUDIO) || frame.codec_frame.size != FB_FRAME_SIZE || data[0] != 0 || data[FB_FRAME_SIZE-1] != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"No Silence on Underrun");
+		return FALSE;
+	}
+
+	mpf_frame_buffer_stat_get(buffer,&stat);
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"FB Policy: written [%u] read [%u] overflow [%u] underrun [%u]",
+		stat.write_count,
+		stat.read_count,
+		stat.overflow_count,
+		stat.underrun_count);
+	if(stat.overflow_count != 2 || stat.underrun_count != 3 || stat.read_count != 2) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Statistics");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Thread transfer context */
+typedef struct {
+	mpf_frame_buffer_t   *buffer;
+	volatile apr_uint32_t done;
+} fb_transfer_t;
+
+/** Writer thread, writes the stream in unaligned chunks as soon as there is room for them */
+static void* APR_THREAD_FUNC fb_writer_run(apr_thread_t *thread, void *data)
+{
+	fb_transfer_t *transfer = data;
+	apr_size_t offset = 0;
+	apr_size_t size;
+	apr_size_t total = (apr_size_t)FB_THREAD_FRAMES * FB_FRAME_SIZE;
+	mpf_frame_buffer_stat_t stat;
+	while(offset < total) {
+		mpf_frame_buffer_stat_get(transfer->buffer,&stat);
+		if(stat.write_count - stat.read_count > FB_FRAME_COUNT - 3) {
+			/* a chunk may complete up to 2 frames */
+			apr_thread_yield();
+			continue;
+		}
+
+		size = 1 + (offset * 13) % (FB_FRAME_SIZE * 2);
+		if(size > total - offset) {
+			size = total - offset;
+		}
+		if(fb_stream_write(transfer->buffer,offset,size) == FALSE) {
+			break;
+		}
+		offset += size;
+	}
+	apr_atomic_set32(&transfer->done,1);
+	return NULL;
+}
+
+/** Transfer frames between writer and reader threads */
+static apt_bool_t fb_thread_run(apr_pool_t *pool)
+{
+	apr_byte_t data[FB_FRAME_SIZE];
+	mpf_frame_t frame;
+	mpf_frame_buffer_stat_t stat;
+	apr_thread_t *thread;
+	apr_status_t rv;
+	apr_size_t read = 0;
+	apt_bool_t status = TRUE;
+	fb_transfer_t transfer;
+
+	transfer.buffer = mpf_frame_buffer_create(FB_FRAME_SIZE,FB_FRAME_COUNT,pool);
+	apr_atomic_set32(&transfer.done,0);
+	if(apr_thread_create(&thread,NULL,fb_writer_run,&transfer,pool) != APR_SUCCESS) {
+		return FALSE;
+	}
+
+	frame.codec_frame.buffer = data;
+	while(read < FB_THREAD_FRAMES) {
+		apr_uint32_t done = apr_atomic_read32(&transfer.done);
+		mpf_frame_buffer_read(transfer.buffer,&frame);
+		if(frame.type == MEDIA_FRAME_TYPE_NONE) {
+			if(done) {
+				/* the writer is done, but frames are missing */
+				status = FALSE;
+				break;
+			}
+			apr_thread_yield();
+			continue;
+		}
+		if(fb_stream_check(&frame,read * FB_FRAME_SIZE) == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Frame Data [%"APR_SIZE_T_FMT"]",read);
+			status = FALSE;
+			break;
+		}
+		read++;
+	}
+	apr_thread_join(&rv,thread);
+
+	mpf_frame_buffer_stat_get(transfer.buffer,&stat);
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"FB Threads: written [%u] read [%u] overflow [%u] underrun [%u]",
+		stat.write_count,
+		stat.read_count,
+		stat.overflow_count,
+		stat.underrun_count);
+	if(status == FALSE || stat.overflow_count != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Frames Lost between Threads");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static apt_bool_t frame_buffer_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apt_bool_t status = TRUE;
+	if(fb_partial_run(suite->pool) == FALSE) {
+		status = FALSE;
+	}
+	if(fb_policy_run(suite->pool) == FALSE) {
+		status = FALSE;
+	}
+	if(fb_thread_run(suite->pool) == FALSE) {
+		status = FALSE;
+	}
+	return status;
+}
+
+apt_test_suite_t* frame_buffer_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"frame-buffer",NULL,frame_buffer_test_run);
+	return suite;
+}
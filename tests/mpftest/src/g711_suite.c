@@ -0,0 +1,168 @@
+/*
+ * Copyright 2008-2010 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <stdlib.h>
+#include "apt_test_suite.h"
+#include "apt_log.h"
+#include "mpf_codec_g711.h"
+#include "g711/g711.h"
+
+/** Number of samples in a frame (20 msec at 8 kHz) */
+#define G711_FRAME_SAMPLES   160
+/** Default number of frames to convert */
+#define G711_FRAME_COUNT     100000
+
+typedef void (*g711_encode_f)(const apr_int16_t *linear, apr_byte_t *encoded, apr_size_t count);
+typedef void (*g711_decode_f)(const apr_byte_t *encoded, apr_int16_t *linear, apr_size_t count);
+
+static void g711u_scalar_encode(const apr_int16_t *linear, apr_byte_t *ulaw, apr_size_t count)
+{
+	apr_size_t i;
+	for(i=0; i<count; i++) {
+		ulaw[i] = linear_to_ulaw(linear[i]);
+	}
+}
+
+static void g711u_scalar_decode(const apr_byte_t *ulaw, apr_int16_t *linear, apr_size_t count)
+{
+	apr_size_t i;
+	for(i=0; i<count; i++) {
+		linear[i] = ulaw_to_linear(ulaw[i]);
+	}
+}
+
+static void g711a_scalar_encode(const apr_int16_t *linear, apr_byte_t *alaw, apr_size_t count)
+{
+	apr_size_t i;
+	for(i=0; i<count; i++) {
+		alaw[i] = linear_to_alaw(linear[i]);
+	}
+}
+
+static void g711a_scalar_decode(const apr_byte_t *alaw, apr_int16_t *linear, apr_size_t count)
+{
+	apr_size_t i;
+	for(i=0; i<count; i++) {
+		linear[i] = alaw_to_linear(alaw[i]);
+	}
+}
+
+/** Check the bulk routines produce exactly the same output as the scalar ones */
+static apt_bool_t g711_conformance_check(const char *name, g711_encode_f encode, g711_encode_f ref_encode, g711_decode_f decode, g711_decode_f ref_decode)
+{
+	apr_int16_t linear[256];
+	apr_int16_t ref_linear[256];
+	apr_byte_t encoded[256];
+	apr_byte_t ref_encoded[256];
+	apr_int32_t value;
+	apr_size_t i;
+
+	/* every linear value, in blocks of odd size to exercise the tail handling */
+	for(value = -32768; value <= 32767; ) {
+		for(i=0; i<251 && value <= 32767; i++, value++) {
+			linear[i] = (apr_int16_t)value;
+		}
+		encode(linear,encoded,i);
+		ref_encode(linear,ref_encoded,i);
+		if(memcmp(encoded,ref_encoded,i) != 0) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"%s Encode Mismatch near [%d]",name,value);
+			return FALSE;
+		}
+	}
+
+	/* every encoded value */
+	for(i=0; i<256; i++) {
+		encoded[i] = (apr_byte_t)i;
+	}
+	decode(encoded,linear,256);
+	ref_decode(encoded,ref_linear,256);
+	if(memcmp(linear,ref_linear,sizeof(linear)) != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"%s Decode Mismatch",name);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static apr_interval_time_t g711_encode_measure(g711_encode_f encode, const apr_int16_t *linear, apr_byte_t *encoded, apr_size_t frame_count)
+{
+	apr_size_t i;
+	apr_time_t start = apr_time_now();
+	for(i=0; i<frame_count; i++) {
+		encode(linear,encoded,G711_FRAME_SAMPLES);
+	}
+	return apr_time_now() - start;
+}
+
+static apr_interval_time_t g711_decode_measure(g711_decode_f decode, const apr_byte_t *encoded, apr_int16_t *linear, apr_size_t frame_count)
+{
+	apr_size_t i;
+	apr_time_t start = apr_time_now();
+	for(i=0; i<frame_count; i++) {
+		decode(encoded,linear,G711_FRAME_SAMPLES);
+	}
+	return apr_time_now() - start;
+}
+
+static void g711_benchmark_run(const char *name, g711_encode_f encode, g711_encode_f ref_encode, g711_decode_f decode, g711_decode_f ref_decode, apr_size_t frame_count)
+{
+	apr_int16_t linear[G711_FRAME_SAMPLES];
+	apr_byte_t encoded[G711_FRAME_SAMPLES];
+	apr_interval_time_t scalar_time;
+	apr_interval_time_t bulk_time;
+	apr_size_t i;
+
+	/* a sweep across all the segments */
+	for(i=0; i<G711_FRAME_SAMPLES; i++) {
+		linear[i] = (apr_int16_t)((i * 409) % 65536 - 32768);
+	}
+
+	scalar_time = g711_encode_measure(ref_encode,linear,encoded,frame_count);
+	bulk_time = g711_encode_measure(encode,linear,encoded,frame_count);
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"%s Encode %"APR_SIZE_T_FMT" Frames: scalar [%"APR_TIME_T_FMT" usec] bulk [%"APR_TIME_T_FMT" usec]",
+		name,frame_count,scalar_time,bulk_time);
+
+	scalar_time = g711_decode_measure(ref_decode,encoded,linear,frame_count);
+	bulk_time = g711_decode_measure(decode,encoded,linear,frame_count);
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"%s Decode %"APR_SIZE_T_FMT" Frames: scalar [%"APR_TIME_T_FMT" usec] bulk [%"APR_TIME_T_FMT" usec]",
+		name,frame_count,scalar_time,bulk_time);
+}
+
+static apt_bool_t g711_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apr_size_t frame_count = G711_FRAME_COUNT;
+	if(argc > 0) {
+		frame_count = atol(argv[0]);
+	}
+
+	if(g711_conformance_check("PCMU",mpf_g711u_encode,g711u_scalar_encode,mpf_g711u_decode,g711u_scalar_decode) == FALSE) {
+		return FALSE;
+	}
+	if(g711_conformance_check("PCMA",mpf_g711a_encode,g711a_scalar_encode,mpf_g711a_decode,g711a_scalar_decode) == FALSE) {
+		return FALSE;
+	}
+
+	g711_benchmark_run("PCMU",mpf_g711u_encode,g711u_scalar_encode,mpf_g711u_decode,g711u_scalar_decode,frame_count);
+	g711_benchmark_run("PCMA",mpf_g711a_encode,g711a_scalar_encode,mpf_g711a_decode,g711a_scalar_decode,frame_count);
+	return TRUE;
+}
+
+apt_test_suite_t* g711_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"g711",NULL,g711_test_run);
+	return suite;
+}
@@ -0,0 +1,291 @@
+/*
+ * Copyright 2008-2010 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <stdlib.h>
+#include <math.h>
+#include "apt_test_suite.h"
+#include "apt_log.h"
+#include "mpf_codec_manager.h"
+#include "mpf_codec.h"
+#include "mpf_rtp_pt.h"
+
+#ifndef M_PI
+#	define M_PI 3.141592653589793238462643
+#endif
+
+/** Number of samples in a frame (10 msec at 16 kHz) */
+#define G722_FRAME_SAMPLES   160
+/** Number of codes in a frame */
+#define G722_FRAME_SIZE      80
+/** Default number of frames to convert */
+#define G722_FRAME_COUNT     100000
+/** Number of frames of a test signal (1 sec) */
+#define G722_SIGNAL_FRAMES   100
+/** Max delay of the decoded signal in samples (the QMF filters delay it by 22) */
+#define G722_MAX_DELAY       40
+
+mpf_codec_t* mpf_codec_g722_create(apr_pool_t *pool);
+
+/** Test signal */
+typedef struct {
+	const char *name;
+	double      freq1;
+	double      amp1;
+	double      freq2;
+	double      amp2;
+	double      min_snr;
+} g722_signal_t;
+
+static const g722_signal_t g722_signals[] = {
+	{"300 Hz",          300,  8000,    0,    0, 25},
+	{"1000+5100 Hz",   1000,  8000, 5100, 3000, 25},
+	{"3400 Hz",        3400, 10000,    0,    0, 20},
+	{"low level",      1000,   200, 2500,  100, 10}
+};
+
+static void g722_signal_generate(const g722_signal_t *signal, apr_int16_t *linear, apr_size_t count)
+{
+	apr_size_t i;
+	for(i=0; i<count; i++) {
+		linear[i] = (apr_int16_t)(
+			signal->amp1 * sin(2 * M_PI * signal->freq1 * i / 16000) +
+			signal->amp2 * sin(2 * M_PI * signal->freq2 * i / 16000));
+	}
+}
+
+/** Signal to noise ratio of the decoded signal, compensating the delay of the codec */
+static double g722_snr_calculate(const apr_int16_t *original, const apr_int16_t *decoded, apr_size_t count)
+{
+	double best = -100;
+	double signal, noise, err, snr;
+	apr_size_t delay;
+	apr_size_t i;
+	for(delay=0; delay<=G722_MAX_DELAY; delay++) {
+		signal = 0;
+		noise = 0;
+		/* skip the adaptation at the beginning */
+		for(i=count/10; i<count-G722_MAX_DELAY; i++) {
+			err = (double)decoded[i+delay] - original[i];
+			signal += (double)original[i] * original[i];
+			noise += err * err;
+		}
+		snr = noise > 0 ? 10 * log10(signal / noise) : 100;
+		if(snr > best) {
+			best = snr;
+		}
+	}
+	return best;
+}
+
+/** Check G.722 is negotiable by codec manager and follows RTP clock of 8000 (RFC3551) */
+static apt_bool_t g722_negotiation_check(const mpf_codec_manager_t *codec_manager, apr_pool_t *pool)
+{
+	mpf_codec_list_t codec_list;
+	mpf_codec_descriptor_t *descriptor;
+	mpf_codec_descriptor_t peer;
+	mpf_codec_t *codec;
+
+	mpf_codec_list_init(&codec_list,2,pool);
+	mpf_codec_manager_codec_list_load(codec_manager,&codec_list,"G722 G722/99/16000",pool);
+	descriptor = mpf_codec_list_descriptor_get(&codec_list,0);
+	if(!descriptor || descriptor->payload_type != RTP_PT_G722 || descriptor->sampling_rate != 16000 ||
+		mpf_codec_rtp_clock_rate_get(descriptor) != 8000 ||
+		mpf_codec_frame_samples_calculate(descriptor) != G722_FRAME_SIZE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected G722 Descriptor");
+		return FALSE;
+	}
+	descriptor = mpf_codec_list_descriptor_get(&codec_list,1);
+	if(!descriptor || descriptor->payload_type != 99 || descriptor->sampling_rate != 16000 ||
+		mpf_codec_rtp_clock_rate_get(descriptor) != 8000) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Dynamic G722 Descriptor");
+		return FALSE;
+	}
+
+	/* remote SDP advertises a=rtpmap:9 G722/8000 */
+	mpf_codec_descriptor_init(&peer);
+	peer.payload_type = RTP_PT_G722;
+	apt_string_set(&peer.name,"G722");
+	peer.channel_count = 1;
+	mpf_codec_rtp_clock_rate_set(&peer,8000);
+	if(peer.sampling_rate != 16000 || mpf_codec_list_descriptor_find(&codec_list,&peer) == NULL) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Match G722 Descriptor");
+		return FALSE;
+	}
+
+	codec = mpf_codec_manager_codec_get(codec_manager,&peer,pool);
+	if(!codec || mpf_codec_frame_size_calculate(&peer,codec->attribs) != G722_FRAME_SIZE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Get G722 Codec");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Encode and decode the signal frame by frame */
+static void g722_transcode(mpf_codec_t *encoder, mpf_codec_t *decoder, const apr_int16_t *linear, apr_int16_t *decoded, apr_size_t frame_count)
+{
+	apr_byte_t encoded[G722_FRAME_SIZE];
+	mpf_codec_frame_t frame_in;
+	mpf_codec_frame_t frame_out;
+	apr_size_t i;
+
+	for(i=0; i<frame_count; i++) {
+		frame_in.buffer = (void*)(linear + i * G722_FRAME_SAMPLES);
+		frame_in.size = G722_FRAME_SAMPLES * sizeof(apr_int16_t);
+		frame_out.buffer = encoded;
+		mpf_codec_encode(encoder,&frame_in,&frame_out);
+
+		frame_in.buffer = encoded;
+		frame_in.size = frame_out.size;
+		frame_out.buffer = decoded + i * G722_FRAME_SAMPLES;
+		mpf_codec_decode(decoder,&frame_in,&frame_out);
+	}
+}
+
+static apt_bool_t g722_quality_check(mpf_codec_t *encoder, mpf_codec_t *decoder)
+{
+	apr_int16_t linear[G722_SIGNAL_FRAMES * G722_FRAME_SAMPLES];
+	apr_int16_t decoded[G722_SIGNAL_FRAMES * G722_FRAME_SAMPLES];
+	apr_byte_t silence[G722_FRAME_SIZE];
+	mpf_codec_frame_t frame_in;
+	mpf_codec_frame_t frame_out;
+	double snr;
+	apr_size_t i;
+
+	for(i=0; i<sizeof(g722_signals)/sizeof(g722_signals[0]); i++) {
+		g722_signal_generate(&g722_signals[i],linear,G722_SIGNAL_FRAMES * G722_FRAME_SAMPLES);
+		mpf_codec_open(encoder);
+		mpf_codec_open(decoder);
+		g722_transcode(encoder,decoder,linear,decoded,G722_SIGNAL_FRAMES);
+		mpf_codec_close(encoder);
+		mpf_codec_close(decoder);
+
+		snr = g722_snr_calculate(linear,decoded,G722_SIGNAL_FRAMES * G722_FRAME_SAMPLES);
+		apt_log(APT_LOG_MARK,APT_PRIO_INFO,"G722 %s SNR [%.1f dB]",g722_signals[i].name,snr);
+		if(snr < g722_signals[i].min_snr) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"G722 %s SNR [%.1f dB] is below [%.0f dB]",
+				g722_signals[i].name,snr,g722_signals[i].min_snr);
+			return FALSE;
+		}
+	}
+
+	/* silence frame must decode to (near) silence */
+	frame_out.buffer = silence;
+	frame_out.size = sizeof(silence);
+	mpf_codec_initialize(encoder,&frame_out);
+	mpf_codec_open(decoder);
+	for(i=0; i<G722_SIGNAL_FRAMES; i++) {
+		frame_in.buffer = silence;
+		frame_in.size = sizeof(silence);
+		frame_out.buffer = decoded + i * G722_FRAME_SAMPLES;
+		mpf_codec_decode(decoder,&frame_in,&frame_out);
+	}
+	mpf_codec_close(decoder);
+	for(i=0; i<G722_SIGNAL_FRAMES * G722_FRAME_SAMPLES; i++) {
+		if(decoded[i] > 16 || decoded[i] < -16) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"G722 Silence Decoded to [%d]",decoded[i]);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+static void g722_benchmark_run(mpf_codec_t *encoder, mpf_codec_t *decoder, apr_size_t frame_count)
+{
+	apr_int16_t linear[G722_SIGNAL_FRAMES * G722_FRAME_SAMPLES];
+	apr_byte_t encoded[G722_SIGNAL_FRAMES * G722_FRAME_SIZE];
+	mpf_codec_frame_t frame_in;
+	mpf_codec_frame_t frame_out;
+	apr_interval_time_t encode_time;
+	apr_interval_time_t decode_time;
+	apr_time_t start;
+	apr_size_t i;
+	apr_size_t j;
+
+	g722_signal_generate(&g722_signals[1],linear,G722_SIGNAL_FRAMES * G722_FRAME_SAMPLES);
+	mpf_codec_open(encoder);
+	mpf_codec_open(decoder);
+
+	start = apr_time_now();
+	for(i=0; i<frame_count; i++) {
+		j = i % G722_SIGNAL_FRAMES;
+		frame_in.buffer = linear + j * G722_FRAME_SAMPLES;
+		frame_in.size = G722_FRAME_SAMPLES * sizeof(apr_int16_t);
+		frame_out.buffer = encoded + j * G722_FRAME_SIZE;
+		mpf_codec_encode(encoder,&frame_in,&frame_out);
+	}
+	encode_time = apr_time_now() - start;
+
+	start = apr_time_now();
+	for(i=0; i<frame_count; i++) {
+		j = i % G722_SIGNAL_FRAMES;
+		frame_in.buffer = encoded + j * G722_FRAME_SIZE;
+		frame_in.size = G722_FRAME_SIZE;
+		frame_out.buffer = linear + j * G722_FRAME_SAMPLES;
+		mpf_codec_decode(decoder,&frame_in,&frame_out);
+	}
+	decode_time = apr_time_now() - start;
+
+	mpf_codec_close(encoder);
+	mpf_codec_close(decoder);
+
+	/* each frame lasts for 10 msec, so frame_count/100 sec of audio is processed */
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"G722 %"APR_SIZE_T_FMT" Frames: encode [%"APR_TIME_T_FMT" usec] decode [%"APR_TIME_T_FMT" usec] "
+		"channels per core [%"APR_SIZE_T_FMT"]",
+		frame_count,encode_time,decode_time,
+		(encode_time + decode_time) ? (apr_size_t)(frame_count * 10000 / (encode_time + decode_time)) : 0);
+}
+
+static apt_bool_t g722_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	mpf_codec_manager_t *codec_manager;
+	mpf_codec_descriptor_t descriptor;
+	mpf_codec_t *encoder;
+	mpf_codec_t *decoder;
+	apr_size_t frame_count = G722_FRAME_COUNT;
+	if(argc > 0) {
+		frame_count = atol(argv[0]);
+	}
+
+	codec_manager = mpf_codec_manager_create(1,suite->pool);
+	mpf_codec_manager_codec_register(codec_manager,mpf_codec_g722_create(suite->pool));
+	if(g722_negotiation_check(codec_manager,suite->pool) == FALSE) {
+		return FALSE;
+	}
+
+	mpf_codec_descriptor_init(&descriptor);
+	descriptor.payload_type = RTP_PT_G722;
+	encoder = mpf_codec_manager_codec_get(codec_manager,&descriptor,suite->pool);
+	decoder = mpf_codec_manager_codec_get(codec_manager,&descriptor,suite->pool);
+	if(!encoder || !decoder) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Get G722 Codec");
+		return FALSE;
+	}
+
+	if(g722_quality_check(encoder,decoder) == FALSE) {
+		return FALSE;
+	}
+
+	g722_benchmark_run(encoder,decoder,frame_count);
+	return TRUE;
+}
+
+apt_test_suite_t* g722_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"g722",NULL,g722_test_run);
+	return suite;
+}
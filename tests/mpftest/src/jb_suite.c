@@ -0,0 +1,310 @@
+/*
+ * Copyright 2008-2010 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <stdlib.h>
+#include <math.h>
+#include "apt_test_suite.h"
+#include "apt_log.h"
+#include "mpf_jitter_buffer.h"
+#include "mpf_codec_g711.h"
+#include "mpf_rtp_pt.h"
+
+#ifndef M_PI
+#	define M_PI 3.141592653589793238462643
+#endif
+
+/** Number of samples in a frame (10 msec at 8 kHz) */
+#define JB_FRAME_SAMPLES     80
+/** Number of frames in a packet (20 msec ptime) */
+#define JB_PACKET_FRAMES     2
+/** Number of samples in a packet */
+#define JB_PACKET_SAMPLES    (JB_FRAME_SAMPLES * JB_PACKET_FRAMES)
+/** Number of packets sent in a test run (60 sec) */
+#define JB_PACKET_COUNT      3000
+/** Transit delay of a packet delayed by a spike in frames */
+#define JB_SPIKE_FRAMES      30
+/** Number of packets sent in a concealment test run */
+#define JB_PLC_PACKET_COUNT  20
+/** Min SNR of concealed signal in dB */
+#define JB_PLC_MIN_SNR       3
+/** Min SNR of the signal following the lost packet in dB */
+#define JB_RECOVERED_MIN_SNR 20
+
+mpf_codec_t* mpf_codec_g711u_create(apr_pool_t *pool);
+
+/** Network conditions to play out the stream under */
+typedef struct {
+	const char  *name;
+	/** initial playout delay in msec */
+	apr_uint32_t initial_delay;
+	/** max transit delay variation in frames */
+	apr_uint32_t jitter;
+	/** percent of packets lost */
+	apr_uint32_t loss;
+	/** percent of packets delayed by a spike of JB_SPIKE_FRAMES frames */
+	apr_uint32_t spikes;
+	/** percent of packets sent before the jitter starts */
+	apr_uint32_t onset;
+	/** bounds the playout delay must converge to in msec */
+	apr_uint32_t min_delay;
+	apr_uint32_t max_delay;
+	/** max percent of packets arrived too late */
+	apr_uint32_t max_late;
+} jb_scenario_t;
+
+static const jb_scenario_t jb_scenarios[] = {
+	{"no jitter",             200, 0,  0, 0,  0, 10,  40, 0},
+	{"jitter 60 msec",        200, 6,  0, 0,  0, 40, 100, 8},
+	{"jitter 80 msec",         20, 8,  0, 0,  0, 50, 120, 8},
+	{"jitter 80 msec onset",   20, 8,  0, 0, 20, 50, 120, 8},
+	{"loss 10%",               50, 2, 10, 0,  0, 10,  60, 5},
+	{"jitter 40 msec spikes", 100, 4,  0, 2,  0, 20, 100, 8}
+};
+
+/** Voice-like periodic signal (harmonics of 150 Hz) */
+static apr_int16_t jb_signal_sample(apr_size_t i)
+{
+	double t = (double)i / 8000;
+	return (apr_int16_t)(
+		6000 * sin(2 * M_PI * 150 * t) +
+		3000 * sin(2 * M_PI * 300 * t + 1) +
+		1500 * sin(2 * M_PI * 450 * t + 2));
+}
+
+static mpf_jitter_buffer_t* jb_create(mpf_jb_config_t *config, apr_uint32_t initial_delay, apt_bool_t adaptive, apt_bool_t plc, apr_pool_t *pool)
+{
+	mpf_codec_descriptor_t *descriptor = apr_palloc(pool,sizeof(mpf_codec_descriptor_t));
+	mpf_codec_t *codec = mpf_codec_g711u_create(pool);
+
+	mpf_codec_descriptor_init(descriptor);
+	descriptor->payload_type = RTP_PT_PCMU;
+	apt_string_set(&descriptor->name,"PCMU");
+	descriptor->sampling_rate = 8000;
+	descriptor->channel_count = 1;
+
+	mpf_jb_config_init(config);
+	config->adaptive = adaptive ? 1 : 0;
+	config->plc = plc ? 1 : 0;
+	config->initial_playout_delay = initial_delay;
+	config->min_playout_delay = 0;
+	config->max_playout_delay = 600;
+	return mpf_jitter_buffer_create(config,descriptor,codec,pool);
+}
+
+/** Encode the n-th packet of the signal */
+static void jb_packet_generate(apr_size_t n, apr_byte_t *payload)
+{
+	apr_int16_t linear[JB_PACKET_SAMPLES];
+	apr_size_t i;
+	for(i=0; i<JB_PACKET_SAMPLES; i++) {
+		linear[i] = jb_signal_sample(n * JB_PACKET_SAMPLES + i);
+	}
+	mpf_g711u_encode(linear,payload,JB_PACKET_SAMPLES);
+}
+
+/** Play out the stream under the given network conditions */
+static apt_bool_t jb_scenario_run(const jb_scenario_t *scenario, apr_pool_t *pool)
+{
+	mpf_jb_config_t config;
+	mpf_jitter_buffer_t *jb = jb_create(&config,scenario->initial_delay,TRUE,TRUE,pool);
+	apr_uint32_t *arrivals = apr_palloc(pool,sizeof(apr_uint32_t) * JB_PACKET_COUNT);
+	apr_byte_t payload[JB_PACKET_SAMPLES];
+	apr_byte_t frame_buffer[JB_FRAME_SAMPLES];
+	mpf_frame_t frame;
+	rtp_jb_stat_t stat;
+	apr_uint32_t delay_sum = 0;
+	apr_uint32_t delay_count = 0;
+	apr_uint32_t silent_frames = 0;
+	apr_uint32_t mean_delay;
+	apr_uint32_t tick;
+	apr_size_t first = 0;
+	apr_size_t n;
+	apt_bool_t status = TRUE;
+
+	srand(1);
+	for(n=0; n<JB_PACKET_COUNT; n++) {
+		arrivals[n] = (apr_uint32_t)(n * JB_PACKET_FRAMES);
+		if((apr_uint32_t)(rand() % 100) < scenario->loss) {
+			/* never arrives */
+			arrivals[n] = 0xFFFFFFFF;
+			continue;
+		}
+		if(scenario->jitter && n * 100 >= JB_PACKET_COUNT * scenario->onset) {
+			arrivals[n] += rand() % (scenario->jitter + 1);
+		}
+		if((apr_uint32_t)(rand() % 100) < scenario->spikes) {
+			arrivals[n] += JB_SPIKE_FRAMES;
+		}
+	}
+
+	frame.codec_frame.buffer = frame_buffer;
+	for(tick=0; tick<JB_PACKET_COUNT * JB_PACKET_FRAMES; tick++) {
+		/* deliver packets arrived by this tick */
+		while(first * JB_PACKET_FRAMES + scenario->jitter + JB_SPIKE_FRAMES < tick) {
+			first++;
+		}
+		for(n=first; n<JB_PACKET_COUNT && n * JB_PACKET_FRAMES <= tick; n++) {
+			if(arrivals[n] == tick) {
+				jb_packet_generate(n,payload);
+				mpf_jitter_buffer_write(jb,payload,sizeof(payload),(apr_uint32_t)(n * JB_PACKET_SAMPLES),n == 0);
+			}
+		}
+
+		mpf_jitter_buffer_read(jb,&frame);
+		if(tick >= JB_PACKET_COUNT) {
+			/* measure the second half, after the delay has converged */
+			delay_sum += mpf_jitter_buffer_playout_delay_get(jb);
+			delay_count++;
+			if(!(frame.type & MEDIA_FRAME_TYPE_AUDIO)) {
+				silent_frames++;
+			}
+		}
+	}
+
+	mean_delay = delay_sum / delay_count;
+	mpf_jitter_buffer_stat_get(jb,&stat);
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"JB %s: playout delay [%u ms] target [%u ms] mean [%u ms] "
+		"late [%u] lost [%u] concealed [%u] accelerated [%u] expanded [%u] silent [%u]",
+		scenario->name,
+		stat.playout_delay,
+		stat.target_playout_delay,
+		mean_delay,
+		stat.late_packets,
+		stat.lost_frames,
+		stat.concealed_frames,
+		stat.accelerated_frames,
+		stat.expanded_frames,
+		silent_frames);
+
+	if(mean_delay < scenario->min_delay || mean_delay > scenario->max_delay) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"JB %s: Mean Playout Delay [%u ms] Out of Bounds [%u - %u ms]",
+			scenario->name,mean_delay,scenario->min_delay,scenario->max_delay);
+		status = FALSE;
+	}
+	if(stat.late_packets * 100 > JB_PACKET_COUNT * scenario->max_late) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"JB %s: Too Many Late Packets [%u]",scenario->name,stat.late_packets);
+		status = FALSE;
+	}
+	if(silent_frames * 100 > JB_PACKET_COUNT) {
+		/* lost and late frames must be concealed */
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"JB %s: Too Many Silent Frames [%u]",scenario->name,silent_frames);
+		status = FALSE;
+	}
+	return status;
+}
+
+/** Signal to noise ratio of the played out samples in the range of the signal */
+static double jb_snr_calculate(const apr_int16_t *played, apr_size_t offset, apr_size_t count)
+{
+	double signal = 0;
+	double noise = 0;
+	double err;
+	apr_size_t i;
+	for(i=offset; i<offset+count; i++) {
+		err = (double)played[i] - jb_signal_sample(i);
+		signal += (double)jb_signal_sample(i) * jb_signal_sample(i);
+		noise += err * err;
+	}
+	return noise > 0 ? 10 * log10(signal / noise) : 100;
+}
+
+/** Play out the stream missing a single packet and compare the played out signal to the original one */
+static apt_bool_t jb_plc_run(apt_bool_t plc, apr_pool_t *pool)
+{
+	mpf_jb_config_t config;
+	mpf_jitter_buffer_t *jb = jb_create(&config,20,FALSE,plc,pool);
+	apr_int16_t *played = apr_pcalloc(pool,sizeof(apr_int16_t) * JB_PLC_PACKET_COUNT * JB_PACKET_SAMPLES);
+	apr_byte_t payload[JB_PACKET_SAMPLES];
+	apr_byte_t frame_buffer[JB_FRAME_SAMPLES];
+	mpf_frame_t frame;
+	rtp_jb_stat_t stat;
+	apr_size_t played_samples = 0;
+	apr_size_t lost = JB_PLC_PACKET_COUNT / 2;
+	apr_size_t n,i;
+	double lost_snr, recovered_snr;
+
+	frame.codec_frame.buffer = frame_buffer;
+	for(n=0; n<JB_PLC_PACKET_COUNT; n++) {
+		if(n != lost) {
+			jb_packet_generate(n,payload);
+			mpf_jitter_buffer_write(jb,payload,sizeof(payload),(apr_uint32_t)(n * JB_PACKET_SAMPLES),n == 0);
+		}
+
+		for(i=0; i<JB_PACKET_FRAMES; i++) {
+			mpf_jitter_buffer_read(jb,&frame);
+			if(!played_samples && !(frame.type & MEDIA_FRAME_TYPE_AUDIO)) {
+				/* playout delay */
+				continue;
+			}
+			if(played_samples + JB_FRAME_SAMPLES > JB_PLC_PACKET_COUNT * JB_PACKET_SAMPLES) {
+				break;
+			}
+			if(frame.type & MEDIA_FRAME_TYPE_AUDIO) {
+				mpf_g711u_decode(frame.codec_frame.buffer,played + played_samples,JB_FRAME_SAMPLES);
+			}
+			played_samples += JB_FRAME_SAMPLES;
+		}
+	}
+
+	mpf_jitter_buffer_stat_get(jb,&stat);
+	lost_snr = jb_snr_calculate(played,lost * JB_PACKET_SAMPLES,JB_PACKET_SAMPLES);
+	recovered_snr = jb_snr_calculate(played,(lost + 1) * JB_PACKET_SAMPLES,JB_PACKET_SAMPLES * 4);
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"JB PLC [%s]: lost [%u] concealed [%u] SNR lost [%.1f dB] recovered [%.1f dB]",
+		plc ? "on" : "off",
+		stat.lost_frames,
+		stat.concealed_frames,
+		lost_snr,
+		recovered_snr);
+
+	if(stat.lost_frames != JB_PACKET_FRAMES || stat.concealed_frames != (plc ? JB_PACKET_FRAMES : 0)) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Number of Lost/Concealed Frames");
+		return FALSE;
+	}
+	if(plc && lost_snr < JB_PLC_MIN_SNR) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Poor Concealment SNR [%.1f dB]",lost_snr);
+		return FALSE;
+	}
+	if(recovered_snr < JB_RECOVERED_MIN_SNR) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Poor SNR after Loss [%.1f dB]",recovered_snr);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static apt_bool_t jb_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apr_size_t i;
+	apt_bool_t status = TRUE;
+
+	if(jb_plc_run(FALSE,suite->pool) == FALSE || jb_plc_run(TRUE,suite->pool) == FALSE) {
+		status = FALSE;
+	}
+
+	for(i=0; i<sizeof(jb_scenarios)/sizeof(jb_scenarios[0]); i++) {
+		if(jb_scenario_run(&jb_scenarios[i],suite->pool) == FALSE) {
+			status = FALSE;
+		}
+	}
+	return status;
+}
+
+apt_test_suite_t* jb_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"jb",NULL,jb_test_run);
+	return suite;
+}
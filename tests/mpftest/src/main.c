@@ -20,6 +20,14 @@
 #include "apt_log.h"
 
 apt_test_suite_t* mpf_suite_create(apr_pool_t *pool);
+apt_test_suite_t* g711_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* file_io_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* g722_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* dtmf_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* vad_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* jb_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* frame_buffer_test_suite_create(apr_pool_t *pool);
+apt_test_suite_t* profile_test_suite_create(apr_pool_t *pool);
 
 int main(int argc, const char * const *argv)
 {
@@ -40,6 +48,30 @@ int main(int argc, const char * const *argv)
 	test_suite = mpf_suite_create(pool);
 	apt_test_framework_suite_add(test_framework,test_suite);
 
+	test_suite = g711_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = file_io_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = g722_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = dtmf_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = vad_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = jb_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = frame_buffer_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
+	test_suite = profile_test_suite_create(pool);
+	apt_test_framework_suite_add(test_framework,test_suite);
+
 	/* run tests */
 	apt_test_framework_run(test_framework,argc,argv);
 
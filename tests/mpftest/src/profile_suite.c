@@ -0,0 +1,296 @@
+/*
+ * Copyright 2008-2010 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <apr_time.h>
+#include "apt_test_suite.h"
+#include "apt_log.h"
+#include "mpf_engine.h"
+#include "mpf_context.h"
+#include "mpf_scheduler.h"
+#include "mpf_termination.h"
+#include "mpf_termination_factory.h"
+#include "mpf_stream.h"
+#include "mpf_codec_descriptor.h"
+#include "mpf_rtp_pt.h"
+
+/** Time the source takes to read a frame (usec) */
+#define PROFILE_READ_TIME       1000
+/** Number of sampled ticks */
+#define PROFILE_SAMPLE_COUNT    20
+/** Resolution of the scheduler clock (msec) */
+#define PROFILE_RESOLUTION      10
+/** Number of ticks the clock is held back for */
+#define PROFILE_SLOW_TICK_COUNT 10
+/** Time a slow tick takes (msec), it is 2 ticks behind the schedule each */
+#define PROFILE_SLOW_TICK_TIME  (PROFILE_RESOLUTION * 3)
+/** Number of ticks to let the clock catch up with the schedule */
+#define PROFILE_TICK_COUNT      (PROFILE_SLOW_TICK_COUNT + 60)
+/** Max number of attempts to wait for the ticks */
+#define PROFILE_WAIT_ATTEMPTS   1000
+
+/** Upper bounds of the buckets of the tick duration histogram as documented */
+static const apr_uint32_t profile_histogram_bounds[MPF_TICK_HISTOGRAM_SIZE-1] = {
+	100, 250, 500, 1000, 2000, 5000, 10000, 20000, 50000
+};
+
+/** Check the durations around each bound fall into the adjacent buckets */
+static apt_bool_t profile_histogram_run()
+{
+	apr_size_t i;
+	apr_uint32_t bound;
+	if(mpf_engine_tick_histogram_bucket_get(0) != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Bucket of Zero Duration");
+		return FALSE;
+	}
+	for(i=0; i<MPF_TICK_HISTOGRAM_SIZE-1; i++) {
+		bound = profile_histogram_bounds[i];
+		/* the bound itself belongs to the next bucket */
+		if(mpf_engine_tick_histogram_bucket_get(bound - 1) != i ||
+			mpf_engine_tick_histogram_bucket_get(bound) != i + 1) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Buckets around Bound [%u]: [%"APR_SIZE_T_FMT"] [%"APR_SIZE_T_FMT"]",
+				bound,
+				mpf_engine_tick_histogram_bucket_get(bound - 1),
+				mpf_engine_tick_histogram_bucket_get(bound));
+			return FALSE;
+		}
+	}
+	if(mpf_engine_tick_histogram_bucket_get(0xFFFFFFFF) != MPF_TICK_HISTOGRAM_SIZE-1) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Bucket of Max Duration");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static apt_bool_t profile_stream_read(mpf_audio_stream_t *stream, mpf_frame_t *frame)
+{
+	apr_sleep(PROFILE_READ_TIME);
+	return TRUE;
+}
+
+static apt_bool_t profile_stream_write(mpf_audio_stream_t *stream, const mpf_frame_t *frame)
+{
+	return TRUE;
+}
+
+static const mpf_audio_stream_vtable_t profile_stream_vtable = {
+	NULL,
+	NULL,
+	NULL,
+	profile_stream_read,
+	NULL,
+	NULL,
+	profile_stream_write,
+	NULL
+};
+
+/** Create PCMU descriptor, the same on both ends, so that the frames are passed through */
+static mpf_codec_descriptor_t* profile_descriptor_create(apr_pool_t *pool)
+{
+	mpf_codec_descriptor_t *descriptor = apr_palloc(pool,sizeof(mpf_codec_descriptor_t));
+	mpf_codec_descriptor_init(descriptor);
+	descriptor->payload_type = RTP_PT_PCMU;
+	apt_string_set(&descriptor->name,"PCMU");
+	descriptor->sampling_rate = 8000;
+	descriptor->channel_count = 1;
+	return descriptor;
+}
+
+/** Create raw termination with the stream of specified direction */
+static mpf_termination_t* profile_termination_create(mpf_stream_direction_e direction, apr_pool_t *pool)
+{
+	mpf_stream_capabilities_t *capabilities = mpf_stream_capabilities_create(direction,pool);
+	mpf_audio_stream_t *stream = mpf_audio_stream_create(NULL,&profile_stream_vtable,capabilities,pool);
+	if(!stream) {
+		return NULL;
+	}
+	if(direction & STREAM_DIRECTION_RECEIVE) {
+		stream->rx_descriptor = profile_descriptor_create(pool);
+	}
+	if(direction & STREAM_DIRECTION_SEND) {
+		stream->tx_descriptor = profile_descriptor_create(pool);
+	}
+	return mpf_raw_termination_create(NULL,stream,NULL,pool);
+}
+
+/** Process a context bridging two terminations and check the profile accumulated */
+static apt_bool_t profile_context_run(apr_pool_t *pool)
+{
+	apt_bool_t status = TRUE;
+	mpf_context_profile_t profile;
+	const mpf_object_profile_t *object_profile;
+	mpf_codec_manager_t *codec_manager;
+	mpf_context_factory_t *factory;
+	mpf_context_t *context;
+	mpf_termination_t *source;
+	mpf_termination_t *sink;
+	apr_size_t i;
+
+	memset(&profile,0,sizeof(profile));
+	factory = mpf_context_factory_create(pool);
+	/* contexts of no objects are not accounted */
+	mpf_context_factory_profile_process(factory,&profile);
+	if(profile.sample_count != 1 || profile.context_count != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Profile of Empty Factory");
+		mpf_context_factory_destroy(factory);
+		return FALSE;
+	}
+
+	codec_manager = mpf_engine_codec_manager_create(pool);
+	source = profile_termination_create(STREAM_DIRECTION_RECEIVE,pool);
+	sink = profile_termination_create(STREAM_DIRECTION_SEND,pool);
+	if(!codec_manager || !source || !sink) {
+		mpf_context_factory_destroy(factory);
+		return FALSE;
+	}
+	source->codec_manager = codec_manager;
+	sink->codec_manager = codec_manager;
+
+	context = mpf_context_create(factory,"profile",NULL,2,pool);
+	mpf_context_termination_add(context,source);
+	mpf_context_termination_add(context,sink);
+	mpf_context_association_add(context,source,sink);
+	mpf_context_topology_apply(context);
+
+	memset(&profile,0,sizeof(profile));
+	for(i=0; i<PROFILE_SAMPLE_COUNT; i++) {
+		mpf_context_factory_profile_process(factory,&profile);
+	}
+
+	object_profile = &profile.objects[MPF_OBJECT_TYPE_NULL_BRIDGE];
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Context Profile: contexts [%u] avg [%"APR_UINT64_T_FMT" usec] max [%u usec] <%s> null-bridge [%u] avg [%"APR_UINT64_T_FMT" usec] max [%u usec]",
+		profile.context_count,
+		profile.context_count ? profile.context_total_time / profile.context_count : 0,
+		profile.context_max_time,
+		profile.context_max_name,
+		object_profile->process_count,
+		object_profile->process_count ? object_profile->total_time / object_profile->process_count : 0,
+		object_profile->max_time);
+
+	if(profile.sample_count != PROFILE_SAMPLE_COUNT || profile.context_count != PROFILE_SAMPLE_COUNT ||
+		object_profile->process_count != PROFILE_SAMPLE_COUNT) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Number of Samples");
+		status = FALSE;
+	}
+	else if(profile.objects[MPF_OBJECT_TYPE_BRIDGE].process_count ||
+		profile.objects[MPF_OBJECT_TYPE_MIXER].process_count ||
+		profile.objects[MPF_OBJECT_TYPE_MULTIPLIER].process_count) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Object Types Sampled");
+		status = FALSE;
+	}
+	else if(object_profile->max_time < PROFILE_READ_TIME ||
+		object_profile->total_time < PROFILE_SAMPLE_COUNT * PROFILE_READ_TIME ||
+		profile.context_total_time < object_profile->total_time ||
+		profile.context_max_time < object_profile->max_time) {
+		/* the context takes as long as its objects at least */
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Processing Time");
+		status = FALSE;
+	}
+	else if(strcmp(profile.context_max_name,"profile") != 0) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Context Name <%s>",profile.context_max_name);
+		status = FALSE;
+	}
+
+	mpf_context_topology_destroy(context);
+	mpf_context_termination_subtract(context,source);
+	mpf_context_termination_subtract(context,sink);
+	mpf_context_destroy(context);
+	mpf_context_factory_destroy(factory);
+	return status;
+}
+
+/** Scheduler clock state */
+typedef struct {
+	/** Number of ticks fired */
+	volatile apr_uint32_t tick_count;
+} profile_clock_t;
+
+static void profile_clock_proc(mpf_scheduler_t *scheduler, void *obj)
+{
+	profile_clock_t *clock = obj;
+	if(clock->tick_count < PROFILE_SLOW_TICK_COUNT) {
+		/* hold the clock back */
+		apr_sleep(PROFILE_SLOW_TICK_TIME * 1000);
+	}
+	clock->tick_count++;
+}
+
+/** Hold the scheduler clock back, let it catch up and check the drift accumulated */
+static apt_bool_t profile_drift_run(apr_pool_t *pool)
+{
+	mpf_scheduler_stat_t stat;
+	profile_clock_t clock;
+	apr_size_t attempts = 0;
+	mpf_scheduler_t *scheduler = mpf_scheduler_create(pool);
+	if(!scheduler) {
+		return FALSE;
+	}
+
+	clock.tick_count = 0;
+	mpf_scheduler_media_clock_set(scheduler,PROFILE_RESOLUTION,profile_clock_proc,&clock);
+	if(mpf_scheduler_start(scheduler) == FALSE) {
+		mpf_scheduler_destroy(scheduler);
+		return FALSE;
+	}
+	while(clock.tick_count < PROFILE_TICK_COUNT && attempts < PROFILE_WAIT_ATTEMPTS) {
+		apr_sleep(PROFILE_RESOLUTION * 1000);
+		attempts++;
+	}
+	mpf_scheduler_stop(scheduler);
+	mpf_scheduler_stat_get(scheduler,&stat);
+	mpf_scheduler_destroy(scheduler);
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Scheduler Stat: ticks [%u] late [%u] drift [%u usec] max drift [%u usec]",
+		clock.tick_count,
+		stat.late_count,
+		stat.time_drift,
+		stat.max_time_drift);
+#ifndef WIN32
+	/* each slow tick but the first one is fired late and adds 2 ticks to the drift */
+	if(stat.late_count < PROFILE_SLOW_TICK_COUNT - 1 ||
+		stat.max_time_drift < (PROFILE_SLOW_TICK_TIME - PROFILE_RESOLUTION) * 1000 * PROFILE_SLOW_TICK_COUNT) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Drift not Accumulated");
+		return FALSE;
+	}
+	/* the clock catches up with the schedule firing late ticks with no sleep */
+	if(clock.tick_count < PROFILE_TICK_COUNT || stat.time_drift >= stat.max_time_drift) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Clock not Caught up with Schedule");
+		return FALSE;
+	}
+#endif
+	return TRUE;
+}
+
+static apt_bool_t profile_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	if(profile_histogram_run() == FALSE) {
+		return FALSE;
+	}
+	if(profile_context_run(suite->pool) == FALSE) {
+		return FALSE;
+	}
+	if(profile_drift_run(suite->pool) == FALSE) {
+		return FALSE;
+	}
+	return TRUE;
+}
+
+apt_test_suite_t* profile_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"profile",NULL,profile_test_run);
+	return suite;
+}
@@ -0,0 +1,360 @@
+/*
+ * Copyright 2008-2010 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+/*
+ * Offline evaluation of the activity detector.
+ * Without arguments a labeled recording is synthesized and the adaptive mode
+ * is checked against it. Otherwise the arguments are 16-bit mono PCM WAV files
+ * (8 or 16 kHz), each labeled by a file of the same name with the ".lab" extension
+ * listing speech segments as "start end" pairs in msec, one per line.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "apt_test_suite.h"
+#include "apt_log.h"
+#include "mpf_activity_detector.h"
+
+#ifndef M_PI
+#	define M_PI 3.141592653589793238462643
+#endif
+
+#define VAD_MAX_SEGMENTS        256
+/** Timeouts the detector is evaluated with [msec] */
+#define VAD_SPEECH_TIMEOUT      300
+#define VAD_SILENCE_TIMEOUT     800
+#define VAD_NOINPUT_TIMEOUT     5000
+
+/** Labeled recording */
+typedef struct vad_recording_t vad_recording_t;
+struct vad_recording_t {
+	const char   *name;
+	apr_int16_t  *samples;
+	apr_size_t    sample_count;
+	apr_uint16_t  sampling_rate;
+	/* speech segments [msec] */
+	apr_size_t    starts[VAD_MAX_SEGMENTS];
+	apr_size_t    ends[VAD_MAX_SEGMENTS];
+	apr_size_t    segment_count;
+};
+
+/** Evaluation results */
+typedef struct vad_score_t vad_score_t;
+struct vad_score_t {
+	apr_size_t detected;
+	apr_size_t early_ends;
+	apr_size_t false_starts;
+	apr_size_t noinputs;
+	apr_size_t onset_latency;
+	apr_size_t end_latency;
+	apr_size_t end_count;
+};
+
+static apr_uint32_t vad_le_get(const unsigned char *buf, apr_size_t size)
+{
+	apr_uint32_t value = 0;
+	while(size--) {
+		value = (value << 8) | buf[size];
+	}
+	return value;
+}
+
+/** Load 16-bit mono PCM WAV file */
+static apt_bool_t vad_wav_load(vad_recording_t *recording, const char *path, apr_pool_t *pool)
+{
+	unsigned char *data;
+	long size;
+	apr_size_t pos = 12;
+	apr_size_t chunk_size;
+	apt_bool_t format_ok = FALSE;
+	FILE *file = fopen(path,"rb");
+	if(!file) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Open WAV File [%s]",path);
+		return FALSE;
+	}
+	fseek(file,0,SEEK_END);
+	size = ftell(file);
+	fseek(file,0,SEEK_SET);
+	data = apr_palloc(pool,size > 0 ? size : 1);
+	if(size < 12 || fread(data,1,size,file) != (size_t)size ||
+		memcmp(data,"RIFF",4) != 0 || memcmp(data+8,"WAVE",4) != 0) {
+		fclose(file);
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Not a WAV File [%s]",path);
+		return FALSE;
+	}
+	fclose(file);
+
+	recording->samples = NULL;
+	while(pos + 8 <= (apr_size_t)size) {
+		chunk_size = vad_le_get(data+pos+4,4);
+		if(pos + 8 + chunk_size > (apr_size_t)size) {
+			chunk_size = size - pos - 8;
+		}
+		if(memcmp(data+pos,"fmt ",4) == 0 && chunk_size >= 16) {
+			recording->sampling_rate = (apr_uint16_t)vad_le_get(data+pos+12,4);
+			format_ok = vad_le_get(data+pos+8,2) == 1 && vad_le_get(data+pos+10,2) == 1 &&
+				vad_le_get(data+pos+22,2) == 16 &&
+				(recording->sampling_rate == 8000 || recording->sampling_rate == 16000);
+		}
+		else if(memcmp(data+pos,"data",4) == 0) {
+			apr_size_t i;
+			recording->sample_count = chunk_size / 2;
+			recording->samples = apr_palloc(pool,recording->sample_count * sizeof(apr_int16_t) + 1);
+			for(i=0; i<recording->sample_count; i++) {
+				recording->samples[i] = (apr_int16_t)vad_le_get(data+pos+8+i*2,2);
+			}
+		}
+		pos += 8 + chunk_size + (chunk_size & 1);
+	}
+
+	if(format_ok == FALSE || !recording->samples) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unsupported WAV Format [%s] (16-bit mono 8/16 kHz PCM expected)",path);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Load labels of speech segments */
+static apt_bool_t vad_labels_load(vad_recording_t *recording, const char *wav_path, apr_pool_t *pool)
+{
+	char *path = apr_pstrdup(pool,wav_path);
+	char *ext = strrchr(path,'.');
+	unsigned long start, end;
+	FILE *file;
+	if(ext) {
+		*ext = '\0';
+	}
+	path = apr_pstrcat(pool,path,".lab",NULL);
+	file = fopen(path,"r");
+	if(!file) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Open Labels [%s]",path);
+		return FALSE;
+	}
+	recording->segment_count = 0;
+	while(recording->segment_count < VAD_MAX_SEGMENTS && fscanf(file,"%lu %lu",&start,&end) == 2) {
+		recording->starts[recording->segment_count] = start;
+		recording->ends[recording->segment_count] = end;
+		recording->segment_count++;
+	}
+	fclose(file);
+	return TRUE;
+}
+
+/** Synthesize utterances (voiced harmonics modulated at syllable rate) in low-pass filtered noise */
+static void vad_recording_synthesize(vad_recording_t *recording, apr_uint16_t sampling_rate, apr_pool_t *pool)
+{
+	/* utterances [msec], the noise rises in the trailing noise-only part */
+	static const apr_size_t starts[] = {1000, 3700, 6200};
+	static const apr_size_t ends[] = {2500, 4700, 6900};
+	apr_size_t duration = 20000;
+	apr_size_t noise_ramp_start = 9000;
+	apr_size_t noise_ramp_end = 11000;
+	apr_size_t i,s,h,msec;
+	double t,noise = 0,amplitude,value,f0,gain;
+
+	recording->name = sampling_rate == 8000 ? "synthetic-8kHz" : "synthetic-16kHz";
+	recording->sampling_rate = sampling_rate;
+	recording->sample_count = duration * sampling_rate / 1000;
+	recording->samples = apr_palloc(pool,recording->sample_count * sizeof(apr_int16_t));
+	recording->segment_count = sizeof(starts) / sizeof(starts[0]);
+	for(s=0; s<recording->segment_count; s++) {
+		recording->starts[s] = starts[s];
+		recording->ends[s] = ends[s];
+	}
+
+	srand(1);
+	for(i=0; i<recording->sample_count; i++) {
+		t = (double)i / sampling_rate;
+		msec = i * 1000 / sampling_rate;
+		/* call center like noise at -31 dBFS, rising by 10 dB */
+		noise = 0.9 * noise + 0.1 * (rand() % 20001 - 10000);
+		if(msec < noise_ramp_start) {
+			gain = 0.7;
+		}
+		else if(msec < noise_ramp_end) {
+			gain = 0.7 + 1.5 * (msec - noise_ramp_start) / (noise_ramp_end - noise_ramp_start);
+		}
+		else {
+			gain = 2.2;
+		}
+		value = noise * gain;
+
+		for(s=0; s<recording->segment_count; s++) {
+			if(msec >= starts[s] && msec < ends[s]) {
+				double pos = t - starts[s] / 1000.0;
+				/* syllables at 4 Hz with a 150 msec pause in the middle of the first utterance */
+				amplitude = 0.55 + 0.45 * sin(2 * M_PI * 4 * pos);
+				if(s == 0 && pos >= 0.6 && pos < 0.75) {
+					amplitude = 0;
+				}
+				f0 = 120 + 20 * sin(2 * M_PI * 1.5 * pos);
+				for(h=1; h<=20 && h*f0 < sampling_rate/2; h++) {
+					value += amplitude * 6000 / h * sin(2 * M_PI * h * f0 * pos);
+				}
+			}
+		}
+		if(value > 32767) value = 32767;
+		if(value < -32768) value = -32768;
+		recording->samples[i] = (apr_int16_t)value;
+	}
+}
+
+static apt_bool_t vad_in_segment(const vad_recording_t *recording, apr_size_t time, apr_size_t *segment)
+{
+	apr_size_t s;
+	for(s=0; s<recording->segment_count; s++) {
+		if(time >= recording->starts[s] && time <= recording->ends[s]) {
+			*segment = s;
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/** Run the detector over the recording and score the events against the labels */
+static void vad_recording_evaluate(const vad_recording_t *recording, mpf_detector_mode_e mode, float sensitivity, vad_score_t *score, apr_pool_t *pool)
+{
+	mpf_activity_detector_t *detector = mpf_activity_detector_create(pool);
+	mpf_detector_event_e event;
+	mpf_frame_t frame;
+	apr_size_t frame_samples = recording->sampling_rate * CODEC_FRAME_TIME_BASE / 1000;
+	apr_size_t time = 0;
+	apr_size_t segment = 0;
+	apr_size_t active_segment = VAD_MAX_SEGMENTS;
+	apt_bool_t *detected = apr_pcalloc(pool,sizeof(apt_bool_t) * (recording->segment_count + 1));
+	apr_size_t i,s;
+
+	memset(score,0,sizeof(vad_score_t));
+	mpf_activity_detector_mode_set(detector,mode);
+	mpf_activity_detector_sensitivity_set(detector,sensitivity);
+	mpf_activity_detector_speech_timeout_set(detector,VAD_SPEECH_TIMEOUT);
+	mpf_activity_detector_silence_timeout_set(detector,VAD_SILENCE_TIMEOUT);
+	mpf_activity_detector_noinput_timeout_set(detector,VAD_NOINPUT_TIMEOUT);
+
+	frame.type = MEDIA_FRAME_TYPE_AUDIO;
+	frame.codec_frame.size = frame_samples * sizeof(apr_int16_t);
+	for(i=0; i+frame_samples<=recording->sample_count; i+=frame_samples, time+=CODEC_FRAME_TIME_BASE) {
+		frame.codec_frame.buffer = recording->samples + i;
+		event = mpf_activity_detector_process(detector,&frame);
+		if(event == MPF_DETECTOR_EVENT_ACTIVITY) {
+			/* activity is reported speech timeout after the onset */
+			if(vad_in_segment(recording,time - VAD_SPEECH_TIMEOUT,&segment) == TRUE ||
+				vad_in_segment(recording,time,&segment) == TRUE) {
+				if(detected[segment] == FALSE) {
+					detected[segment] = TRUE;
+					score->detected++;
+					score->onset_latency += time - recording->starts[segment];
+				}
+				active_segment = segment;
+			}
+			else {
+				apt_log(APT_LOG_MARK,APT_PRIO_INFO,"%s %s False Start [%"APR_SIZE_T_FMT"]",
+					recording->name,mode == MPF_DETECTOR_MODE_ADAPTIVE ? "adaptive" : "level",time);
+				score->false_starts++;
+				active_segment = VAD_MAX_SEGMENTS;
+			}
+		}
+		else if(event == MPF_DETECTOR_EVENT_INACTIVITY) {
+			if(active_segment < VAD_MAX_SEGMENTS) {
+				if(time < recording->ends[active_segment] + VAD_SILENCE_TIMEOUT / 2) {
+					score->early_ends++;
+				}
+				else {
+					score->end_latency += time - recording->ends[active_segment];
+					score->end_count++;
+				}
+			}
+			active_segment = VAD_MAX_SEGMENTS;
+		}
+		else if(event == MPF_DETECTOR_EVENT_NOINPUT) {
+			score->noinputs++;
+			/* the engine completes the request, the next one starts afresh */
+			mpf_activity_detector_reset(detector);
+		}
+	}
+
+	for(s=0; s<recording->segment_count; s++) {
+		if(detected[s] == FALSE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_INFO,"%s %s Missed Segment [%"APR_SIZE_T_FMT"-%"APR_SIZE_T_FMT"]",
+				recording->name,mode == MPF_DETECTOR_MODE_ADAPTIVE ? "adaptive" : "level",
+				recording->starts[s],recording->ends[s]);
+		}
+	}
+}
+
+static void vad_score_log(const vad_recording_t *recording, const char *mode, const vad_score_t *score)
+{
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"%s %s: detected [%"APR_SIZE_T_FMT"/%"APR_SIZE_T_FMT"] early ends [%"APR_SIZE_T_FMT"] "
+		"false starts [%"APR_SIZE_T_FMT"] noinputs [%"APR_SIZE_T_FMT"] onset latency [%"APR_SIZE_T_FMT" msec] end latency [%"APR_SIZE_T_FMT" msec]",
+		recording->name,
+		mode,
+		score->detected,
+		recording->segment_count,
+		score->early_ends,
+		score->false_starts,
+		score->noinputs,
+		score->detected ? score->onset_latency / score->detected : 0,
+		score->end_count ? score->end_latency / score->end_count : 0);
+}
+
+static void vad_recording_compare(const vad_recording_t *recording, vad_score_t *adaptive_score, apr_pool_t *pool)
+{
+	vad_score_t level_score;
+	vad_recording_evaluate(recording,MPF_DETECTOR_MODE_LEVEL,0.5f,&level_score,pool);
+	vad_score_log(recording,"level",&level_score);
+	vad_recording_evaluate(recording,MPF_DETECTOR_MODE_ADAPTIVE,0.5f,adaptive_score,pool);
+	vad_score_log(recording,"adaptive",adaptive_score);
+}
+
+static apt_bool_t vad_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	vad_recording_t *recording = apr_palloc(suite->pool,sizeof(vad_recording_t));
+	vad_score_t score;
+	apr_uint16_t sampling_rate;
+	int i;
+
+	if(argc > 0) {
+		for(i=0; i<argc; i++) {
+			recording->name = argv[i];
+			if(vad_wav_load(recording,argv[i],suite->pool) == FALSE ||
+				vad_labels_load(recording,argv[i],suite->pool) == FALSE) {
+				return FALSE;
+			}
+			vad_recording_compare(recording,&score,suite->pool);
+		}
+		return TRUE;
+	}
+
+	for(sampling_rate = 8000; sampling_rate <= 16000; sampling_rate *= 2) {
+		vad_recording_synthesize(recording,sampling_rate,suite->pool);
+		vad_recording_compare(recording,&score,suite->pool);
+		/* every utterance in one piece, then noinput in spite of the louder noise */
+		if(score.detected != recording->segment_count || score.early_ends || score.false_starts || !score.noinputs) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"%s Adaptive Detection Failed",recording->name);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+apt_test_suite_t* vad_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"vad",NULL,vad_test_run);
+	return suite;
+}
@@ -0,0 +1,269 @@
+/*
+ * Copyright 2008-2010 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <stdlib.h>
+#include <apr_time.h>
+#include "apt_test_suite.h"
+#include "apt_obj_list.h"
+#include "apt_log.h"
+#include "mrcp_connection.h"
+
+#define LOAD_GATEWAY_COUNT          100
+#define LOAD_GATEWAY_CONNECTIONS    4
+#define LOAD_CHANNEL_COUNT          10000
+/* channels set up in a batch, latency is measured per batch */
+#define LOAD_BATCH_SIZE             50
+
+/** Connection load test data */
+typedef struct connection_load_t connection_load_t;
+struct connection_load_t {
+	apr_pool_t              *pool;
+	apt_obj_list_t          *connection_list;
+	mrcp_connection_index_t *connection_index;
+	mrcp_connection_t      **connections;
+	apr_size_t               connection_count;
+	apt_str_t               *gateway_ips;
+	apr_size_t               gateway_count;
+	mrcp_control_channel_t  *channels;
+	apr_size_t               channel_count;
+};
+
+/* Former lookup walking through the list of connections */
+static mrcp_connection_t* connection_list_find(apt_obj_list_t *list, const apt_str_t *remote_ip, apr_port_t port)
+{
+	mrcp_connection_t *connection;
+	apt_list_elem_t *elem = apt_list_first_elem_get(list);
+	while(elem) {
+		connection = apt_list_elem_object_get(elem);
+		if(connection && apt_string_compare(&connection->remote_ip,remote_ip) == TRUE &&
+			(!port || connection->r_sockaddr->port == port)) {
+			return connection;
+		}
+		elem = apt_list_next_elem_get(list,elem);
+	}
+	return NULL;
+}
+
+static apt_bool_t connection_load_create(connection_load_t *load, apr_size_t gateway_count, apr_size_t channel_count)
+{
+	apr_size_t i;
+	mrcp_connection_t *connection;
+	char *ip;
+
+	load->gateway_count = gateway_count;
+	load->gateway_ips = apr_palloc(load->pool,sizeof(apt_str_t) * gateway_count);
+	load->connection_count = gateway_count * LOAD_GATEWAY_CONNECTIONS;
+	load->connections = apr_palloc(load->pool,sizeof(mrcp_connection_t*) * load->connection_count);
+	load->connection_list = apt_list_create(load->pool);
+	load->connection_index = mrcp_connection_index_create(load->pool);
+
+	for(i=0; i<gateway_count; i++) {
+		ip = apr_psprintf(load->pool,"10.0.%"APR_SIZE_T_FMT".%"APR_SIZE_T_FMT,i / 250,i % 250 + 1);
+		apt_string_set(&load->gateway_ips[i],ip);
+	}
+
+	/* each media gateway establishes several connections from different ports */
+	for(i=0; i<load->connection_count; i++) {
+		connection = mrcp_connection_create();
+		connection->remote_ip = load->gateway_ips[i % gateway_count];
+		if(apr_sockaddr_info_get(&connection->r_sockaddr,connection->remote_ip.buf,APR_INET,
+				(apr_port_t)(10000 + i / gateway_count),0,connection->pool) != APR_SUCCESS) {
+			mrcp_connection_destroy(connection);
+			return FALSE;
+		}
+		connection->it = apt_list_push_back(load->connection_list,connection,load->pool);
+		mrcp_connection_index_add(load->connection_index,connection);
+		load->connections[i] = connection;
+	}
+
+	load->channel_count = channel_count;
+	load->channels = apr_pcalloc(load->pool,sizeof(mrcp_control_channel_t) * channel_count);
+	for(i=0; i<channel_count; i++) {
+		ip = apr_psprintf(load->pool,"%08"APR_SIZE_T_FMT"@speechrecog",i);
+		apt_string_set(&load->channels[i].identifier,ip);
+	}
+	return TRUE;
+}
+
+static void connection_load_destroy(connection_load_t *load)
+{
+	apr_size_t i;
+	for(i=0; i<load->connection_count; i++) {
+		mrcp_connection_destroy(load->connections[i]);
+	}
+}
+
+static int latency_compare(const void *v1, const void *v2)
+{
+	const apr_interval_time_t *t1 = v1;
+	const apr_interval_time_t *t2 = v2;
+	return (*t1 > *t2) - (*t1 < *t2);
+}
+
+/* Set up all the channels over connections found either in the index or in the list */
+static apt_bool_t connection_load_run(connection_load_t *load, apt_bool_t indexed, apr_port_t port, const char *name)
+{
+	apr_size_t batch_count = (load->channel_count + LOAD_BATCH_SIZE - 1) / LOAD_BATCH_SIZE;
+	apr_interval_time_t *latencies = apr_palloc(load->pool,sizeof(apr_interval_time_t) * batch_count);
+	apr_interval_time_t total = 0;
+	mrcp_connection_t *connection;
+	mrcp_control_channel_t *channel;
+	const apt_str_t *remote_ip;
+	apr_time_t start;
+	apr_size_t i,j;
+	apt_bool_t status = TRUE;
+
+	for(i=0; i<batch_count; i++) {
+		start = apr_time_now();
+		for(j=i*LOAD_BATCH_SIZE; j<(i+1)*LOAD_BATCH_SIZE && j<load->channel_count; j++) {
+			channel = &load->channels[j];
+			remote_ip = &load->gateway_ips[j % load->gateway_count];
+			if(indexed == TRUE) {
+				connection = mrcp_connection_index_find(load->connection_index,remote_ip,port);
+			}
+			else {
+				connection = connection_list_find(load->connection_list,remote_ip,port);
+			}
+			if(!connection) {
+				status = FALSE;
+				continue;
+			}
+			mrcp_connection_channel_add(connection,channel);
+		}
+		/* nsec per channel */
+		latencies[i] = (apr_time_now() - start) * 1000 / LOAD_BATCH_SIZE;
+		total += latencies[i];
+	}
+
+	for(j=0; j<load->channel_count; j++) {
+		channel = &load->channels[j];
+		mrcp_connection_channel_remove(channel->connection,channel);
+	}
+
+	qsort(latencies,batch_count,sizeof(apr_interval_time_t),latency_compare);
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"%s Setup %"APR_SIZE_T_FMT" Channels over %"APR_SIZE_T_FMT" Connections [nsec per channel] "
+		"mean [%"APR_TIME_T_FMT"] p50 [%"APR_TIME_T_FMT"] p90 [%"APR_TIME_T_FMT"] p99 [%"APR_TIME_T_FMT"] max [%"APR_TIME_T_FMT"]",
+		name,
+		load->channel_count,
+		load->connection_count,
+		total / batch_count,
+		latencies[batch_count * 50 / 100],
+		latencies[batch_count * 90 / 100],
+		latencies[batch_count * 99 / 100],
+		latencies[batch_count - 1]);
+	return status;
+}
+
+/* Lookups in the index must match the former lookup in the list */
+static apt_bool_t connection_index_verify(connection_load_t *load)
+{
+	apr_size_t i;
+	apr_port_t port;
+	mrcp_connection_t *connection;
+	apt_str_t unknown_ip;
+
+	for(i=0; i<load->connection_count; i++) {
+		connection = load->connections[i];
+		port = connection->r_sockaddr->port;
+		if(mrcp_connection_index_find(load->connection_index,&connection->remote_ip,port) != connection) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Find Connection [%s:%hu]",connection->remote_ip.buf,port);
+			return FALSE;
+		}
+		if(!mrcp_connection_index_find(load->connection_index,&connection->remote_ip,0)) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Find Any Connection [%s]",connection->remote_ip.buf);
+			return FALSE;
+		}
+	}
+
+	apt_string_set(&unknown_ip,"192.168.0.1");
+	if(mrcp_connection_index_find(load->connection_index,&unknown_ip,0) ||
+		mrcp_connection_index_find(load->connection_index,&load->gateway_ips[0],9999)) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Found Unknown Connection");
+		return FALSE;
+	}
+
+	/* remove every other connection and check the rest are still found */
+	for(i=0; i<load->connection_count; i+=2) {
+		connection = load->connections[i];
+		apt_list_elem_remove(load->connection_list,connection->it);
+		connection->it = NULL;
+		mrcp_connection_index_remove(load->connection_index,connection);
+	}
+	for(i=0; i<load->connection_count; i++) {
+		connection = load->connections[i];
+		port = connection->r_sockaddr->port;
+		if(mrcp_connection_index_find(load->connection_index,&connection->remote_ip,port) !=
+			connection_list_find(load->connection_list,&connection->remote_ip,port)) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Index Mismatch after Removal [%s:%hu]",connection->remote_ip.buf,port);
+			return FALSE;
+		}
+	}
+	if(mrcp_connection_index_count_get(load->connection_index) != load->connection_count / 2) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Number of Indexed Connections [%"APR_SIZE_T_FMT"]",
+			mrcp_connection_index_count_get(load->connection_index));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static apt_bool_t connection_load_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	connection_load_t load;
+	apr_size_t gateway_count = LOAD_GATEWAY_COUNT;
+	apr_size_t channel_count = LOAD_CHANNEL_COUNT;
+	apt_bool_t status = TRUE;
+
+	if(argc > 0) {
+		gateway_count = atol(argv[0]);
+	}
+	if(argc > 1) {
+		channel_count = atol(argv[1]);
+	}
+	if(!gateway_count || channel_count < LOAD_BATCH_SIZE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Invalid Arguments [gateways channels]");
+		return FALSE;
+	}
+
+	load.pool = suite->pool;
+	if(connection_load_create(&load,gateway_count,channel_count) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Connections");
+		return FALSE;
+	}
+
+	/* server shares any connection from the gateway, client looks for the one to the offered port */
+	if(connection_load_run(&load,FALSE,0,"Server List") == FALSE ||
+		connection_load_run(&load,TRUE,0,"Server Index") == FALSE ||
+		connection_load_run(&load,FALSE,10000 + LOAD_GATEWAY_CONNECTIONS - 1,"Client List") == FALSE ||
+		connection_load_run(&load,TRUE,10000 + LOAD_GATEWAY_CONNECTIONS - 1,"Client Index") == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Find Connection for Channel");
+		status = FALSE;
+	}
+
+	if(status == TRUE) {
+		status = connection_index_verify(&load);
+	}
+
+	connection_load_destroy(&load);
+	return status;
+}
+
+apt_test_suite_t* connection_load_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"connection-load",NULL,connection_load_test_run);
+	return suite;
+}
@@ -0,0 +1,183 @@
+/*
+ * Copyright 2008-2010 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <stdlib.h>
+#include <ctype.h>
+#include <apr_time.h>
+#include "apt_test_suite.h"
+#include "apt_log.h"
+#include "mrcp_resource_loader.h"
+#include "mrcp_resource_factory.h"
+#include "mrcp_resource.h"
+#include "mrcp_generic_header.h"
+
+#define LOOKUP_ITERATION_COUNT 100000
+#define LOOKUP_MAX_NAME_LENGTH 64
+
+/** Header field names which are not in any table */
+static const char *unknown_names[] = {
+	"X-Unknown-Header",
+	"Content",
+	"Speech-Languag",
+	"Hotword-Mid-Duration",
+	""
+};
+
+static apt_bool_t header_lookup_check(const char *name, const mrcp_header_vtable_t *vtable, const apt_str_t *value, apr_size_t expected_id)
+{
+	apr_size_t id = apt_string_table_hash_id_find(vtable->field_table,vtable->field_count,vtable->field_hash,value);
+	if(id != expected_id) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"%s Lookup Mismatch [%.*s] id [%"APR_SIZE_T_FMT"] expected [%"APR_SIZE_T_FMT"]",
+			name,(int)value->length,value->buf,id,expected_id);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static apt_bool_t header_table_verify(const char *name, const mrcp_header_vtable_t *vtable)
+{
+	char buffer[LOOKUP_MAX_NAME_LENGTH];
+	apt_str_t value;
+	apr_size_t i,j;
+	const apt_str_t *field_name;
+
+	if(!vtable->field_hash) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"%s Has no Perfect Hash",name);
+		return FALSE;
+	}
+
+	for(i=0; i<vtable->field_count; i++) {
+		field_name = &vtable->field_table[i].value;
+		if(header_lookup_check(name,vtable,field_name,i) == FALSE) {
+			return FALSE;
+		}
+
+		/* header field names are case insensitive */
+		if(field_name->length > sizeof(buffer)) {
+			continue;
+		}
+		for(j=0; j<field_name->length; j++) {
+			buffer[j] = (char)((j % 2) ? toupper((unsigned char)field_name->buf[j]) : tolower((unsigned char)field_name->buf[j]));
+		}
+		value.buf = buffer;
+		value.length = field_name->length;
+		if(header_lookup_check(name,vtable,&value,i) == FALSE) {
+			return FALSE;
+		}
+	}
+
+	for(i=0; i<sizeof(unknown_names)/sizeof(unknown_names[0]); i++) {
+		apt_string_set(&value,unknown_names[i]);
+		if(header_lookup_check(name,vtable,&value,apt_string_table_id_find(vtable->field_table,vtable->field_count,&value)) == FALSE) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+static void header_table_benchmark(const char *name, const mrcp_header_vtable_t *vtable, apr_size_t iteration_count)
+{
+	apr_time_t start;
+	apr_interval_time_t linear_time;
+	apr_interval_time_t hash_time;
+	apr_size_t i,j;
+
+	start = apr_time_now();
+	for(i=0; i<iteration_count; i++) {
+		for(j=0; j<vtable->field_count; j++) {
+			apt_string_table_id_find(vtable->field_table,vtable->field_count,&vtable->field_table[j].value);
+		}
+	}
+	linear_time = apr_time_now() - start;
+
+	start = apr_time_now();
+	for(i=0; i<iteration_count; i++) {
+		for(j=0; j<vtable->field_count; j++) {
+			apt_string_table_hash_id_find(vtable->field_table,vtable->field_count,vtable->field_hash,&vtable->field_table[j].value);
+		}
+	}
+	hash_time = apr_time_now() - start;
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"%s %"APR_SIZE_T_FMT" Lookups: linear [%"APR_TIME_T_FMT" usec] hash [%"APR_TIME_T_FMT" usec]",
+		name,
+		iteration_count * vtable->field_count,
+		linear_time,
+		hash_time);
+}
+
+static apt_bool_t header_lookup_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	mrcp_resource_factory_t *factory;
+	mrcp_resource_loader_t *resource_loader;
+	mrcp_resource_t *resource;
+	const mrcp_header_vtable_t *vtable;
+	apr_size_t iteration_count = LOOKUP_ITERATION_COUNT;
+	apr_size_t i;
+	mrcp_version_e version;
+	const char *name;
+	apt_bool_t status = TRUE;
+
+	if(argc > 0) {
+		iteration_count = atol(argv[0]);
+	}
+
+	resource_loader = mrcp_resource_loader_create(TRUE,suite->pool);
+	if(!resource_loader) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Resource Loader");
+		return FALSE;
+	}
+
+	factory = mrcp_resource_factory_get(resource_loader);
+	if(!factory) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Resource Factory");
+		return FALSE;
+	}
+
+	for(version = MRCP_VERSION_1; version <= MRCP_VERSION_2; version++) {
+		name = version == MRCP_VERSION_1 ? "MRCPv1 generic" : "MRCPv2 generic";
+		vtable = mrcp_generic_header_vtable_get(version);
+		if(header_table_verify(name,vtable) == FALSE) {
+			status = FALSE;
+			continue;
+		}
+		header_table_benchmark(name,vtable,iteration_count);
+
+		for(i=0; i<MRCP_RESOURCE_TYPE_COUNT; i++) {
+			resource = mrcp_resource_get(factory,i);
+			if(!resource) {
+				continue;
+			}
+			name = apr_psprintf(suite->pool,"MRCPv%d %s",version,resource->name.buf);
+			vtable = resource->get_resource_header_vtable(version);
+			if(header_table_verify(name,vtable) == FALSE) {
+				status = FALSE;
+				continue;
+			}
+			header_table_benchmark(name,vtable,iteration_count);
+		}
+	}
+
+	mrcp_resource_factory_destroy(factory);
+	return status;
+}
+
+apt_test_suite_t* header_lookup_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"header-lookup",NULL,header_lookup_test_run);
+	return suite;
+}
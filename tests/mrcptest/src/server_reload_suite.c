@@ -0,0 +1,260 @@
+/*
+ * Copyright 2008-2010 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include "apt_test_suite.h"
+#include "apt_consumer_task.h"
+#include "apt_dir_layout.h"
+#include "apt_log.h"
+#include "mrcp_server.h"
+#include "mrcp_server_session.h"
+#include "mrcp_sig_agent.h"
+#include "mrcp_resource_loader.h"
+#include "mpf_engine.h"
+#include "mpf_codec_manager.h"
+#include "mpf_rtp_termination_factory.h"
+
+/** Number of reloads made in a row */
+#define RELOAD_COUNT           100
+
+#define RELOAD_SETTINGS_ID     "Reload-Settings"
+#define RELOAD_PROFILE_ID      "Reload-Profile"
+
+/** Components the reloaded profiles refer to */
+typedef struct {
+	mrcp_server_t             *server;
+	mrcp_sig_agent_t          *agent;
+	mpf_engine_t              *media_engine;
+	mpf_termination_factory_t *rtp_factory;
+} reload_env_t;
+
+/** Count destruction of the pool of a generation */
+static apr_status_t reload_pool_cleanup(void *data)
+{
+	apr_size_t *destroyed_count = data;
+	(*destroyed_count)++;
+	return APR_SUCCESS;
+}
+
+/** Register RTP settings and profile of the generation being loaded */
+static apt_bool_t reload_generation_load(reload_env_t *env, apr_size_t *destroyed_count)
+{
+	mpf_rtp_settings_t *rtp_settings;
+	mrcp_profile_t *profile;
+	apr_pool_t *pool = mrcp_server_profile_pool_get(env->server);
+	if(!pool) {
+		return FALSE;
+	}
+	apr_pool_cleanup_register(pool,destroyed_count,reload_pool_cleanup,apr_pool_cleanup_null);
+
+	rtp_settings = mpf_rtp_settings_alloc(pool);
+	if(mrcp_server_rtp_settings_register(env->server,rtp_settings,apr_pstrdup(pool,RELOAD_SETTINGS_ID)) == FALSE) {
+		return FALSE;
+	}
+	profile = mrcp_server_profile_create(
+				apr_pstrdup(pool,RELOAD_PROFILE_ID),
+				NULL,
+				env->agent,
+				NULL,
+				env->media_engine,
+				env->rtp_factory,
+				mrcp_server_rtp_settings_get(env->server,RELOAD_SETTINGS_ID),
+				pool);
+	return mrcp_server_profile_register(env->server,profile,NULL);
+}
+
+/** Reload RTP settings and profile, then swap in or discard the loaded generation */
+static apt_bool_t reload_generation_swap(reload_env_t *env, apr_size_t *destroyed_count, apt_bool_t commit)
+{
+	if(mrcp_server_profiles_reload_begin(env->server) == FALSE) {
+		return FALSE;
+	}
+	if(reload_generation_load(env,destroyed_count) == FALSE) {
+		mrcp_server_profiles_reload_end(env->server,FALSE);
+		return FALSE;
+	}
+	return mrcp_server_profiles_reload_end(env->server,commit);
+}
+
+/** Create session and check it is created with the current profile */
+static mrcp_session_t* reload_session_create(reload_env_t *env)
+{
+	mrcp_server_session_t *session;
+	mrcp_profile_t *profile = mrcp_server_profile_get(env->server,RELOAD_PROFILE_ID);
+	mrcp_session_t *base = env->agent->create_server_session(env->agent);
+	if(!base) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Session");
+		return NULL;
+	}
+	session = (mrcp_server_session_t*)base;
+	if(!profile || session->profile != profile || profile->rtp_settings != mrcp_server_rtp_settings_get(env->server,RELOAD_SETTINGS_ID)) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Session not Created with Current Profile");
+		mrcp_session_destroy(base);
+		return NULL;
+	}
+	return base;
+}
+
+/** Create the server serving the profile of a stub signaling agent */
+static apt_bool_t reload_env_create(reload_env_t *env, apt_dir_layout_t *dir_layout)
+{
+	mrcp_resource_loader_t *resource_loader;
+	apt_consumer_task_t *agent_task;
+	mpf_rtp_config_t *rtp_config;
+	apr_pool_t *pool;
+
+	env->server = mrcp_server_create(dir_layout);
+	if(!env->server) {
+		return FALSE;
+	}
+	pool = mrcp_server_memory_pool_get(env->server);
+
+	resource_loader = mrcp_resource_loader_create(TRUE,pool);
+	mrcp_server_resource_factory_register(env->server,mrcp_resource_factory_get(resource_loader));
+	mrcp_server_codec_manager_register(env->server,mpf_engine_codec_manager_create(pool));
+
+	env->media_engine = mpf_engine_create("Reload-Media-Engine",pool);
+	mrcp_server_media_engine_register(env->server,env->media_engine);
+	rtp_config = mpf_rtp_config_alloc(pool);
+	apt_string_set(&rtp_config->ip,"127.0.0.1");
+	env->rtp_factory = mpf_rtp_termination_factory_create(rtp_config,pool);
+
+	/* the stub agent doesn't signal anything, the sessions are only created and destroyed */
+	env->agent = mrcp_signaling_agent_create("Reload-Agent",NULL,MRCP_VERSION_1,pool);
+	agent_task = apt_consumer_task_create(env->agent,NULL,pool);
+	if(!env->agent || !agent_task) {
+		mrcp_server_destroy(env->server);
+		return FALSE;
+	}
+	env->agent->task = apt_consumer_task_base_get(agent_task);
+	mrcp_server_signaling_agent_register(env->server,env->agent);
+	return TRUE;
+}
+
+/** Reload profiles while sessions are established, check each generation is destroyed once swapped out and unreferenced */
+static apt_bool_t reload_swap_run(apt_dir_layout_t *dir_layout)
+{
+	reload_env_t env;
+	apr_size_t destroyed_counts[3] = {0,0,0};
+	apr_size_t swapped_count = 0;
+	mrcp_session_t *first_session = NULL;
+	mrcp_session_t *second_session = NULL;
+	apt_bool_t status = FALSE;
+	apr_size_t i;
+
+	if(reload_env_create(&env,dir_layout) == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Server");
+		return FALSE;
+	}
+
+	do {
+		/* the initial generation is referenced by the first session */
+		if(reload_generation_load(&env,&destroyed_counts[0]) == FALSE) {
+			break;
+		}
+		first_session = reload_session_create(&env);
+		if(!first_session) {
+			break;
+		}
+
+		/* the swapped out generation is kept while the first session is established */
+		if(reload_generation_swap(&env,&destroyed_counts[1],TRUE) == FALSE) {
+			break;
+		}
+		if(destroyed_counts[0] != 0) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Generation Destroyed while Referenced by Session");
+			break;
+		}
+		second_session = reload_session_create(&env);
+		if(!second_session) {
+			break;
+		}
+		if(((mrcp_server_session_t*)first_session)->profile == ((mrcp_server_session_t*)second_session)->profile) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Profile not Swapped");
+			break;
+		}
+		mrcp_session_destroy(first_session);
+		first_session = NULL;
+		if(destroyed_counts[0] != 1) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Generation not Destroyed with Last Session");
+			break;
+		}
+
+		/* only one reload may be in progress */
+		if(mrcp_server_profiles_reload_begin(env.server) == FALSE) {
+			break;
+		}
+		if(mrcp_server_profiles_reload_begin(env.server) == TRUE) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Nested Reload Begun");
+			break;
+		}
+		mrcp_server_profiles_reload_end(env.server,FALSE);
+
+		/* the discarded generation is destroyed at once, the current one stays in use */
+		if(reload_generation_swap(&env,&destroyed_counts[2],FALSE) == FALSE) {
+			break;
+		}
+		if(destroyed_counts[2] != 1 ||
+			mrcp_server_profile_get(env.server,RELOAD_PROFILE_ID) != ((mrcp_server_session_t*)second_session)->profile) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Discarded Generation Applied");
+			break;
+		}
+
+		/* unreferenced generations don't accumulate across reloads */
+		for(i=0; i<RELOAD_COUNT; i++) {
+			if(reload_generation_swap(&env,&swapped_count,TRUE) == FALSE) {
+				break;
+			}
+		}
+		apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Server Reload: reloads [%"APR_SIZE_T_FMT"] destroyed generations [%"APR_SIZE_T_FMT"]",
+			i,
+			swapped_count);
+		if(i != RELOAD_COUNT || swapped_count != RELOAD_COUNT - 1 || destroyed_counts[1] != 0) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Number of Destroyed Generations");
+			break;
+		}
+		mrcp_session_destroy(second_session);
+		second_session = NULL;
+		if(destroyed_counts[1] != 1) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Generation not Destroyed with Last Session");
+			break;
+		}
+		status = TRUE;
+	}
+	while(0);
+
+	if(first_session) {
+		mrcp_session_destroy(first_session);
+	}
+	if(second_session) {
+		mrcp_session_destroy(second_session);
+	}
+	mrcp_server_destroy(env.server);
+	return status;
+}
+
+static apt_bool_t server_reload_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apt_dir_layout_t *dir_layout = apt_default_dir_layout_create("../",suite->pool);
+	return reload_swap_run(dir_layout);
+}
+
+apt_test_suite_t* server_reload_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"server-reload",NULL,server_reload_test_run);
+	return suite;
+}
@@ -0,0 +1,426 @@
+/*
+ * Copyright 2008-2010 Arsen Chaloyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * $Id$
+ */
+
+#include <apr_atomic.h>
+#include <apr_hash.h>
+#include <apr_portable.h>
+#include <apr_thread_proc.h>
+#include "apt_test_suite.h"
+#include "apt_pool.h"
+#include "apt_consumer_task.h"
+#include "apt_dir_layout.h"
+#include "apt_log.h"
+#include "mrcp_server.h"
+#include "mrcp_session.h"
+#include "mrcp_sig_agent.h"
+#include "mrcp_resource_loader.h"
+#include "mrcp_engine_iface.h"
+#include "mrcp_engine_impl.h"
+#include "mpf_engine.h"
+#include "mpf_codec_manager.h"
+#include "mpf_rtp_termination_factory.h"
+
+/** Number of shards (and threads calling the engine) */
+#define SHARD_COUNT            4
+/** Number of sessions routed */
+#define SHARD_SESSION_COUNT    200
+/** Number of channel lifecycles per thread */
+#define SHARD_ENGINE_ITERATIONS 500
+/** Max number of attempts to wait for the sessions to terminate */
+#define SHARD_WAIT_ATTEMPTS    1000
+
+/** Test engine detecting the calls made concurrently */
+typedef struct {
+	/** Number of threads in the engine */
+	volatile apr_uint32_t inside;
+	/** Number of calls made while another thread was in the engine */
+	volatile apr_uint32_t overlap_count;
+} shard_engine_t;
+
+/** Thread calling the engine as a shard does */
+typedef struct {
+	mrcp_engine_t *engine;
+	apr_size_t     failure_count;
+} shard_engine_thread_t;
+
+/** Mark the engine entered, give the other threads a chance to enter as well, then leave */
+static void shard_engine_call(shard_engine_t *shard_engine)
+{
+	if(apr_atomic_inc32(&shard_engine->inside) != 0) {
+		apr_atomic_inc32(&shard_engine->overlap_count);
+	}
+	apr_thread_yield();
+	apr_atomic_dec32(&shard_engine->inside);
+}
+
+static apt_bool_t shard_channel_destroy(mrcp_engine_channel_t *channel)
+{
+	shard_engine_call(channel->engine->obj);
+	return TRUE;
+}
+
+static apt_bool_t shard_channel_open(mrcp_engine_channel_t *channel)
+{
+	shard_engine_call(channel->engine->obj);
+	return TRUE;
+}
+
+static apt_bool_t shard_channel_close(mrcp_engine_channel_t *channel)
+{
+	shard_engine_call(channel->engine->obj);
+	return TRUE;
+}
+
+static apt_bool_t shard_channel_request_process(mrcp_engine_channel_t *channel, mrcp_message_t *request)
+{
+	shard_engine_call(channel->engine->obj);
+	return TRUE;
+}
+
+static const mrcp_engine_channel_method_vtable_t shard_channel_vtable = {
+	shard_channel_destroy,
+	shard_channel_open,
+	shard_channel_close,
+	shard_channel_request_process
+};
+
+static apt_bool_t shard_engine_destroy(mrcp_engine_t *engine)
+{
+	return TRUE;
+}
+
+static apt_bool_t shard_engine_open(mrcp_engine_t *engine)
+{
+	return mrcp_engine_open_respond(engine,TRUE);
+}
+
+static apt_bool_t shard_engine_close(mrcp_engine_t *engine)
+{
+	return mrcp_engine_close_respond(engine);
+}
+
+static mrcp_engine_channel_t* shard_engine_channel_create(mrcp_engine_t *engine, apr_pool_t *pool)
+{
+	shard_engine_call(engine->obj);
+	return mrcp_engine_channel_create(engine,&shard_channel_vtable,NULL,NULL,pool);
+}
+
+static const mrcp_engine_method_vtable_t shard_engine_vtable = {
+	shard_engine_destroy,
+	shard_engine_open,
+	shard_engine_close,
+	shard_engine_channel_create
+};
+
+static apt_bool_t shard_engine_on_open(mrcp_engine_t *engine, apt_bool_t status)
+{
+	mrcp_engine_on_open(engine,status);
+	return TRUE;
+}
+
+static apt_bool_t shard_engine_on_close(mrcp_engine_t *engine)
+{
+	mrcp_engine_on_close(engine);
+	return TRUE;
+}
+
+static const mrcp_engine_event_vtable_t shard_engine_event_vtable = {
+	shard_engine_on_open,
+	shard_engine_on_close
+};
+
+static void* APR_THREAD_FUNC shard_engine_thread_run(apr_thread_t *thread, void *data)
+{
+	shard_engine_thread_t *engine_thread = data;
+	mrcp_engine_channel_t *channel;
+	apr_size_t i;
+	apr_pool_t *pool = apt_pool_create();
+	for(i=0; i<SHARD_ENGINE_ITERATIONS; i++) {
+		channel = mrcp_engine_channel_virtual_create(engine_thread->engine,MRCP_VERSION_2,pool);
+		if(!channel) {
+			engine_thread->failure_count++;
+			continue;
+		}
+		if(mrcp_engine_channel_virtual_open(channel) == FALSE) {
+			engine_thread->failure_count++;
+		}
+		mrcp_engine_channel_request_process(channel,NULL);
+		mrcp_engine_channel_virtual_close(channel);
+		mrcp_engine_channel_virtual_destroy(channel);
+		apr_pool_clear(pool);
+	}
+	apr_pool_destroy(pool);
+	apr_thread_exit(thread,APR_SUCCESS);
+	return NULL;
+}
+
+/** Call the engine from several threads at once and check the calls never overlap */
+static apt_bool_t shard_engine_run(apr_pool_t *pool)
+{
+	shard_engine_t shard_engine;
+	shard_engine_thread_t engine_threads[SHARD_COUNT];
+	apr_thread_t *threads[SHARD_COUNT];
+	apr_status_t retval;
+	apr_size_t failure_count = 0;
+	apr_size_t i;
+	mrcp_engine_t *engine;
+
+	shard_engine.inside = 0;
+	shard_engine.overlap_count = 0;
+	engine = mrcp_engine_create(MRCP_SYNTHESIZER_RESOURCE,&shard_engine,&shard_engine_vtable,pool);
+	if(!engine) {
+		return FALSE;
+	}
+	engine->id = "Shard-Engine";
+	engine->config = mrcp_engine_config_alloc(pool);
+	engine->event_vtable = &shard_engine_event_vtable;
+	if(mrcp_engine_virtual_open(engine) == FALSE || engine->is_open == FALSE) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Open Engine");
+		return FALSE;
+	}
+
+	for(i=0; i<SHARD_COUNT; i++) {
+		engine_threads[i].engine = engine;
+		engine_threads[i].failure_count = 0;
+		if(apr_thread_create(&threads[i],NULL,shard_engine_thread_run,&engine_threads[i],pool) != APR_SUCCESS) {
+			threads[i] = NULL;
+			failure_count++;
+		}
+	}
+	for(i=0; i<SHARD_COUNT; i++) {
+		if(threads[i]) {
+			apr_thread_join(&retval,threads[i]);
+		}
+		failure_count += engine_threads[i].failure_count;
+	}
+
+	mrcp_engine_virtual_close(engine);
+	mrcp_engine_virtual_destroy(engine);
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Shard Engine: threads [%d] overlaps [%u] failures [%"APR_SIZE_T_FMT"] channels left [%u]",
+		SHARD_COUNT,
+		shard_engine.overlap_count,
+		failure_count,
+		engine->cur_channel_count);
+	if(shard_engine.overlap_count || failure_count || engine->cur_channel_count) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Engine Entered Concurrently");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/** Sessions terminated by the server */
+typedef struct {
+	apr_thread_mutex_t *mutex;
+	/** Number of sessions terminated per shard */
+	apr_size_t          counts[SHARD_COUNT];
+	/** Thread the sessions of the shard have been terminated in */
+	apr_os_thread_t     threads[SHARD_COUNT];
+	/** Number of sessions terminated in another thread than the rest of the shard */
+	apr_size_t          misrouted_count;
+	/** Sessions to destroy once the server is shut down */
+	mrcp_session_t     *sessions[SHARD_SESSION_COUNT];
+	/** Number of sessions terminated */
+	volatile apr_uint32_t terminated_count;
+} shard_router_t;
+
+/** Get the shard the session is expected to be routed to (by the hash of its identifier) */
+static apr_size_t shard_expected_get(const mrcp_session_t *session)
+{
+	apr_ssize_t length = session->id.length;
+	return apr_hashfunc_default(session->id.buf,&length) % SHARD_COUNT;
+}
+
+static apt_bool_t shard_session_on_terminate(mrcp_session_t *session)
+{
+	shard_router_t *router = session->obj;
+	apr_os_thread_t thread = apr_os_thread_current();
+	apr_size_t id = shard_expected_get(session);
+	apr_uint32_t count;
+
+	apr_thread_mutex_lock(router->mutex);
+	if(!router->counts[id]) {
+		router->threads[id] = thread;
+	}
+	else if(!apr_os_thread_equal(router->threads[id],thread)) {
+		router->misrouted_count++;
+	}
+	router->counts[id]++;
+	/* the server still refers to the session, destroy it later */
+	count = apr_atomic_read32(&router->terminated_count);
+	if(count < SHARD_SESSION_COUNT) {
+		router->sessions[count] = session;
+	}
+	apr_atomic_inc32(&router->terminated_count);
+	apr_thread_mutex_unlock(router->mutex);
+	return TRUE;
+}
+
+static const mrcp_session_response_vtable_t shard_session_response_vtable = {
+	NULL,
+	shard_session_on_terminate,
+	NULL,
+	NULL
+};
+
+/** Create the server of several shards, serving the profile of a stub signaling agent */
+static mrcp_server_t* shard_server_create(apt_dir_layout_t *dir_layout, mrcp_sig_agent_t **signaling_agent)
+{
+	mrcp_resource_loader_t *resource_loader;
+	apt_consumer_task_t *agent_task;
+	mpf_engine_t *media_engine;
+	mpf_rtp_config_t *rtp_config;
+	mpf_termination_factory_t *rtp_factory;
+	mrcp_profile_t *profile;
+	mrcp_sig_agent_t *agent;
+	apr_pool_t *pool;
+	mrcp_server_t *server = mrcp_server_create(dir_layout);
+	if(!server) {
+		return NULL;
+	}
+	pool = mrcp_server_memory_pool_get(server);
+	if(mrcp_server_shard_count_set(server,SHARD_COUNT) == FALSE) {
+		mrcp_server_destroy(server);
+		return NULL;
+	}
+
+	resource_loader = mrcp_resource_loader_create(TRUE,pool);
+	mrcp_server_resource_factory_register(server,mrcp_resource_factory_get(resource_loader));
+	mrcp_server_codec_manager_register(server,mpf_engine_codec_manager_create(pool));
+
+	media_engine = mpf_engine_create("Shard-Media-Engine",pool);
+	mrcp_server_media_engine_register(server,media_engine);
+	rtp_config = mpf_rtp_config_alloc(pool);
+	apt_string_set(&rtp_config->ip,"127.0.0.1");
+	rtp_factory = mpf_rtp_termination_factory_create(rtp_config,pool);
+
+	/* the stub agent doesn't signal anything by itself, the sessions are driven by the test */
+	agent = mrcp_signaling_agent_create("Shard-Agent",NULL,MRCP_VERSION_1,pool);
+	agent_task = apt_consumer_task_create(agent,NULL,pool);
+	if(!agent || !agent_task) {
+		mrcp_server_destroy(server);
+		return NULL;
+	}
+	agent->task = apt_consumer_task_base_get(agent_task);
+	mrcp_server_signaling_agent_register(server,agent);
+
+	profile = mrcp_server_profile_create("Shard-Profile",NULL,agent,NULL,media_engine,rtp_factory,NULL,pool);
+	if(mrcp_server_profile_register(server,profile,NULL) == FALSE) {
+		mrcp_server_destroy(server);
+		return NULL;
+	}
+	*signaling_agent = agent;
+	return server;
+}
+
+/** Terminate sessions through the server of several shards and check each one is processed by the task of its shard */
+static apt_bool_t shard_routing_run(apt_dir_layout_t *dir_layout, apr_pool_t *pool)
+{
+	apt_bool_t status = TRUE;
+	shard_router_t router;
+	mrcp_server_shard_stat_t stat;
+	mrcp_sig_agent_t *agent = NULL;
+	mrcp_session_t *session;
+	mrcp_server_t *server;
+	apr_size_t attempts = 0;
+	apr_size_t i, j;
+
+	memset(&router,0,sizeof(router));
+	if(apr_thread_mutex_create(&router.mutex,APR_THREAD_MUTEX_DEFAULT,pool) != APR_SUCCESS) {
+		return FALSE;
+	}
+	server = shard_server_create(dir_layout,&agent);
+	if(!server) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Failed to Create Server");
+		return FALSE;
+	}
+	if(mrcp_server_start(server) == FALSE) {
+		mrcp_server_destroy(server);
+		return FALSE;
+	}
+
+	for(i=0; i<SHARD_SESSION_COUNT; i++) {
+		session = agent->create_server_session(agent);
+		if(!session) {
+			status = FALSE;
+			break;
+		}
+		session->obj = &router;
+		session->response_vtable = &shard_session_response_vtable;
+		mrcp_session_terminate_request(session);
+	}
+	while(apr_atomic_read32(&router.terminated_count) < i && attempts < SHARD_WAIT_ATTEMPTS) {
+		apr_sleep(1000);
+		attempts++;
+	}
+	mrcp_server_shutdown(server);
+
+	apt_log(APT_LOG_MARK,APT_PRIO_NOTICE,"Shard Routing: sessions [%"APR_SIZE_T_FMT"] terminated [%u] misrouted [%"APR_SIZE_T_FMT"]",
+		i,
+		router.terminated_count,
+		router.misrouted_count);
+	if(status == FALSE || router.terminated_count != SHARD_SESSION_COUNT || router.misrouted_count) {
+		apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Sessions not Terminated by their Shards");
+		status = FALSE;
+	}
+
+	for(i=0; i<SHARD_COUNT && status == TRUE; i++) {
+		/* each shard is processed by a task of its own */
+		for(j=0; j<i; j++) {
+			if(router.counts[i] && router.counts[j] && apr_os_thread_equal(router.threads[i],router.threads[j])) {
+				apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Shards [%"APR_SIZE_T_FMT"] [%"APR_SIZE_T_FMT"] Share Thread",j,i);
+				status = FALSE;
+			}
+		}
+		/* the core messages are counted as well */
+		if(mrcp_server_shard_stat_get(server,i,&stat) == FALSE ||
+			stat.task_stat.msg_count < router.counts[i]) {
+			apt_log(APT_LOG_MARK,APT_PRIO_WARNING,"Unexpected Number of Messages Processed by Shard [%"APR_SIZE_T_FMT"]: [%u] expected [%"APR_SIZE_T_FMT"]",
+				i,
+				stat.task_stat.msg_count,
+				router.counts[i]);
+			status = FALSE;
+		}
+	}
+
+	for(i=0; i<router.terminated_count && i<SHARD_SESSION_COUNT; i++) {
+		mrcp_session_destroy(router.sessions[i]);
+	}
+	mrcp_server_destroy(server);
+	return status;
+}
+
+static apt_bool_t server_shard_test_run(apt_test_suite_t *suite, int argc, const char * const *argv)
+{
+	apt_dir_layout_t *dir_layout;
+	if(shard_engine_run(suite->pool) == FALSE) {
+		return FALSE;
+	}
+
+	dir_layout = apt_default_dir_layout_create("../",suite->pool);
+	if(shard_routing_run(dir_layout,suite->pool) == FALSE) {
+		return FALSE;
+	}
+	return TRUE;
+}
+
+apt_test_suite_t* server_shard_test_suite_create(apr_pool_t *pool)
+{
+	apt_test_suite_t *suite = apt_test_suite_create(pool,"server-shard",NULL,server_shard_test_run);
+	return suite;
+}
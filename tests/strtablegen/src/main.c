@@ -17,6 +17,7 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include <ctype.h>
 #include "apt_pool.h"
 #include "apt_string_table.h"
@@ -54,6 +55,153 @@ static apt_bool_t string_table_key_generate(apt_str_table_item_t table[], apr_si
 	return TRUE;
 }
 
+#define HASH_CANDIDATE_COUNT 64
+#define HASH_MAX_SEED        0xFFFF
+
+/* Key position candidates in order of preference: 0,-1,1,-2,2,... */
+static int hash_candidate_get(apr_size_t index)
+{
+	int pos = (int)(index / 2);
+	return (index % 2) ? -(pos + 1) : pos;
+}
+
+static apr_size_t hash_key_distinct_count(const apt_str_table_item_t table[], apr_size_t count, const apt_str_table_hash_t *hash)
+{
+	apr_size_t i,j;
+	apr_size_t distinct = 0;
+	apr_size_t k;
+	int pos;
+	for(i=0; i<count; i++) {
+		for(j=0; j<i; j++) {
+			if(table[i].value.length != table[j].value.length) {
+				continue;
+			}
+			for(k=0; k<hash->key_count; k++) {
+				pos = hash->keys[k];
+				if(pos < 0) {
+					pos += (int)table[i].value.length;
+				}
+				if(pos >= 0 && (apr_size_t)pos < table[i].value.length &&
+					tolower(table[i].value.buf[pos]) != tolower(table[j].value.buf[pos])) {
+					break;
+				}
+			}
+			if(k == hash->key_count) {
+				/* same length and key characters */
+				break;
+			}
+		}
+		if(j == i) {
+			distinct++;
+		}
+	}
+	return distinct;
+}
+
+static apt_bool_t hash_keys_select(const apt_str_table_item_t table[], apr_size_t count, apt_str_table_hash_t *hash)
+{
+	apr_size_t i,k;
+	apr_size_t distinct;
+	apr_size_t best_distinct;
+	int best_key;
+
+	hash->key_count = 0;
+	best_distinct = hash_key_distinct_count(table,count,hash);
+	/* greedily add the key position which distinguishes most of the strings */
+	while(best_distinct < count && hash->key_count < APT_STR_TABLE_HASH_MAX_KEYS) {
+		best_key = 0;
+		distinct = 0;
+		for(i=0; i<HASH_CANDIDATE_COUNT; i++) {
+			hash->keys[hash->key_count] = hash_candidate_get(i);
+			hash->key_count++;
+			k = hash_key_distinct_count(table,count,hash);
+			if(k > distinct) {
+				distinct = k;
+				best_key = hash->keys[hash->key_count-1];
+			}
+			hash->key_count--;
+		}
+		if(distinct <= best_distinct) {
+			break;
+		}
+		hash->keys[hash->key_count++] = best_key;
+		best_distinct = distinct;
+	}
+	return (best_distinct == count) ? TRUE : FALSE;
+}
+
+static apt_bool_t string_table_hash_generate(const apt_str_table_item_t table[], apr_size_t count, 
+											 apt_str_table_hash_t *hash, apr_uint16_t seeds[], apr_uint16_t ids[])
+{
+	apr_size_t buckets[100];
+	apr_size_t slots[100];
+	apr_size_t order[100];
+	apt_bool_t used[100];
+	apr_size_t i,j,k;
+	apr_size_t size;
+	apr_uint32_t seed;
+
+	if(!count || hash_keys_select(table,count,hash) == FALSE) {
+		return FALSE;
+	}
+	hash->seeds = seeds;
+	hash->ids = ids;
+	hash->size = count;
+
+	for(i=0; i<count; i++) {
+		buckets[i] = apt_string_table_hash_compute(hash,&table[i].value,0) % count;
+		seeds[i] = 0;
+		ids[i] = (apr_uint16_t)count;
+		used[i] = FALSE;
+	}
+
+	/* place buckets in order of their size (largest first) */
+	size = 0;
+	for(k=count; k>0; k--) {
+		for(j=0; j<count; j++) {
+			apr_size_t bucket_size = 0;
+			for(i=0; i<count; i++) {
+				if(buckets[i] == j) bucket_size++;
+			}
+			if(bucket_size == k) {
+				order[size++] = j;
+			}
+		}
+	}
+
+	for(k=0; k<size; k++) {
+		for(seed=1; seed<=HASH_MAX_SEED; seed++) {
+			apt_bool_t fit = TRUE;
+			for(i=0; i<count && fit == TRUE; i++) {
+				if(buckets[i] != order[k]) continue;
+				slots[i] = apt_string_table_hash_compute(hash,&table[i].value,seed) % count;
+				if(used[slots[i]] == TRUE) {
+					fit = FALSE;
+				}
+				for(j=0; j<i && fit == TRUE; j++) {
+					if(buckets[j] == order[k] && slots[j] == slots[i]) {
+						fit = FALSE;
+					}
+				}
+			}
+			if(fit == TRUE) {
+				break;
+			}
+		}
+		if(seed > HASH_MAX_SEED) {
+			return FALSE;
+		}
+		seeds[order[k]] = (apr_uint16_t)seed;
+		for(i=0; i<count; i++) {
+			if(buckets[i] == order[k]) {
+				used[slots[i]] = TRUE;
+				ids[slots[i]] = (apr_uint16_t)i;
+			}
+		}
+	}
+	return TRUE;
+}
+
 #define TEST_BUFFER_SIZE 2048
 static char parse_buffer[TEST_BUFFER_SIZE];
 
@@ -95,10 +243,33 @@ static apt_bool_t string_table_write(const apt_str_table_item_t table[], apr_siz
 	return TRUE;
 }
 
+static apt_bool_t string_table_hash_write(const apt_str_table_hash_t *hash, const char *name, FILE *file)
+{
+	size_t i;
+	fprintf(file,"\r\nstatic const apr_uint16_t %s_hash_seeds[] = {",name);
+	for(i=0; i<hash->size; i++) {
+		fprintf(file,"%s%u",i ? "," : "",hash->seeds[i]);
+	}
+	fprintf(file,"};\r\nstatic const apr_uint16_t %s_hash_ids[] = {",name);
+	for(i=0; i<hash->size; i++) {
+		fprintf(file,"%s%u",i ? "," : "",hash->ids[i]);
+	}
+	fprintf(file,"};\r\nstatic const apt_str_table_hash_t %s_hash = {{",name);
+	for(i=0; i<APT_STR_TABLE_HASH_MAX_KEYS; i++) {
+		fprintf(file,"%s%d",i ? "," : "",i < hash->key_count ? hash->keys[i] : 0);
+	}
+	fprintf(file,"},%"APR_SIZE_T_FMT",%s_hash_seeds,%s_hash_ids,%"APR_SIZE_T_FMT"};\r\n",
+		hash->key_count,name,name,hash->size);
+	return TRUE;
+}
+
 int main(int argc, char *argv[])
 {
 	apr_pool_t *pool = NULL;
 	apt_str_table_item_t table[100];
+	apt_str_table_hash_t hash;
+	apr_uint16_t seeds[100];
+	apr_uint16_t ids[100];
 	size_t count;
 	FILE *file_in, *file_out;
 
@@ -109,7 +280,7 @@ int main(int argc, char *argv[])
 	pool = apt_pool_create();
 
 	if(argc < 2) {
-		printf("usage: stringtablegen stringtable.in [stringtable.out]\n");
+		printf("usage: stringtablegen stringtable.in [stringtable.out] [table_name]\n");
 		return 0;
 	}
 	file_in = fopen(argv[1], "rb");
@@ -118,7 +289,7 @@ int main(int argc, char *argv[])
 		return 0;
 	}
 
-	if(argc > 2) {
+	if(argc > 2 && strcmp(argv[2],"-") != 0) {
 		file_out = fopen(argv[2], "wb");
 	}
 	else {
@@ -134,6 +305,16 @@ int main(int argc, char *argv[])
 	/* dump string table to the file */
 	string_table_write(table,count,file_out);
 
+	/* generate and dump perfect hash of the string table */
+	if(argc > 3) {
+		if(string_table_hash_generate(table,count,&hash,seeds,ids) == TRUE) {
+			string_table_hash_write(&hash,argv[3],file_out);
+		}
+		else {
+			printf("cannot generate perfect hash of %s\n", argv[1]);
+		}
+	}
+
 	fclose(file_in);
 	if(file_out != stdout) {
 		fclose(file_out);